@@ -73,6 +73,9 @@
 #define RRAND_R(seed, max, min) (os_rand_r(seed) % ((max) - (min)) + (min))
 
 struct benchmark;
+struct latency_hist;
+struct perf_counters;
+struct perf_events;
 
 /*
  * benchmark_args - Arguments for benchmark.
@@ -97,6 +100,8 @@ struct benchmark_args {
 	unsigned seed;		 /* PRNG seed */
 	unsigned repeats;	/* number of repeats of one scenario */
 	unsigned min_exe_time;   /* minimal execution time */
+	char *output_format;     /* format of printed results */
+	char *perf_events;       /* performance counters to read */
 	bool help;		 /* print help for benchmark */
 	void *opts;		 /* benchmark specific arguments */
 };
@@ -132,6 +137,8 @@ struct latency {
 	uint64_t pctl50_0p;
 	uint64_t pctl99_0p;
 	uint64_t pctl99_9p;
+	uint64_t pctl99_99p;
+	uint64_t pctl99_999p;
 };
 
 /*
@@ -140,7 +147,6 @@ struct latency {
 struct thread_results {
 	benchmark_time_t beg;
 	benchmark_time_t end;
-	benchmark_time_t end_op[];
 };
 
 /*
@@ -148,6 +154,8 @@ struct thread_results {
  */
 struct bench_results {
 	struct thread_results **thres;
+	struct latency_hist *hist; /* latencies of all threads */
+	struct perf_counters *perf; /* counters of all threads, may be NULL */
 };
 
 /*
@@ -160,6 +168,8 @@ struct total_results {
 	double nopsps;
 	struct results total;
 	struct latency latency;
+	const struct perf_events *events; /* counted events, may be NULL */
+	double *perf; /* counts per operation, NAN if not available */
 	struct bench_results *res;
 };
 
@@ -254,6 +264,8 @@ struct worker_info {
 	void *priv;		       /* worker's private data */
 	benchmark_time_t beg;	  /* start time */
 	benchmark_time_t end;	  /* end time */
+	struct latency_hist *hist;     /* latencies of operations */
+	struct perf_counters *perf;    /* performance counters, may be NULL */
 };
 
 /*
@@ -263,7 +275,6 @@ struct operation_info {
 	struct worker_info *worker;  /* worker's info */
 	struct benchmark_args *args; /* benchmark arguments */
 	size_t index;		     /* operation's index */
-	benchmark_time_t end;	/* operation's end time */
 };
 
 /*
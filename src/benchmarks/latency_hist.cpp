@@ -0,0 +1,171 @@
+/*
+ * Copyright 2018, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * latency_hist.cpp -- log-linear latency histogram
+ */
+
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "latency_hist.hpp"
+
+/*
+ * latency_hist_alloc -- allocate an empty histogram
+ */
+struct latency_hist *
+latency_hist_alloc(void)
+{
+	auto *hist = (struct latency_hist *)malloc(sizeof(struct latency_hist));
+	assert(hist != nullptr);
+	latency_hist_reset(hist);
+
+	return hist;
+}
+
+/*
+ * latency_hist_free -- release histogram
+ */
+void
+latency_hist_free(struct latency_hist *hist)
+{
+	free(hist);
+}
+
+/*
+ * latency_hist_reset -- remove all recorded values
+ */
+void
+latency_hist_reset(struct latency_hist *hist)
+{
+	memset(hist, 0, sizeof(*hist));
+	hist->min = UINT64_MAX;
+}
+
+/*
+ * latency_hist_merge -- add all values recorded in src to dst
+ */
+void
+latency_hist_merge(struct latency_hist *dst, const struct latency_hist *src)
+{
+	if (src->count == 0)
+		return;
+
+	for (unsigned i = 0; i < LATENCY_HIST_NBUCKETS; i++)
+		dst->buckets[i] += src->buckets[i];
+
+	dst->count += src->count;
+	dst->sum += src->sum;
+	dst->sum_sq += src->sum_sq;
+	if (src->min < dst->min)
+		dst->min = src->min;
+	if (src->max > dst->max)
+		dst->max = src->max;
+}
+
+/*
+ * latency_hist_avg -- return average of recorded values
+ */
+uint64_t
+latency_hist_avg(const struct latency_hist *hist)
+{
+	if (hist->count == 0)
+		return 0;
+
+	return hist->sum / hist->count;
+}
+
+/*
+ * latency_hist_std_dev -- return standard deviation of recorded values
+ */
+double
+latency_hist_std_dev(const struct latency_hist *hist)
+{
+	if (hist->count == 0)
+		return 0.0;
+
+	double avg = (double)hist->sum / (double)hist->count;
+	double var = hist->sum_sq / (double)hist->count - avg * avg;
+
+	return var > 0.0 ? sqrt(var) : 0.0;
+}
+
+/*
+ * latency_hist_highest -- (internal) return highest value counted in bucket
+ */
+static uint64_t
+latency_hist_highest(unsigned idx)
+{
+	if (idx < (1U << LATENCY_HIST_SUB_BITS))
+		return idx;
+
+	unsigned shift = idx / LATENCY_HIST_SUB_HALF - 1;
+	uint64_t sub = idx - shift * LATENCY_HIST_SUB_HALF;
+
+	return ((sub + 1) << shift) - 1;
+}
+
+/*
+ * latency_hist_pctl -- return value below which pctl percent of recorded
+ * values fall
+ *
+ * The value at rank count * pctl / 100 of the sorted samples is reported,
+ * rounded up to the end of its bucket and clamped to the exact extremes.
+ */
+uint64_t
+latency_hist_pctl(const struct latency_hist *hist, double pctl)
+{
+	if (hist->count == 0)
+		return 0;
+
+	uint64_t rank = (uint64_t)((double)hist->count * pctl / 100.0) + 1;
+	if (rank > hist->count)
+		rank = hist->count;
+
+	uint64_t seen = 0;
+	for (unsigned i = 0; i < LATENCY_HIST_NBUCKETS; i++) {
+		seen += hist->buckets[i];
+		if (seen < rank)
+			continue;
+
+		uint64_t value = latency_hist_highest(i);
+		if (value > hist->max)
+			value = hist->max;
+		if (value < hist->min)
+			value = hist->min;
+		return value;
+	}
+
+	return hist->max;
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2018, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * latency_hist.hpp -- log-linear latency histogram
+ *
+ * Values below 2^LATENCY_HIST_SUB_BITS are counted exactly, every further
+ * power of two range is split into 2^(LATENCY_HIST_SUB_BITS - 1) equal
+ * sub-buckets, which bounds the relative error of a reported value to
+ * 1 / 2^(LATENCY_HIST_SUB_BITS - 1) regardless of the number of samples.
+ */
+
+#ifndef LATENCY_HIST_HPP
+#define LATENCY_HIST_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include "util.h"
+
+#define LATENCY_HIST_SUB_BITS 10
+#define LATENCY_HIST_SUB_HALF (1U << (LATENCY_HIST_SUB_BITS - 1))
+#define LATENCY_HIST_NBUCKETS                                                  \
+	((64 - LATENCY_HIST_SUB_BITS + 2) * LATENCY_HIST_SUB_HALF)
+
+/*
+ * struct latency_hist -- histogram of latencies in nanoseconds
+ */
+struct latency_hist {
+	uint64_t count;	/* number of recorded values */
+	uint64_t min;	/* exact minimum */
+	uint64_t max;	/* exact maximum */
+	uint64_t sum;	/* sum of recorded values */
+	double sum_sq;	/* sum of squares of recorded values */
+	uint64_t buckets[LATENCY_HIST_NBUCKETS];
+};
+
+struct latency_hist *latency_hist_alloc(void);
+void latency_hist_free(struct latency_hist *hist);
+void latency_hist_reset(struct latency_hist *hist);
+void latency_hist_merge(struct latency_hist *dst,
+			const struct latency_hist *src);
+uint64_t latency_hist_avg(const struct latency_hist *hist);
+double latency_hist_std_dev(const struct latency_hist *hist);
+uint64_t latency_hist_pctl(const struct latency_hist *hist, double pctl);
+
+/*
+ * latency_hist_index -- return index of the bucket counting the value
+ */
+static inline unsigned
+latency_hist_index(uint64_t value)
+{
+	if (value < (1ULL << LATENCY_HIST_SUB_BITS))
+		return (unsigned)value;
+
+	unsigned shift = util_mssb_index64(value) - (LATENCY_HIST_SUB_BITS - 1);
+	return shift * LATENCY_HIST_SUB_HALF + (unsigned)(value >> shift);
+}
+
+/*
+ * latency_hist_record -- record a single value
+ */
+static inline void
+latency_hist_record(struct latency_hist *hist, uint64_t value)
+{
+	hist->buckets[latency_hist_index(value)]++;
+	hist->count++;
+	hist->sum += value;
+	hist->sum_sq += (double)value * (double)value;
+	if (value < hist->min)
+		hist->min = value;
+	if (value > hist->max)
+		hist->max = value;
+}
+
+#endif
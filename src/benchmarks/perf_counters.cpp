@@ -0,0 +1,323 @@
+/*
+ * Copyright 2018, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * perf_counters.cpp -- per-thread performance counters
+ *
+ * Counters are opened with perf_event_open(2) by the worker thread itself,
+ * so each of them counts only the thread that runs the measured loop.
+ * Events which cannot be opened, e.g. hardware events in a container
+ * without access to the PMU, are marked as not valid instead of failing
+ * the benchmark, so software events can still be collected there.
+ */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "perf_counters.hpp"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define PERF_HW_CACHE(cache, op, result)                                       \
+	((cache) | ((op) << 8) | ((result) << 16))
+
+/*
+ * perf_known -- events available by name
+ */
+static const struct perf_event_desc perf_known[] = {
+	{"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+	{"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+	{"cache-references", PERF_TYPE_HARDWARE,
+	 PERF_COUNT_HW_CACHE_REFERENCES},
+	{"cache-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+	{"branches", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS},
+	{"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+	{"llc-misses", PERF_TYPE_HW_CACHE,
+	 PERF_HW_CACHE(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ,
+		       PERF_COUNT_HW_CACHE_RESULT_MISS)},
+	{"dtlb-misses", PERF_TYPE_HW_CACHE,
+	 PERF_HW_CACHE(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ,
+		       PERF_COUNT_HW_CACHE_RESULT_MISS)},
+	{"task-clock", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+	{"page-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+	{"context-switches", PERF_TYPE_SOFTWARE,
+	 PERF_COUNT_SW_CONTEXT_SWITCHES},
+	{"cpu-migrations", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS},
+};
+
+/* events counted for "default" */
+static const char *perf_default[] = {
+	"cycles", "instructions", "llc-misses", "dtlb-misses",
+};
+
+#define ARRAY_LEN(x) (sizeof(x) / sizeof((x)[0]))
+
+/*
+ * perf_events_add -- (internal) add event given by name or raw code
+ */
+static int
+perf_events_add(struct perf_events *events, const char *name)
+{
+	if (events->nevents == PERF_EVENTS_MAX) {
+		fprintf(stderr, "too many perf events\n");
+		return -1;
+	}
+
+	if (strlen(name) >= PERF_EVENT_NAME_MAX) {
+		fprintf(stderr, "%s: perf event name too long\n", name);
+		return -1;
+	}
+
+	struct perf_event_desc *desc = &events->desc[events->nevents];
+
+	/* raw event as accepted by perf(1), e.g. r01c4 */
+	if (name[0] == 'r' && name[1] != '\0') {
+		char *end;
+		errno = 0;
+		unsigned long long config = strtoull(name + 1, &end, 16);
+		if (errno == 0 && *end == '\0') {
+			strcpy(desc->name, name);
+			desc->type = PERF_TYPE_RAW;
+			desc->config = config;
+			events->nevents++;
+			return 0;
+		}
+	}
+
+	for (size_t i = 0; i < ARRAY_LEN(perf_known); i++) {
+		if (strcmp(name, perf_known[i].name) == 0) {
+			*desc = perf_known[i];
+			events->nevents++;
+			return 0;
+		}
+	}
+
+	fprintf(stderr, "%s: unknown perf event\n", name);
+	return -1;
+}
+
+/*
+ * perf_events_parse -- parse list of events separated by semicolons
+ */
+int
+perf_events_parse(struct perf_events *events, const char *list)
+{
+	events->nevents = 0;
+
+	char *str = strdup(list);
+	if (str == nullptr) {
+		perror("strdup");
+		return -1;
+	}
+
+	int ret = 0;
+	char *saveptr = nullptr;
+	for (char *name = strtok_r(str, ";", &saveptr); name != nullptr;
+	     name = strtok_r(nullptr, ";", &saveptr)) {
+		if (strcmp(name, "default") == 0) {
+			for (size_t i = 0; i < ARRAY_LEN(perf_default) && !ret;
+			     i++)
+				ret = perf_events_add(events, perf_default[i]);
+		} else {
+			ret = perf_events_add(events, name);
+		}
+		if (ret)
+			break;
+	}
+
+	free(str);
+	return ret;
+}
+
+/*
+ * perf_counters_start -- open and enable counters in the calling thread
+ */
+void
+perf_counters_start(struct perf_counters *pc)
+{
+	for (unsigned i = 0; i < pc->events->nevents; i++) {
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = pc->events->desc[i].type;
+		attr.config = pc->events->desc[i].config;
+		attr.disabled = 1;
+		/*
+		 * context switches and migrations are accounted by the kernel,
+		 * excluding it would hide all of them
+		 */
+		if (attr.type != PERF_TYPE_SOFTWARE ||
+		    (attr.config != PERF_COUNT_SW_CONTEXT_SWITCHES &&
+		     attr.config != PERF_COUNT_SW_CPU_MIGRATIONS))
+			attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+			PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		pc->count[i] = 0;
+		pc->fd[i] = (int)syscall(__NR_perf_event_open, &attr, 0, -1,
+					 -1, 0);
+		pc->valid[i] = pc->fd[i] >= 0;
+	}
+
+	for (unsigned i = 0; i < pc->events->nevents; i++) {
+		if (pc->valid[i] &&
+		    ioctl(pc->fd[i], PERF_EVENT_IOC_ENABLE, 0) != 0)
+			pc->valid[i] = false;
+	}
+}
+
+/*
+ * perf_counters_stop -- disable counters, read and close them
+ *
+ * Values are scaled if the kernel had to multiplex the counters.
+ */
+void
+perf_counters_stop(struct perf_counters *pc)
+{
+	for (unsigned i = 0; i < pc->events->nevents; i++) {
+		if (pc->fd[i] >= 0)
+			ioctl(pc->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+	}
+
+	for (unsigned i = 0; i < pc->events->nevents; i++) {
+		if (pc->fd[i] < 0)
+			continue;
+
+		uint64_t val[3]; /* value, time enabled, time running */
+		if (!pc->valid[i] || read(pc->fd[i], val, sizeof(val)) !=
+			    (ssize_t)sizeof(val) || val[2] == 0) {
+			pc->valid[i] = false;
+		} else if (val[2] < val[1]) {
+			pc->count[i] = (uint64_t)((double)val[0] *
+						  (double)val[1] /
+						  (double)val[2]);
+		} else {
+			pc->count[i] = val[0];
+		}
+
+		close(pc->fd[i]);
+		pc->fd[i] = -1;
+	}
+}
+
+#else
+
+/*
+ * perf_events_parse -- parse list of events separated by semicolons
+ */
+int
+perf_events_parse(struct perf_events *events, const char *list)
+{
+	events->nevents = 0;
+	if (*list == '\0')
+		return 0;
+
+	fprintf(stderr, "perf events are not supported on this platform\n");
+	return -1;
+}
+
+/*
+ * perf_counters_start -- open and enable counters in the calling thread
+ */
+void
+perf_counters_start(struct perf_counters *pc)
+{
+	for (unsigned i = 0; i < pc->events->nevents; i++)
+		pc->valid[i] = false;
+}
+
+/*
+ * perf_counters_stop -- disable counters, read and close them
+ */
+void
+perf_counters_stop(struct perf_counters *pc)
+{
+}
+
+#endif
+
+/*
+ * perf_counters_alloc -- allocate counters of given events
+ */
+struct perf_counters *
+perf_counters_alloc(const struct perf_events *events)
+{
+	auto *pc = (struct perf_counters *)malloc(sizeof(struct perf_counters));
+	if (pc == nullptr)
+		return nullptr;
+
+	pc->events = events;
+	perf_counters_reset(pc);
+
+	return pc;
+}
+
+/*
+ * perf_counters_free -- release counters
+ */
+void
+perf_counters_free(struct perf_counters *pc)
+{
+	free(pc);
+}
+
+/*
+ * perf_counters_reset -- zero all counts and mark them as valid
+ */
+void
+perf_counters_reset(struct perf_counters *pc)
+{
+	for (unsigned i = 0; i < PERF_EVENTS_MAX; i++) {
+		pc->fd[i] = -1;
+		pc->count[i] = 0;
+		pc->valid[i] = true;
+	}
+}
+
+/*
+ * perf_counters_add -- add counts of src to dst
+ */
+void
+perf_counters_add(struct perf_counters *dst, const struct perf_counters *src)
+{
+	for (unsigned i = 0; i < dst->events->nevents; i++) {
+		dst->count[i] += src->count[i];
+		dst->valid[i] = dst->valid[i] && src->valid[i];
+	}
+}
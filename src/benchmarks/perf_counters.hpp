@@ -0,0 +1,83 @@
+/*
+ * Copyright 2018, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * perf_counters.hpp -- per-thread performance counters
+ */
+
+#ifndef PERF_COUNTERS_HPP
+#define PERF_COUNTERS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#define PERF_EVENTS_MAX 16
+#define PERF_EVENT_NAME_MAX 32
+
+/*
+ * struct perf_event_desc -- single event to count
+ */
+struct perf_event_desc {
+	char name[PERF_EVENT_NAME_MAX];
+	uint32_t type;
+	uint64_t config;
+};
+
+/*
+ * struct perf_events -- list of events to count in every worker thread
+ */
+struct perf_events {
+	unsigned nevents;
+	struct perf_event_desc desc[PERF_EVENTS_MAX];
+};
+
+/*
+ * struct perf_counters -- counters of a thread or sum of counters
+ */
+struct perf_counters {
+	const struct perf_events *events;
+	int fd[PERF_EVENTS_MAX];
+	uint64_t count[PERF_EVENTS_MAX];
+	bool valid[PERF_EVENTS_MAX]; /* event could be counted */
+};
+
+int perf_events_parse(struct perf_events *events, const char *list);
+
+struct perf_counters *perf_counters_alloc(const struct perf_events *events);
+void perf_counters_free(struct perf_counters *pc);
+void perf_counters_reset(struct perf_counters *pc);
+void perf_counters_start(struct perf_counters *pc);
+void perf_counters_stop(struct perf_counters *pc);
+void perf_counters_add(struct perf_counters *dst,
+		       const struct perf_counters *src);
+
+#endif
@@ -55,11 +55,16 @@
 #include "clo_vec.hpp"
 #include "config_reader.hpp"
 #include "file.h"
+#include "latency_hist.hpp"
 #include "libpmempool.h"
 #include "mmap.h"
 #include "os.h"
 #include "os_thread.h"
+#include "perf_counters.hpp"
+#include "poolset_util.hpp"
 #include "queue.h"
+#include "results_compare.hpp"
+#include "run_meta.hpp"
 #include "scenario.hpp"
 #include "set.h"
 #include "util.h"
@@ -83,6 +88,9 @@ struct pmembench {
 	struct scenario *scenario;
 	struct clo_vec *clovec;
 	bool override_clos;
+	struct run_meta meta; /* valid if meta_valid is set */
+	bool meta_valid;
+	bool csv_header; /* csv header has been printed */
 };
 
 /*
@@ -123,7 +131,7 @@ static struct version_s {
 static struct bench_list benchmarks;
 
 /* common arguments for benchmarks */
-static struct benchmark_clo pmembench_clos[13];
+static struct benchmark_clo pmembench_clos[15];
 
 /* list of arguments for pmembench */
 static struct benchmark_clo pmembench_opts[2];
@@ -294,6 +302,27 @@ pmembench_constructor(void)
 	pmembench_clos[12].off =
 		clo_field_offset(struct benchmark_args, is_dynamic_poolset);
 	pmembench_clos[12].ignore_in_res = true;
+
+	pmembench_clos[13].opt_long = "output-format";
+	pmembench_clos[13].type = CLO_TYPE_STR;
+	pmembench_clos[13].descr = "Format of results: text, csv or json";
+	pmembench_clos[13].off =
+		clo_field_offset(struct benchmark_args, output_format);
+	pmembench_clos[13].def = "text";
+	pmembench_clos[13].ignore_in_res = true;
+
+	pmembench_clos[14].opt_long = "perf-events";
+	pmembench_clos[14].type = CLO_TYPE_STR;
+	pmembench_clos[14].descr =
+		"Performance counters to read in worker threads, separated by "
+		"semicolon: default, cycles, instructions, llc-misses, "
+		"dtlb-misses, cache-references, cache-misses, branches, "
+		"branch-misses, task-clock, page-faults, context-switches, "
+		"cpu-migrations or r<hex> for a raw event";
+	pmembench_clos[14].off =
+		clo_field_offset(struct benchmark_args, perf_events);
+	pmembench_clos[14].def = "";
+	pmembench_clos[14].ignore_in_res = true;
 }
 
 /*
@@ -395,15 +424,184 @@ pmembench_merge_clos(struct benchmark *bench)
 static int
 pmembench_run_worker(struct benchmark *bench, struct worker_info *winfo)
 {
+	benchmark_time_t prev;
+	benchmark_time_t now;
+	benchmark_time_t lat;
+	int ret = 0;
+
+	if (winfo->perf)
+		perf_counters_start(winfo->perf);
+
 	benchmark_time_get(&winfo->beg);
+	prev = winfo->beg;
 	for (size_t i = 0; i < winfo->nops; i++) {
-		if (bench->info->operation(bench, &winfo->opinfo[i]))
-			return -1;
-		benchmark_time_get(&winfo->opinfo[i].end);
+		if (bench->info->operation(bench, &winfo->opinfo[i])) {
+			ret = -1;
+			break;
+		}
+		benchmark_time_get(&now);
+		benchmark_time_diff(&lat, &prev, &now);
+		latency_hist_record(winfo->hist,
+				    benchmark_time_get_nsecs(&lat));
+		prev = now;
 	}
-	benchmark_time_get(&winfo->end);
+	winfo->end = prev;
 
-	return 0;
+	if (winfo->perf)
+		perf_counters_stop(winfo->perf);
+
+	return ret;
+}
+
+/*
+ * output_format -- format of printed results
+ */
+enum output_format {
+	OUTPUT_FORMAT_TEXT,
+	OUTPUT_FORMAT_CSV,
+	OUTPUT_FORMAT_JSON,
+
+	OUTPUT_FORMAT_UNKNOWN
+};
+
+/*
+ * pmembench_output_format -- parse name of the output format
+ */
+static enum output_format
+pmembench_output_format(const char *name)
+{
+	if (strcmp(name, "text") == 0)
+		return OUTPUT_FORMAT_TEXT;
+	if (strcmp(name, "csv") == 0)
+		return OUTPUT_FORMAT_CSV;
+	if (strcmp(name, "json") == 0)
+		return OUTPUT_FORMAT_JSON;
+
+	return OUTPUT_FORMAT_UNKNOWN;
+}
+
+#define RESULT_FIELDS 15
+
+/* names of the result columns, in order of printing */
+static const char *result_names[RESULT_FIELDS] = {
+	"total-avg[sec]",
+	"ops-per-second[1/sec]",
+	"total-max[sec]",
+	"total-min[sec]",
+	"total-median[sec]",
+	"total-std-dev[sec]",
+	"latency-avg[nsec]",
+	"latency-min[nsec]",
+	"latency-max[nsec]",
+	"latency-std-dev[nsec]",
+	"latency-pctl-50.0%[nsec]",
+	"latency-pctl-99.0%[nsec]",
+	"latency-pctl-99.9%[nsec]",
+	"latency-pctl-99.99%[nsec]",
+	"latency-pctl-99.999%[nsec]",
+};
+
+/*
+ * struct result_value -- value of a single result column
+ */
+struct result_value {
+	bool is_double;
+	double dval;
+	uint64_t uval;
+};
+
+/*
+ * pmembench_result_values -- get values of all result columns
+ */
+static void
+pmembench_result_values(struct total_results *res, struct result_value *vals)
+{
+	const struct result_value values[RESULT_FIELDS] = {
+		{true, res->total.avg, 0},
+		{true, res->nopsps, 0},
+		{true, res->total.max, 0},
+		{true, res->total.min, 0},
+		{true, res->total.med, 0},
+		{true, res->total.std_dev, 0},
+		{false, 0.0, res->latency.avg},
+		{false, 0.0, res->latency.min},
+		{false, 0.0, res->latency.max},
+		{true, res->latency.std_dev, 0},
+		{false, 0.0, res->latency.pctl50_0p},
+		{false, 0.0, res->latency.pctl99_0p},
+		{false, 0.0, res->latency.pctl99_9p},
+		{false, 0.0, res->latency.pctl99_99p},
+		{false, 0.0, res->latency.pctl99_999p},
+	};
+
+	memcpy(vals, values, sizeof(values));
+}
+
+/*
+ * pmembench_print_value -- print value of a result column
+ */
+static void
+pmembench_print_value(const struct result_value *val, bool json)
+{
+	if (!val->is_double)
+		printf("%" PRIu64, val->uval);
+	else if (json && !std::isfinite(val->dval))
+		printf("null");
+	else
+		printf("%f", val->dval);
+}
+
+/*
+ * pmembench_print_csv_str -- print string as a csv field
+ */
+static void
+pmembench_print_csv_str(const char *str)
+{
+	if (strpbrk(str, ",\"\n") == nullptr) {
+		printf("%s", str);
+		return;
+	}
+
+	putchar('"');
+	for (; *str != '\0'; str++) {
+		if (*str == '"')
+			putchar('"');
+		putchar(*str);
+	}
+	putchar('"');
+}
+
+/*
+ * pmembench_print_json_str -- print string as a json string
+ */
+static void
+pmembench_print_json_str(const char *str)
+{
+	putchar('"');
+	for (; *str != '\0'; str++) {
+		unsigned char c = (unsigned char)*str;
+		if (c == '"' || c == '\\')
+			printf("\\%c", c);
+		else if (c < 0x20)
+			printf("\\u%04x", c);
+		else
+			putchar(c);
+	}
+	putchar('"');
+}
+
+/*
+ * pmembench_affinity_str -- describe worker threads affinity
+ */
+static const char *
+pmembench_affinity_str(struct benchmark_args *args)
+{
+	if (!args->thread_affinity)
+		return "none";
+	if (*args->affinity_list != '\0')
+		return args->affinity_list;
+
+	return "sequential";
 }
 
 /*
@@ -411,8 +609,29 @@ pmembench_run_worker(struct benchmark *bench, struct worker_info *winfo)
  */
 static void
 pmembench_print_header(struct pmembench *pb, struct benchmark *bench,
-		       struct clo_vec *clovec)
+		       struct clo_vec *clovec, enum output_format format,
+		       const struct perf_events *events)
 {
+	size_t i;
+
+	if (format == OUTPUT_FORMAT_JSON)
+		return;
+
+	if (format == OUTPUT_FORMAT_CSV) {
+		/* all benchmarks share the columns, print them once */
+		if (pb->csv_header)
+			return;
+		pb->csv_header = true;
+
+		printf("scenario,group,benchmark,repeats");
+		for (i = 0; i < RESULT_FIELDS; i++)
+			printf(",%s", result_names[i]);
+		printf(",bandwidth[MiB/s],args,cpu-model,isa,flush,"
+		       "cpu-cache-flush,memcpy,pool-type,is-pmem,"
+		       "thread-affinity,version,perf\n");
+		return;
+	}
+
 	if (pb->scenario) {
 		printf("%s: %s [%" PRIu64 "]%s%s%s\n", pb->scenario->name,
 		       bench->info->name, clovec->nargs,
@@ -422,20 +641,8 @@ pmembench_print_header(struct pmembench *pb, struct benchmark *bench,
 	} else {
 		printf("%s [%" PRIu64 "]\n", bench->info->name, clovec->nargs);
 	}
-	printf("total-avg[sec];"
-	       "ops-per-second[1/sec];"
-	       "total-max[sec];"
-	       "total-min[sec];"
-	       "total-median[sec];"
-	       "total-std-dev[sec];"
-	       "latency-avg[nsec];"
-	       "latency-min[nsec];"
-	       "latency-max[nsec];"
-	       "latency-std-dev[nsec];"
-	       "latency-pctl-50.0%%[nsec];"
-	       "latency-pctl-99.0%%[nsec];"
-	       "latency-pctl-99.9%%[nsec]");
-	size_t i;
+	for (i = 0; i < RESULT_FIELDS; i++)
+		printf("%s%s", i ? ";" : "", result_names[i]);
 	for (i = 0; i < bench->nclos; i++) {
 		if (!bench->clos[i].ignore_in_res) {
 			printf(";%s", bench->clos[i].opt_long);
@@ -445,27 +652,33 @@ pmembench_print_header(struct pmembench *pb, struct benchmark *bench,
 	if (bench->info->print_bandwidth)
 		printf(";bandwidth[MiB/s]");
 
+	for (unsigned e = 0; e < events->nevents; e++)
+		printf(";%s/op", events->desc[e].name);
+
 	if (bench->info->print_extra_headers)
 		bench->info->print_extra_headers();
 	printf("\n");
 }
 
 /*
- * pmembench_print_results -- print benchmark's results
+ * pmembench_print_results_text -- print benchmark's results as a line of
+ * semicolon separated values
  */
 static void
-pmembench_print_results(struct benchmark *bench, struct benchmark_args *args,
-			struct total_results *res)
+pmembench_print_results_text(struct benchmark *bench,
+			     struct benchmark_args *args,
+			     struct total_results *res)
 {
-	printf("%f;%f;%f;%f;%f;%f;%" PRIu64 ";%" PRIu64 ";%" PRIu64
-	       ";%f;%" PRIu64 ";%" PRIu64 ";%" PRIu64,
-	       res->total.avg, res->nopsps, res->total.max, res->total.min,
-	       res->total.med, res->total.std_dev, res->latency.avg,
-	       res->latency.min, res->latency.max, res->latency.std_dev,
-	       res->latency.pctl50_0p, res->latency.pctl99_0p,
-	       res->latency.pctl99_9p);
+	struct result_value vals[RESULT_FIELDS];
+	pmembench_result_values(res, vals);
 
 	size_t i;
+	for (i = 0; i < RESULT_FIELDS; i++) {
+		if (i)
+			putchar(';');
+		pmembench_print_value(&vals[i], false);
+	}
+
 	for (i = 0; i < bench->nclos; i++) {
 		if (!bench->clos[i].ignore_in_res)
 			printf(";%s", benchmark_clo_str(&bench->clos[i], args,
@@ -475,11 +688,195 @@ pmembench_print_results(struct benchmark *bench, struct benchmark_args *args,
 	if (bench->info->print_bandwidth)
 		printf(";%f", res->nopsps * args->dsize / 1024 / 1024);
 
+	for (unsigned e = 0; res->events && e < res->events->nevents; e++) {
+		if (std::isnan(res->perf[e]))
+			printf(";-");
+		else
+			printf(";%f", res->perf[e]);
+	}
+
 	if (bench->info->print_extra_values)
 		bench->info->print_extra_values(bench, args, res);
 	printf("\n");
 }
 
+/*
+ * pmembench_print_results_csv -- print benchmark's results and metadata as
+ * a csv row
+ */
+static void
+pmembench_print_results_csv(struct pmembench *pb, struct benchmark *bench,
+			    struct benchmark_args *args,
+			    struct total_results *res, struct pool_meta *pool)
+{
+	struct result_value vals[RESULT_FIELDS];
+	pmembench_result_values(res, vals);
+
+	pmembench_print_csv_str(pb->scenario ? pb->scenario->name : "");
+	putchar(',');
+	pmembench_print_csv_str(pb->scenario && pb->scenario->group
+					? pb->scenario->group
+					: "");
+	putchar(',');
+	pmembench_print_csv_str(bench->info->name);
+	printf(",%zu", res->nrepeats);
+
+	size_t i;
+	for (i = 0; i < RESULT_FIELDS; i++) {
+		putchar(',');
+		pmembench_print_value(&vals[i], false);
+	}
+
+	putchar(',');
+	if (bench->info->print_bandwidth)
+		printf("%f", res->nopsps * args->dsize / 1024 / 1024);
+
+	/* arguments are joined into a single field to keep columns fixed */
+	putchar(',');
+	bool quote = false;
+	for (i = 0; i < bench->nclos; i++) {
+		if (bench->clos[i].ignore_in_res)
+			continue;
+		const char *val = benchmark_clo_str(&bench->clos[i], args,
+						    bench->args_size);
+		quote = quote || strpbrk(val, ",\"\n") != nullptr;
+	}
+	if (quote)
+		putchar('"');
+	bool first = true;
+	for (i = 0; i < bench->nclos; i++) {
+		if (bench->clos[i].ignore_in_res)
+			continue;
+		const char *val = benchmark_clo_str(&bench->clos[i], args,
+						    bench->args_size);
+		printf("%s%s=", first ? "" : " ", bench->clos[i].opt_long);
+		for (; *val != '\0'; val++) {
+			if (quote && *val == '"')
+				putchar('"');
+			putchar(*val);
+		}
+		first = false;
+	}
+	if (quote)
+		putchar('"');
+
+	putchar(',');
+	pmembench_print_csv_str(pb->meta.cpu_model);
+	putchar(',');
+	pmembench_print_csv_str(pb->meta.isa);
+	printf(",%s,%s,%s,%s,", pb->meta.flush,
+	       pb->meta.cache_flush ? "yes" : "no", pb->meta.memcpy_impl,
+	       pool->type);
+	if (pool->is_pmem >= 0)
+		printf("%s", pool->is_pmem ? "yes" : "no");
+	putchar(',');
+	pmembench_print_csv_str(pmembench_affinity_str(args));
+	putchar(',');
+	pmembench_print_csv_str(pb->meta.version);
+
+	/* counters which could not be read are omitted */
+	putchar(',');
+	first = true;
+	for (unsigned e = 0; res->events && e < res->events->nevents; e++) {
+		if (std::isnan(res->perf[e]))
+			continue;
+		printf("%s%s/op=%f", first ? "" : " ",
+		       res->events->desc[e].name, res->perf[e]);
+		first = false;
+	}
+	printf("\n");
+}
+
+/*
+ * pmembench_print_results_json -- print benchmark's results and metadata as
+ * a single line json object
+ */
+static void
+pmembench_print_results_json(struct pmembench *pb, struct benchmark *bench,
+			     struct benchmark_args *args,
+			     struct total_results *res, struct pool_meta *pool)
+{
+	struct result_value vals[RESULT_FIELDS];
+	pmembench_result_values(res, vals);
+
+	printf("{\"scenario\":");
+	pmembench_print_json_str(pb->scenario ? pb->scenario->name : "");
+	printf(",\"group\":");
+	pmembench_print_json_str(pb->scenario && pb->scenario->group
+					 ? pb->scenario->group
+					 : "");
+	printf(",\"benchmark\":");
+	pmembench_print_json_str(bench->info->name);
+	printf(",\"repeats\":%zu", res->nrepeats);
+
+	printf(",\"results\":{");
+	size_t i;
+	for (i = 0; i < RESULT_FIELDS; i++) {
+		printf("%s\"%s\":", i ? "," : "", result_names[i]);
+		pmembench_print_value(&vals[i], true);
+	}
+	if (bench->info->print_bandwidth) {
+		struct result_value bw = {
+			true, res->nopsps * args->dsize / 1024 / 1024, 0};
+		printf(",\"bandwidth[MiB/s]\":");
+		pmembench_print_value(&bw, true);
+	}
+	for (unsigned e = 0; res->events && e < res->events->nevents; e++) {
+		struct result_value val = {true, res->perf[e], 0};
+		printf(",\"%s/op\":", res->events->desc[e].name);
+		pmembench_print_value(&val, true);
+	}
+
+	printf("},\"args\":{");
+	bool first = true;
+	for (i = 0; i < bench->nclos; i++) {
+		if (bench->clos[i].ignore_in_res)
+			continue;
+		printf("%s\"%s\":", first ? "" : ",", bench->clos[i].opt_long);
+		pmembench_print_json_str(benchmark_clo_str(
+			&bench->clos[i], args, bench->args_size));
+		first = false;
+	}
+
+	printf("},\"meta\":{\"cpu-model\":");
+	pmembench_print_json_str(pb->meta.cpu_model);
+	printf(",\"isa\":");
+	pmembench_print_json_str(pb->meta.isa);
+	printf(",\"flush\":\"%s\",\"cpu-cache-flush\":%s,\"memcpy\":\"%s\","
+	       "\"pool-type\":\"%s\",\"is-pmem\":%s,\"thread-affinity\":",
+	       pb->meta.flush, pb->meta.cache_flush ? "true" : "false",
+	       pb->meta.memcpy_impl, pool->type,
+	       pool->is_pmem < 0 ? "null" : pool->is_pmem ? "true" : "false");
+	pmembench_print_json_str(pmembench_affinity_str(args));
+	printf(",\"version\":");
+	pmembench_print_json_str(pb->meta.version);
+	printf("}}\n");
+}
+
+/*
+ * pmembench_print_results -- print benchmark's results
+ */
+static void
+pmembench_print_results(struct pmembench *pb, struct benchmark *bench,
+			struct benchmark_args *args, struct total_results *res,
+			enum output_format format)
+{
+	if (format == OUTPUT_FORMAT_TEXT) {
+		pmembench_print_results_text(bench, args, res);
+		return;
+	}
+
+	/* dynamic poolsets are created in the working directory */
+	struct pool_meta pool;
+	run_meta_pool(args->is_dynamic_poolset ? POOLSET_PATH : args->fname,
+		      &pool);
+
+	if (format == OUTPUT_FORMAT_CSV)
+		pmembench_print_results_csv(pb, bench, args, res, &pool);
+	else
+		pmembench_print_results_json(pb, bench, args, res, &pool);
+}
+
 /*
  * pmembench_parse_clos -- parse command line arguments for benchmark
  */
@@ -565,7 +962,8 @@ err:
 static int
 pmembench_init_workers(struct benchmark_worker **workers, size_t nworkers,
 		       size_t n_ops, struct benchmark *bench,
-		       struct benchmark_args *args)
+		       struct benchmark_args *args,
+		       const struct perf_events *events)
 {
 	size_t i;
 	int ncpus = 0;
@@ -620,6 +1018,16 @@ pmembench_init_workers(struct benchmark_worker **workers, size_t nworkers,
 			workers[i]->info.opinfo[j].args = args;
 			workers[i]->info.opinfo[j].index = j;
 		}
+		workers[i]->info.hist = latency_hist_alloc();
+		workers[i]->info.perf = nullptr;
+		if (events) {
+			workers[i]->info.perf = perf_counters_alloc(events);
+			if (workers[i]->info.perf == nullptr) {
+				perror("perf_counters_alloc");
+				ret = -1;
+				goto end;
+			}
+		}
 		workers[i]->bench = bench;
 		workers[i]->args = args;
 		workers[i]->func = pmembench_run_worker;
@@ -638,15 +1046,17 @@ end:
  */
 static void
 results_store(struct bench_results *res, struct benchmark_worker **workers,
-	      unsigned nthreads, size_t nops)
+	      unsigned nthreads)
 {
+	latency_hist_reset(res->hist);
+	if (res->perf)
+		perf_counters_reset(res->perf);
 	for (unsigned i = 0; i < nthreads; i++) {
 		res->thres[i]->beg = workers[i]->info.beg;
 		res->thres[i]->end = workers[i]->info.end;
-		for (size_t j = 0; j < nops; j++) {
-			res->thres[i]->end_op[j] =
-				workers[i]->info.opinfo[j].end;
-		}
+		latency_hist_merge(res->hist, workers[i]->info.hist);
+		if (res->perf)
+			perf_counters_add(res->perf, workers[i]->info.perf);
 	}
 }
 
@@ -674,21 +1084,29 @@ compare_doubles(const void *a1, const void *b1)
 }
 
 /*
-* compare_uint64t -- comparing function used for sorting
-*/
-static int
-compare_uint64t(const void *a1, const void *b1)
+ * results_free -- release results structure
+ */
+static void
+results_free(struct total_results *total)
 {
-	const auto *a = (const uint64_t *)a1;
-	const auto *b = (const uint64_t *)b1;
-	return (*a > *b) - (*a < *b);
+	for (size_t i = 0; i < total->nrepeats; i++) {
+		for (size_t j = 0; j < total->nthreads; j++)
+			free(total->res[i].thres[j]);
+		free(total->res[i].thres);
+		latency_hist_free(total->res[i].hist);
+		perf_counters_free(total->res[i].perf);
+	}
+	free(total->res);
+	free(total->perf);
+	free(total);
 }
 
 /*
  * results_alloc -- prepare structure to store all benchmark results
  */
 static struct total_results *
-results_alloc(size_t nrepeats, size_t nthreads, size_t nops)
+results_alloc(size_t nrepeats, size_t nthreads, size_t nops,
+	      const struct perf_events *events)
 {
 	struct total_results *total =
 		(struct total_results *)malloc(sizeof(*total));
@@ -696,6 +1114,13 @@ results_alloc(size_t nrepeats, size_t nthreads, size_t nops)
 	total->nrepeats = nrepeats;
 	total->nthreads = nthreads;
 	total->nops = nops;
+	total->events = events;
+	total->perf = nullptr;
+	if (events) {
+		total->perf =
+			(double *)malloc(events->nevents * sizeof(double));
+		assert(total->perf != nullptr);
+	}
 	total->res =
 		(struct bench_results *)malloc(nrepeats * sizeof(*total->res));
 	assert(total->res != nullptr);
@@ -708,30 +1133,25 @@ results_alloc(size_t nrepeats, size_t nthreads, size_t nops)
 		assert(res->thres != nullptr);
 		for (size_t j = 0; j < nthreads; j++) {
 			res->thres[j] = (struct thread_results *)malloc(
-				sizeof(*res->thres[j]) +
-				nops * sizeof(benchmark_time_t));
+				sizeof(*res->thres[j]));
 			assert(res->thres[j] != nullptr);
 		}
+		res->hist = latency_hist_alloc();
+		res->perf = nullptr;
+		if (events) {
+			res->perf = perf_counters_alloc(events);
+			if (res->perf == nullptr) {
+				perror("perf_counters_alloc");
+				total->nrepeats = i + 1;
+				results_free(total);
+				return nullptr;
+			}
+		}
 	}
 
 	return total;
 }
 
-/*
- * results_free -- release results structure
- */
-static void
-results_free(struct total_results *total)
-{
-	for (size_t i = 0; i < total->nrepeats; i++) {
-		for (size_t j = 0; j < total->nthreads; j++)
-			free(total->res[i].thres[j]);
-		free(total->res[i].thres);
-	}
-	free(total->res);
-	free(total);
-}
-
 /*
  * get_total_results -- return results of all repeats of scenario
  */
@@ -748,8 +1168,6 @@ get_total_results(struct total_results *tres)
 
 	tres->total.min = DBL_MAX;
 	tres->total.max = DBL_MIN;
-	tres->latency.min = UINT64_MAX;
-	tres->latency.max = 0;
 
 	/* allocate helper arrays */
 	benchmark_time_t *tbeg =
@@ -831,76 +1249,33 @@ get_total_results(struct total_results *tres)
 
 	tres->total.std_dev = sqrt(tres->total.std_dev / tres->nrepeats);
 
-	/* latency */
-	for (size_t i = 0; i < tres->nrepeats; i++) {
-		struct bench_results *res = &tres->res[i];
-		for (size_t j = 0; j < tres->nthreads; j++) {
-			struct thread_results *thres = res->thres[j];
-			benchmark_time_t *beg = &thres->beg;
-			for (size_t o = 0; o < tres->nops; o++) {
-				benchmark_time_t lat;
-				benchmark_time_diff(&lat, beg,
-						    &thres->end_op[o]);
-				uint64_t nsecs = benchmark_time_get_nsecs(&lat);
-
-				/* min, max latency */
-				if (nsecs > tres->latency.max)
-					tres->latency.max = nsecs;
-				if (nsecs < tres->latency.min)
-					tres->latency.min = nsecs;
-
-				tres->latency.avg += nsecs;
-
-				beg = &thres->end_op[o];
-			}
+	/* latency of all operations of all threads and repeats */
+	struct latency_hist *hist = latency_hist_alloc();
+	for (size_t i = 0; i < tres->nrepeats; i++)
+		latency_hist_merge(hist, tres->res[i].hist);
+
+	assert(hist->count > 0);
+	tres->latency.min = hist->min;
+	tres->latency.max = hist->max;
+	tres->latency.avg = latency_hist_avg(hist);
+	tres->latency.std_dev = latency_hist_std_dev(hist);
+	tres->latency.pctl50_0p = latency_hist_pctl(hist, 50.0);
+	tres->latency.pctl99_0p = latency_hist_pctl(hist, 99.0);
+	tres->latency.pctl99_9p = latency_hist_pctl(hist, 99.9);
+	tres->latency.pctl99_99p = latency_hist_pctl(hist, 99.99);
+	tres->latency.pctl99_999p = latency_hist_pctl(hist, 99.999);
+
+	/* performance counters per operation */
+	for (unsigned e = 0; tres->events && e < tres->events->nevents; e++) {
+		uint64_t sum = 0;
+		bool valid = true;
+		for (size_t i = 0; i < tres->nrepeats; i++) {
+			sum += tres->res[i].perf->count[e];
+			valid = valid && tres->res[i].perf->valid[e];
 		}
+		tres->perf[e] = valid ? (double)sum / (double)hist->count : NAN;
 	}
-
-	/* average latency */
-	size_t count = tres->nrepeats * tres->nthreads * tres->nops;
-	assert(count > 0);
-	tres->latency.avg /= count;
-
-	auto *ntotals = (uint64_t *)calloc(count, sizeof(uint64_t));
-	assert(ntotals != nullptr);
-	count = 0;
-
-	/* std deviation of latency and percentiles */
-	for (size_t i = 0; i < tres->nrepeats; i++) {
-		struct bench_results *res = &tres->res[i];
-		for (size_t j = 0; j < tres->nthreads; j++) {
-			struct thread_results *thres = res->thres[j];
-			benchmark_time_t *beg = &thres->beg;
-			for (size_t o = 0; o < tres->nops; o++) {
-				benchmark_time_t lat;
-				benchmark_time_diff(&lat, beg,
-						    &thres->end_op[o]);
-				uint64_t nsecs = benchmark_time_get_nsecs(&lat);
-
-				uint64_t dev = (nsecs - tres->latency.avg);
-				dev *= dev;
-
-				tres->latency.std_dev += dev;
-
-				beg = &thres->end_op[o];
-
-				ntotals[count] = nsecs;
-				++count;
-			}
-		}
-	}
-
-	tres->latency.std_dev = sqrt(tres->latency.std_dev / count);
-
-	/* find 50%, 99.0% and 99.9% percentiles */
-	qsort(ntotals, count, sizeof(uint64_t), compare_uint64t);
-	uint64_t p50_0 = count * 50 / 100;
-	uint64_t p99_0 = count * 99 / 100;
-	uint64_t p99_9 = count * 999 / 1000;
-	tres->latency.pctl50_0p = ntotals[p50_0];
-	tres->latency.pctl99_0p = ntotals[p99_0];
-	tres->latency.pctl99_9p = ntotals[p99_9];
-	free(ntotals);
+	latency_hist_free(hist);
 
 	free(totals);
 	free(tend);
@@ -967,6 +1342,8 @@ pmembench_print_usage()
 	       "\t[<benchmark>[<args>]]\n");
 	printf("\t\t\t\t\t\t[<config>[<scenario>]]\n");
 	printf("\t\t\t\t\t\t[<config>[<scenario>[<common_args>]]]\n");
+	printf("\t\t\t\t\t\t[compare [--threshold=<percent>] "
+	       "<baseline.csv> <new.csv>]\n");
 }
 
 /*
@@ -1001,6 +1378,11 @@ pmembench_print_examples()
 	       "<name_of_scenario_2> <common_args>\n");
 	printf(" # runs the specified scenarios from config file and overwrites"
 	       " the given common_args from the config file\n");
+	printf("or\n");
+	printf("$ pmembench compare [--threshold=<percent>] <baseline.csv> "
+	       "<new.csv>\n");
+	printf(" # compares results printed with --output-format=csv and "
+	       "flags significant regressions\n");
 }
 
 /*
@@ -1175,7 +1557,9 @@ pmembench_single_repeat(struct benchmark *bench, struct benchmark_args *args,
 	assert(workers != nullptr);
 
 	if ((ret = pmembench_init_workers(workers, n_threads, n_ops, bench,
-					  args)) != 0) {
+					  args,
+					  res->perf ? res->perf->events
+						    : nullptr)) != 0) {
 		goto out;
 	}
 
@@ -1192,12 +1576,14 @@ pmembench_single_repeat(struct benchmark *bench, struct benchmark_args *args,
 		}
 	}
 
-	results_store(res, workers, args->n_threads, args->n_ops_per_thread);
+	results_store(res, workers, args->n_threads);
 
 	for (j = 0; j < args->n_threads; j++) {
 		benchmark_worker_exit(workers[j]);
 
 		free(workers[j]->info.opinfo);
+		latency_hist_free(workers[j]->info.hist);
+		perf_counters_free(workers[j]->info.perf);
 		benchmark_worker_free(workers[j]);
 	}
 
@@ -1243,10 +1629,12 @@ scale_up_min_exe_time(struct benchmark *bench, struct benchmark_args *args,
 				 total_res->total.min);
 		args->n_ops_per_thread = n_ops;
 
+		const struct perf_events *events = total_res->events;
 		results_free(total_res);
 		*total_results = results_alloc(args->repeats, args->n_threads,
-					       args->n_ops_per_thread);
-		assert(*total_results != nullptr);
+					       args->n_ops_per_thread, events);
+		if (*total_results == nullptr)
+			return -1;
 		total_res = *total_results;
 		total_res->nrepeats = 1;
 	} while (1);
@@ -1283,6 +1671,7 @@ pmembench_run(struct pmembench *pb, struct benchmark *bench)
 	double *workers_times = nullptr;
 
 	struct clo_vec *clovec = nullptr;
+	struct perf_events events;
 
 	assert(bench->info != nullptr);
 	pmembench_merge_clos(bench);
@@ -1354,7 +1743,27 @@ pmembench_run(struct pmembench *pb, struct benchmark *bench)
 		goto out;
 	}
 
-	pmembench_print_header(pb, bench, clovec);
+	enum output_format format;
+	format = pmembench_output_format(args->output_format);
+	if (format == OUTPUT_FORMAT_UNKNOWN) {
+		fprintf(stderr, "unknown output format: %s\n",
+			args->output_format);
+		ret = -1;
+		goto out;
+	}
+
+	/* counted events are common for all sets of arguments */
+	if (perf_events_parse(&events, args->perf_events)) {
+		ret = -1;
+		goto out;
+	}
+
+	if (format != OUTPUT_FORMAT_TEXT && !pb->meta_valid) {
+		run_meta_get(&pb->meta);
+		pb->meta_valid = true;
+	}
+
+	pmembench_print_header(pb, bench, clovec, format, &events);
 
 	size_t args_i;
 	for (args_i = 0; args_i < clovec->nargs; args_i++) {
@@ -1422,8 +1831,12 @@ pmembench_run(struct pmembench *pb, struct benchmark *bench)
 						 sizeof(double));
 		assert(workers_times != nullptr);
 		total_res = results_alloc(args->repeats, args->n_threads,
-					  args->n_ops_per_thread);
-		assert(total_res != nullptr);
+					  args->n_ops_per_thread,
+					  events.nevents ? &events : nullptr);
+		if (total_res == nullptr) {
+			ret = -1;
+			goto out;
+		}
 
 		unsigned i = 0;
 		if (args->min_exe_time != 0 && bench->info->multiops) {
@@ -1444,7 +1857,13 @@ pmembench_run(struct pmembench *pb, struct benchmark *bench)
 		}
 
 		get_total_results(total_res);
-		pmembench_print_results(bench, args, total_res);
+		pmembench_print_results(pb, bench, args, total_res, format);
+
+		for (unsigned e = 0; e < events.nevents; e++) {
+			if (std::isnan(total_res->perf[e]))
+				fprintf(stderr, "perf event %s not available\n",
+					events.desc[e].name);
+		}
 
 		args->n_ops_per_thread = n_ops_per_thread_copy;
 
@@ -1626,6 +2045,8 @@ main(int argc, char *argv[])
 	bench = pmembench_get_bench(bench_name);
 	if (nullptr != bench)
 		ret = pmembench_run(pb, bench);
+	else if (strcmp(bench_name, "compare") == 0)
+		ret = results_compare(pb->argc - 1, pb->argv + 1);
 	else if (fexists)
 		ret = pmembench_run_config(pb, bench_name);
 	else if ((ret = pmembench_parse_opts(pb)) != 0) {
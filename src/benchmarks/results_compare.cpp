@@ -0,0 +1,487 @@
+/*
+ * Copyright 2018, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * results_compare.cpp -- comparison of two pmembench result files
+ *
+ * Both files have to be produced with --output-format=csv. Results are
+ * matched by scenario, benchmark and arguments. A result is reported as a
+ * regression when its throughput dropped by more than the threshold and
+ * the difference of the mean execution times is significant according to
+ * the one-sided Welch's t-test at the 95% confidence level. Results of fewer
+ * than 2 repeats or without any variance cannot be tested, so their changes
+ * are reported as insufficient-repeats and never count as regressions.
+ */
+
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "results_compare.hpp"
+
+#define CSV_LINE_MAX 16384
+#define CSV_FIELDS_MAX 64
+
+/*
+ * struct cmp_row -- single result read from a file
+ */
+struct cmp_row {
+	char *scenario;
+	char *benchmark;
+	char *args;
+	unsigned repeats;
+	double total_avg;
+	double total_std_dev;
+	double nopsps;
+	char *pctl99;
+};
+
+/*
+ * struct cmp_file -- all results read from a file
+ */
+struct cmp_file {
+	struct cmp_row *rows;
+	size_t nrows;
+};
+
+/*
+ * columns of the csv output the comparison depends on
+ */
+enum cmp_column {
+	COL_SCENARIO,
+	COL_BENCHMARK,
+	COL_ARGS,
+	COL_REPEATS,
+	COL_TOTAL_AVG,
+	COL_TOTAL_STD_DEV,
+	COL_NOPSPS,
+	COL_PCTL99,
+
+	COL_MAX
+};
+
+static const char *cmp_column_names[COL_MAX] = {
+	"scenario",
+	"benchmark",
+	"args",
+	"repeats",
+	"total-avg[sec]",
+	"total-std-dev[sec]",
+	"ops-per-second[1/sec]",
+	"latency-pctl-99.0%[nsec]",
+};
+
+/*
+ * t_crit -- one-sided critical values of Student's t-distribution at the
+ * 95% confidence level for 1 to 30 degrees of freedom
+ */
+static const double t_crit[] = {
+	6.314, 2.920, 2.353, 2.132, 2.015, 1.943, 1.895, 1.860, 1.833, 1.812,
+	1.796, 1.782, 1.771, 1.761, 1.753, 1.746, 1.740, 1.734, 1.729, 1.725,
+	1.721, 1.717, 1.714, 1.711, 1.708, 1.706, 1.703, 1.701, 1.699, 1.697,
+};
+
+/*
+ * csv_split -- (internal) split csv line into fields in place
+ */
+static size_t
+csv_split(char *line, char **fields, size_t max)
+{
+	size_t n = 0;
+	char *src = line;
+
+	line[strcspn(line, "\r\n")] = '\0';
+	while (n < max) {
+		char *dst = src;
+		fields[n++] = dst;
+		if (*src == '"') {
+			src++;
+			while (*src != '\0') {
+				if (*src == '"' && src[1] == '"') {
+					*dst++ = '"';
+					src += 2;
+				} else if (*src == '"') {
+					src++;
+					break;
+				} else {
+					*dst++ = *src++;
+				}
+			}
+		} else {
+			while (*src != '\0' && *src != ',')
+				*dst++ = *src++;
+		}
+
+		if (*src != ',') {
+			*dst = '\0';
+			break;
+		}
+		src++;
+		*dst = '\0';
+	}
+
+	return n;
+}
+
+/*
+ * cmp_parse_uint -- (internal) parse an unsigned integer field
+ */
+static int
+cmp_parse_uint(const char *field, unsigned *value)
+{
+	char *end;
+	errno = 0;
+	unsigned long long v = strtoull(field, &end, 10);
+	if (errno || end == field || *end != '\0' || v > UINT_MAX ||
+	    strchr(field, '-') != nullptr)
+		return -1;
+
+	*value = (unsigned)v;
+	return 0;
+}
+
+/*
+ * cmp_parse_double -- (internal) parse a non-negative floating point field
+ */
+static int
+cmp_parse_double(const char *field, double *value)
+{
+	char *end;
+	errno = 0;
+	double v = strtod(field, &end);
+	if (errno || end == field || *end != '\0' || !(v >= 0.0))
+		return -1;
+
+	*value = v;
+	return 0;
+}
+
+/*
+ * cmp_file_free -- (internal) release results read from a file
+ */
+static void
+cmp_file_free(struct cmp_file *file)
+{
+	for (size_t i = 0; i < file->nrows; i++) {
+		free(file->rows[i].scenario);
+		free(file->rows[i].benchmark);
+		free(file->rows[i].args);
+		free(file->rows[i].pctl99);
+	}
+	free(file->rows);
+	file->rows = nullptr;
+	file->nrows = 0;
+}
+
+/*
+ * cmp_file_read -- (internal) read all results from a csv file
+ */
+static int
+cmp_file_read(const char *path, struct cmp_file *file)
+{
+	file->rows = nullptr;
+	file->nrows = 0;
+
+	FILE *fp = fopen(path, "r");
+	if (fp == nullptr) {
+		perror(path);
+		return -1;
+	}
+
+	char *line = (char *)malloc(CSV_LINE_MAX);
+	char *fields[CSV_FIELDS_MAX];
+	size_t cols[COL_MAX];
+	size_t nfields;
+	bool header = false;
+	int ret = -1;
+
+	if (line == nullptr) {
+		perror("malloc");
+		goto out;
+	}
+
+	while (fgets(line, CSV_LINE_MAX, fp) != nullptr) {
+		if (strchr(line, '\n') == nullptr && !feof(fp)) {
+			fprintf(stderr, "%s: line too long\n", path);
+			goto out;
+		}
+
+		nfields = csv_split(line, fields, CSV_FIELDS_MAX);
+
+		/* each pmembench run starts with its own header */
+		if (strcmp(fields[0], cmp_column_names[COL_SCENARIO]) == 0) {
+			for (size_t c = 0; c < COL_MAX; c++) {
+				cols[c] = nfields;
+				for (size_t f = 0; f < nfields; f++) {
+					if (strcmp(fields[f],
+						   cmp_column_names[c]) == 0)
+						cols[c] = f;
+				}
+				if (cols[c] == nfields) {
+					fprintf(stderr, "%s: missing column "
+							"%s\n",
+						path, cmp_column_names[c]);
+					goto out;
+				}
+			}
+			header = true;
+			continue;
+		}
+
+		if (!header) {
+			fprintf(stderr, "%s: not a pmembench csv file\n",
+				path);
+			goto out;
+		}
+
+		bool short_row = false;
+		for (size_t c = 0; c < COL_MAX; c++)
+			short_row = short_row || cols[c] >= nfields;
+		if (short_row) {
+			fprintf(stderr, "%s: invalid row\n", path);
+			goto out;
+		}
+
+		struct cmp_row *rows = (struct cmp_row *)realloc(
+			file->rows, (file->nrows + 1) * sizeof(*rows));
+		if (rows == nullptr) {
+			perror("realloc");
+			goto out;
+		}
+		file->rows = rows;
+
+		struct cmp_row *row = &rows[file->nrows++];
+		row->scenario = strdup(fields[cols[COL_SCENARIO]]);
+		row->benchmark = strdup(fields[cols[COL_BENCHMARK]]);
+		row->args = strdup(fields[cols[COL_ARGS]]);
+		row->pctl99 = strdup(fields[cols[COL_PCTL99]]);
+		if (row->scenario == nullptr || row->benchmark == nullptr ||
+		    row->args == nullptr || row->pctl99 == nullptr) {
+			perror("strdup");
+			goto out;
+		}
+
+		if (cmp_parse_uint(fields[cols[COL_REPEATS]],
+				   &row->repeats) ||
+		    cmp_parse_double(fields[cols[COL_TOTAL_AVG]],
+				     &row->total_avg) ||
+		    cmp_parse_double(fields[cols[COL_TOTAL_STD_DEV]],
+				     &row->total_std_dev) ||
+		    cmp_parse_double(fields[cols[COL_NOPSPS]],
+				     &row->nopsps)) {
+			fprintf(stderr, "%s: invalid value in row of %s\n",
+				path, row->benchmark);
+			goto out;
+		}
+	}
+
+	if (ferror(fp)) {
+		perror(path);
+		goto out;
+	}
+
+	ret = 0;
+out:
+	if (ret)
+		cmp_file_free(file);
+	free(line);
+	fclose(fp);
+	return ret;
+}
+
+/*
+ * cmp_row_find -- (internal) find result of the same benchmark and arguments
+ */
+static struct cmp_row *
+cmp_row_find(struct cmp_file *file, struct cmp_row *row)
+{
+	for (size_t i = 0; i < file->nrows; i++) {
+		struct cmp_row *r = &file->rows[i];
+		if (strcmp(r->scenario, row->scenario) == 0 &&
+		    strcmp(r->benchmark, row->benchmark) == 0 &&
+		    strcmp(r->args, row->args) == 0)
+			return r;
+	}
+
+	return nullptr;
+}
+
+/*
+ * enum cmp_result -- outcome of the significance test
+ */
+enum cmp_result {
+	CMP_NOT_SIGNIFICANT,
+	CMP_SIGNIFICANT,
+	CMP_INSUFFICIENT, /* too few repeats or no variance to judge */
+};
+
+/*
+ * cmp_significant -- (internal) check whether the execution time of new is
+ * longer (dir > 0) or shorter (dir < 0) than of old with 95% confidence
+ */
+static enum cmp_result
+cmp_significant(struct cmp_row *old, struct cmp_row *cur, int dir)
+{
+	double diff = (cur->total_avg - old->total_avg) * dir;
+	if (diff <= 0.0)
+		return CMP_NOT_SIGNIFICANT;
+
+	/* reported deviations are population ones */
+	double n1 = old->repeats;
+	double n2 = cur->repeats;
+	if (n1 < 2 || n2 < 2)
+		return CMP_INSUFFICIENT;
+
+	double v1 = old->total_std_dev * old->total_std_dev / (n1 - 1);
+	double v2 = cur->total_std_dev * cur->total_std_dev / (n2 - 1);
+	double se2 = v1 + v2;
+	if (se2 == 0.0)
+		return CMP_INSUFFICIENT;
+
+	double t = diff / sqrt(se2);
+	double df = se2 * se2 /
+		(v1 * v1 / (n1 - 1) + v2 * v2 / (n2 - 1));
+
+	double crit = 1.645;
+	if (df < 1.0)
+		crit = t_crit[0];
+	else if (df <= 30.0)
+		crit = t_crit[(size_t)df - 1];
+
+	return t > crit ? CMP_SIGNIFICANT : CMP_NOT_SIGNIFICANT;
+}
+
+/*
+ * results_compare_usage -- (internal) print usage of the compare mode
+ */
+static void
+results_compare_usage(void)
+{
+	printf("Usage: $ pmembench compare [--threshold=<percent>] "
+	       "<baseline.csv> <new.csv>\n");
+}
+
+/*
+ * results_compare -- compare results of two pmembench runs, returns 1 if any
+ * regression was found, 0 if none and -1 on error
+ */
+int
+results_compare(int argc, char *argv[])
+{
+	double threshold = RESULTS_COMPARE_THRESHOLD;
+	const char *prefix = "--threshold=";
+
+	if (argc > 0 && strncmp(argv[0], prefix, strlen(prefix)) == 0) {
+		char *end;
+		errno = 0;
+		threshold = strtod(argv[0] + strlen(prefix), &end);
+		if (errno || *end != '\0' || threshold < 0.0) {
+			fprintf(stderr, "invalid threshold: %s\n", argv[0]);
+			return -1;
+		}
+		argc--;
+		argv++;
+	}
+
+	if (argc != 2) {
+		results_compare_usage();
+		return -1;
+	}
+
+	struct cmp_file base;
+	struct cmp_file cur;
+	if (cmp_file_read(argv[0], &base))
+		return -1;
+	if (cmp_file_read(argv[1], &cur)) {
+		cmp_file_free(&base);
+		return -1;
+	}
+
+	int nregressions = 0;
+
+	printf("scenario;benchmark;args;ops-per-second-base[1/sec];"
+	       "ops-per-second-new[1/sec];change[%%];"
+	       "latency-pctl-99.0%%-base[nsec];"
+	       "latency-pctl-99.0%%-new[nsec];status\n");
+
+	for (size_t i = 0; i < cur.nrows; i++) {
+		struct cmp_row *row = &cur.rows[i];
+		struct cmp_row *old = cmp_row_find(&base, row);
+		if (old == nullptr) {
+			printf("%s;%s;%s;;%f;;;%s;new\n", row->scenario,
+			       row->benchmark, row->args, row->nopsps,
+			       row->pctl99);
+			continue;
+		}
+
+		double change = 0.0;
+		if (old->nopsps > 0.0)
+			change = (row->nopsps - old->nopsps) * 100.0 /
+				old->nopsps;
+
+		enum cmp_result res = CMP_NOT_SIGNIFICANT;
+		const char *status = "unchanged";
+		if (change < -threshold) {
+			res = cmp_significant(old, row, 1);
+			if (res == CMP_SIGNIFICANT) {
+				status = "regression";
+				nregressions++;
+			}
+		} else if (change > threshold) {
+			res = cmp_significant(old, row, -1);
+			if (res == CMP_SIGNIFICANT)
+				status = "improvement";
+		}
+		if (res == CMP_INSUFFICIENT)
+			status = "insufficient-repeats";
+
+		printf("%s;%s;%s;%f;%f;%.2f;%s;%s;%s\n", row->scenario,
+		       row->benchmark, row->args, old->nopsps, row->nopsps,
+		       change, old->pctl99, row->pctl99, status);
+	}
+
+	for (size_t i = 0; i < base.nrows; i++) {
+		struct cmp_row *old = &base.rows[i];
+		if (cmp_row_find(&cur, old) == nullptr)
+			printf("%s;%s;%s;%f;;;%s;;missing\n", old->scenario,
+			       old->benchmark, old->args, old->nopsps,
+			       old->pctl99);
+	}
+
+	cmp_file_free(&cur);
+	cmp_file_free(&base);
+
+	return nregressions ? 1 : 0;
+}
@@ -0,0 +1,316 @@
+/*
+ * Copyright 2018, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * run_meta.cpp -- description of the platform and pool a benchmark ran on
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+
+#include "file.h"
+#include "libpmem.h"
+#include "os.h"
+#include "run_meta.hpp"
+#include "set.h"
+
+/* XXX - modify Linux makefiles to generate srcversion.h and remove #ifdef */
+#ifdef _WIN32
+#include "srcversion.h"
+#endif
+
+#define EAX_IDX 0
+#define EBX_IDX 1
+#define ECX_IDX 2
+#define EDX_IDX 3
+
+#if defined(__x86_64__) || defined(__amd64__)
+
+#include <cpuid.h>
+
+#define RUN_META_CPUID 1
+
+static inline void
+cpuid(unsigned func, unsigned subfunc, unsigned cpuinfo[4])
+{
+	__cpuid_count(func, subfunc, cpuinfo[EAX_IDX], cpuinfo[EBX_IDX],
+		      cpuinfo[ECX_IDX], cpuinfo[EDX_IDX]);
+}
+
+#elif defined(_M_X64) || defined(_M_AMD64)
+
+#include <intrin.h>
+
+#define RUN_META_CPUID 1
+
+static inline void
+cpuid(unsigned func, unsigned subfunc, unsigned cpuinfo[4])
+{
+	__cpuidex((int *)cpuinfo, (int)func, (int)subfunc);
+}
+
+#endif
+
+#ifdef RUN_META_CPUID
+
+/*
+ * cpu_feature -- (internal) checks if CPU feature is supported
+ */
+static bool
+cpu_feature(unsigned func, unsigned reg, unsigned bit)
+{
+	unsigned cpuinfo[4] = {0};
+
+	cpuid(func & 0x80000000, 0x0, cpuinfo);
+	if (cpuinfo[EAX_IDX] < func)
+		return false;
+
+	cpuid(func, 0x0, cpuinfo);
+	return (cpuinfo[reg] & bit) != 0;
+}
+
+/*
+ * cpu_model -- (internal) read processor brand string
+ */
+static void
+cpu_model(char *model)
+{
+	unsigned cpuinfo[4] = {0};
+
+	cpuid(0x80000000, 0x0, cpuinfo);
+	if (cpuinfo[EAX_IDX] < 0x80000004)
+		return;
+
+	for (unsigned i = 0; i < 3; i++) {
+		cpuid(0x80000002 + i, 0x0, cpuinfo);
+		memcpy(model + i * sizeof(cpuinfo), cpuinfo, sizeof(cpuinfo));
+	}
+	model[RUN_META_CPU_MODEL_LEN - 1] = '\0';
+
+	/* brand strings are right-aligned on some processors */
+	size_t skip = strspn(model, " ");
+	memmove(model, model + skip, strlen(model + skip) + 1);
+}
+
+#endif
+
+/*
+ * isa_append -- (internal) add feature name to the list
+ */
+static void
+isa_append(char *isa, const char *name)
+{
+	if (*isa != '\0')
+		strncat(isa, " ", RUN_META_ISA_LEN - strlen(isa) - 1);
+	strncat(isa, name, RUN_META_ISA_LEN - strlen(isa) - 1);
+}
+
+/*
+ * env_is -- (internal) check whether environment variable is set to value
+ */
+static bool
+env_is(const char *name, const char *value)
+{
+	const char *e = os_getenv(name);
+	return e != nullptr && strcmp(e, value) == 0;
+}
+
+/*
+ * pmem_funcs_get -- (internal) name the flush instruction and the memcpy
+ *	variant libpmem uses on this platform
+ *
+ * libpmem does not export its choice, so the selection it makes based on
+ * CPUID and the PMEM_* environment variables is repeated here, see
+ * pmem_init_funcs in src/libpmem/x86_64/init.c.
+ */
+static void
+pmem_funcs_get(struct run_meta *meta)
+{
+	if (env_is("PMEM_NO_FLUSH", "1"))
+		meta->cache_flush = false;
+	else if (env_is("PMEM_NO_FLUSH", "0"))
+		meta->cache_flush = true;
+	else
+		meta->cache_flush = pmem_has_auto_flush() != 1;
+
+	meta->flush = "unknown";
+	meta->memcpy_impl = "generic";
+
+	const char *e = os_getenv("PMEM_NO_GENERIC_MEMCPY");
+	if (e != nullptr && atoll(e) != 0)
+		meta->memcpy_impl = "libc";
+
+#ifdef RUN_META_CPUID
+	meta->flush = "clflush";
+	if (cpu_feature(0x7, EBX_IDX, 1U << 23) &&
+	    !env_is("PMEM_NO_CLFLUSHOPT", "1"))
+		meta->flush = "clflushopt";
+	if (cpu_feature(0x7, EBX_IDX, 1U << 24) &&
+	    !env_is("PMEM_NO_CLWB", "1"))
+		meta->flush = "clwb";
+
+	if (env_is("PMEM_NO_MOVNT", "1"))
+		return;
+
+	meta->memcpy_impl = "movnt-sse2";
+	if (cpu_feature(0x1, ECX_IDX, 1U << 28) && env_is("PMEM_AVX", "1"))
+		meta->memcpy_impl = "movnt-avx";
+	if (cpu_feature(0x7, EBX_IDX, 1U << 16) && env_is("PMEM_AVX512F", "1"))
+		meta->memcpy_impl = "movnt-avx512f";
+#endif
+}
+
+/*
+ * run_meta_get -- describe the platform benchmarks run on
+ */
+void
+run_meta_get(struct run_meta *meta)
+{
+	memset(meta->cpu_model, 0, sizeof(meta->cpu_model));
+	meta->isa[0] = '\0';
+	meta->version = SRCVERSION;
+
+	pmem_funcs_get(meta);
+
+#ifdef RUN_META_CPUID
+	cpu_model(meta->cpu_model);
+
+	if (cpu_feature(0x1, EDX_IDX, 1U << 19))
+		isa_append(meta->isa, "clflush");
+	if (cpu_feature(0x7, EBX_IDX, 1U << 23))
+		isa_append(meta->isa, "clflushopt");
+	if (cpu_feature(0x7, EBX_IDX, 1U << 24))
+		isa_append(meta->isa, "clwb");
+	if (cpu_feature(0x1, EDX_IDX, 1U << 26))
+		isa_append(meta->isa, "sse2");
+	if (cpu_feature(0x1, ECX_IDX, 1U << 28))
+		isa_append(meta->isa, "avx");
+	if (cpu_feature(0x7, EBX_IDX, 1U << 16))
+		isa_append(meta->isa, "avx512f");
+#endif
+
+	if (meta->cpu_model[0] == '\0')
+		strcpy(meta->cpu_model, "unknown");
+}
+
+/*
+ * pool_types -- pool signatures known to the benchmarks
+ */
+static const struct {
+	const char *sig;
+	const char *type;
+} pool_types[] = {
+	{"PMEMOBJ", "obj"},
+	{"PMEMBLK", "blk"},
+	{"PMEMLOG", "log"},
+	{"PMEMCTO", "cto"},
+};
+
+/*
+ * pool_is_pmem -- (internal) check whether libpmem maps files at given path
+ *	as pmem, without mapping the file itself
+ *
+ * Device DAX is always mapped as pmem. For other files a small temporary file
+ * is mapped in the same directory, as the file system decides.
+ */
+static int
+pool_is_pmem(const char *path)
+{
+	if (util_file_is_device_dax(path))
+		return 1;
+
+	char *dir = strdup(path);
+	if (dir == nullptr)
+		return -1;
+
+	char *sep = strrchr(dir, '/');
+#ifdef _WIN32
+	char *bsep = strrchr(dir, '\\');
+	if (bsep != nullptr && (sep == nullptr || bsep > sep))
+		sep = bsep;
+#endif
+	if (sep == nullptr)
+		strcpy(dir, ".");
+	else
+		sep[sep == dir ? 1 : 0] = '\0';
+
+	size_t len;
+	int is_pmem = -1;
+	void *addr = pmem_map_file(dir, Pagesize,
+				   PMEM_FILE_CREATE | PMEM_FILE_TMPFILE,
+				   S_IWUSR | S_IRUSR, &len, &is_pmem);
+	free(dir);
+	if (addr == nullptr)
+		return -1;
+
+	pmem_unmap(addr, len);
+	return is_pmem;
+}
+
+/*
+ * run_meta_pool -- describe the pool or file at given path
+ *
+ * Only the signature of the pool header is read, the pool is not mapped.
+ */
+void
+run_meta_pool(const char *path, struct pool_meta *meta)
+{
+	meta->type = "none";
+	meta->is_pmem = -1;
+
+	struct pool_set *set = nullptr;
+	if (util_is_poolset_file(path) == 1) {
+		int fd = os_open(path, O_RDONLY);
+		if (fd < 0)
+			return;
+		int ret = util_poolset_parse(&set, path, fd);
+		os_close(fd);
+		if (ret)
+			return;
+		path = set->replica[0]->part[0].path;
+	}
+
+	char sig[POOL_HDR_SIG_LEN];
+	if (util_file_pread(path, sig, sizeof(sig), 0) ==
+	    (ssize_t)sizeof(sig)) {
+		for (size_t i = 0; i < ARRAY_SIZE(pool_types); i++) {
+			if (memcmp(sig, pool_types[i].sig, sizeof(sig)) == 0)
+				meta->type = pool_types[i].type;
+		}
+	}
+
+	meta->is_pmem = pool_is_pmem(path);
+
+	if (set)
+		util_poolset_free(set);
+}
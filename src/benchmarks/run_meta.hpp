@@ -0,0 +1,68 @@
+/*
+ * Copyright 2018, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * run_meta.hpp -- description of the platform and pool a benchmark ran on
+ */
+
+#ifndef RUN_META_HPP
+#define RUN_META_HPP
+
+#include <cstddef>
+
+#define RUN_META_CPU_MODEL_LEN 49 /* cpuid brand string with '\0' */
+#define RUN_META_ISA_LEN 64
+
+/*
+ * struct run_meta -- metadata common for all benchmarks of the run
+ */
+struct run_meta {
+	char cpu_model[RUN_META_CPU_MODEL_LEN];
+	char isa[RUN_META_ISA_LEN]; /* relevant CPU features */
+	const char *flush;	/* flush instruction used by libpmem */
+	bool cache_flush;	/* libpmem flushes CPU caches at all */
+	const char *memcpy_impl; /* libpmem memcpy/memset variant */
+	const char *version;	/* source version */
+};
+
+/*
+ * struct pool_meta -- metadata of the pool used by a single benchmark
+ */
+struct pool_meta {
+	const char *type;	/* pool type or "none" */
+	int is_pmem;		/* mapped as pmem, -1 if unknown */
+};
+
+void run_meta_get(struct run_meta *meta);
+void run_meta_pool(const char *path, struct pool_meta *meta);
+
+#endif
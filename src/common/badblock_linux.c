@@ -35,7 +35,11 @@
  */
 
 #define _GNU_SOURCE
+#include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
 #include <linux/falloc.h>
 
 #include "file.h"
@@ -47,6 +51,91 @@
 #include "badblock.h"
 #include "vec.h"
 
+#ifdef DEBUG
+/*
+ * In debug builds bad blocks of regular files can be emulated, so that
+ * the bad blocks recovery can be tested without the hardware support.
+ * The variable contains a list of entries in the format:
+ * <path>:<offset>:<length>[;<path>:<offset>:<length>...]
+ * where offset and length are logical offsets in the file in bytes.
+ * If the variable is set, files which are not listed contain no bad blocks.
+ */
+#define BADBLOCKS_EMULATE_VAR "PMEM_BADBLOCKS_EMULATE"
+
+/*
+ * os_badblocks_emulate_get -- (internal) fill the 'bbs' array with
+ *                             the emulated bad blocks of the file
+ */
+static int
+os_badblocks_emulate_get(const char *file, const char *list,
+		struct badblocks *bbs)
+{
+	LOG(3, "file %s list %s badblocks %p", file, list, bbs);
+
+	VEC(bbsvec, struct bad_block) bbv = VEC_INITIALIZER;
+
+	char *dup = Strdup(list);
+	if (dup == NULL) {
+		ERR("!Strdup");
+		return -1;
+	}
+
+	char *saveptr = NULL;
+	char *entry;
+	for (entry = strtok_r(dup, ";", &saveptr); entry != NULL;
+			entry = strtok_r(NULL, ";", &saveptr)) {
+		/* the path may contain colons, so parse the entry backwards */
+		char *len_str = strrchr(entry, ':');
+		if (len_str == NULL)
+			goto err_invalid;
+		*len_str++ = '\0';
+
+		char *off_str = strrchr(entry, ':');
+		if (off_str == NULL)
+			goto err_invalid;
+		*off_str++ = '\0';
+
+		if (strcmp(entry, file) != 0)
+			continue;
+
+		char *end;
+		errno = 0;
+		unsigned long long off = strtoull(off_str, &end, 0);
+		if (errno || *end != '\0')
+			goto err_invalid;
+
+		unsigned long long len = strtoull(len_str, &end, 0);
+		if (errno || *end != '\0' || len == 0 || len > UINT_MAX)
+			goto err_invalid;
+
+		struct bad_block bb;
+		bb.offset = off;
+		bb.length = (unsigned)len;
+
+		LOG(4, "emulated bad block: offset: %llu, length: %llu",
+			off, len);
+
+		if (VEC_PUSH_BACK(&bbv, bb))
+			goto err;
+	}
+
+	Free(dup);
+
+	bbs->bbv = VEC_ARR(&bbv);
+	bbs->bb_cnt = (unsigned)VEC_SIZE(&bbv);
+
+	return 0;
+
+err_invalid:
+	ERR("invalid %s entry -- '%s'", BADBLOCKS_EMULATE_VAR, entry);
+	errno = EINVAL;
+err:
+	VEC_DELETE(&bbv);
+	Free(dup);
+	return -1;
+}
+#endif
+
 /*
  * os_badblocks_get -- returns 0 and bad blocks in the 'bbs' array
  *                     (that has to be pre-allocated)
@@ -75,6 +164,12 @@ os_badblocks_get(const char *file, struct badblocks *bbs)
 
 	memset(bbs, 0, sizeof(*bbs));
 
+#ifdef DEBUG
+	char *emulated = os_getenv(BADBLOCKS_EMULATE_VAR);
+	if (emulated != NULL)
+		return os_badblocks_emulate_get(file, emulated, bbs);
+#endif
+
 	if (os_dimm_files_namespace_badblocks(file, bbs)) {
 		LOG(1, "checking the file for bad blocks failed -- '%s'", file);
 		goto error_free_all;
@@ -76,6 +76,8 @@ int util_fd_is_device_dax(int fd);
 int util_ddax_region_find(const char *path);
 ssize_t util_file_get_size(const char *path);
 size_t util_file_device_dax_alignment(const char *path);
+int util_file_numa_node(const char *path);
+int util_file_is_tmpfs(const char *path);
 void *util_file_map_whole(const char *path);
 int util_file_zero(const char *path, os_off_t off, size_t len);
 ssize_t util_file_pread(const char *path, void *buffer, size_t size,
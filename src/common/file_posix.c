@@ -38,6 +38,9 @@
 #define _GNU_SOURCE
 
 #include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <signal.h>
 #include <string.h>
 #include <unistd.h>
@@ -46,6 +49,11 @@
 #include <sys/stat.h>
 #include <sys/sysmacros.h>
 #include <sys/types.h>
+#ifdef __FreeBSD__
+#include <sys/mount.h>
+#else
+#include <sys/vfs.h>
+#endif
 
 #include "os.h"
 #include "file.h"
@@ -293,6 +301,97 @@ util_file_device_dax_alignment(const char *path)
 	return device_dax_alignment(path);
 }
 
+/*
+ * util_file_numa_node -- returns the NUMA node of the device holding the file
+ *
+ * For a Device DAX it is the node of the device itself, for other files
+ * the node of the block device of their file system. Returns -1 if the node
+ * is not known, e.g. for file systems not backed by a device.
+ */
+int
+util_file_numa_node(const char *path)
+{
+	LOG(3, "path \"%s\"", path);
+
+	os_stat_t st;
+	if (os_stat(path, &st) < 0) {
+		ERR("!stat \"%s\"", path);
+		return -1;
+	}
+
+	char spath[PATH_MAX];
+	int fd;
+	if (S_ISCHR(st.st_mode)) {
+		snprintf(spath, PATH_MAX,
+			"/sys/dev/char/%u:%u/device/numa_node",
+			os_major(st.st_rdev), os_minor(st.st_rdev));
+		fd = os_open(spath, O_RDONLY);
+	} else {
+		snprintf(spath, PATH_MAX,
+			"/sys/dev/block/%u:%u/device/numa_node",
+			os_major(st.st_dev), os_minor(st.st_dev));
+		fd = os_open(spath, O_RDONLY);
+		if (fd < 0) {
+			/* a partition is on the node of the whole device */
+			snprintf(spath, PATH_MAX,
+				"/sys/dev/block/%u:%u/../device/numa_node",
+				os_major(st.st_dev), os_minor(st.st_dev));
+			fd = os_open(spath, O_RDONLY);
+		}
+	}
+
+	if (fd < 0) {
+		LOG(4, "no NUMA node of \"%s\"", path);
+		return -1;
+	}
+
+	char buf[16];
+	ssize_t nread = read(fd, buf, sizeof(buf) - 1);
+	(void) os_close(fd);
+	if (nread <= 0) {
+		LOG(2, "cannot read \"%s\"", spath);
+		return -1;
+	}
+
+	buf[nread] = '\0';
+
+	char *endptr;
+	int olderrno = errno;
+	errno = 0;
+	long node = strtol(buf, &endptr, 10);
+	if (errno || endptr == buf || (*endptr != '\n' && *endptr != '\0') ||
+			node < -1 || node > INT_MAX) {
+		LOG(2, "invalid NUMA node %s", buf);
+		node = -1;
+	}
+	errno = olderrno;
+
+	LOG(4, "NUMA node %ld", node);
+	return (int)node;
+}
+
+/*
+ * util_file_is_tmpfs -- checks whether the file is on a tmpfs file system
+ */
+int
+util_file_is_tmpfs(const char *path)
+{
+	LOG(3, "path \"%s\"", path);
+
+	struct statfs fs;
+	if (statfs(path, &fs) < 0) {
+		ERR("!statfs \"%s\"", path);
+		return -1;
+	}
+
+#ifdef __FreeBSD__
+	return strcmp(fs.f_fstypename, "tmpfs") == 0;
+#else
+	/* TMPFS_MAGIC from linux/magic.h */
+	return fs.f_type == 0x01021994;
+#endif
+}
+
 /*
  * util_ddax_region_find -- returns Device DAX region id
  */
@@ -212,6 +212,28 @@ util_file_device_dax_alignment(const char *path)
 	return 0;
 }
 
+/*
+ * util_file_numa_node -- returns the NUMA node of the device holding the file
+ */
+int
+util_file_numa_node(const char *path)
+{
+	LOG(3, "path \"%s\"", path);
+
+	return -1;
+}
+
+/*
+ * util_file_is_tmpfs -- checks whether the file is on a tmpfs file system
+ */
+int
+util_file_is_tmpfs(const char *path)
+{
+	LOG(3, "path \"%s\"", path);
+
+	return 0;
+}
+
 /*
  * util_ddax_region_find -- returns DEV dax region id that contains file
  */
@@ -161,7 +161,8 @@ util_unmap(void *addr, size_t len)
  * size must be multiple of page size.
  */
 void *
-util_map_tmpfile(const char *dir, size_t size, size_t req_align)
+util_map_tmpfile(const char *dir, size_t size, size_t req_align,
+	int *map_sync)
 {
 	int oerrno;
 
@@ -184,7 +185,7 @@ util_map_tmpfile(const char *dir, size_t size, size_t req_align)
 
 	void *base;
 	if ((base = util_map(fd, size, MAP_SHARED,
-			0, req_align, NULL)) == NULL) {
+			0, req_align, map_sync)) == NULL) {
 		LOG(2, "cannot mmap temporary file");
 		goto err;
 	}
@@ -62,7 +62,12 @@ void *util_map(int fd, size_t len, int flags, int rdonly,
 		size_t req_align, int *map_sync);
 int util_unmap(void *addr, size_t len);
 
-void *util_map_tmpfile(const char *dir, size_t size, size_t req_align);
+void *util_map_tmpfile(const char *dir, size_t size, size_t req_align,
+	int *map_sync);
+void *util_map_hugetlb(size_t size, size_t page_size);
+void util_map_advise_huge(void *addr, size_t len);
+int util_range_bind_node(void *addr, size_t len, unsigned node);
+int util_range_get_node(void *addr);
 
 #ifdef __FreeBSD__
 #define MAP_NORESERVE 0
@@ -34,15 +34,34 @@
  * mmap_posix.c -- memory-mapped files for Posix
  */
 
+#include <errno.h>
 #include <stdio.h>
+#include <string.h>
 #include <sys/mman.h>
 #include <sys/param.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 #include "mmap.h"
 #include "out.h"
 #include "os.h"
+#include "util.h"
 
 #define PROCMAXLEN 2048 /* maximum expected line length in /proc files */
 
+#define NODEMASK_BITS 1024 /* maximum number of NUMA nodes */
+
+/* mbind(2) constants, to avoid depending on libnuma headers */
+#ifdef SYS_mbind
+#define MPOL_BIND 2
+#define MPOL_MF_MOVE (1 << 1)
+#endif
+
+/* get_mempolicy(2) constants */
+#ifdef SYS_get_mempolicy
+#define MPOL_F_NODE (1 << 0)
+#define MPOL_F_ADDR (1 << 1)
+#endif
+
 char *Mmap_mapfile = OS_MAPFILE; /* Should be modified only for testing */
 
 #ifdef __FreeBSD__
@@ -218,3 +237,110 @@ util_map_sync(void *addr, size_t len, int proto, int flags, int fd,
 	/* other error */
 	return MAP_FAILED;
 }
+
+/*
+ * util_map_hugetlb -- map anonymous memory backed by huge pages
+ *
+ * If page_size is 0, the default huge page size of the system is used.
+ */
+void *
+util_map_hugetlb(size_t size, size_t page_size)
+{
+	LOG(3, "size %zu page_size %zu", size, page_size);
+
+#ifdef MAP_HUGETLB
+	int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#ifdef MAP_HUGE_SHIFT
+	if (page_size)
+		flags |= util_lssb_index64(page_size) << MAP_HUGE_SHIFT;
+#endif
+	void *addr = mmap(NULL, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+	if (addr == MAP_FAILED) {
+		ERR("!mmap MAP_HUGETLB");
+		return NULL;
+	}
+
+	return addr;
+#else
+	ERR("huge page mappings not supported");
+	errno = ENOTSUP;
+	return NULL;
+#endif
+}
+
+/*
+ * util_map_advise_huge -- ask the kernel to back the range with huge pages
+ *
+ * This is only a hint - it is not an error if the kernel ignores it.
+ */
+void
+util_map_advise_huge(void *addr, size_t len)
+{
+	LOG(3, "addr %p len %zu", addr, len);
+
+#ifdef MADV_HUGEPAGE
+	if (os_madvise(addr, len, MADV_HUGEPAGE))
+		LOG(4, "madvise MADV_HUGEPAGE: %s", strerror(errno));
+#endif
+}
+
+/*
+ * util_range_bind_node -- bind the memory range to a NUMA node
+ *
+ * Pages already faulted in are migrated to the node.
+ */
+int
+util_range_bind_node(void *addr, size_t len, unsigned node)
+{
+	LOG(3, "addr %p len %zu node %u", addr, len, node);
+
+	if (node >= NODEMASK_BITS) {
+		ERR("invalid node %u", node);
+		errno = EINVAL;
+		return -1;
+	}
+
+#ifdef SYS_mbind
+	unsigned long mask[NODEMASK_BITS / (8 * sizeof(unsigned long))] = {0};
+	mask[node / (8 * sizeof(unsigned long))] |=
+		1UL << (node % (8 * sizeof(unsigned long)));
+
+	if (syscall(SYS_mbind, addr, len, MPOL_BIND, mask,
+			NODEMASK_BITS + 1, MPOL_MF_MOVE)) {
+		ERR("!mbind");
+		return -1;
+	}
+
+	return 0;
+#else
+	ERR("binding memory to a NUMA node not supported");
+	errno = ENOTSUP;
+	return -1;
+#endif
+}
+
+/*
+ * util_range_get_node -- return the NUMA node of the page at a given address
+ *
+ * The page is faulted in if it is not present yet.
+ */
+int
+util_range_get_node(void *addr)
+{
+	LOG(3, "addr %p", addr);
+
+#ifdef SYS_get_mempolicy
+	int node;
+	if (syscall(SYS_get_mempolicy, &node, NULL, 0, addr,
+			MPOL_F_NODE | MPOL_F_ADDR)) {
+		ERR("!get_mempolicy");
+		return -1;
+	}
+
+	return node;
+#else
+	ERR("querying the NUMA node of memory not supported");
+	errno = ENOTSUP;
+	return -1;
+#endif
+}
@@ -147,3 +147,54 @@ util_map_sync(void *addr, size_t len, int proto, int flags, int fd,
 
 	return mmap(addr, len, proto, flags, fd, offset);
 }
+
+/*
+ * util_map_hugetlb -- map anonymous memory backed by huge pages
+ */
+void *
+util_map_hugetlb(size_t size, size_t page_size)
+{
+	LOG(3, "size %zu page_size %zu", size, page_size);
+
+	ERR("huge page mappings not supported");
+	errno = ENOTSUP;
+	return NULL;
+}
+
+/*
+ * util_map_advise_huge -- ask the kernel to back the range with huge pages
+ */
+void
+util_map_advise_huge(void *addr, size_t len)
+{
+	LOG(3, "addr %p len %zu", addr, len);
+
+	/* large pages can not be requested for an existing mapping */
+}
+
+/*
+ * util_range_bind_node -- bind the memory range to a NUMA node
+ */
+int
+util_range_bind_node(void *addr, size_t len, unsigned node)
+{
+	LOG(3, "addr %p len %zu node %u", addr, len, node);
+
+	/* the NUMA node can be selected only when the memory is allocated */
+	ERR("binding memory to a NUMA node not supported");
+	errno = ENOTSUP;
+	return -1;
+}
+
+/*
+ * util_range_get_node -- return the NUMA node of the page at a given address
+ */
+int
+util_range_get_node(void *addr)
+{
+	LOG(3, "addr %p", addr);
+
+	ERR("querying the NUMA node of memory not supported");
+	errno = ENOTSUP;
+	return -1;
+}
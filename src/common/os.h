@@ -125,6 +125,7 @@ int os_unsetenv(const char *name);
 int os_setenv(const char *name, const char *value, int overwrite);
 char *os_getenv(const char *name);
 const char *os_strsignal(int sig);
+int os_getcpu(unsigned *cpu, unsigned *node);
 
 /*
  * XXX: missing APis (used in ut_file.c)
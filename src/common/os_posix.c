@@ -45,6 +45,7 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/uio.h>
+#include <sys/syscall.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
@@ -287,3 +288,17 @@ os_getenv(const char *name)
 const char *os_strsignal(int sig) {
 	return strsignal(sig);
 }
+
+/*
+ * os_getcpu -- return the CPU and the NUMA node the calling thread runs on
+ */
+int
+os_getcpu(unsigned *cpu, unsigned *node)
+{
+#ifdef SYS_getcpu
+	return (int)syscall(SYS_getcpu, cpu, node, NULL);
+#else
+	errno = ENOTSUP;
+	return -1;
+#endif
+}
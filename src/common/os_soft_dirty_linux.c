@@ -0,0 +1,167 @@
+/*
+ * Copyright 2018, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * os_soft_dirty_linux.c -- Linux abstraction layer for soft-dirty page
+ * tracking
+ *
+ * Writing "4" to /proc/self/clear_refs clears the soft-dirty bits of all
+ * the pages mapped by the process.  After that, the kernel sets the bit
+ * again on each page written to, and reports it in bit 55 of the page's
+ * /proc/self/pagemap entry.  See Documentation/vm/soft-dirty.txt for details.
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "out.h"
+#include "os.h"
+#include "util.h"
+#include "os_soft_dirty.h"
+
+#define SOFT_DIRTY_CLEAR_REFS "/proc/self/clear_refs"
+#define SOFT_DIRTY_PAGEMAP "/proc/self/pagemap"
+
+#define PAGEMAP_SOFT_DIRTY (1ULL << 55)
+
+/* number of pagemap entries read at once */
+#define PAGEMAP_BATCH 4096
+
+/*
+ * os_soft_dirty_clear -- clear soft-dirty bits of all the process' pages
+ */
+int
+os_soft_dirty_clear(void)
+{
+	LOG(3, NULL);
+
+	int fd;
+
+	if ((fd = os_open(SOFT_DIRTY_CLEAR_REFS, O_WRONLY)) < 0) {
+		LOG(1, "!os_open(\"%s\", O_WRONLY)", SOFT_DIRTY_CLEAR_REFS);
+		if (errno == ENOENT)
+			errno = ENOTSUP;
+		return -1;
+	}
+
+	if (write(fd, "4", 1) != 1) {
+		LOG(1, "!write(%d, \"4\")", fd);
+		int oerrno = errno;
+		os_close(fd);
+		errno = oerrno;
+		return -1;
+	}
+
+	os_close(fd);
+	return 0;
+}
+
+/*
+ * os_soft_dirty_walk -- call cb for each run of soft-dirty pages
+ * in the given range
+ *
+ * Returns -1 on error, or the last value returned by cb.
+ */
+int
+os_soft_dirty_walk(void *addr, size_t len, os_soft_dirty_cb cb, void *arg)
+{
+	LOG(3, "addr %p len %zu", addr, len);
+
+	ASSERTeq((uintptr_t)addr % Pagesize, 0);
+
+	uintptr_t start = (uintptr_t)addr;
+	uintptr_t end = start + roundup(len, Pagesize);
+
+	uint64_t *entries = Malloc(PAGEMAP_BATCH * sizeof(*entries));
+	if (entries == NULL) {
+		ERR("!Malloc");
+		return -1;
+	}
+
+	int fd;
+	int ret = 0;
+
+	if ((fd = os_open(SOFT_DIRTY_PAGEMAP, O_RDONLY)) < 0) {
+		LOG(1, "!os_open(\"%s\", O_RDONLY)", SOFT_DIRTY_PAGEMAP);
+		if (errno == ENOENT)
+			errno = ENOTSUP;
+		ret = -1;
+		goto out_free;
+	}
+
+	uintptr_t run = 0;
+	size_t runlen = 0;
+	uintptr_t page = start;
+
+	while (page < end) {
+		size_t nentries = MIN((end - page) / Pagesize, PAGEMAP_BATCH);
+		off_t off = (off_t)(page / Pagesize * sizeof(*entries));
+
+		ssize_t nread = pread(fd, entries,
+				nentries * sizeof(*entries), off);
+		if (nread <= 0 || nread % (ssize_t)sizeof(*entries)) {
+			ERR("!pread(%d, %p, %zu)", fd, entries,
+				nentries * sizeof(*entries));
+			ret = -1;
+			goto out_close;
+		}
+
+		nentries = (size_t)nread / sizeof(*entries);
+		for (size_t i = 0; i < nentries; ++i, page += Pagesize) {
+			if (entries[i] & PAGEMAP_SOFT_DIRTY) {
+				if (runlen == 0)
+					run = page;
+				runlen += Pagesize;
+				continue;
+			}
+
+			if (runlen == 0)
+				continue;
+
+			ret = cb((void *)run, runlen, arg);
+			if (ret)
+				goto out_close;
+			runlen = 0;
+		}
+	}
+
+	if (runlen != 0)
+		ret = cb((void *)run, runlen, arg);
+
+out_close:
+	os_close(fd);
+out_free:
+	Free(entries);
+	return ret;
+}
@@ -602,3 +602,23 @@ os_strsignal(int sig)
 	else
 		return STR_UNKNOWN_SIGNAL;
 }
+
+/*
+ * os_getcpu -- return the CPU and the NUMA node the calling thread runs on
+ */
+int
+os_getcpu(unsigned *cpu, unsigned *node)
+{
+	PROCESSOR_NUMBER pn;
+	USHORT node_number;
+
+	GetCurrentProcessorNumberEx(&pn);
+	if (!GetNumaProcessorNodeEx(&pn, &node_number)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	*cpu = (unsigned)pn.Group * 64 + pn.Number;
+	*node = node_number;
+	return 0;
+}
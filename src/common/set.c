@@ -89,10 +89,14 @@ static RPMEMpool *(*Rpmem_open)(const char *target, const char *pool_set_name,
 int (*Rpmem_close)(RPMEMpool *rpp);
 int (*Rpmem_persist)(RPMEMpool *rpp, size_t offset, size_t length,
 			unsigned lane, unsigned flags);
+int (*Rpmem_persistv)(RPMEMpool *rpp, const struct rpmem_range *ranges,
+			unsigned nranges, unsigned lane, unsigned flags);
 int (*Rpmem_deep_persist)(RPMEMpool *rpp, size_t offset, size_t length,
 			unsigned lane);
 int (*Rpmem_read)(RPMEMpool *rpp, void *buff, size_t offset,
 		size_t length, unsigned lane);
+int (*Rpmem_read_bulk)(RPMEMpool *rpp, void *buff, size_t offset,
+		size_t length, unsigned lane, unsigned nlanes);
 int (*Rpmem_remove)(const char *target, const char *pool_set_name, int flags);
 int (*Rpmem_set_attr)(RPMEMpool *rpp, const struct rpmem_pool_attr *rattr);
 
@@ -176,8 +180,10 @@ util_remote_unload_core(void)
 	Rpmem_open = NULL;
 	Rpmem_close = NULL;
 	Rpmem_persist = NULL;
+	Rpmem_persistv = NULL;
 	Rpmem_deep_persist = NULL;
 	Rpmem_read = NULL;
+	Rpmem_read_bulk = NULL;
 	Rpmem_remove = NULL;
 	Rpmem_set_attr = NULL;
 }
@@ -217,8 +223,10 @@ util_remote_load(void)
 	CHECK_FUNC_COMPATIBLE(rpmem_open, *Rpmem_open);
 	CHECK_FUNC_COMPATIBLE(rpmem_close, *Rpmem_close);
 	CHECK_FUNC_COMPATIBLE(rpmem_persist, *Rpmem_persist);
+	CHECK_FUNC_COMPATIBLE(rpmem_persistv, *Rpmem_persistv);
 	CHECK_FUNC_COMPATIBLE(rpmem_deep_persist, *Rpmem_deep_persist);
 	CHECK_FUNC_COMPATIBLE(rpmem_read, *Rpmem_read);
+	CHECK_FUNC_COMPATIBLE(rpmem_read_bulk, *Rpmem_read_bulk);
 	CHECK_FUNC_COMPATIBLE(rpmem_remove, *Rpmem_remove);
 
 	util_mutex_lock(&Remote_lock);
@@ -258,6 +266,12 @@ util_remote_load(void)
 		goto err;
 	}
 
+	/*
+	 * rpmem_persistv is optional -- older versions of librpmem do not
+	 * provide it and the ranges are persisted one by one then.
+	 */
+	Rpmem_persistv = util_dlsym(Rpmem_handle_remote, "rpmem_persistv");
+
 	Rpmem_deep_persist = util_dlsym(Rpmem_handle_remote,
 			"rpmem_deep_persist");
 	if (util_dl_check_error(Rpmem_deep_persist, "dlsym")) {
@@ -271,6 +285,12 @@ util_remote_load(void)
 		goto err;
 	}
 
+	/*
+	 * rpmem_read_bulk is optional -- older versions of librpmem do not
+	 * provide it and the data is read on a single lane then.
+	 */
+	Rpmem_read_bulk = util_dlsym(Rpmem_handle_remote, "rpmem_read_bulk");
+
 	Rpmem_remove = util_dlsym(Rpmem_handle_remote, "rpmem_remove");
 	if (util_dl_check_error(Rpmem_remove, "dlsym")) {
 		ERR("symbol 'rpmem_remove' not found");
@@ -1979,6 +1999,8 @@ util_poolset_remote_open(struct pool_replica *rep, unsigned repidx,
 		util_remote_store_attr(rep->part[0].hdr, &rpmem_attr_open);
 	}
 
+	rep->remote->nlanes = remote_nlanes;
+
 	if (remote_nlanes < *nlanes)
 		*nlanes = remote_nlanes;
 
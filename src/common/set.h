@@ -131,6 +131,7 @@ struct remote_replica {
 	char *node_addr;	/* address of a remote node */
 	/* poolset descriptor is a pool set file name on a remote node */
 	char *pool_desc;	/* descriptor of a poolset */
+	unsigned nlanes;	/* number of lanes granted by the remote node */
 };
 
 struct pool_replica {
@@ -416,10 +417,15 @@ int util_replica_close_remote(struct pool_replica *rep, unsigned repn,
 
 extern int (*Rpmem_persist)(RPMEMpool *rpp, size_t offset, size_t length,
 						unsigned lane, unsigned flags);
+extern int (*Rpmem_persistv)(RPMEMpool *rpp,
+		const struct rpmem_range *ranges, unsigned nranges,
+		unsigned lane, unsigned flags);
 extern int (*Rpmem_deep_persist)(RPMEMpool *rpp, size_t offset, size_t length,
 								unsigned lane);
 extern int (*Rpmem_read)(RPMEMpool *rpp, void *buff, size_t offset,
 				size_t length, unsigned lane);
+extern int (*Rpmem_read_bulk)(RPMEMpool *rpp, void *buff, size_t offset,
+				size_t length, unsigned lane, unsigned nlanes);
 extern int (*Rpmem_close)(RPMEMpool *rpp);
 
 extern int (*Rpmem_remove)(const char *target,
@@ -79,7 +79,7 @@ typedef struct pmemcto PMEMctopool;
  * used at compile-time by passing these defines to pmemcto_check_version().
  */
 #define PMEMCTO_MAJOR_VERSION 1
-#define PMEMCTO_MINOR_VERSION 0
+#define PMEMCTO_MINOR_VERSION 1
 
 #ifndef _WIN32
 const char *pmemcto_check_version(unsigned major_required,
@@ -129,6 +129,10 @@ int pmemcto_checkW(const wchar_t *path, const wchar_t *layout);
 
 void pmemcto_close(PMEMctopool *pcp);
 void pmemcto_stats_print(PMEMctopool *pcp, const char *opts);
+int pmemcto_ctl_get(PMEMctopool *pcp, const char *name, void *oldp,
+	size_t *oldlenp);
+int pmemcto_ctl_set(PMEMctopool *pcp, const char *name, void *newp,
+	size_t newlen);
 
 /*
  * support for malloc and friends...
@@ -147,6 +151,8 @@ size_t pmemcto_malloc_usable_size(PMEMctopool *pcp, void *ptr);
  */
 void pmemcto_set_root_pointer(PMEMctopool *pcp, void *ptr);
 void *pmemcto_get_root_pointer(PMEMctopool *pcp);
+void pmemcto_mark_dirty(PMEMctopool *pcp, const void *ptr, size_t size);
+int pmemcto_checkpoint(PMEMctopool *pcp);
 
 /*
  * Passing NULL to pmemcto_set_funcs() tells libpmemcto to continue to use
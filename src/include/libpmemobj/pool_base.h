@@ -62,10 +62,12 @@ extern "C" {
 #define pmemobj_open pmemobj_openW
 #define pmemobj_create pmemobj_createW
 #define pmemobj_check pmemobj_checkW
+#define pmemobj_backup pmemobj_backupW
 #else
 #define pmemobj_open pmemobj_openU
 #define pmemobj_create pmemobj_createU
 #define pmemobj_check pmemobj_checkU
+#define pmemobj_backup pmemobj_backupU
 #endif
 #endif
 
@@ -94,6 +96,17 @@ int pmemobj_checkW(const wchar_t *path, const wchar_t *layout);
 #endif
 
 void pmemobj_close(PMEMobjpool *pop);
+
+/*
+ * Makes a consistent copy of the open pool in the given file or poolset,
+ * while the pool is being used by other threads.
+ */
+#ifndef _WIN32
+int pmemobj_backup(PMEMobjpool *pop, const char *path, unsigned flags);
+#else
+int pmemobj_backupU(PMEMobjpool *pop, const char *path, unsigned flags);
+int pmemobj_backupW(PMEMobjpool *pop, const wchar_t *path, unsigned flags);
+#endif
 /*
  * If called for the first time on a newly created pool, the root object
  * of given size is allocated.  Otherwise, it returns the existing root object.
@@ -49,7 +49,9 @@
 #define pmempool_check_init pmempool_check_initW
 #define pmempool_check pmempool_checkW
 #define pmempool_sync pmempool_syncW
+#define pmempool_xsync pmempool_xsyncW
 #define pmempool_transform pmempool_transformW
+#define pmempool_xtransform pmempool_xtransformW
 #define pmempool_rm pmempool_rmW
 #define pmempool_check_version pmempool_check_versionW
 #define pmempool_errormsg pmempool_errormsgW
@@ -60,7 +62,9 @@
 #define pmempool_check_init pmempool_check_initU
 #define pmempool_check pmempool_checkU
 #define pmempool_sync pmempool_syncU
+#define pmempool_xsync pmempool_xsyncU
 #define pmempool_transform pmempool_transformU
+#define pmempool_xtransform pmempool_xtransformU
 #define pmempool_rm pmempool_rmU
 #define pmempool_check_version pmempool_check_versionU
 #define pmempool_errormsg pmempool_errormsgU
@@ -167,7 +171,7 @@ enum pmempool_check_result pmempool_check_end(PMEMpoolcheck *ppc);
  * used at compile-time by passing these defines to pmempool_check_version().
  */
 #define PMEMPOOL_MAJOR_VERSION 1
-#define PMEMPOOL_MINOR_VERSION 3
+#define PMEMPOOL_MINOR_VERSION 4
 
 /*
  * check status
@@ -240,6 +244,30 @@ struct pmempool_check_statusW *pmempool_checkW(PMEMpoolcheck *ppc);
  * LIBPMEMPOOL SYNC & TRANSFORM
  */
 
+/*
+ * sync only the regions of replicas which differ from the source replica
+ * given in pmempool_copy_opts
+ */
+#define PMEMPOOL_SYNC_INCREMENTAL (1 << 2)
+
+/*
+ * progress callback -- called after each copied chunk of data, returning
+ * a non-zero value cancels the operation
+ */
+typedef int pmempool_progress_func(size_t copied, size_t total, void *arg);
+
+/*
+ * options of copying data between replicas -- zeroed fields select defaults
+ */
+struct pmempool_copy_opts {
+	unsigned nthreads;	/* number of copying threads */
+	size_t chunk_size;	/* size of the chunk persisted at once */
+	size_t max_bandwidth;	/* copying speed limit in bytes per second */
+	pmempool_progress_func *progress;
+	void *arg;		/* argument passed to the progress callback */
+	unsigned src_replica;	/* source replica number counted from 1 */
+};
+
 /*
  * Synchronize data between replicas within a poolset.
  *
@@ -247,9 +275,15 @@ struct pmempool_check_statusW *pmempool_checkW(PMEMpoolcheck *ppc);
  */
 #ifndef _WIN32
 int pmempool_sync(const char *poolset_file, unsigned flags);
+int pmempool_xsync(const char *poolset_file, unsigned flags,
+	const struct pmempool_copy_opts *opts);
 #else
 int pmempool_syncU(const char *poolset_file, unsigned flags);
 int pmempool_syncW(const wchar_t *poolset_file, unsigned flags);
+int pmempool_xsyncU(const char *poolset_file, unsigned flags,
+	const struct pmempool_copy_opts *opts);
+int pmempool_xsyncW(const wchar_t *poolset_file, unsigned flags,
+	const struct pmempool_copy_opts *opts);
 #endif
 
 /*
@@ -260,11 +294,20 @@ int pmempool_syncW(const wchar_t *poolset_file, unsigned flags);
 #ifndef _WIN32
 int pmempool_transform(const char *poolset_file_src,
 	const char *poolset_file_dst, unsigned flags);
+int pmempool_xtransform(const char *poolset_file_src,
+	const char *poolset_file_dst, unsigned flags,
+	const struct pmempool_copy_opts *opts);
 #else
 int pmempool_transformU(const char *poolset_file_src,
 	const char *poolset_file_dst, unsigned flags);
 int pmempool_transformW(const wchar_t *poolset_file_src,
 	const wchar_t *poolset_file_dst, unsigned flags);
+int pmempool_xtransformU(const char *poolset_file_src,
+	const char *poolset_file_dst, unsigned flags,
+	const struct pmempool_copy_opts *opts);
+int pmempool_xtransformW(const wchar_t *poolset_file_src,
+	const wchar_t *poolset_file_dst, unsigned flags,
+	const struct pmempool_copy_opts *opts);
 #endif
 
 /* PMEMPOOL RM */
@@ -84,11 +84,56 @@ int rpmem_close(RPMEMpool *rpp);
 
 int rpmem_persist(RPMEMpool *rpp, size_t offset, size_t length,
 		unsigned lane, unsigned flags);
+
+/*
+ * rpmem_range -- single range of vectored persist operation
+ */
+struct rpmem_range {
+	size_t offset;	/* offset in pool */
+	size_t length;	/* length of range */
+};
+
+int rpmem_persistv(RPMEMpool *rpp, const struct rpmem_range *ranges,
+		unsigned nranges, unsigned lane, unsigned flags);
+
+int rpmem_persist_async(RPMEMpool *rpp, size_t offset, size_t length,
+		unsigned lane, unsigned flags, uint64_t *token);
+int rpmem_poll(RPMEMpool *rpp, uint64_t token);
+int rpmem_wait(RPMEMpool *rpp, uint64_t token);
 int rpmem_read(RPMEMpool *rpp, void *buff, size_t offset, size_t length,
 		unsigned lane);
+int rpmem_read_bulk(RPMEMpool *rpp, void *buff, size_t offset, size_t length,
+		unsigned lane, unsigned nlanes);
 int rpmem_deep_persist(RPMEMpool *rpp, size_t offset, size_t length,
 		unsigned lane);
 
+/* number of buckets of persist latency histogram */
+#define RPMEM_STATS_HIST_SIZE 128
+
+/* lower bound (in nanoseconds) of latencies counted in histogram bucket */
+#define RPMEM_STATS_HIST_LOWER(b) ((b) < 4 ? (uint64_t)(b) :\
+	(uint64_t)(4 + (b) % 4) << ((b) / 4 - 1))
+
+/* lane number for statistics aggregated over all lanes */
+#define RPMEM_STATS_ALL_LANES ((unsigned)-1)
+
+struct rpmem_stats {
+	uint64_t persists;	/* number of completed persist operations */
+	uint64_t persist_bytes;	/* number of bytes made persistent */
+	uint64_t messages;	/* number of persist messages sent */
+	uint64_t reads;		/* number of completed read operations */
+	uint64_t read_bytes;	/* number of bytes read */
+	uint64_t errors;	/* number of failed operations */
+	uint64_t pending;	/* number of asynchronous persists in flight */
+	uint64_t lag;		/* age of the oldest pending persist [ns] */
+	uint64_t lat_min;	/* minimum persist latency [ns] */
+	uint64_t lat_max;	/* maximum persist latency [ns] */
+	uint64_t lat_sum;	/* sum of persist latencies [ns] */
+	uint64_t lat_hist[RPMEM_STATS_HIST_SIZE]; /* latency histogram */
+};
+
+int rpmem_stats_get(RPMEMpool *rpp, unsigned lane, struct rpmem_stats *stats);
+
 #define RPMEM_REMOVE_FORCE 0x1
 #define RPMEM_REMOVE_POOL_SET 0x2
 
@@ -101,7 +146,7 @@ int rpmem_remove(const char *target, const char *pool_set, int flags);
  * at compile-time by passing these defines to rpmem_check_version().
  */
 #define RPMEM_MAJOR_VERSION 1
-#define RPMEM_MINOR_VERSION 2
+#define RPMEM_MINOR_VERSION 3
 const char *rpmem_check_version(unsigned major_required,
 		unsigned minor_required);
 
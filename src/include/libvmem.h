@@ -44,10 +44,12 @@
 #ifdef _WIN32
 #ifndef PMDK_UTF8_API
 #define vmem_create vmem_createW
+#define vmem_xcreate vmem_xcreateW
 #define vmem_check_version vmem_check_versionW
 #define vmem_errormsg vmem_errormsgW
 #else
 #define vmem_create vmem_createU
+#define vmem_xcreate vmem_xcreateU
 #define vmem_check_version vmem_check_versionU
 #define vmem_errormsg vmem_errormsgU
 #endif
@@ -75,10 +77,31 @@ VMEM *vmem_createU(const char *dir, size_t size);
 VMEM *vmem_createW(const wchar_t *dir, size_t size);
 #endif
 
+/*
+ * flags supported by vmem_xcreate()
+ */
+#define VMEM_CREATE_HUGE_2M	(1U << 0) /* use 2 MiB pages */
+#define VMEM_CREATE_HUGE_1G	(1U << 1) /* use 1 GiB pages */
+#define VMEM_CREATE_HUGETLB	(1U << 2) /* use anonymous huge pages */
+#define VMEM_CREATE_POPULATE	(1U << 3) /* pre-fault the whole pool */
+
+#ifndef _WIN32
+VMEM *vmem_xcreate(const char *dir, size_t size, unsigned flags);
+#else
+VMEM *vmem_xcreateU(const char *dir, size_t size, unsigned flags);
+VMEM *vmem_xcreateW(const wchar_t *dir, size_t size, unsigned flags);
+#endif
+
 VMEM *vmem_create_in_region(void *addr, size_t size);
 void vmem_delete(VMEM *vmp);
 int vmem_check(VMEM *vmp);
 void vmem_stats_print(VMEM *vmp, const char *opts);
+int vmem_ctl_get(VMEM *vmp, const char *name, void *oldp, size_t *oldlenp);
+int vmem_ctl_set(VMEM *vmp, const char *name, void *newp, size_t newlen);
+int vmem_bind_node(VMEM *vmp, unsigned node);
+int vmem_thread_bind(VMEM *vmp);
+VMEM *vmem_pool_local(VMEM *const *pools, unsigned npools);
+int vmem_background_purge(VMEM *vmp, unsigned decay_ms);
 
 /*
  * support for malloc and friends...
@@ -104,7 +127,7 @@ size_t vmem_malloc_usable_size(VMEM *vmp, void *ptr);
  * these defines to vmem_check_version().
  */
 #define VMEM_MAJOR_VERSION 1
-#define VMEM_MINOR_VERSION 1
+#define VMEM_MINOR_VERSION 2
 
 #ifndef _WIN32
 const char *vmem_check_version(unsigned major_required,
@@ -10,6 +10,7 @@
 #ifdef JEMALLOC_H_EXTERNS
 
 bool	pages_purge(void *addr, size_t length, bool file_mapped);
+bool	pages_purge_reclaim(void *addr, size_t length);
 
 void	*chunk_alloc_mmap(size_t size, size_t alignment, bool *zero);
 bool	chunk_dalloc_mmap(void *chunk, size_t size);
@@ -29,6 +29,12 @@ struct extent_node_s {
 
 	/* True if zero-filled; used by chunk recycling code. */
 	bool			zeroed;
+
+	/*
+	 * True if the pages have not been purged yet; used by chunk recycling
+	 * code of pools in deferred purging mode.
+	 */
+	bool			dirty;
 };
 typedef rb_tree(extent_node_t) extent_tree_t;
 
@@ -134,6 +134,20 @@ void pool_destroy(pool_t *pool);
 extern malloc_mutex_t	pools_lock;
 extern malloc_mutex_t	pool_base_lock;
 
+/*
+ * Pools whose dirty pages are purged only on explicit request (e.g. from
+ * a background thread), with the file blocks backing them released.
+ * Indexed by pool_id; kept outside of pool_t, which may be persistent.
+ */
+extern bool	pool_purge_deferred[POOLS_MAX];
+
+/*
+ * Per pool overrides of opt_lg_dirty_mult and opt_tcache, reset to the
+ * process-wide settings each time the pool is booted.
+ */
+extern ssize_t	pool_lg_dirty_mult[POOLS_MAX];
+extern bool	pool_tcache[POOLS_MAX];
+
 void pool_prefork();
 void pool_postfork_parent();
 void pool_postfork_child();
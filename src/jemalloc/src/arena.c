@@ -869,13 +869,17 @@ arena_maybe_purge(arena_t *arena)
 	size_t npurgeable, threshold;
 
 	/* Don't purge if the option is disabled. */
-	if (opt_lg_dirty_mult < 0)
+	if (pool_lg_dirty_mult[arena->pool->pool_id] < 0)
+		return;
+	/* Don't purge if it is left to an explicit purge request. */
+	if (pool_purge_deferred[arena->pool->pool_id])
 		return;
 	/* Don't purge if all dirty pages are already being purged. */
 	if (arena->ndirty <= arena->npurgatory)
 		return;
 	npurgeable = arena->ndirty - arena->npurgatory;
-	threshold = (arena->nactive >> opt_lg_dirty_mult);
+	threshold = (arena->nactive >>
+	    pool_lg_dirty_mult[arena->pool->pool_id]);
 	/*
 	 * Don't purge unless the number of purgeable pages exceeds the
 	 * threshold.
@@ -908,7 +912,8 @@ arena_compute_npurgatory(arena_t *arena, bool all)
 	npurgeable = arena->ndirty - arena->npurgatory;
 
 	if (all == false) {
-		size_t threshold = (arena->nactive >> opt_lg_dirty_mult);
+		size_t threshold = (arena->nactive >>
+		    pool_lg_dirty_mult[arena->pool->pool_id]);
 
 		npurgatory = npurgeable - threshold;
 	} else
@@ -981,22 +986,30 @@ arena_chunk_purge_stashed(arena_t *arena, arena_chunk_t *chunk,
 {
 	size_t npurged, pageind, npages, nmadvise;
 	arena_chunk_map_t *mapelm;
+	bool file_mapped, reclaim;
 
 	malloc_mutex_unlock(&arena->lock);
 	if (config_stats)
 		nmadvise = 0;
 	npurged = 0;
+	file_mapped = pool_is_file_mapped(arena->pool);
+	reclaim = pool_purge_deferred[arena->pool->pool_id];
 	ql_foreach(mapelm, mapelms, u.ql_link) {
-		bool unzeroed, file_mapped;
+		bool unzeroed;
 		size_t flag_unzeroed, i;
 
 		pageind = arena_mapelm_to_pageind(mapelm);
 		npages = arena_mapbits_large_size_get(chunk, pageind) >>
 		    LG_PAGE;
 		assert(pageind + npages <= chunk_npages);
-		file_mapped = pool_is_file_mapped(arena->pool);
-		unzeroed = pages_purge((void *)((uintptr_t)chunk + (pageind <<
-		    LG_PAGE)), (npages << LG_PAGE), file_mapped);
+		if (reclaim) {
+			unzeroed = pages_purge_reclaim((void *)((uintptr_t)chunk
+			    + (pageind << LG_PAGE)), (npages << LG_PAGE));
+		} else {
+			unzeroed = pages_purge((void *)((uintptr_t)chunk +
+			    (pageind << LG_PAGE)), (npages << LG_PAGE),
+			    file_mapped);
+		}
 		flag_unzeroed = unzeroed ? CHUNK_MAP_UNZEROED : 0;
 		/*
 		 * Set the unzeroed flag for all pages, now that pages_purge()
@@ -1103,8 +1116,8 @@ arena_purge(arena_t *arena, bool all)
 		assert(ndirty == arena->ndirty);
 	}
 	assert(arena->ndirty > arena->npurgatory || all);
-	assert((arena->nactive >> opt_lg_dirty_mult) < (arena->ndirty -
-	    arena->npurgatory) || all);
+	assert((arena->nactive >> pool_lg_dirty_mult[arena->pool->pool_id]) <
+	    (arena->ndirty - arena->npurgatory) || all);
 
 	if (config_stats)
 		arena->stats.npurge++;
@@ -1176,6 +1189,16 @@ arena_purge_all(arena_t *arena)
 {
 	malloc_mutex_lock(&arena->lock);
 	arena_purge(arena, true);
+	/*
+	 * Pools purged only on explicit request give back the spare chunk
+	 * too, so that no dirty pages are left behind.
+	 */
+	if (pool_purge_deferred[arena->pool->pool_id] && arena->spare != NULL) {
+		arena_chunk_t *spare = arena->spare;
+
+		arena->spare = NULL;
+		arena_chunk_dalloc_internal(arena, spare);
+	}
 	malloc_mutex_unlock(&arena->lock);
 }
 
@@ -33,7 +33,7 @@ chunk_recycle(pool_t *pool, extent_tree_t *chunks_szad, extent_tree_t *chunks_ad
 	extent_node_t *node;
 	extent_node_t key;
 	size_t alloc_size, leadsize, trailsize;
-	bool zeroed;
+	bool zeroed, dirty;
 
 	if (base) {
 		/*
@@ -63,6 +63,7 @@ chunk_recycle(pool_t *pool, extent_tree_t *chunks_szad, extent_tree_t *chunks_ad
 	trailsize = node->size - leadsize - size;
 	ret = (void *)((uintptr_t)node->addr + leadsize);
 	zeroed = node->zeroed;
+	dirty = node->dirty;
 	if (zeroed)
 	    *zero = true;
 	/* Remove node from the tree. */
@@ -96,6 +97,7 @@ chunk_recycle(pool_t *pool, extent_tree_t *chunks_szad, extent_tree_t *chunks_ad
 		node->addr = (void *)((uintptr_t)(ret) + size);
 		node->size = trailsize;
 		node->zeroed = zeroed;
+		node->dirty = dirty;
 		extent_tree_szad_insert(chunks_szad, node);
 		extent_tree_ad_insert(chunks_ad, node);
 		node = NULL;
@@ -266,11 +268,21 @@ void
 chunk_record(pool_t *pool, extent_tree_t *chunks_szad, extent_tree_t *chunks_ad, void *chunk,
     size_t size, bool zeroed)
 {
-	bool unzeroed, file_mapped;
+	bool unzeroed, file_mapped, dirty;
 	extent_node_t *xnode, *node, *prev, *xprev, key;
 
-	file_mapped = pool_is_file_mapped(pool);
-	unzeroed = pages_purge(chunk, size, file_mapped);
+	/*
+	 * Pools in deferred purging mode leave the pages dirty, to be purged
+	 * by chunk_purge_deferred() instead of on the deallocation path.
+	 */
+	dirty = false;
+	if (pool_purge_deferred[pool->pool_id]) {
+		unzeroed = true;
+		dirty = (zeroed == false);
+	} else {
+		file_mapped = pool_is_file_mapped(pool);
+		unzeroed = pages_purge(chunk, size, file_mapped);
+	}
 	JEMALLOC_VALGRIND_MAKE_MEM_NOACCESS(chunk, size);
 
 	/*
@@ -305,6 +317,7 @@ chunk_record(pool_t *pool, extent_tree_t *chunks_szad, extent_tree_t *chunks_ad,
 		node->addr = chunk;
 		node->size += size;
 		node->zeroed = (node->zeroed && zeroed);
+		node->dirty = (node->dirty || dirty);
 		extent_tree_szad_insert(chunks_szad, node);
 	} else {
 		/* Coalescing forward failed, so insert a new node. */
@@ -322,6 +335,7 @@ chunk_record(pool_t *pool, extent_tree_t *chunks_szad, extent_tree_t *chunks_ad,
 		node->addr = chunk;
 		node->size = size;
 		node->zeroed = zeroed;
+		node->dirty = dirty;
 		extent_tree_ad_insert(chunks_ad, node);
 		extent_tree_szad_insert(chunks_szad, node);
 	}
@@ -342,6 +356,7 @@ chunk_record(pool_t *pool, extent_tree_t *chunks_szad, extent_tree_t *chunks_ad,
 		node->addr = prev->addr;
 		node->size += prev->size;
 		node->zeroed = (node->zeroed && prev->zeroed);
+		node->dirty = (node->dirty || prev->dirty);
 		extent_tree_szad_insert(chunks_szad, node);
 
 		xprev = prev;
@@ -359,6 +374,45 @@ label_return:
 		base_node_dalloc(pool, xprev);
 }
 
+static void
+chunk_purge_tree(pool_t *pool, extent_tree_t *chunks_ad)
+{
+	extent_node_t *node, key;
+
+	key.addr = NULL;
+	malloc_mutex_lock(&pool->chunks_mtx);
+	while ((node = extent_tree_ad_nsearch(chunks_ad, &key)) != NULL) {
+		key.addr = (void *)((uintptr_t)node->addr + node->size);
+		if (node->dirty == false)
+			continue;
+
+		/*
+		 * Keep chunks_mtx held while purging, so that the range is
+		 * neither recycled nor missing from the tree meanwhile, but
+		 * let other threads in between the nodes.
+		 */
+		node->zeroed = (pages_purge_reclaim(node->addr, node->size) ==
+		    false);
+		node->dirty = false;
+		malloc_mutex_unlock(&pool->chunks_mtx);
+		malloc_mutex_lock(&pool->chunks_mtx);
+	}
+	malloc_mutex_unlock(&pool->chunks_mtx);
+}
+
+/*
+ * Purge the pages of the recorded chunks which chunk_record() left dirty,
+ * called on explicit purge requests of pools in deferred purging mode.
+ */
+void
+chunk_purge_deferred(pool_t *pool)
+{
+
+	if (have_dss)
+		chunk_purge_tree(pool, &pool->chunks_ad_dss);
+	chunk_purge_tree(pool, &pool->chunks_ad_mmap);
+}
+
 void
 chunk_unmap(pool_t *pool, void *chunk, size_t size)
 {
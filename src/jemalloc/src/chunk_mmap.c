@@ -142,6 +142,22 @@ pages_purge(void *addr, size_t length, bool file_mapped)
 	return (unzeroed);
 }
 
+/*
+ * Purge pages of a shared file mapping, releasing the file blocks backing
+ * them, so that the space can be reused by other mappings of the same
+ * file system.  Falls back to the regular purge if it is not possible.
+ */
+bool
+pages_purge_reclaim(void *addr, size_t length)
+{
+
+#if defined(JEMALLOC_HAVE_MADVISE) && defined(MADV_REMOVE)
+	if (madvise(addr, length, MADV_REMOVE) == 0)
+		return (false);
+#endif
+	return (pages_purge(addr, length, true));
+}
+
 static void *
 chunk_alloc_mmap_slow(size_t size, size_t alignment, bool *zero)
 {
@@ -182,6 +182,9 @@ INDEX_PROTO(pool_i)
 CTL_PROTO(pools_npools)
 CTL_PROTO(pool_i_base)
 CTL_PROTO(pool_i_size)
+CTL_PROTO(pool_i_purge_deferred)
+CTL_PROTO(pool_i_lg_dirty_mult)
+CTL_PROTO(pool_i_tcache)
 
 /******************************************************************************/
 /* mallctl tree. */
@@ -432,6 +435,9 @@ static const ctl_named_node_t pools_node[] = {
 static const ctl_named_node_t pool_i_node[] = {
 	{NAME("mem_base"),      CTL(pool_i_base)},
 	{NAME("mem_size"),	CTL(pool_i_size)},
+	{NAME("purge_deferred"),	CTL(pool_i_purge_deferred)},
+	{NAME("lg_dirty_mult"),	CTL(pool_i_lg_dirty_mult)},
+	{NAME("tcache"),	CTL(pool_i_tcache)},
 	{NAME("arena"),		CHILD(indexed, arena)},
 	{NAME("arenas"),	CHILD(named, arenas)},
 	{NAME("stats"),		CHILD(named, pool_stats)}
@@ -1247,7 +1253,7 @@ thread_arena_ctl(const size_t *mib, size_t miblen, void *oldp, size_t *oldlenp,
 {
 	int ret;
 	unsigned newind, oldind;
-	size_t pool_ind = mib[1];
+	size_t pool_ind = mib[2];
 	pool_t *pool;
 	arena_t dummy;
 
@@ -1337,8 +1343,8 @@ thread_arena_ctl(const size_t *mib, size_t miblen, void *oldp, size_t *oldlenp,
 		}
 
 		tsd = arenas_tsd_get();
-		tsd->seqno[0] = pool->seqno;
-		tsd->arenas[0] = arena;
+		tsd->seqno[pool->pool_id] = pool->seqno;
+		tsd->arenas[pool->pool_id] = arena;
 	}
 
 	ret = 0;
@@ -1418,6 +1424,9 @@ arena_purge(pool_t *pool, unsigned arena_ind)
 			if (tarenas[i] != NULL)
 				arena_purge_all(tarenas[i]);
 		}
+		/* including the chunks freed since the last purge */
+		if (pool_purge_deferred[pool->pool_id])
+			chunk_purge_deferred(pool);
 	} else {
 		assert(arena_ind < pool->ctl_stats.narenas);
 		if (tarenas[arena_ind] != NULL)
@@ -1764,6 +1773,90 @@ label_return:
        return (ret);
 }
 
+static int
+pool_i_purge_deferred_ctl(const size_t *mib, size_t miblen, void *oldp,
+    size_t *oldlenp, void *newp, size_t newlen)
+{
+	int ret;
+	bool oldval, newval;
+	size_t pool_ind = mib[1];
+
+	if (pool_ind >= npools)
+		return (ENOENT);
+
+	malloc_mutex_lock(&ctl_mtx);
+	oldval = pool_purge_deferred[pool_ind];
+	newval = oldval;
+	WRITE(newval, bool);
+	READ(oldval, bool);
+	pool_purge_deferred[pool_ind] = newval;
+
+	ret = 0;
+label_return:
+	malloc_mutex_unlock(&ctl_mtx);
+	return (ret);
+}
+
+static int
+pool_i_lg_dirty_mult_ctl(const size_t *mib, size_t miblen, void *oldp,
+    size_t *oldlenp, void *newp, size_t newlen)
+{
+	int ret;
+	ssize_t oldval, newval;
+	size_t pool_ind = mib[1];
+
+	if (pool_ind >= npools)
+		return (ENOENT);
+
+	malloc_mutex_lock(&ctl_mtx);
+	oldval = pool_lg_dirty_mult[pool_ind];
+	newval = oldval;
+	WRITE(newval, ssize_t);
+	if (newval < -1 || newval >= (ssize_t)(sizeof(size_t) << 3)) {
+		ret = EINVAL;
+		goto label_return;
+	}
+	READ(oldval, ssize_t);
+	pool_lg_dirty_mult[pool_ind] = newval;
+
+	ret = 0;
+label_return:
+	malloc_mutex_unlock(&ctl_mtx);
+	return (ret);
+}
+
+static int
+pool_i_tcache_ctl(const size_t *mib, size_t miblen, void *oldp,
+    size_t *oldlenp, void *newp, size_t newlen)
+{
+	int ret;
+	bool oldval, newval;
+	size_t pool_ind = mib[1];
+
+	if (!config_tcache)
+		return (ENOENT);
+	if (pool_ind >= npools)
+		return (ENOENT);
+
+	malloc_mutex_lock(&ctl_mtx);
+	oldval = pool_tcache[pool_ind];
+	newval = oldval;
+	WRITE(newval, bool);
+	READ(oldval, bool);
+	pool_tcache[pool_ind] = newval;
+	/*
+	 * Flush the cache of the calling thread only, objects cached by other
+	 * threads go back to the pool when these threads exit.
+	 */
+	if (oldval && newval == false && pool_ind < tcache_tsd_get()->npools)
+		tcache_flush(pools[pool_ind]);
+
+	ret = 0;
+label_return:
+	malloc_mutex_unlock(&ctl_mtx);
+	return (ret);
+}
+
 /**
  * @stub
  */
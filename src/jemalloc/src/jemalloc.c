@@ -2566,6 +2566,79 @@ je_pool_malloc_stats_print(pool_t *pool,
 	stats_print(pool, write_cb, cbopaque, opts);
 }
 
+/*
+ * mallctl() limited to a single pool -- names are relative to the
+ * "pool.<i>" subtree, except for the global ones handled below.
+ */
+int
+je_pool_ctl(pool_t *pool, const char *name, void *oldp, size_t *oldlenp,
+    void *newp, size_t newlen)
+{
+	char buf[128];
+	int len;
+
+	if (strcmp(name, "epoch") == 0 || strcmp(name, "version") == 0 ||
+	    strncmp(name, "config.", strlen("config.")) == 0 ||
+	    strncmp(name, "opt.", strlen("opt.")) == 0 ||
+	    strncmp(name, "thread.tcache.", strlen("thread.tcache.")) == 0)
+		return (ctl_byname(name, oldp, oldlenp, newp, newlen));
+
+	if (strcmp(name, "thread.arena") == 0)
+		len = malloc_snprintf(buf, sizeof(buf), "thread.pool.%u.arena",
+		    pool->pool_id);
+	else
+		len = malloc_snprintf(buf, sizeof(buf), "pool.%u.%s",
+		    pool->pool_id, name);
+
+	if (len < 0 || (size_t)len >= sizeof(buf))
+		return (ENOENT);
+
+	return (ctl_byname(buf, oldp, oldlenp, newp, newlen));
+}
+
+/*
+ * Acquire all the locks of a single pool, in the same order as
+ * jemalloc_prefork() does, so that the pool metadata is not modified until
+ * je_pool_resume() is called.  Allocations served from the thread caches
+ * do not modify the arena metadata and are not blocked.
+ */
+void
+je_pool_quiesce(pool_t *pool)
+{
+	unsigned i;
+
+	malloc_rwlock_prefork(&pool->arenas_lock);
+	for (i = 0; i < pool->narenas_total; i++) {
+		if (pool->arenas[i] != NULL)
+			arena_prefork(pool->arenas[i]);
+	}
+
+	chunk_prefork0(pool);
+	base_prefork(pool);
+	chunk_prefork1(pool);
+	huge_prefork(pool);
+}
+
+/*
+ * Release the locks acquired by je_pool_quiesce().
+ */
+void
+je_pool_resume(pool_t *pool)
+{
+	unsigned i;
+
+	huge_postfork_parent(pool);
+	chunk_postfork_parent1(pool);
+	base_postfork_parent(pool);
+	chunk_postfork_parent0(pool);
+
+	for (i = 0; i < pool->narenas_total; i++) {
+		if (pool->arenas[i] != NULL)
+			arena_postfork_parent(pool->arenas[i]);
+	}
+	malloc_rwlock_postfork_parent(&pool->arenas_lock);
+}
+
 void
 je_pool_set_alloc_funcs(void *(*malloc_func)(size_t),
 				void (*free_func)(void *))
@@ -3,6 +3,9 @@
 
 malloc_mutex_t	pool_base_lock;
 malloc_mutex_t	pools_lock;
+bool		pool_purge_deferred[POOLS_MAX];
+ssize_t		pool_lg_dirty_mult[POOLS_MAX];
+bool		pool_tcache[POOLS_MAX];
 
 /*
  * Initialize runtime state of the pool.
@@ -12,6 +15,9 @@ bool
 pool_boot(pool_t *pool, unsigned pool_id)
 {
 	pool->pool_id = pool_id;
+	pool_purge_deferred[pool_id] = false;
+	pool_lg_dirty_mult[pool_id] = opt_lg_dirty_mult;
+	pool_tcache[pool_id] = opt_tcache;
 
 	if (malloc_mutex_init(&pool->memory_range_mtx))
 		return (true);
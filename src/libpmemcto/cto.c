@@ -62,6 +62,9 @@
 #include "valgrind_internal.h"
 #include "os_thread.h"
 #include "os_deep.h"
+#include "os_soft_dirty.h"
+#include "file.h"
+#include "uuid.h"
 
 /* default hint address for mmap() when PMEM_MMAP_HINT is not specified */
 #define CTO_MMAP_HINT ((void *)0x10000000000)
@@ -86,6 +89,15 @@ static const struct pool_attr Cto_open_attr = {
 
 static os_mutex_t Pool_lock; /* guards pmemcto_create and pmemcto_open */
 
+/*
+ * Soft-dirty bits are cleared for the whole process, so only one pool
+ * at a time may rely on them.  Guarded by Pool_lock.
+ */
+static PMEMctopool *Dirty_owner;
+
+/* dirty ranges tracking, unless disabled with PMEMCTO_DIRTY_TRACKING=0 */
+static int Dirty_tracking = 1;
+
 /*
  * cto_print_jemalloc_messages -- (internal) custom print function for jemalloc
  *
@@ -121,6 +133,12 @@ cto_init(void)
 
 	util_mutex_init(&Pool_lock);
 
+	char *env = os_getenv(PMEMCTO_DIRTY_TRACKING_VAR);
+	if (env != NULL && strcmp(env, "0") == 0) {
+		LOG(3, "dirty ranges tracking disabled");
+		Dirty_tracking = 0;
+	}
+
 	/* set up jemalloc messages to a custom print function */
 	je_cto_malloc_message = cto_print_jemalloc_messages;
 }
@@ -162,6 +180,7 @@ cto_descr_create(PMEMctopool *pcp, const char *layout, size_t poolsize)
 	pcp->size = poolsize;
 	pcp->root = (uint64_t)NULL;
 	pcp->consistent = 0;
+	pcp->checkpoint = 0;
 
 	/* store non-volatile part of pool's descriptor */
 	util_persist(pcp->is_pmem, dscp, CTO_DSC_P_SIZE);
@@ -169,13 +188,103 @@ cto_descr_create(PMEMctopool *pcp, const char *layout, size_t poolsize)
 	return 0;
 }
 
+/*
+ * cto_ckpt_path -- (internal) return the path of the pool's checkpoint image
+ */
+static char *
+cto_ckpt_path(const char *path)
+{
+	size_t len = strlen(path) + sizeof(CTO_CKPT_SUFFIX);
+
+	char *ckpt_path = Malloc(len);
+	if (ckpt_path == NULL) {
+		ERR("!Malloc");
+		return NULL;
+	}
+
+	strcpy(ckpt_path, path);
+	strcat(ckpt_path, CTO_CKPT_SUFFIX);
+
+	return ckpt_path;
+}
+
+/*
+ * cto_ckpt_hdr_valid -- (internal) check if the image matches the pool
+ */
+static int
+cto_ckpt_hdr_valid(PMEMctopool *pcp, const struct cto_ckpt_hdr *hdr)
+{
+	if (memcmp(hdr->signature, CTO_CKPT_SIG, POOL_HDR_SIG_LEN) != 0) {
+		LOG(2, "invalid checkpoint image signature");
+		return 0;
+	}
+
+	if (uuidcmp(hdr->poolset_uuid, pcp->set->uuid) != 0 ||
+	    hdr->addr != pcp->addr || hdr->size != pcp->size) {
+		LOG(2, "checkpoint image of another pool");
+		return 0;
+	}
+
+	if (hdr->checkpoint != pcp->checkpoint) {
+		LOG(2, "checkpoint image %ju does not match checkpoint %ju",
+				(uintmax_t)hdr->checkpoint,
+				(uintmax_t)pcp->checkpoint);
+		return 0;
+	}
+
+	return 1;
+}
+
+/*
+ * cto_ckpt_check -- (internal) check the checkpoint image of the pool
+ */
+static int
+cto_ckpt_check(PMEMctopool *pcp, const char *path)
+{
+	LOG(3, "pcp %p path \"%s\"", pcp, path);
+
+	char *ckpt_path = cto_ckpt_path(path);
+	if (ckpt_path == NULL)
+		return -1;
+
+	int ret = -1;
+	struct cto_ckpt_hdr hdr;
+
+	ssize_t size = util_file_get_size(ckpt_path);
+	if (size < 0) {
+		LOG(2, "cannot get the size of \"%s\"", ckpt_path);
+		goto out;
+	}
+
+	if ((size_t)size != CTO_CKPT_IMAGES * pcp->size) {
+		LOG(2, "checkpoint file size %zd does not match pool size %ju",
+				size, (uintmax_t)pcp->size);
+		goto out;
+	}
+
+	os_off_t off = (os_off_t)(CTO_CKPT_IMAGE(pcp->checkpoint) * pcp->size);
+	if (util_file_pread(ckpt_path, &hdr, sizeof(hdr), off) !=
+			(ssize_t)sizeof(hdr)) {
+		LOG(2, "cannot read \"%s\"", ckpt_path);
+		goto out;
+	}
+
+	if (cto_ckpt_hdr_valid(pcp, &hdr))
+		ret = 0;
+out:
+	Free(ckpt_path);
+	return ret;
+}
+
 /*
  * cto_descr_check -- (internal) validate cto pool descriptor
  */
 static int
-cto_descr_check(PMEMctopool *pcp, const char *layout, size_t poolsize)
+cto_descr_check(PMEMctopool *pcp, const char *path, const char *layout,
+		size_t poolsize)
 {
-	LOG(3, "pcp %p layout \"%s\" poolsize %zu", pcp, layout, poolsize);
+	LOG(3, "pcp %p path \"%s\" layout \"%s\" poolsize %zu", pcp, path,
+			layout, poolsize);
 
 	if (layout && strncmp(pcp->layout, layout, PMEMCTO_MAX_LAYOUT)) {
 		ERR("wrong layout (\"%s\") pool created with layout \"%s\"",
@@ -185,9 +294,26 @@ cto_descr_check(PMEMctopool *pcp, const char *layout, size_t poolsize)
 	}
 
 	if (pcp->consistent == 0) {
-		ERR("inconsistent pool");
-		errno = EINVAL;
-		return -1;
+		if (pcp->checkpoint == 0) {
+			ERR("inconsistent pool");
+			errno = EINVAL;
+			return -1;
+		}
+
+		/*
+		 * The pool was not closed properly, but it was checkpointed
+		 * since it was opened, so it can be rolled back to the image
+		 * saved by the last checkpoint.
+		 */
+		if (cto_ckpt_check(pcp, path) != 0) {
+			ERR("inconsistent pool, no image of checkpoint %ju",
+					(uintmax_t)pcp->checkpoint);
+			errno = EINVAL;
+			return -1;
+		}
+
+		LOG(3, "pool not closed, restoring checkpoint %ju",
+				(uintmax_t)pcp->checkpoint);
 	}
 
 	if ((void *)pcp->addr == NULL) {
@@ -226,18 +352,270 @@ cto_descr_check(PMEMctopool *pcp, const char *layout, size_t poolsize)
 	return 0;
 }
 
+/*
+ * cto_dirty_probe_cb -- (internal) soft-dirty walk callback for the probe
+ */
+static int
+cto_dirty_probe_cb(void *addr, size_t len, void *arg)
+{
+	*(int *)arg = 1;
+	return 0;
+}
+
+/*
+ * cto_dirty_init -- (internal) set up dirty ranges tracking
+ *
+ * Stores to the pool are tracked using the kernel soft-dirty bits.  If it
+ * is not possible, pcp->dirty is left NULL and the entire pool is flushed
+ * on close.
+ */
+static void
+cto_dirty_init(PMEMctopool *pcp, int rdonly)
+{
+	LOG(3, "pcp %p rdonly %d", pcp, rdonly);
+
+	pcp->dirty = NULL;
+
+	/* msync on non-pmem writes back only the dirty pages anyway */
+	if (!Dirty_tracking || rdonly || !pcp->is_pmem)
+		return;
+
+	util_mutex_lock(&Pool_lock);
+
+	if (Dirty_owner != NULL) {
+		LOG(3, "dirty ranges tracked for another pool %p", Dirty_owner);
+		goto out;
+	}
+
+	if (os_soft_dirty_clear()) {
+		LOG(3, "!cannot clear soft-dirty bits");
+		goto out;
+	}
+
+	/*
+	 * Make sure the kernel tracks stores to the pool mapping, by writing
+	 * to the consistency flag, which is about to be reset anyway.
+	 */
+	pcp->consistent = 0;
+
+	int dirty = 0;
+	void *page = (void *)ALIGN_DOWN((uintptr_t)&pcp->consistent,
+			Pagesize);
+	if (os_soft_dirty_walk(page, Pagesize, cto_dirty_probe_cb, &dirty) ||
+			!dirty) {
+		LOG(3, "soft-dirty bits not supported for the pool mapping");
+		goto out;
+	}
+
+	struct cto_dirty *d = Malloc(sizeof(*d));
+	if (d == NULL) {
+		LOG(1, "!Malloc");
+		goto out;
+	}
+
+	util_mutex_init(&d->lock);
+	d->nranges = 0;
+	d->overflow = 0;
+
+	pcp->dirty = d;
+	Dirty_owner = pcp;
+
+	LOG(4, "dirty ranges tracking enabled");
+out:
+	util_mutex_unlock(&Pool_lock);
+}
+
+/*
+ * cto_dirty_fini -- (internal) release dirty ranges tracking resources
+ */
+static void
+cto_dirty_fini(PMEMctopool *pcp)
+{
+	LOG(3, "pcp %p", pcp);
+
+	struct cto_dirty *d = pcp->dirty;
+	if (d == NULL)
+		return;
+
+	util_mutex_lock(&Pool_lock);
+	ASSERTeq(Dirty_owner, pcp);
+	Dirty_owner = NULL;
+	util_mutex_unlock(&Pool_lock);
+
+	util_mutex_destroy(&d->lock);
+	Free(d);
+	pcp->dirty = NULL;
+}
+
+/*
+ * cto_range_cmp -- (internal) compare ranges by address
+ */
+static int
+cto_range_cmp(const void *a, const void *b)
+{
+	const struct cto_range *ra = a;
+	const struct cto_range *rb = b;
+
+	if (ra->addr < rb->addr)
+		return -1;
+	if (ra->addr > rb->addr)
+		return 1;
+	return 0;
+}
+
+/*
+ * cto_dirty_compact -- (internal) sort and merge the marked ranges
+ */
+static void
+cto_dirty_compact(struct cto_dirty *d)
+{
+	LOG(4, "nranges %u", d->nranges);
+
+	qsort(d->ranges, d->nranges, sizeof(d->ranges[0]), cto_range_cmp);
+
+	unsigned n = 0;
+	for (unsigned i = 1; i < d->nranges; ++i) {
+		struct cto_range *last = &d->ranges[n];
+		struct cto_range *r = &d->ranges[i];
+
+		if (r->addr <= last->addr + last->len) {
+			last->len = MAX(last->len,
+					r->addr + r->len - last->addr);
+		} else {
+			d->ranges[++n] = *r;
+		}
+	}
+
+	d->nranges = n + 1;
+}
+
+/*
+ * cto_dirty_add -- (internal) add a range to the marked ones
+ *
+ * Must be called with the dirty ranges lock held.
+ */
+static void
+cto_dirty_add(struct cto_dirty *d, uintptr_t addr, size_t len)
+{
+	if (d->overflow)
+		return;
+
+	/* sequential writes are likely to extend the last range */
+	if (d->nranges > 0) {
+		struct cto_range *last = &d->ranges[d->nranges - 1];
+		if (addr >= last->addr && addr <= last->addr + last->len) {
+			last->len = MAX(last->len, addr + len - last->addr);
+			return;
+		}
+	}
+
+	if (d->nranges == CTO_DIRTY_RANGES_MAX) {
+		cto_dirty_compact(d);
+		if (d->nranges == CTO_DIRTY_RANGES_MAX) {
+			LOG(3, "too many dirty ranges");
+			d->overflow = 1;
+			return;
+		}
+	}
+
+	d->ranges[d->nranges].addr = addr;
+	d->ranges[d->nranges].len = len;
+	d->nranges++;
+}
+
+/*
+ * cto_dirty_flush_cb -- (internal) soft-dirty walk callback flushing pages
+ */
+static int
+cto_dirty_flush_cb(void *addr, size_t len, void *arg)
+{
+	pmem_deep_flush(addr, len);
+	return 0;
+}
+
+/*
+ * cto_dirty_walk -- (internal) call cb for the ranges modified since open
+ *
+ * Returns -1 if the modified ranges are not known, and the entire pool
+ * has to be processed instead.  If reset is set, the tracking starts over
+ * right after the ranges are read, so that the next walk covers the ranges
+ * modified after this one.  The ranges should then only be recorded by cb
+ * and processed after the walk, as stores done in the meantime are tracked
+ * for the next walk only.
+ */
+static int
+cto_dirty_walk(PMEMctopool *pcp, os_soft_dirty_cb cb, void *arg, int reset)
+{
+	LOG(3, "pcp %p cb %p arg %p reset %d", pcp, cb, arg, reset);
+
+	struct cto_dirty *d = pcp->dirty;
+	if (d == NULL)
+		return -1;
+
+	int ret = -1;
+
+	util_mutex_lock(&d->lock);
+
+	if (d->overflow)
+		goto out;
+
+	for (unsigned i = 0; i < d->nranges; ++i) {
+		if (cb((void *)d->ranges[i].addr, d->ranges[i].len, arg))
+			goto out;
+	}
+
+	if (os_soft_dirty_walk((void *)pcp->addr, pcp->size, cb, arg)) {
+		LOG(2, "cannot read soft-dirty bits");
+		goto out;
+	}
+
+	ret = 0;
+out:
+	if (reset) {
+		/* leftover soft-dirty bits only make the next flush larger */
+		if (os_soft_dirty_clear())
+			LOG(2, "!cannot clear soft-dirty bits");
+
+		d->nranges = 0;
+		d->overflow = 0;
+	}
+
+	util_mutex_unlock(&d->lock);
+	return ret;
+}
+
 /*
  * cto_runtime_init -- (internal) initialize cto memory pool runtime data
  */
 static int
-cto_runtime_init(PMEMctopool *pcp, int rdonly, int is_pmem)
+cto_runtime_init(PMEMctopool *pcp, const char *path, int rdonly, int is_pmem)
 {
-	LOG(3, "pcp %p rdonly %d is_pmem %d", pcp, rdonly, is_pmem);
+	LOG(3, "pcp %p path \"%s\" rdonly %d is_pmem %d", pcp, path, rdonly,
+			is_pmem);
+
+	pcp->rdonly = rdonly;
 
-	/* reset consistency flag */
+	/* the checkpoint images are mapped by the first checkpoint */
+	pcp->ckpt_path = NULL;
+	pcp->ckpt_addr = NULL;
+	memset(pcp->ckpt_saved, 0, sizeof(pcp->ckpt_saved));
+	memset(&pcp->ckpt_prev, 0, sizeof(pcp->ckpt_prev));
+
+	if (!rdonly && (pcp->ckpt_path = cto_ckpt_path(path)) == NULL)
+		return -1;
+
+	/* start tracking before the first store to the pool */
+	cto_dirty_init(pcp, rdonly);
+
+	/*
+	 * Reset consistency flag and forget the last checkpoint, as its image
+	 * stops matching the pool with the first modification.
+	 */
 	pcp->consistent = 0;
-	os_part_deep_common(REP(pcp->set, 0), 0,
-			&pcp->consistent, sizeof(pcp->consistent), 1);
+	pcp->checkpoint = 0;
+	os_part_deep_common(REP(pcp->set, 0), 0, &pcp->consistent,
+			(uintptr_t)(&pcp->checkpoint + 1) -
+			(uintptr_t)&pcp->consistent, 1);
 
 	/*
 	 * If possible, turn off all permissions on the pool header page.
@@ -250,6 +628,215 @@ cto_runtime_init(PMEMctopool *pcp, int rdonly, int is_pmem)
 	return 0;
 }
 
+/*
+ * cto_runtime_fini -- (internal) release cto memory pool runtime data
+ */
+static void
+cto_runtime_fini(PMEMctopool *pcp)
+{
+	LOG(3, "pcp %p", pcp);
+
+	if (pcp->ckpt_addr != NULL)
+		util_unmap(pcp->ckpt_addr, CTO_CKPT_IMAGES * pcp->size);
+	Free(pcp->ckpt_path);
+	Free(pcp->ckpt_prev.ranges);
+
+	cto_dirty_fini(pcp);
+}
+
+/*
+ * cto_ckpt_map -- (internal) map the checkpoint images, create them if needed
+ */
+static int
+cto_ckpt_map(PMEMctopool *pcp)
+{
+	LOG(3, "pcp %p", pcp);
+
+	size_t ckpt_size = CTO_CKPT_IMAGES * pcp->size;
+	int fd = -1;
+
+	if (os_access(pcp->ckpt_path, F_OK) == 0) {
+		size_t size = 0;
+		fd = util_file_open(pcp->ckpt_path, &size, 0, O_RDWR);
+		if (fd < 0)
+			return -1;
+
+		/* e.g. left by another pool created at the same path */
+		if (size != ckpt_size) {
+			LOG(3, "checkpoint file size %zu, recreating", size);
+			(void) os_close(fd);
+			fd = -1;
+
+			if (os_unlink(pcp->ckpt_path)) {
+				ERR("!unlink \"%s\"", pcp->ckpt_path);
+				return -1;
+			}
+		}
+	}
+
+	if (fd < 0) {
+		fd = util_file_create(pcp->ckpt_path, ckpt_size, 0);
+		if (fd < 0)
+			return -1;
+
+		if (os_chmod(pcp->ckpt_path, S_IRUSR | S_IWUSR)) {
+			ERR("!chmod \"%s\"", pcp->ckpt_path);
+			(void) os_close(fd);
+			return -1;
+		}
+	}
+
+	void *addr = util_map(fd, ckpt_size, MAP_SHARED, 0, 0, NULL);
+
+	int oerrno = errno;
+	(void) os_close(fd);
+	errno = oerrno;
+
+	if (addr == NULL)
+		return -1;
+
+	/* whatever the images contain, it is not known to match the pool */
+	pcp->ckpt_addr = addr;
+	memset(pcp->ckpt_saved, 0, sizeof(pcp->ckpt_saved));
+
+	return 0;
+}
+
+/*
+ * cto_ckpt_image -- (internal) return the address of the given image
+ */
+static inline char *
+cto_ckpt_image(PMEMctopool *pcp, unsigned img)
+{
+	return (char *)pcp->ckpt_addr + img * pcp->size;
+}
+
+/*
+ * cto_ckpt_copy -- (internal) copy a range of the pool to a checkpoint image
+ *
+ * The pool header is never copied, its place in the image is taken by
+ * the image header.
+ */
+static void
+cto_ckpt_copy(PMEMctopool *pcp, char *image, uintptr_t addr, size_t len)
+{
+	uintptr_t start = MAX(addr, pcp->addr + sizeof(struct pool_hdr));
+	uintptr_t end = MIN(addr + len, pcp->addr + pcp->size);
+
+	if (start >= end)
+		return;
+
+	memcpy(image + (start - pcp->addr), (void *)start, end - start);
+}
+
+/*
+ * cto_ckpt_copy_ranges -- (internal) copy the ranges to a checkpoint image
+ */
+static void
+cto_ckpt_copy_ranges(PMEMctopool *pcp, char *image,
+		const struct cto_ckpt_ranges *r)
+{
+	for (size_t i = 0; i < r->nranges; ++i)
+		cto_ckpt_copy(pcp, image, r->ranges[i].addr, r->ranges[i].len);
+}
+
+/*
+ * cto_ckpt_ranges_add_cb -- (internal) dirty ranges walk callback recording
+ *	them for the checkpoint
+ */
+static int
+cto_ckpt_ranges_add_cb(void *addr, size_t len, void *arg)
+{
+	struct cto_ckpt_ranges *r = arg;
+
+	if (r->nranges == r->size) {
+		size_t size = r->size ? 2 * r->size : CTO_DIRTY_RANGES_MAX;
+		struct cto_range *ranges = Realloc(r->ranges,
+				size * sizeof(*ranges));
+		if (ranges == NULL) {
+			LOG(2, "!cannot record dirty ranges");
+			return -1;
+		}
+
+		r->ranges = ranges;
+		r->size = size;
+	}
+
+	r->ranges[r->nranges].addr = (uintptr_t)addr;
+	r->ranges[r->nranges].len = len;
+	r->nranges++;
+
+	return 0;
+}
+
+/*
+ * cto_ckpt_restore -- (internal) roll the pool back to the last checkpoint
+ *
+ * Called before the heap is used, so the entire pool apart from the pool
+ * header and the run-time part of the descriptor is overwritten.
+ */
+static int
+cto_ckpt_restore(PMEMctopool *pcp, const char *path)
+{
+	LOG(3, "pcp %p path \"%s\"", pcp, path);
+
+	char *ckpt_path = cto_ckpt_path(path);
+	if (ckpt_path == NULL)
+		return -1;
+
+	int ret = -1;
+	size_t size = 0;
+
+	int fd = util_file_open(ckpt_path, &size, 0, O_RDONLY);
+	if (fd < 0)
+		goto out;
+
+	void *addr = NULL;
+	if (size == CTO_CKPT_IMAGES * pcp->size)
+		addr = util_map(fd, size, MAP_SHARED, 1, 0, NULL);
+
+	(void) os_close(fd);
+
+	if (addr == NULL)
+		goto out;
+
+	char *image = (char *)addr +
+			CTO_CKPT_IMAGE(pcp->checkpoint) * pcp->size;
+
+	/* the image might have changed since the descriptor was checked */
+	if (!cto_ckpt_hdr_valid(pcp, (struct cto_ckpt_hdr *)image)) {
+		ERR("checkpoint image does not match the pool");
+		errno = EINVAL;
+		goto out_unmap;
+	}
+
+	/* the image of the descriptor carries the same checkpoint number */
+	memcpy(pcp->layout, image + sizeof(struct pool_hdr), CTO_DSC_P_SIZE);
+	ASSERTeq(pcp->consistent, 0);
+
+	memcpy((char *)pcp + CTO_DSC_SIZE_ALIGNED,
+			image + CTO_DSC_SIZE_ALIGNED,
+			pcp->size - CTO_DSC_SIZE_ALIGNED);
+
+	struct pool_replica *rep = REP(pcp->set, 0);
+	for (unsigned p = 0; p < rep->nparts; p++) {
+		struct pool_set_part *part = PART(rep, p);
+		if (os_part_deep_common(rep, p, part->addr, part->size, 1)) {
+			ERR("!cannot flush the pool");
+			goto out_unmap;
+		}
+	}
+
+	LOG(4, "checkpoint %ju restored", (uintmax_t)pcp->checkpoint);
+	ret = 0;
+
+out_unmap:
+	util_unmap(addr, size);
+out:
+	Free(ckpt_path);
+	return ret;
+}
+
 /*
  * pmemcto_create -- create a cto memory pool
  */
@@ -309,6 +896,7 @@ pmemcto_createU(const char *path, const char *layout, size_t poolsize,
 	pcp->set = set;
 	pcp->is_pmem = rep->is_pmem;
 	pcp->is_dev_dax = rep->part[0].is_dev_dax;
+	pcp->dirty = NULL;
 
 	/* is_dev_dax implies is_pmem */
 	ASSERT(!pcp->is_dev_dax || pcp->is_pmem);
@@ -326,7 +914,7 @@ pmemcto_createU(const char *path, const char *layout, size_t poolsize,
 	}
 
 	/* initialize runtime parts */
-	if (cto_runtime_init(pcp, 0, rep->is_pmem) != 0) {
+	if (cto_runtime_init(pcp, path, 0, rep->is_pmem) != 0) {
 		ERR("pool initialization failed");
 		goto err;
 	}
@@ -337,17 +925,19 @@ pmemcto_createU(const char *path, const char *layout, size_t poolsize,
 			rep->repsize - CTO_DSC_SIZE_ALIGNED,
 			set->zeroed, 1) == NULL) {
 		ERR("pool creation failed");
-		goto err;
+		goto err_runtime;
 	}
 
 	if (util_poolset_chmod(set, mode))
-		goto err;
+		goto err_runtime;
 
 	util_poolset_fdclose(set);
 
 	LOG(3, "pcp %p", pcp);
 	return pcp;
 
+err_runtime:
+	cto_runtime_fini(pcp);
 err:
 	LOG(4, "error clean up");
 	int oerrno = errno;
@@ -427,8 +1017,11 @@ cto_open_noinit(const char *path, const char *layout, unsigned flags,
 
 	ASSERTeq(pcp->size, rep->repsize);
 	pcp->set = set;
+	/* needed by checkpoints, the header is not accessible later */
+	memcpy(set->uuid, pcp->hdr.poolset_uuid, POOL_HDR_UUID_LEN);
 	pcp->is_pmem = rep->is_pmem;
 	pcp->is_dev_dax = rep->part[0].is_dev_dax;
+	pcp->dirty = NULL;
 
 	/* is_dev_dax implies is_pmem */
 	ASSERT(!pcp->is_dev_dax || pcp->is_pmem);
@@ -440,7 +1033,7 @@ cto_open_noinit(const char *path, const char *layout, unsigned flags,
 	}
 
 	/* validate pool descriptor */
-	if (cto_descr_check(pcp, layout, set->poolsize) != 0) {
+	if (cto_descr_check(pcp, path, layout, set->poolsize) != 0) {
 		LOG(2, "descriptor check failed");
 		goto err;
 	}
@@ -513,8 +1106,16 @@ cto_open_common(const char *path, const char *layout, unsigned flags)
 		goto err;
 	}
 
+	/* not closed properly, the descriptor check found a checkpoint */
+	if (pcp->consistent == 0 && cto_ckpt_restore(pcp, path) != 0) {
+		ERR("cannot restore checkpoint %ju",
+				(uintmax_t)pcp->checkpoint);
+		goto err;
+	}
+
 	/* initialize runtime parts */
-	if (cto_runtime_init(pcp, set->rdonly, set->replica[0]->is_pmem) != 0) {
+	if (cto_runtime_init(pcp, path, set->rdonly,
+			set->replica[0]->is_pmem) != 0) {
 		ERR("pool initialization failed");
 		goto err;
 	}
@@ -533,6 +1134,7 @@ cto_open_common(const char *path, const char *layout, unsigned flags)
 			(void *)((uintptr_t)pcp + CTO_DSC_SIZE_ALIGNED),
 			set->poolsize - CTO_DSC_SIZE_ALIGNED, 0, 0) == NULL) {
 		ERR("pool creation failed");
+		cto_runtime_fini(pcp);
 		util_unmap((void *)pcp->addr, pcp->size);
 		goto err;
 	}
@@ -617,15 +1219,21 @@ pmemcto_close(PMEMctopool *pcp)
 		return;
 	}
 
-	/* deep flush the entire pool to persistence */
+	/* deep flush the pool to persistence */
 	RANGE_RW((void *)pcp->addr, sizeof(struct pool_hdr), pcp->is_dev_dax);
 	VALGRIND_DO_MAKE_MEM_DEFINED(pcp->addr, pcp->size);
 
+	/*
+	 * If the ranges modified since open are known, flush only those
+	 * and just deep drain the parts.  Otherwise flush the entire pool.
+	 */
+	int flush = cto_dirty_walk(pcp, cto_dirty_flush_cb, NULL, 0) != 0;
+
 	/* so far, there could be only one replica in CTO pool set */
 	struct pool_replica *rep = REP(pcp->set, 0);
 	for (unsigned p = 0; p < rep->nparts; p++) {
 		struct pool_set_part *part = PART(rep, p);
-		os_part_deep_common(rep, p, part->addr, part->size, 1);
+		os_part_deep_common(rep, p, part->addr, part->size, flush);
 	}
 
 	/* set consistency flag */
@@ -633,12 +1241,156 @@ pmemcto_close(PMEMctopool *pcp)
 	os_part_deep_common(REP(pcp->set, 0), 0,
 			&pcp->consistent, sizeof(pcp->consistent), 1);
 
+	cto_runtime_fini(pcp);
 
 	util_mutex_lock(&Pool_lock);
 	util_poolset_close(pcp->set, DO_NOT_DELETE_PARTS);
 	util_mutex_unlock(&Pool_lock);
 }
 
+/*
+ * pmemcto_checkpoint -- save the current state of the pool
+ *
+ * Writes the state of the pool to the checkpoint image not used by the
+ * previous checkpoint and switches to it, so the pool is rolled back to
+ * this image if it is not closed.  The image holds the checkpoint before
+ * the previous one, so if the ranges modified since then are known, only
+ * those are copied.
+ */
+int
+pmemcto_checkpoint(PMEMctopool *pcp)
+{
+	LOG(3, "pcp %p", pcp);
+
+	if (pcp->rdonly) {
+		ERR("EROFS (pool is read-only)");
+		errno = EROFS;
+		return -1;
+	}
+
+	pool_t *pool = (pool_t *)((uintptr_t)pcp + CTO_DSC_SIZE_ALIGNED);
+
+	/* no changes to the heap metadata until it is saved */
+	je_cto_pool_quiesce(pool);
+
+	int ret = -1;
+	struct cto_ckpt_ranges cur = { NULL, 0, 0 };
+
+	if (pcp->ckpt_addr == NULL && cto_ckpt_map(pcp) != 0) {
+		ERR("cannot map checkpoint image \"%s\"", pcp->ckpt_path);
+		goto out;
+	}
+
+	uint64_t checkpoint = pcp->checkpoint + 1;
+	unsigned img = CTO_CKPT_IMAGE(checkpoint);
+	char *image = cto_ckpt_image(pcp, img);
+	struct cto_ckpt_hdr *hdr = (struct cto_ckpt_hdr *)image;
+
+	/*
+	 * The image holds the checkpoint before the previous one, which the
+	 * pool does not refer to anymore.  It is not usable until it is
+	 * entirely written.
+	 */
+	hdr->checkpoint = 0;
+	if (pmem_msync(hdr, sizeof(*hdr))) {
+		ERR("!cannot invalidate checkpoint image");
+		goto out;
+	}
+
+	/*
+	 * Read and reset the ranges modified since the previous checkpoint
+	 * before copying them, so that the stores done meanwhile are saved
+	 * by the next checkpoint.  Until this one succeeds, neither image
+	 * can be brought up to date by copying only the modified ranges.
+	 */
+	uint64_t saved = pcp->ckpt_saved[img];
+	uint64_t other_saved = pcp->ckpt_saved[!img];
+	memset(pcp->ckpt_saved, 0, sizeof(pcp->ckpt_saved));
+
+	int flush = cto_dirty_walk(pcp, cto_ckpt_ranges_add_cb, &cur, 1) != 0;
+
+	/*
+	 * If the ranges modified since the checkpoint held by the image are
+	 * known, save and flush only those and just deep drain the parts.
+	 * Otherwise copy and flush the entire pool.
+	 */
+	VALGRIND_DO_DISABLE_ERROR_REPORTING;
+	if (!flush) {
+		for (size_t i = 0; i < cur.nranges; ++i)
+			pmem_deep_flush((void *)cur.ranges[i].addr,
+					cur.ranges[i].len);
+	}
+
+	if (!flush && saved != 0 && saved + CTO_CKPT_IMAGES == checkpoint) {
+		cto_ckpt_copy_ranges(pcp, image, &pcp->ckpt_prev);
+		cto_ckpt_copy_ranges(pcp, image, &cur);
+	} else {
+		cto_ckpt_copy(pcp, image, pcp->addr, pcp->size);
+	}
+	VALGRIND_DO_ENABLE_ERROR_REPORTING;
+
+	((struct pmemcto *)image)->checkpoint = checkpoint;
+
+	if (pmem_msync(image, pcp->size)) {
+		ERR("!cannot write checkpoint image");
+		goto out;
+	}
+
+	memcpy(hdr->signature, CTO_CKPT_SIG, POOL_HDR_SIG_LEN);
+	memcpy(hdr->poolset_uuid, pcp->set->uuid, POOL_HDR_UUID_LEN);
+	hdr->addr = pcp->addr;
+	hdr->size = pcp->size;
+	hdr->checkpoint = checkpoint;
+	if (pmem_msync(hdr, sizeof(*hdr))) {
+		ERR("!cannot write checkpoint image");
+		goto out;
+	}
+
+	/* the pool content is needed on close, which flushes only new ranges */
+	struct pool_replica *rep = REP(pcp->set, 0);
+	for (unsigned p = 0; p < rep->nparts; p++) {
+		struct pool_set_part *part = PART(rep, p);
+		char *addr = part->addr;
+		size_t len = part->size;
+
+		/* pool header is not accessible, and never modified anyway */
+		if (p == 0) {
+			addr += sizeof(struct pool_hdr);
+			len -= sizeof(struct pool_hdr);
+		}
+
+		if (os_part_deep_common(rep, p, addr, len, flush)) {
+			ERR("!cannot flush the pool");
+			goto out;
+		}
+	}
+
+	/* from now on the pool is rolled back to this image if not closed */
+	pcp->checkpoint = checkpoint;
+	os_part_deep_common(rep, 0, &pcp->checkpoint,
+			sizeof(pcp->checkpoint), 1);
+
+	/*
+	 * The other image needs the ranges modified since its checkpoint,
+	 * which are the ones saved by this checkpoint, if they are known.
+	 */
+	pcp->ckpt_saved[img] = checkpoint;
+	if (!flush)
+		pcp->ckpt_saved[!img] = other_saved;
+
+	Free(pcp->ckpt_prev.ranges);
+	pcp->ckpt_prev = cur;
+	cur.ranges = NULL;
+
+	ret = 0;
+
+	LOG(4, "checkpoint %ju", (uintmax_t)checkpoint);
+out:
+	Free(cur.ranges);
+	je_cto_pool_resume(pool);
+	return ret;
+}
+
 /*
  * pmemcto_set_root_pointer -- saves pointer to root object
  */
@@ -669,6 +1421,34 @@ pmemcto_get_root_pointer(PMEMctopool *pcp)
 	return (void *)pcp->root;
 }
 
+/*
+ * pmemcto_mark_dirty -- mark the range as modified since the last checkpoint
+ *
+ * Stores done by the CPU are tracked automatically, this is needed only for
+ * modifications the kernel cannot see, e.g. done by DMA.
+ */
+void
+pmemcto_mark_dirty(PMEMctopool *pcp, const void *ptr, size_t size)
+{
+	LOG(3, "pcp %p ptr %p size %zu", pcp, ptr, size);
+
+	if ((char *)ptr < (char *)pcp->addr + CTO_DSC_SIZE_ALIGNED ||
+	    (char *)ptr + size > (char *)pcp->addr + pcp->size) {
+		ERR("range out of pool: ptr %p size %zu", ptr, size);
+		return;
+	}
+
+	struct cto_dirty *d = pcp->dirty;
+
+	/* without tracking the entire pool is flushed on close */
+	if (d == NULL || size == 0)
+		return;
+
+	util_mutex_lock(&d->lock);
+	cto_dirty_add(d, (uintptr_t)ptr, size);
+	util_mutex_unlock(&d->lock);
+}
+
 /*
  * pmemcto_checkU -- memory pool consistency check
  */
@@ -748,6 +1528,52 @@ pmemcto_stats_print(PMEMctopool *pcp, const char *opts)
 			cto_print_jemalloc_stats, NULL, opts);
 }
 
+/*
+ * pmemcto_ctl_get -- read a value of the pool's allocator control entry
+ */
+int
+pmemcto_ctl_get(PMEMctopool *pcp, const char *name, void *oldp,
+		size_t *oldlenp)
+{
+	LOG(3, "pcp %p name \"%s\" oldp %p oldlenp %p", pcp, name, oldp,
+			oldlenp);
+
+	int ret = je_cto_pool_ctl(
+			(pool_t *)((uintptr_t)pcp + CTO_DSC_SIZE_ALIGNED),
+			name, oldp, oldlenp, NULL, 0);
+
+	if (ret != 0) {
+		errno = ret;
+		ERR("!cannot read \"%s\"", name);
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * pmemcto_ctl_set -- modify the pool's allocator control entry
+ */
+int
+pmemcto_ctl_set(PMEMctopool *pcp, const char *name, void *newp,
+		size_t newlen)
+{
+	LOG(3, "pcp %p name \"%s\" newp %p newlen %zu", pcp, name, newp,
+			newlen);
+
+	int ret = je_cto_pool_ctl(
+			(pool_t *)((uintptr_t)pcp + CTO_DSC_SIZE_ALIGNED),
+			name, NULL, NULL, newp, newlen);
+
+	if (ret != 0) {
+		errno = ret;
+		ERR("!cannot write \"%s\"", name);
+		return -1;
+	}
+
+	return 0;
+}
+
 /*
  * pmemcto_malloc -- allocate memory
  */
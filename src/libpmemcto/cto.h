@@ -43,6 +43,7 @@
 #define PMEMCTO_LOG_PREFIX "libpmemcto"
 #define PMEMCTO_LOG_LEVEL_VAR "PMEMCTO_LOG_LEVEL"
 #define PMEMCTO_LOG_FILE_VAR "PMEMCTO_LOG_FILE"
+#define PMEMCTO_DIRTY_TRACKING_VAR "PMEMCTO_DIRTY_TRACKING"
 
 /* attributes of the cto memory pool format for the pool header */
 #define CTO_HDR_SIG "PMEMCTO"	/* must be 8 bytes including '\0' */
@@ -56,10 +57,67 @@
 #define CTO_FORMAT_INCOMPAT_CHECK POOL_FEAT_ALL
 #define CTO_FORMAT_RO_COMPAT_CHECK 0x0000
 
+/* maximum number of explicitly marked dirty ranges tracked per pool */
+#define CTO_DIRTY_RANGES_MAX 1024
+
 /* size of the persistent part of PMEMOBJ pool descriptor (2kB) */
 #define CTO_DSC_P_SIZE		2048
 /* size of unused part of the persistent part of PMEMOBJ pool descriptor */
-#define CTO_DSC_P_UNUSED	(CTO_DSC_P_SIZE - PMEMCTO_MAX_LAYOUT - 28)
+#define CTO_DSC_P_UNUSED	(CTO_DSC_P_SIZE - PMEMCTO_MAX_LAYOUT - 40)
+
+struct cto_range {
+	uintptr_t addr;
+	size_t len;
+};
+
+/*
+ * Run-time state of dirty ranges tracking, used to flush only the modified
+ * parts of the pool on checkpoint and close.  Stores to the pool are tracked
+ * by the kernel (soft-dirty bits), the ranges below are the ones marked
+ * explicitly with pmemcto_mark_dirty(), e.g. modified by DMA.
+ */
+struct cto_dirty {
+	os_mutex_t lock;	/* protects the fields below */
+	unsigned nranges;	/* number of marked ranges */
+	int overflow;		/* true if the marked ranges didn't fit */
+	struct cto_range ranges[CTO_DIRTY_RANGES_MAX];
+};
+
+/* the checkpoint images are kept in a file named after the pool */
+#define CTO_CKPT_SUFFIX ".checkpoint"
+#define CTO_CKPT_SIG "PMEMCKP"	/* must be 8 bytes including '\0' */
+
+/*
+ * The file holds two images of the pool size, used alternately, so that
+ * the image of the previous checkpoint stays intact while the next one is
+ * written.  Checkpoint n is saved to the image of index n % 2.
+ */
+#define CTO_CKPT_IMAGES 2
+#define CTO_CKPT_IMAGE(checkpoint) ((unsigned)((checkpoint) % CTO_CKPT_IMAGES))
+
+/*
+ * Header of the checkpoint image.  The rest of the image is a copy
+ * of the pool at the same offsets, so the header takes the place of the
+ * pool header, which is never copied.  The image is valid only if its
+ * checkpoint number matches the one stored in the pool descriptor.
+ */
+struct cto_ckpt_hdr {
+	char signature[POOL_HDR_SIG_LEN];
+	uuid_t poolset_uuid;	/* pool set the image belongs to */
+	uint64_t addr;		/* mapping address of the pool */
+	uint64_t size;		/* size of the pool */
+	uint64_t checkpoint;	/* number of the checkpoint, 0 if invalid */
+};
+
+/*
+ * Ranges modified between two checkpoints, needed to bring the image
+ * of the checkpoint before the previous one up to date.
+ */
+struct cto_ckpt_ranges {
+	struct cto_range *ranges;
+	size_t nranges;
+	size_t size;		/* number of allocated entries */
+};
 
 /*
  * XXX: We don't care about portable data types, as the pool may only be open
@@ -77,6 +135,7 @@ struct pmemcto {
 	uint64_t root;		/* root pointer */
 
 	uint8_t consistent;	/* successfully flushed before exit */
+	uint64_t checkpoint;	/* number of the last checkpoint, 0 if none */
 	unsigned char unused[CTO_DSC_P_UNUSED]; /* must be zero */
 
 	/* some run-time state, allocated out of memory pool... */
@@ -84,6 +143,12 @@ struct pmemcto {
 	int is_pmem;		/* true if pool is PMEM */
 	int rdonly;		/* true if pool is opened read-only */
 	int is_dev_dax;		/* true if mapped on device dax */
+	struct cto_dirty *dirty; /* dirty ranges tracking, NULL if disabled */
+	char *ckpt_path;	/* path of the checkpoint image */
+	void *ckpt_addr;	/* mapping of the images, NULL if unmapped */
+	/* checkpoint saved to each image since open, 0 if not known */
+	uint64_t ckpt_saved[CTO_CKPT_IMAGES];
+	struct cto_ckpt_ranges ckpt_prev; /* modified before last checkpoint */
 };
 
 /* data area starts at this alignment after the struct pmemcto above */
@@ -118,6 +183,9 @@ void cto_fini(void);
 #define je_cto_pool_extend je_vmem_pool_extend
 #define je_cto_pool_set_alloc_funcs je_vmem_pool_set_alloc_funcs
 #define je_cto_pool_check je_vmem_pool_check
+#define je_cto_pool_ctl je_vmem_pool_ctl
+#define je_cto_pool_quiesce je_vmem_pool_quiesce
+#define je_cto_pool_resume je_vmem_pool_resume
 #define je_cto_malloc_message je_vmem_malloc_message
 #endif
 
@@ -0,0 +1,728 @@
+/*
+ * Copyright 2018, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * backup.c -- online backup of an open pool
+ *
+ * The pool is copied by a number of threads while the application keeps
+ * using it.  Every modification of the pool has to be flushed to become
+ * persistent, so the ranges modified in the meantime are recorded by the
+ * pmem operations of the pool and copied again in subsequent rounds.  The last
+ * round is done with all the lanes held, so no transaction or atomic
+ * operation is in progress while it completes.  The backup contains the state
+ * of the pool at that moment, which is recovered when the backup is opened
+ * like after a crash.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "libpmem.h"
+#include "libpmemobj.h"
+#include "backup.h"
+#include "file.h"
+#include "lane.h"
+#include "mmap.h"
+#include "obj.h"
+#include "os.h"
+#include "os_thread.h"
+#include "out.h"
+#include "set.h"
+#include "util.h"
+#include "valgrind_internal.h"
+
+/* granularity of tracking modified ranges of the pool */
+#define BACKUP_UNIT_SHIFT 16
+#define BACKUP_UNIT_SIZE ((size_t)1 << BACKUP_UNIT_SHIFT) /* 64 KiB */
+
+/* number of units handed out to a copying thread at once (4 MiB) */
+#define BACKUP_CHUNK_UNITS 64
+
+/* maximum number of copying threads */
+#define BACKUP_MAX_THREADS 8
+
+/* maximum number of rounds of copying done without holding the lanes */
+#define BACKUP_MAX_ROUNDS 4
+
+/* the last round starts when fewer units than this are modified (16 MiB) */
+#define BACKUP_FINAL_UNITS 256
+
+/*
+ * obj_backup -- tracking of modified ranges, kept until the pool is closed
+ */
+struct obj_backup {
+	int active;		/* modifications are tracked */
+	int busy;		/* backup in progress */
+	uintptr_t base;		/* beginning of the tracked range */
+	size_t size;		/* size of the tracked range */
+	size_t nunits;		/* number of tracked units */
+	size_t nwords;		/* size of the bitmaps in 64-bit words */
+	uint64_t *dirty;	/* units modified since the last round */
+	uint64_t *copy;		/* units to be copied in the current round */
+};
+
+/*
+ * backup_part -- destination part file
+ */
+struct backup_part {
+	const char *path;
+	const char *src_path;
+	int fd;
+	int created;		/* file was created by the backup */
+	void *addr;		/* mapping of the whole file */
+	size_t filesize;
+	int is_pmem;
+
+	struct pool_hdr *hdr;	/* copy of the source part header, if any */
+	size_t off;		/* offset of the part data within the pool */
+	size_t size;		/* size of the part data */
+	size_t data_off;	/* offset of the part data within the file */
+};
+
+/*
+ * backup_run -- state of the backup in progress
+ */
+struct backup_run {
+	PMEMobjpool *pop;
+	struct obj_backup *bkp;
+	struct pool_set *set;	/* destination poolset, if any */
+	struct backup_part *parts;
+	unsigned nparts;
+	unsigned nthreads;
+	size_t next;		/* next unit to be handed out */
+};
+
+/*
+ * backup_mark -- record modification of the pool range
+ */
+void
+backup_mark(struct obj_backup *bkp, const void *addr, size_t len)
+{
+	if (!bkp->active || len == 0)
+		return;
+
+	uintptr_t start = (uintptr_t)addr;
+	if (start < bkp->base || start - bkp->base >= bkp->size)
+		return;
+
+	size_t off = start - bkp->base;
+	size_t end = off + len < bkp->size ? off + len : bkp->size;
+	size_t last = (end - 1) >> BACKUP_UNIT_SHIFT;
+
+	for (size_t u = off >> BACKUP_UNIT_SHIFT; u <= last; ++u) {
+		uint64_t *word = &bkp->dirty[u / 64];
+		uint64_t bit = 1ULL << (u % 64);
+
+		/* avoid bouncing the cache line if already marked */
+		if (!(*word & bit))
+			util_fetch_and_or64(word, bit);
+	}
+}
+
+/*
+ * backup_new -- (internal) allocate tracking of modified ranges of the pool
+ */
+static struct obj_backup *
+backup_new(PMEMobjpool *pop)
+{
+	struct pool_replica *rep = pop->set->replica[0];
+
+	struct obj_backup *bkp = Zalloc(sizeof(*bkp));
+	if (bkp == NULL) {
+		ERR("!Zalloc");
+		return NULL;
+	}
+
+	bkp->base = (uintptr_t)pop;
+	for (unsigned p = 0; p < rep->nparts; ++p)
+		bkp->size += rep->part[p].size;
+
+	bkp->nunits = (bkp->size + BACKUP_UNIT_SIZE - 1) >> BACKUP_UNIT_SHIFT;
+	bkp->nwords = (bkp->nunits + 63) / 64;
+
+	bkp->dirty = Zalloc(bkp->nwords * sizeof(uint64_t));
+	bkp->copy = Zalloc(bkp->nwords * sizeof(uint64_t));
+	if (bkp->dirty == NULL || bkp->copy == NULL) {
+		ERR("!Zalloc");
+		backup_delete(bkp);
+		return NULL;
+	}
+
+	return bkp;
+}
+
+/*
+ * backup_delete -- free tracking of modified ranges of the pool
+ */
+void
+backup_delete(struct obj_backup *bkp)
+{
+	if (bkp == NULL)
+		return;
+
+	Free(bkp->dirty);
+	Free(bkp->copy);
+	Free(bkp);
+}
+
+/*
+ * backup_part_open -- (internal) open or create and map destination part
+ */
+static int
+backup_part_open(struct backup_part *part)
+{
+	if (os_access(part->path, F_OK) == 0) {
+		size_t size = 0;
+		part->fd = util_file_open(part->path, &size, 0, O_RDWR);
+		if (part->fd < 0)
+			return -1;
+
+		if (size != part->filesize) {
+			ERR("size of \"%s\" (%zu) does not match the source "
+				"part (%zu)", part->path, size,
+				part->filesize);
+			errno = EINVAL;
+			return -1;
+		}
+	} else if (errno == ENOENT) {
+		part->fd = util_file_create(part->path, part->filesize, 0);
+		if (part->fd < 0)
+			return -1;
+		part->created = 1;
+	} else {
+		ERR("!access \"%s\"", part->path);
+		return -1;
+	}
+
+	int map_sync;
+	part->addr = util_map(part->fd, part->filesize, MAP_SHARED, 0, 0,
+			&map_sync);
+	if (part->addr == NULL)
+		return -1;
+
+	part->is_pmem = util_file_is_device_dax(part->path) || map_sync ||
+		pmem_is_pmem(part->addr, part->filesize);
+
+	return 0;
+}
+
+/*
+ * backup_hdr_read -- (internal) read the header of the source part
+ *
+ * Headers of the parts other than the first one are not mapped while
+ * the pool is open.
+ */
+static int
+backup_hdr_read(struct backup_part *part)
+{
+	part->hdr = Malloc(sizeof(*part->hdr));
+	if (part->hdr == NULL) {
+		ERR("!Malloc");
+		return -1;
+	}
+
+	int fd = os_open(part->src_path, O_RDONLY);
+	if (fd < 0) {
+		ERR("!open \"%s\"", part->src_path);
+		return -1;
+	}
+
+	ssize_t ret = pread(fd, part->hdr, sizeof(*part->hdr), 0);
+	(void) os_close(fd);
+	if (ret != (ssize_t)sizeof(*part->hdr)) {
+		if (ret >= 0)
+			errno = EIO;
+		ERR("!cannot read the header of \"%s\"", part->src_path);
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * backup_parts_close -- (internal) unmap and close destination parts,
+ *	remove the created ones on error
+ */
+static void
+backup_parts_close(struct backup_run *run, int error)
+{
+	for (unsigned p = 0; p < run->nparts; ++p) {
+		struct backup_part *part = &run->parts[p];
+
+		if (part->addr != NULL)
+			util_unmap(part->addr, part->filesize);
+		if (part->fd >= 0)
+			(void) os_close(part->fd);
+		Free(part->hdr);
+		if (!part->created)
+			continue;
+
+		if (error) {
+			(void) os_unlink(part->path);
+			continue;
+		}
+
+		/* created files have no permissions, use those of the source */
+		os_stat_t st;
+		if (os_stat(part->src_path, &st) ||
+		    os_chmod(part->path, st.st_mode & (S_IRWXU | S_IRWXG |
+				S_IRWXO)))
+			ERR("!cannot set permissions of \"%s\"", part->path);
+	}
+
+	Free(run->parts);
+	run->parts = NULL;
+
+	if (run->set != NULL) {
+		util_poolset_free(run->set);
+		run->set = NULL;
+	}
+}
+
+/*
+ * backup_parts_open -- (internal) open destination file or parts of
+ *	the destination poolset
+ */
+static int
+backup_parts_open(struct backup_run *run, const char *path)
+{
+	struct pool_set *sset = run->pop->set;
+	struct pool_replica *srep = sset->replica[0];
+
+	int is_poolset = os_access(path, F_OK) == 0 ?
+		util_is_poolset_file(path) : 0;
+	if (is_poolset < 0)
+		return -1;
+
+	if (is_poolset) {
+		int fd = os_open(path, O_RDONLY);
+		if (fd < 0) {
+			ERR("!open \"%s\"", path);
+			return -1;
+		}
+
+		int ret = util_poolset_parse(&run->set, path, fd);
+		(void) os_close(fd);
+		if (ret)
+			return -1;
+
+		if (run->set->nreplicas != 1 || run->set->remote) {
+			ERR("destination poolset must have exactly one local "
+				"replica");
+			errno = EINVAL;
+			return -1;
+		}
+		if (run->set->replica[0]->nparts != srep->nparts) {
+			ERR("number of parts of the destination poolset (%u) "
+				"does not match the source (%u)",
+				run->set->replica[0]->nparts, srep->nparts);
+			errno = EINVAL;
+			return -1;
+		}
+	} else if (srep->nparts != 1) {
+		ERR("backup of a pool with multiple parts requires "
+			"a poolset destination");
+		errno = EINVAL;
+		return -1;
+	}
+
+	run->nparts = srep->nparts;
+	run->parts = Zalloc(run->nparts * sizeof(*run->parts));
+	if (run->parts == NULL) {
+		ERR("!Zalloc");
+		return -1;
+	}
+	for (unsigned p = 0; p < run->nparts; ++p)
+		run->parts[p].fd = -1;
+
+	size_t hdrsize = (sset->options & (OPTION_SINGLEHDR | OPTION_NOHDRS)) ?
+		0 : Mmap_align;
+
+	for (unsigned p = 0; p < run->nparts; ++p) {
+		struct backup_part *part = &run->parts[p];
+		struct pool_set_part *spart = &srep->part[p];
+
+		part->path = is_poolset ?
+			run->set->replica[0]->part[p].path : path;
+		part->src_path = spart->path;
+		part->filesize = spart->filesize;
+		if (is_poolset && run->set->replica[0]->part[p].filesize !=
+				part->filesize) {
+			ERR("size of the part %u of the destination poolset "
+				"does not match the source", p);
+			errno = EINVAL;
+			return -1;
+		}
+
+		part->off = (size_t)((uintptr_t)spart->addr -
+			(uintptr_t)run->pop);
+		part->size = spart->size;
+		if (p > 0 && hdrsize != 0) {
+			part->data_off = hdrsize;
+			if (backup_hdr_read(part))
+				return -1;
+		}
+
+		if (backup_part_open(part))
+			return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * backup_persist -- (internal) make the range of the destination part
+ *	persistent
+ */
+static void
+backup_persist(struct backup_part *part, const void *addr, size_t len)
+{
+	if (part->is_pmem)
+		pmem_persist(addr, len);
+	else if (pmem_msync(addr, len))
+		FATAL("!pmem_msync");
+}
+
+/*
+ * backup_write -- (internal) copy data to the destination part and make
+ *	them persistent
+ */
+static void
+backup_write(struct backup_part *part, size_t off, const void *src,
+	size_t len)
+{
+	char *dst = (char *)part->addr + off;
+
+	if (part->is_pmem) {
+		pmem_memcpy_persist(dst, src, len);
+	} else {
+		memcpy(dst, src, len);
+		backup_persist(part, dst, len);
+	}
+}
+
+/*
+ * backup_copy -- (internal) copy the range of the pool to the destination
+ */
+static void
+backup_copy(struct backup_run *run, size_t off, size_t len)
+{
+	size_t end = off + len;
+
+	for (unsigned p = 0; p < run->nparts && off < end; ++p) {
+		struct backup_part *part = &run->parts[p];
+		if (off >= part->off + part->size)
+			continue;
+
+		size_t pend = part->off + part->size < end ?
+			part->off + part->size : end;
+
+		backup_write(part, part->data_off + (off - part->off),
+			(char *)run->pop + off, pend - off);
+
+		off = pend;
+	}
+}
+
+/*
+ * backup_worker -- (internal) copy the units selected for the current round
+ */
+static void *
+backup_worker(void *arg)
+{
+	struct backup_run *run = arg;
+	struct obj_backup *bkp = run->bkp;
+
+	while (1) {
+		size_t first = util_fetch_and_add64(&run->next,
+				BACKUP_CHUNK_UNITS);
+		if (first >= bkp->nunits)
+			break;
+
+		size_t last = first + BACKUP_CHUNK_UNITS < bkp->nunits ?
+			first + BACKUP_CHUNK_UNITS : bkp->nunits;
+
+		/* copy runs of consecutive selected units at once */
+		size_t u = first;
+		while (u < last) {
+			if (!(bkp->copy[u / 64] & (1ULL << (u % 64)))) {
+				++u;
+				continue;
+			}
+
+			size_t start = u;
+			while (u < last && (bkp->copy[u / 64] &
+					(1ULL << (u % 64))))
+				++u;
+
+			size_t off = start << BACKUP_UNIT_SHIFT;
+			size_t end = u << BACKUP_UNIT_SHIFT;
+			if (end > bkp->size)
+				end = bkp->size;
+
+			backup_copy(run, off, end - off);
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * backup_round -- (internal) copy the selected units using multiple threads
+ */
+static void
+backup_round(struct backup_run *run)
+{
+	os_thread_t threads[BACKUP_MAX_THREADS];
+	unsigned started = 0;
+
+	run->next = 0;
+
+	/* the calling thread is one of the workers */
+	for (; started < run->nthreads - 1; ++started) {
+		errno = os_thread_create(&threads[started], NULL,
+				backup_worker, run);
+		if (errno) {
+			ERR("!os_thread_create");
+			break; /* the running workers copy the rest */
+		}
+	}
+
+	backup_worker(run);
+
+	for (unsigned i = 0; i < started; ++i)
+		os_thread_join(&threads[i], NULL);
+}
+
+/*
+ * backup_collect -- (internal) select units modified since the last round
+ *	to be copied, returns their number
+ */
+static size_t
+backup_collect(struct obj_backup *bkp)
+{
+	size_t n = 0;
+
+	for (size_t w = 0; w < bkp->nwords; ++w) {
+		bkp->copy[w] = bkp->dirty[w] ?
+			util_fetch_and_and64(&bkp->dirty[w], 0) : 0;
+		n += util_popcount64(bkp->copy[w]);
+	}
+
+	return n;
+}
+
+/*
+ * backup_pending -- (internal) count units modified since the last round
+ */
+static size_t
+backup_pending(struct obj_backup *bkp)
+{
+	size_t n = 0;
+
+	for (size_t w = 0; w < bkp->nwords; ++w)
+		n += util_popcount64(bkp->dirty[w]);
+
+	return n;
+}
+
+/*
+ * backup_finish -- (internal) copy the headers of the parts, reset their
+ *	shutdown state and unlink them from the source replicas
+ *
+ * The headers of the source parts are marked dirty while the pool is open.
+ * The backup is complete and persistent at this point, so it is not subject
+ * to an unsafe shutdown of the source device.
+ */
+static void
+backup_finish(struct backup_run *run)
+{
+	struct pool_hdr *hdr0 = run->parts[0].addr;
+
+	for (unsigned p = 0; p < run->nparts; ++p) {
+		struct backup_part *part = &run->parts[p];
+
+		/* the header of the first part is a part of the pool data */
+		if (p > 0) {
+			if (part->hdr == NULL)
+				continue;
+			memcpy(part->addr, part->hdr, sizeof(*part->hdr));
+		}
+
+		struct pool_hdr *hdr = part->addr;
+		memset(&hdr->sds, 0, sizeof(hdr->sds));
+
+		/* the copy is a single replica, do not link the source ones */
+		memcpy(hdr->prev_repl_uuid, hdr0->uuid, POOL_HDR_UUID_LEN);
+		memcpy(hdr->next_repl_uuid, hdr0->uuid, POOL_HDR_UUID_LEN);
+		util_checksum(hdr, sizeof(*hdr), &hdr->checksum, 1,
+			POOL_HDR_CSUM_END_OFF);
+
+		backup_persist(part, hdr, POOL_HDR_SIZE);
+	}
+}
+
+/*
+ * backup_run -- (internal) copy the pool to the opened destination
+ */
+static void
+backup_run(struct backup_run *run)
+{
+	PMEMobjpool *pop = run->pop;
+	struct obj_backup *bkp = run->bkp;
+
+	/*
+	 * Start tracking while no operation is in progress, so that each of
+	 * them either completes before the first round or is tracked.
+	 */
+	lane_hold_all(pop);
+	memset(bkp->dirty, 0, bkp->nwords * sizeof(uint64_t));
+	util_fetch_and_or32(&bkp->active, 1);
+	lane_release_all(pop);
+
+	/* the pool header is not accessible in debug builds */
+	RANGE_RO(pop->addr, sizeof(struct pool_hdr), pop->is_dev_dax);
+
+	memset(bkp->copy, 0xff, bkp->nwords * sizeof(uint64_t));
+	backup_round(run);
+
+	for (int r = 0; r < BACKUP_MAX_ROUNDS; ++r) {
+		if (backup_pending(bkp) < BACKUP_FINAL_UNITS)
+			break;
+
+		LOG(4, "round %d", r + 1);
+		backup_collect(bkp);
+		backup_round(run);
+	}
+
+	lane_hold_all(pop);
+	size_t n = backup_collect(bkp);
+	LOG(4, "final round, %zu units", n);
+	backup_round(run);
+	util_fetch_and_and32(&bkp->active, 0);
+	lane_release_all(pop);
+
+	RANGE_NONE(pop->addr, sizeof(struct pool_hdr), pop->is_dev_dax);
+
+	backup_finish(run);
+}
+
+/*
+ * pmemobj_backupU -- make a consistent copy of the open pool
+ */
+#ifndef _WIN32
+static inline
+#endif
+int
+pmemobj_backupU(PMEMobjpool *pop, const char *path, unsigned flags)
+{
+	LOG(3, "pop %p path %s flags 0x%x", pop, path, flags);
+
+	if (flags != 0) {
+		ERR("invalid flags 0x%x", flags);
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (pmemobj_tx_stage() != TX_STAGE_NONE) {
+		ERR("backup cannot be made within a transaction");
+		errno = EBUSY;
+		return -1;
+	}
+
+	if (pop->backup == NULL) {
+		struct obj_backup *bkp = backup_new(pop);
+		if (bkp == NULL)
+			return -1;
+
+		if (!util_bool_compare_and_swap64(&pop->backup, NULL, bkp))
+			backup_delete(bkp);
+	}
+
+	struct obj_backup *bkp = pop->backup;
+	if (!util_bool_compare_and_swap32(&bkp->busy, 0, 1)) {
+		ERR("backup of the pool already in progress");
+		errno = EBUSY;
+		return -1;
+	}
+
+	struct backup_run run;
+	memset(&run, 0, sizeof(run));
+	run.pop = pop;
+	run.bkp = bkp;
+
+	long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	run.nthreads = ncpus > BACKUP_MAX_THREADS ? BACKUP_MAX_THREADS :
+		(ncpus > 0 ? (unsigned)ncpus : 1);
+
+	int ret = backup_parts_open(&run, path);
+	if (ret == 0)
+		backup_run(&run);
+
+	int oerrno = errno;
+	backup_parts_close(&run, ret);
+
+	util_bool_compare_and_swap32(&bkp->busy, 1, 0);
+
+	errno = oerrno;
+	return ret;
+}
+
+#ifndef _WIN32
+/*
+ * pmemobj_backup -- make a consistent copy of the open pool
+ */
+int
+pmemobj_backup(PMEMobjpool *pop, const char *path, unsigned flags)
+{
+	return pmemobj_backupU(pop, path, flags);
+}
+#else
+/*
+ * pmemobj_backupW -- make a consistent copy of the open pool
+ */
+int
+pmemobj_backupW(PMEMobjpool *pop, const wchar_t *path, unsigned flags)
+{
+	char *upath = util_toUTF8(path);
+	if (upath == NULL)
+		return -1;
+
+	int ret = pmemobj_backupU(pop, upath, flags);
+
+	util_free_UTF8(upath);
+	return ret;
+}
+#endif
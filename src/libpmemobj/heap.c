@@ -64,6 +64,14 @@
  */
 #define HEAP_DEFAULT_GROW_SIZE (1 << 27) /* 128 megabytes */
 
+/*
+ * Zones of large heaps are verified in parallel, by up to
+ * HEAP_CHECK_MAX_THREADS threads, each one verifying at least
+ * HEAP_CHECK_ZONES_PER_THREAD zones on average.
+ */
+#define HEAP_CHECK_MAX_THREADS 8
+#define HEAP_CHECK_ZONES_PER_THREAD 4
+
 /*
  * Arenas store the collection of buckets for allocation classes. Each thread
  * is assigned an arena on its first allocator operation.
@@ -75,6 +83,16 @@ struct arena {
 	size_t nthreads;
 };
 
+/*
+ * State of the parallel heap verification shared by all the workers.
+ */
+struct heap_check_ctx {
+	struct heap_layout *layout;
+	unsigned nzones;
+	unsigned next_zone; /* the next zone to be verified */
+	unsigned failed_zone; /* the first inconsistent zone or nzones */
+};
+
 struct heap_rt {
 	struct alloc_class_collection *alloc_classes;
 
@@ -1552,6 +1570,42 @@ heap_verify_zone(struct zone *zone)
 	return 0;
 }
 
+/*
+ * heap_check_worker -- (internal) verify zones of the heap until all of them
+ *                      are verified or an inconsistent zone is found
+ *
+ * Zones are taken in order, so when an inconsistent zone is found, all zones
+ * with lower ids have been taken already and only the zones with higher ids
+ * may be skipped.
+ */
+static void *
+heap_check_worker(void *arg)
+{
+	struct heap_check_ctx *ctx = arg;
+
+	while (1) {
+		unsigned zid = util_fetch_and_add32(&ctx->next_zone, 1);
+
+		unsigned failed;
+		util_atomic_load_explicit32(&ctx->failed_zone, &failed,
+			memory_order_acquire);
+		if (zid >= ctx->nzones || zid > failed)
+			break;
+
+		if (heap_verify_zone(ZID_TO_ZONE(ctx->layout, zid)) == 0)
+			continue;
+
+		/* remember the lowest id of an inconsistent zone */
+		do {
+			util_atomic_load_explicit32(&ctx->failed_zone, &failed,
+				memory_order_acquire);
+		} while (zid < failed && !util_bool_compare_and_swap32(
+				&ctx->failed_zone, failed, zid));
+	}
+
+	return NULL;
+}
+
 /*
  * heap_check -- verifies if the heap is consistent and can be opened properly
  *
@@ -1570,12 +1624,52 @@ heap_check(void *heap_start, uint64_t heap_size)
 	if (heap_verify_header(&layout->header))
 		return -1;
 
-	for (unsigned i = 0; i < heap_max_zone(heap_size); ++i) {
-		if (heap_verify_zone(ZID_TO_ZONE(layout, i)))
-			return -1;
+	unsigned nzones = heap_max_zone(heap_size);
+	unsigned nthreads = nzones / HEAP_CHECK_ZONES_PER_THREAD;
+	if (nthreads > HEAP_CHECK_MAX_THREADS)
+		nthreads = HEAP_CHECK_MAX_THREADS;
+
+	if (nthreads <= 1) {
+		for (unsigned i = 0; i < nzones; ++i) {
+			if (heap_verify_zone(ZID_TO_ZONE(layout, i)))
+				return -1;
+		}
+
+		return 0;
 	}
 
-	return 0;
+	struct heap_check_ctx ctx;
+	ctx.layout = layout;
+	ctx.nzones = nzones;
+	ctx.next_zone = 0;
+	ctx.failed_zone = nzones;
+
+	os_thread_t threads[HEAP_CHECK_MAX_THREADS];
+	unsigned started = 0;
+
+	/* the calling thread is one of the workers */
+	for (; started < nthreads - 1; ++started) {
+		if (os_thread_create(&threads[started], NULL,
+				heap_check_worker, &ctx))
+			break; /* the running workers check the rest */
+	}
+
+	heap_check_worker(&ctx);
+
+	for (unsigned i = 0; i < started; ++i)
+		os_thread_join(&threads[i], NULL);
+
+	if (ctx.failed_zone == nzones)
+		return 0;
+
+	/*
+	 * Verify the first inconsistent zone again in the calling thread,
+	 * so that the error message is set for it, as in the serial check.
+	 */
+	int ret = heap_verify_zone(ZID_TO_ZONE(layout, ctx.failed_zone));
+	ASSERTne(ret, 0);
+
+	return ret;
 }
 
 /*
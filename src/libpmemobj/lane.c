@@ -49,6 +49,7 @@
 #include "out.h"
 #include "util.h"
 #include "obj.h"
+#include "os.h"
 #include "os_thread.h"
 #include "valgrind_internal.h"
 
@@ -189,6 +190,15 @@ lane_init(PMEMobjpool *pop, struct lane *lane, struct lane_layout *layout)
 	int i;
 	int oerrno;
 
+	lane->remote = NULL;
+	if (pop->has_remote_replicas) {
+		lane->remote = Zalloc(sizeof(*lane->remote));
+		if (lane->remote == NULL) {
+			ERR("!Zalloc of remote persist batch");
+			return -1;
+		}
+	}
+
 	for (i = 0; i < MAX_LANE_SECTION; ++i) {
 		lane->sections[i].layout = &layout->sections[i];
 		errno = 0;
@@ -205,6 +215,8 @@ error_section_construct:
 	oerrno = errno;
 	for (i = i - 1; i >= 0; --i)
 		Section_ops[i]->destroy_rt(pop, &lane->sections[i].runtime);
+	Free(lane->remote);
+	lane->remote = NULL;
 	errno = oerrno;
 	return -1;
 }
@@ -217,6 +229,10 @@ lane_destroy(PMEMobjpool *pop, struct lane *lane)
 {
 	for (int i = 0; i < MAX_LANE_SECTION; ++i)
 		Section_ops[i]->destroy_rt(pop, lane->sections[i].runtime);
+
+	ASSERT(lane->remote == NULL || lane->remote->nranges == 0);
+	Free(lane->remote);
+	lane->remote = NULL;
 }
 
 /*
@@ -235,6 +251,7 @@ lane_boot(PMEMobjpool *pop)
 	}
 
 	pop->lanes_desc.next_lane_idx = 0;
+	pop->lanes_desc.holding_all = 0;
 
 	pop->lanes_desc.lane_locks =
 		Zalloc(sizeof(*pop->lanes_desc.lane_locks) * pop->nlanes);
@@ -481,6 +498,17 @@ lane_hold(PMEMobjpool *pop, struct lane_section **section,
 	uint64_t *llocks = pop->lanes_desc.lane_locks;
 	/* grab next free lane from lanes available at runtime */
 	if (!lane->nest_count++) {
+		/* let lane_hold_all grab the lanes as they are released */
+		int holding_all;
+		util_atomic_load_explicit32(&pop->lanes_desc.holding_all,
+			&holding_all, memory_order_acquire);
+		while (unlikely(holding_all)) {
+			sched_yield();
+			util_atomic_load_explicit32(
+				&pop->lanes_desc.holding_all,
+				&holding_all, memory_order_acquire);
+		}
+
 		get_lane(llocks, lane, pop->lanes_desc.runtime_nlanes);
 	}
 
@@ -522,6 +550,113 @@ lane_detach(PMEMobjpool *pop)
 	return (unsigned)lane->lane_idx;
 }
 
+/*
+ * lane_elapsed_ns -- (internal) returns the time elapsed since *start
+ */
+static uint64_t
+lane_elapsed_ns(const struct timespec *start)
+{
+	struct timespec now;
+	os_clock_gettime(CLOCK_MONOTONIC, &now);
+
+	int64_t ns = (int64_t)(now.tv_sec - start->tv_sec) * 1000000000LL +
+		(now.tv_nsec - start->tv_nsec);
+
+	return ns > 0 ? (uint64_t)ns : 0;
+}
+
+/*
+ * lane_wait_ns -- (internal) yields the processor for the given time
+ */
+static void
+lane_wait_ns(uint64_t ns)
+{
+	struct timespec start;
+	os_clock_gettime(CLOCK_MONOTONIC, &start);
+
+	while (lane_elapsed_ns(&start) < ns)
+		sched_yield();
+}
+
+/*
+ * lane_hold_all -- grabs all the lanes, waiting for the operations in progress
+ *	to finish
+ *
+ * A thread holding a lane may be waiting for a thread which has not taken
+ * a lane yet, e.g. a transaction started with TX_PARAM_MUTEX waits for
+ * a thread which locked the mutex before starting its own transaction. The
+ * latter is held off by the gate, so when the lanes cannot be grabbed in time
+ * the ones grabbed so far are dropped and the gate is opened for a while
+ * before trying again, with a longer timeout.
+ *
+ * Must not be called by a thread which holds a lane, nor by two threads at
+ * the same time.
+ */
+void
+lane_hold_all(PMEMobjpool *pop)
+{
+	uint64_t *llocks = pop->lanes_desc.lane_locks;
+	unsigned nlanes = pop->lanes_desc.runtime_nlanes;
+	uint64_t timeout = LANE_HOLD_ALL_TIMEOUT_NS;
+
+	while (1) {
+		/*
+		 * Keep other threads from taking the lanes again as soon as
+		 * they release them, otherwise busy lanes might never be
+		 * grabbed.
+		 */
+		util_atomic_store_explicit32(&pop->lanes_desc.holding_all, 1,
+			memory_order_release);
+
+		struct timespec start;
+		os_clock_gettime(CLOCK_MONOTONIC, &start);
+
+		unsigned held = 0;
+		while (held < nlanes) {
+			if (util_bool_compare_and_swap64(&llocks[held], 0, 1))
+				held++;
+			else if (lane_elapsed_ns(&start) > timeout)
+				break;
+			else
+				sched_yield();
+		}
+
+		util_atomic_store_explicit32(&pop->lanes_desc.holding_all, 0,
+			memory_order_release);
+
+		if (held == nlanes)
+			return;
+
+		LOG(4, "lane %u busy for %" PRIu64 "ns, retrying", held,
+			timeout);
+
+		for (unsigned i = 0; i < held; ++i) {
+			if (unlikely(!util_bool_compare_and_swap64(&llocks[i],
+					1, 0)))
+				FATAL("util_bool_compare_and_swap64");
+		}
+
+		lane_wait_ns(timeout);
+
+		if (timeout < LANE_HOLD_ALL_TIMEOUT_MAX_NS)
+			timeout *= 2;
+	}
+}
+
+/*
+ * lane_release_all -- drops all the lanes grabbed by lane_hold_all
+ */
+void
+lane_release_all(PMEMobjpool *pop)
+{
+	uint64_t *llocks = pop->lanes_desc.lane_locks;
+
+	for (unsigned i = 0; i < pop->lanes_desc.runtime_nlanes; ++i) {
+		if (unlikely(!util_bool_compare_and_swap64(&llocks[i], 1, 0)))
+			FATAL("util_bool_compare_and_swap64");
+	}
+}
+
 /*
  * lane_release -- drops the per-thread lane
  */
@@ -541,6 +676,12 @@ lane_release(PMEMobjpool *pop)
 	if (unlikely(lane->nest_count == 0)) {
 		FATAL("lane_release");
 	} else if (--(lane->nest_count) == 0) {
+		/* remote persists must not outlive the lane hold */
+		struct lane_remote_batch *batch =
+			pop->lanes_desc.lane[lane->lane_idx].remote;
+		if (batch != NULL && batch->nranges != 0)
+			obj_remote_batch_send(pop, (unsigned)lane->lane_idx);
+
 		if (unlikely(!util_bool_compare_and_swap64(
 				&pop->lanes_desc.lane_locks[lane->lane_idx],
 				1, 0))) {
@@ -62,6 +62,14 @@ extern "C" {
  */
 #define LANE_PRIMARY_ATTEMPTS 128
 
+/*
+ * Time lane_hold_all waits for a busy lane before it drops the lanes grabbed
+ * so far and lets the other threads proceed. It is doubled after each attempt,
+ * up to the maximum.
+ */
+#define LANE_HOLD_ALL_TIMEOUT_NS 1000000ULL
+#define LANE_HOLD_ALL_TIMEOUT_MAX_NS 1000000000ULL
+
 #define RLANE_DEFAULT 0
 
 enum lane_section_type {
@@ -89,9 +97,33 @@ struct lane_layout {
 	struct lane_section_layout sections[MAX_LANE_SECTION];
 };
 
+/* maximum number of remote persist ranges batched in a single lane */
+#define LANE_REMOTE_BATCH_MAX 64
+
+/*
+ * lane_remote_range -- range queued for remote persist
+ */
+struct lane_remote_range {
+	size_t offset;	/* offset from the beginning of the pool */
+	size_t length;
+};
+
+/*
+ * lane_remote_batch -- remote persist ranges queued by flushes executed
+ * while holding the lane, sent to remote replicas in one round trip on drain
+ */
+struct lane_remote_batch {
+	unsigned nranges;
+	unsigned flags;	/* common flags of all queued ranges */
+	struct lane_remote_range ranges[LANE_REMOTE_BATCH_MAX];
+};
+
 struct lane {
 	/* volatile state */
 	struct lane_section sections[MAX_LANE_SECTION];
+
+	/* pending remote persists, allocated only with remote replicas */
+	struct lane_remote_batch *remote;
 };
 
 struct lane_descriptor {
@@ -102,6 +134,7 @@ struct lane_descriptor {
 	 */
 	unsigned runtime_nlanes;
 	unsigned next_lane_idx;
+	int holding_all; /* lane_hold_all waits for the lanes to be released */
 	uint64_t *lane_locks;
 	struct lane *lane;
 };
@@ -150,6 +183,8 @@ int lane_check(PMEMobjpool *pop);
 unsigned lane_hold(PMEMobjpool *pop, struct lane_section **section,
 	enum lane_section_type type);
 void lane_release(PMEMobjpool *pop);
+void lane_hold_all(PMEMobjpool *pop);
+void lane_release_all(PMEMobjpool *pop);
 
 void lane_attach(PMEMobjpool *pop, unsigned lane);
 unsigned lane_detach(PMEMobjpool *pop);
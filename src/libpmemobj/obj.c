@@ -438,6 +438,70 @@ obj_remote_persist(PMEMobjpool *pop, const void *addr, size_t len,
 	return 0;
 }
 
+/*
+ * obj_remote_persistv -- (internal) remote persist function for a batch of
+ *	ranges queued in the lane
+ */
+static int
+obj_remote_persistv(PMEMobjpool *rep, const struct lane_remote_batch *batch,
+			unsigned lane)
+{
+	LOG(15, "rep %p nranges %u lane %u flags %u",
+		rep, batch->nranges, lane, batch->flags);
+
+	ASSERTne(rep->rpp, NULL);
+
+	struct rpmem_range ranges[LANE_REMOTE_BATCH_MAX];
+	for (unsigned i = 0; i < batch->nranges; ++i) {
+		ranges[i].offset = (uintptr_t)rep + batch->ranges[i].offset -
+			rep->remote_base;
+		ranges[i].length = batch->ranges[i].length;
+	}
+
+	unsigned rpmem_flags = 0;
+	if (batch->flags & PMEMOBJ_F_RELAXED)
+		rpmem_flags |= RPMEM_PERSIST_RELAXED;
+
+	/* older librpmem does not provide the vectored persist */
+	if (Rpmem_persistv == NULL) {
+		for (unsigned i = 0; i < batch->nranges; ++i) {
+			int rv = Rpmem_persist(rep->rpp, ranges[i].offset,
+					ranges[i].length, lane, rpmem_flags);
+			if (rv) {
+				ERR("!rpmem_persist(rpp %p offset %zu length %zu"
+					" lane %u) FATAL ERROR (returned value"
+					" %i)", rep->rpp, ranges[i].offset,
+					ranges[i].length, lane, rv);
+				return -1;
+			}
+		}
+
+		return 0;
+	}
+
+	int rv = Rpmem_persistv(rep->rpp, ranges, batch->nranges, lane,
+			rpmem_flags);
+	if (rv) {
+		ERR("!rpmem_persistv(rpp %p nranges %u lane %u)"
+			" FATAL ERROR (returned value %i)",
+			rep->rpp, batch->nranges, lane, rv);
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * obj_track -- (internal) record the modified range if the pool is being
+ *	backed up
+ */
+static inline void
+obj_track(PMEMobjpool *pop, const void *addr, size_t len)
+{
+	if (unlikely(pop->backup != NULL))
+		backup_mark(pop->backup, addr, len);
+}
+
 /*
  * XXX - Consider removing obj_norep_*() wrappers to call *_local()
  * functions directly.  Alternatively, always use obj_rep_*(), even
@@ -455,8 +519,11 @@ obj_norep_memcpy(void *ctx, void *dest, const void *src, size_t len,
 	LOG(15, "pop %p dest %p src %p len %zu flags 0x%x", pop, dest, src, len,
 			flags);
 
-	return pop->memcpy_local(dest, src, len,
+	void *ret = pop->memcpy_local(dest, src, len,
 					flags & PMEM_F_MEM_VALID_FLAGS);
+	obj_track(pop, dest, len);
+
+	return ret;
 }
 
 /*
@@ -470,8 +537,11 @@ obj_norep_memmove(void *ctx, void *dest, const void *src, size_t len,
 	LOG(15, "pop %p dest %p src %p len %zu flags 0x%x", pop, dest, src, len,
 			flags);
 
-	return pop->memmove_local(dest, src, len,
+	void *ret = pop->memmove_local(dest, src, len,
 					flags & PMEM_F_MEM_VALID_FLAGS);
+	obj_track(pop, dest, len);
+
+	return ret;
 }
 
 /*
@@ -484,7 +554,11 @@ obj_norep_memset(void *ctx, void *dest, int c, size_t len, unsigned flags)
 	LOG(15, "pop %p dest %p c 0x%02x len %zu flags 0x%x", pop, dest, c, len,
 			flags);
 
-	return pop->memset_local(dest, c, len, flags & PMEM_F_MEM_VALID_FLAGS);
+	void *ret = pop->memset_local(dest, c, len,
+					flags & PMEM_F_MEM_VALID_FLAGS);
+	obj_track(pop, dest, len);
+
+	return ret;
 }
 
 /*
@@ -497,6 +571,7 @@ obj_norep_persist(void *ctx, const void *addr, size_t len, unsigned flags)
 	LOG(15, "pop %p addr %p len %zu", pop, addr, len);
 
 	pop->persist_local(addr, len);
+	obj_track(pop, addr, len);
 
 	return 0;
 }
@@ -511,6 +586,7 @@ obj_norep_flush(void *ctx, const void *addr, size_t len, unsigned flags)
 	LOG(15, "pop %p addr %p len %zu", pop, addr, len);
 
 	pop->flush_local(addr, len);
+	obj_track(pop, addr, len);
 
 	return 0;
 }
@@ -544,6 +620,146 @@ obj_handle_remote_persist_error(PMEMobjpool *pop)
 	FATAL("Fatal error of remote persist. Aborting...");
 }
 
+/*
+ * obj_remote_batch_coalesce -- (internal) sort ranges queued in the lane and
+ *	merge the overlapping and adjacent ones
+ */
+static void
+obj_remote_batch_coalesce(struct lane_remote_batch *batch)
+{
+	struct lane_remote_range *ranges = batch->ranges;
+
+	/* insertion sort -- the batch is small and usually almost sorted */
+	for (unsigned i = 1; i < batch->nranges; ++i) {
+		struct lane_remote_range r = ranges[i];
+		unsigned j = i;
+		while (j > 0 && ranges[j - 1].offset > r.offset) {
+			ranges[j] = ranges[j - 1];
+			j--;
+		}
+		ranges[j] = r;
+	}
+
+	unsigned n = 0;
+	for (unsigned i = 1; i < batch->nranges; ++i) {
+		size_t end = ranges[n].offset + ranges[n].length;
+		size_t iend = ranges[i].offset + ranges[i].length;
+
+		if (ranges[i].offset <= end) {
+			if (iend > end)
+				ranges[n].length = iend - ranges[n].offset;
+		} else {
+			ranges[++n] = ranges[i];
+		}
+	}
+
+	batch->nranges = n + 1;
+}
+
+/*
+ * obj_remote_batch_send -- send all remote persists queued in the lane to
+ *	all remote replicas
+ */
+void
+obj_remote_batch_send(PMEMobjpool *pop, unsigned lane)
+{
+	LOG(15, "pop %p lane %u", pop, lane);
+
+	struct lane_remote_batch *batch = pop->lanes_desc.lane[lane].remote;
+	ASSERTne(batch, NULL);
+
+	if (batch->nranges == 0)
+		return;
+
+	/* vectored persist requires ranges which do not overlap */
+	obj_remote_batch_coalesce(batch);
+
+	PMEMobjpool *rep = pop->replica;
+	while (rep) {
+		if (rep->rpp != NULL) {
+			if (obj_remote_persistv(rep, batch, lane))
+				obj_handle_remote_persist_error(pop);
+		}
+		rep = rep->replica;
+	}
+
+	batch->nranges = 0;
+	batch->flags = 0;
+}
+
+/*
+ * obj_rep_remote_batch -- (internal) returns remote persist batch of the
+ *	held lane or NULL if remote persists cannot be batched
+ *
+ * Before runtime lane initialization all remote persists use RLANE_DEFAULT
+ * and are executed immediately.
+ */
+static inline struct lane_remote_batch *
+obj_rep_remote_batch(PMEMobjpool *pop, unsigned lane)
+{
+	if (!pop->has_remote_replicas || !pop->lanes_desc.runtime_nlanes)
+		return NULL;
+
+	return pop->lanes_desc.lane[lane].remote;
+}
+
+/*
+ * obj_rep_remote_queue -- (internal) queue remote persist in the lane's batch
+ *	and optionally send the whole batch
+ *
+ * Queued ranges are sent at the latest when the batch is full, on drain or
+ * when the lane is released.
+ *
+ * A new range is merged with any queued range it overlaps or touches. Ranges
+ * are not extended beyond the persisted bytes -- the rest of a cache line may
+ * be modified at the same time by another thread, and sending it to
+ * the replica would make that data visible there before it was persisted.
+ */
+static void
+obj_rep_remote_queue(PMEMobjpool *pop, struct lane_remote_batch *batch,
+	unsigned lane, const void *addr, size_t len, unsigned flags, int send)
+{
+	unsigned relaxed = flags & PMEMOBJ_F_RELAXED;
+
+	if (len == 0)
+		goto out;
+
+	size_t offset = (uintptr_t)addr - (uintptr_t)pop;
+	size_t end = offset + len;
+
+	/* the most recently queued ranges are the most likely to match */
+	for (unsigned i = batch->nranges; i-- > 0; ) {
+		struct lane_remote_range *r = &batch->ranges[i];
+		size_t rend = r->offset + r->length;
+
+		if (offset > rend || end < r->offset)
+			continue;
+
+		if (offset < r->offset)
+			r->offset = offset;
+		r->length = (end > rend ? end : rend) - r->offset;
+		batch->flags &= relaxed;
+		goto out;
+	}
+
+	if (batch->nranges == LANE_REMOTE_BATCH_MAX) {
+		/* merging ranges grown since queued may free some slots */
+		obj_remote_batch_coalesce(batch);
+		if (batch->nranges == LANE_REMOTE_BATCH_MAX)
+			obj_remote_batch_send(pop, lane);
+	}
+
+	/* the batch is relaxed only if all of its ranges are relaxed */
+	batch->flags = batch->nranges == 0 ? relaxed : batch->flags & relaxed;
+	batch->ranges[batch->nranges].offset = offset;
+	batch->ranges[batch->nranges].length = end - offset;
+	batch->nranges++;
+
+out:
+	if (send)
+		obj_remote_batch_send(pop, lane);
+}
+
 /*
  * obj_rep_memcpy -- (internal) memcpy with replication
  */
@@ -561,6 +777,9 @@ obj_rep_memcpy(void *ctx, void *dest, const void *src, size_t len,
 		lane = lane_hold(pop, NULL, LANE_ID);
 
 	void *ret = pop->memcpy_local(dest, src, len, flags);
+	obj_track(pop, dest, len);
+
+	struct lane_remote_batch *batch = obj_rep_remote_batch(pop, lane);
 
 	PMEMobjpool *rep = pop->replica;
 	while (rep) {
@@ -568,13 +787,17 @@ obj_rep_memcpy(void *ctx, void *dest, const void *src, size_t len,
 		if (rep->rpp == NULL) {
 			rep->memcpy_local(rdest, src, len,
 						flags & PMEM_F_MEM_VALID_FLAGS);
-		} else {
+		} else if (batch == NULL) {
 			if (rep->persist_remote(rep, rdest, len, lane, flags))
 				obj_handle_remote_persist_error(pop);
 		}
 		rep = rep->replica;
 	}
 
+	if (batch != NULL)
+		obj_rep_remote_queue(pop, batch, lane, dest, len, flags,
+			!(flags & PMEM_F_MEM_NODRAIN));
+
 	if (pop->has_remote_replicas)
 		lane_release(pop);
 
@@ -598,6 +821,9 @@ obj_rep_memmove(void *ctx, void *dest, const void *src, size_t len,
 		lane = lane_hold(pop, NULL, LANE_ID);
 
 	void *ret = pop->memmove_local(dest, src, len, flags);
+	obj_track(pop, dest, len);
+
+	struct lane_remote_batch *batch = obj_rep_remote_batch(pop, lane);
 
 	PMEMobjpool *rep = pop->replica;
 	while (rep) {
@@ -605,13 +831,17 @@ obj_rep_memmove(void *ctx, void *dest, const void *src, size_t len,
 		if (rep->rpp == NULL) {
 			rep->memmove_local(rdest, src, len,
 						flags & PMEM_F_MEM_VALID_FLAGS);
-		} else {
+		} else if (batch == NULL) {
 			if (rep->persist_remote(rep, rdest, len, lane, flags))
 				obj_handle_remote_persist_error(pop);
 		}
 		rep = rep->replica;
 	}
 
+	if (batch != NULL)
+		obj_rep_remote_queue(pop, batch, lane, dest, len, flags,
+			!(flags & PMEM_F_MEM_NODRAIN));
+
 	if (pop->has_remote_replicas)
 		lane_release(pop);
 
@@ -634,6 +864,9 @@ obj_rep_memset(void *ctx, void *dest, int c, size_t len, unsigned flags)
 		lane = lane_hold(pop, NULL, LANE_ID);
 
 	void *ret = pop->memset_local(dest, c, len, flags);
+	obj_track(pop, dest, len);
+
+	struct lane_remote_batch *batch = obj_rep_remote_batch(pop, lane);
 
 	PMEMobjpool *rep = pop->replica;
 	while (rep) {
@@ -641,13 +874,17 @@ obj_rep_memset(void *ctx, void *dest, int c, size_t len, unsigned flags)
 		if (rep->rpp == NULL) {
 			rep->memset_local(rdest, c, len,
 						flags & PMEM_F_MEM_VALID_FLAGS);
-		} else {
+		} else if (batch == NULL) {
 			if (rep->persist_remote(rep, rdest, len, lane, flags))
 				obj_handle_remote_persist_error(pop);
 		}
 		rep = rep->replica;
 	}
 
+	if (batch != NULL)
+		obj_rep_remote_queue(pop, batch, lane, dest, len, flags,
+			!(flags & PMEM_F_MEM_NODRAIN));
+
 	if (pop->has_remote_replicas)
 		lane_release(pop);
 
@@ -669,19 +906,25 @@ obj_rep_persist(void *ctx, const void *addr, size_t len, unsigned flags)
 		lane = lane_hold(pop, NULL, LANE_ID);
 
 	pop->persist_local(addr, len);
+	obj_track(pop, addr, len);
+
+	struct lane_remote_batch *batch = obj_rep_remote_batch(pop, lane);
 
 	PMEMobjpool *rep = pop->replica;
 	while (rep) {
 		void *raddr = (char *)rep + (uintptr_t)addr - (uintptr_t)pop;
 		if (rep->rpp == NULL) {
 			rep->memcpy_local(raddr, addr, len, 0);
-		} else {
+		} else if (batch == NULL) {
 			if (rep->persist_remote(rep, raddr, len, lane, flags))
 				obj_handle_remote_persist_error(pop);
 		}
 		rep = rep->replica;
 	}
 
+	if (batch != NULL)
+		obj_rep_remote_queue(pop, batch, lane, addr, len, flags, 1);
+
 	if (pop->has_remote_replicas)
 		lane_release(pop);
 
@@ -703,6 +946,9 @@ obj_rep_flush(void *ctx, const void *addr, size_t len, unsigned flags)
 		lane = lane_hold(pop, NULL, LANE_ID);
 
 	pop->flush_local(addr, len);
+	obj_track(pop, addr, len);
+
+	struct lane_remote_batch *batch = obj_rep_remote_batch(pop, lane);
 
 	PMEMobjpool *rep = pop->replica;
 	while (rep) {
@@ -710,13 +956,16 @@ obj_rep_flush(void *ctx, const void *addr, size_t len, unsigned flags)
 		if (rep->rpp == NULL) {
 			rep->memcpy_local(raddr, addr, len,
 				PMEM_F_MEM_NODRAIN);
-		} else {
+		} else if (batch == NULL) {
 			if (rep->persist_remote(rep, raddr, len, lane, flags))
 				obj_handle_remote_persist_error(pop);
 		}
 		rep = rep->replica;
 	}
 
+	if (batch != NULL)
+		obj_rep_remote_queue(pop, batch, lane, addr, len, flags, 0);
+
 	if (pop->has_remote_replicas)
 		lane_release(pop);
 
@@ -740,6 +989,17 @@ obj_rep_drain(void *ctx)
 			rep->drain_local();
 		rep = rep->replica;
 	}
+
+	if (pop->has_remote_replicas) {
+		unsigned lane = lane_hold(pop, NULL, LANE_ID);
+
+		struct lane_remote_batch *batch =
+			obj_rep_remote_batch(pop, lane);
+		if (batch != NULL)
+			obj_remote_batch_send(pop, lane);
+
+		lane_release(pop);
+	}
 }
 
 #if VG_MEMCHECK_ENABLED
@@ -1173,6 +1433,10 @@ obj_replica_init(PMEMobjpool *rep, struct pool_set *set, unsigned repidx,
 			rep->p_ops.memset = obj_norep_memset;
 		}
 		rep->p_ops.base = rep;
+
+		VALGRIND_REMOVE_PMEM_MAPPING(&rep->backup,
+			sizeof(rep->backup));
+		rep->backup = NULL;
 	} else {
 		/* non-master replicas */
 		rep->is_master_replica = 0;
@@ -1958,6 +2222,8 @@ obj_pool_cleanup(PMEMobjpool *pop)
 	lane_section_cleanup(pop);
 	lane_cleanup(pop);
 
+	backup_delete(pop->backup);
+
 	/* unmap all the replicas */
 	obj_replicas_cleanup(pop->set);
 	util_poolset_close(pop->set, DO_NOT_DELETE_PARTS);
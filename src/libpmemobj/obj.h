@@ -40,6 +40,7 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "backup.h"
 #include "lane.h"
 #include "pool_hdr.h"
 #include "pmalloc.h"
@@ -198,9 +199,12 @@ struct pmemobjpool {
 	PMEMrwlock_internal *rwlock_head;
 	PMEMcond_internal *cond_head;
 
+	/* tracking of modifications for online backup */
+	struct obj_backup *backup;
+
 	/* padding to align size of this structure to page boundary */
 	/* sizeof(unused2) == 8192 - offsetof(struct pmemobjpool, unused2) */
-	char unused2[992];
+	char unused2[976];
 };
 
 /*
@@ -247,6 +251,7 @@ void obj_init(void);
 void obj_fini(void);
 int obj_read_remote(void *ctx, uintptr_t base, void *dest, void *addr,
 		size_t length);
+void obj_remote_batch_send(PMEMobjpool *pop, unsigned lane);
 
 /*
  * (debug helper macro) logs notice message if used inside a transaction
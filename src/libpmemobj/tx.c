@@ -1084,6 +1084,7 @@ obj_tx_abort(int errnum, int user)
 		/* process the undo log */
 		tx_abort(tx->pop, lane, layout, 0 /* abort */);
 		tx->ctx = NULL;
+		pmalloc_operation_release(tx->pop);
 		lane_release(tx->pop);
 		tx->section = NULL;
 	}
@@ -37,8 +37,10 @@
 #include <stdint.h>
 #include <sys/param.h>
 #include <endian.h>
+#include <unistd.h>
 
 #include "out.h"
+#include "os_thread.h"
 #include "btt.h"
 #include "libpmempool.h"
 #include "pmempool.h"
@@ -50,6 +52,12 @@ enum questions {
 	Q_REPAIR_FLOG,
 };
 
+/* maximum number of arenas scanned in parallel */
+#define CHECK_BTT_MAX_THREADS 8
+
+/* maximum memory held by the map and flog scans of a single batch */
+#define CHECK_BTT_SCAN_MAX_MEM (256 * 1024 * 1024)
+
 /*
  * flog_read -- (internal) read and convert flog from file
  */
@@ -454,10 +462,13 @@ next:
 }
 
 /*
- * arena_map_flog_check -- (internal) check map and flog
+ * arena_map_flog_scan -- (internal) scan map and flog entries
+ *
+ * It does not touch anything but the arena and the location, so scans
+ * of different arenas can be performed concurrently.
  */
 static int
-arena_map_flog_check(PMEMpoolcheck *ppc, location *loc)
+arena_map_flog_scan(PMEMpoolcheck *ppc, location *loc)
 {
 	LOG(3, NULL);
 
@@ -487,6 +498,26 @@ arena_map_flog_check(PMEMpoolcheck *ppc, location *loc)
 		}
 	}
 
+	return 0;
+
+error_push:
+	CHECK_ERR(ppc, "arena %u: cannot allocate momory for list item",
+			arenap->id);
+	ppc->result = CHECK_RESULT_ERROR;
+	cleanup(ppc, loc);
+	return -1;
+}
+
+/*
+ * arena_map_flog_check -- (internal) check map and flog
+ */
+static int
+arena_map_flog_check(PMEMpoolcheck *ppc, location *loc)
+{
+	LOG(3, NULL);
+
+	struct arena *arenap = loc->arenap;
+
 	if (loc->list_unmap->count)
 		CHECK_INFO(ppc, "arena %u: number of unmapped blocks: %u",
 			arenap->id, loc->list_unmap->count);
@@ -537,10 +568,6 @@ arena_map_flog_check(PMEMpoolcheck *ppc, location *loc)
 
 	return check_questions_sequence_validate(ppc);
 
-error_push:
-	CHECK_ERR(ppc, "arena %u: cannot allocate momory for list item",
-			arenap->id);
-	ppc->result = CHECK_RESULT_ERROR;
 cleanup:
 	cleanup(ppc, loc);
 	return -1;
@@ -636,6 +663,10 @@ static const struct step steps[] = {
 	{
 		.check	= init,
 	},
+	{
+		.check	= arena_map_flog_scan,
+	},
+#define STEP_MAP_FLOG_CHECK 2
 	{
 		.check	= arena_map_flog_check,
 	},
@@ -671,6 +702,206 @@ step_exe(PMEMpoolcheck *ppc, location *loc)
 	return -1;
 }
 
+/*
+ * arena_scan -- (internal) result of the map and flog scan of a single arena
+ *               performed ahead of the check of the arena
+ */
+struct arena_scan {
+	PMEMpoolcheck ppc;	/* private context collecting info statuses */
+	location loc;		/* bitmaps and lists of the arena */
+	os_thread_t thread;
+	int thread_started;
+	int ret;
+};
+
+/*
+ * arena_scan_batch -- (internal) scans of consecutive arenas, of which
+ *                     the first 'next' ones are already consumed
+ */
+struct arena_scan_batch {
+	struct arena_scan scans[CHECK_BTT_MAX_THREADS];
+	unsigned nscans;
+	unsigned next;
+};
+
+/*
+ * arena_scan_worker -- (internal) scan map and flog of a single arena
+ */
+static void *
+arena_scan_worker(void *arg)
+{
+	struct arena_scan *scan = arg;
+	scan->ret = arena_map_flog_scan(&scan->ppc, &scan->loc);
+	return NULL;
+}
+
+/*
+ * arena_scan_discard -- (internal) release resources of the scan which will
+ *                       not be consumed
+ *
+ * Map and flog are released as well, as they will be read again when
+ * the arena is checked.
+ */
+static void
+arena_scan_discard(struct arena_scan *scan)
+{
+	struct arena *arenap = scan->loc.arenap;
+
+	cleanup(&scan->ppc, &scan->loc);
+
+	free(arenap->map);
+	arenap->map = NULL;
+	free(arenap->flog);
+	arenap->flog = NULL;
+
+	check_data_free(scan->ppc.data);
+}
+
+/*
+ * arena_scan_batch_fini -- (internal) discard all the unconsumed scans
+ */
+static void
+arena_scan_batch_fini(struct arena_scan_batch *batch)
+{
+	for (unsigned i = batch->next; i < batch->nscans; ++i)
+		arena_scan_discard(&batch->scans[i]);
+
+	batch->nscans = 0;
+	batch->next = 0;
+}
+
+/*
+ * arena_scan_mem -- (internal) estimate memory held by the scan of the arena
+ *
+ * It is the map and the flog read from the pool and the three bitmaps of
+ * the internal blocks.
+ */
+static uint64_t
+arena_scan_mem(struct arena *arenap)
+{
+	uint64_t bitmapsize = howmany(arenap->btt_info.internal_nlba, 8);
+
+	return btt_map_size(arenap->btt_info.external_nlba) +
+		btt_flog_size(arenap->btt_info.nfree) + 3 * bitmapsize;
+}
+
+/*
+ * arena_scan_batch_start -- (internal) scan map and flog of up to
+ *                           CHECK_BTT_MAX_THREADS consecutive arenas
+ *                           in parallel
+ *
+ * All the scans of the batch are held in memory until consumed, so arenas
+ * are added to the batch only while their scans fit in
+ * CHECK_BTT_SCAN_MAX_MEM. The first arena, which is scanned anyway, is
+ * always added.
+ *
+ * Only the scans, which do not depend on each other, are performed
+ * in parallel. The results are consumed by the check of each arena in order,
+ * so all the messages and questions are generated in the same order as when
+ * the arenas are checked one by one.
+ */
+static void
+arena_scan_batch_start(PMEMpoolcheck *ppc, struct arena *arenap,
+	struct arena_scan_batch *batch)
+{
+	long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	unsigned nthreads = ncpus < 1 ? 1 : ncpus > CHECK_BTT_MAX_THREADS ?
+		CHECK_BTT_MAX_THREADS : (unsigned)ncpus;
+
+	batch->nscans = 0;
+	batch->next = 0;
+
+	/* there is nothing to gain from a batch of a single arena */
+	if (nthreads < 2 || TAILQ_NEXT(arenap, next) == NULL)
+		return;
+
+	uint64_t mem = 0;
+	for (; arenap != NULL && batch->nscans < nthreads;
+			arenap = TAILQ_NEXT(arenap, next)) {
+		struct arena_scan *scan = &batch->scans[batch->nscans];
+
+		mem += arena_scan_mem(arenap);
+		if (batch->nscans > 0 && mem > CHECK_BTT_SCAN_MAX_MEM)
+			break;
+
+		memset(scan, 0, sizeof(*scan));
+		scan->ppc = *ppc;
+		scan->ppc.data = check_data_alloc();
+		if (scan->ppc.data == NULL)
+			break;
+
+		/*
+		 * If the map and flog cannot be read the batch ends here, and
+		 * the error is reported when the arena is checked.
+		 */
+		scan->loc.arenap = arenap;
+		if (init(&scan->ppc, &scan->loc)) {
+			free(arenap->flog);
+			arenap->flog = NULL;
+			check_data_free(scan->ppc.data);
+			break;
+		}
+
+		batch->nscans++;
+	}
+
+	/* the last scan is performed by the calling thread */
+	for (unsigned i = 0; i + 1 < batch->nscans; ++i) {
+		struct arena_scan *scan = &batch->scans[i];
+		scan->thread_started = os_thread_create(&scan->thread, NULL,
+			arena_scan_worker, scan) == 0;
+	}
+
+	for (unsigned i = 0; i < batch->nscans; ++i) {
+		if (!batch->scans[i].thread_started)
+			arena_scan_worker(&batch->scans[i]);
+	}
+
+	for (unsigned i = 0; i < batch->nscans; ++i) {
+		if (batch->scans[i].thread_started)
+			os_thread_join(&batch->scans[i].thread, NULL);
+	}
+}
+
+/*
+ * arena_scan_consume -- (internal) use the result of the scan of the arena
+ *                       as if the arena was scanned by the check itself
+ */
+static int
+arena_scan_consume(PMEMpoolcheck *ppc, location *loc,
+	struct arena_scan_batch *batch)
+{
+	if (batch->next == batch->nscans)
+		return 0;
+
+	struct arena_scan *scan = &batch->scans[batch->next];
+	if (scan->loc.arenap != loc->arenap)
+		return 0;
+
+	batch->next++;
+
+	check_data_move_infos(ppc->data, scan->ppc.data);
+	check_data_free(scan->ppc.data);
+
+	if (scan->ret) {
+		/* the scan has already released its resources */
+		CHECK_ERR(ppc, "arena %u: cannot allocate momory for list item",
+			loc->arenap->id);
+		ppc->result = CHECK_RESULT_ERROR;
+		return -1;
+	}
+
+	loc->bitmap = scan->loc.bitmap;
+	loc->dup_bitmap = scan->loc.dup_bitmap;
+	loc->fbitmap = scan->loc.fbitmap;
+	loc->list_inval = scan->loc.list_inval;
+	loc->list_flog_inval = scan->loc.list_flog_inval;
+	loc->list_unmap = scan->loc.list_unmap;
+	loc->step = STEP_MAP_FLOG_CHECK;
+
+	return 0;
+}
+
 /*
  * check_btt_map_flog -- perform check and fixing of map and flog
  */
@@ -680,6 +911,9 @@ check_btt_map_flog(PMEMpoolcheck *ppc)
 	LOG(3, NULL);
 
 	location *loc = check_get_step_data(ppc->data);
+	struct arena_scan_batch batch;
+	batch.nscans = 0;
+	batch.next = 0;
 
 	if (ppc->pool->blk_no_layout)
 		return;
@@ -698,12 +932,20 @@ check_btt_map_flog(PMEMpoolcheck *ppc)
 				loc->step == 0) {
 			CHECK_INFO(ppc, "arena %u: checking BTT Map and Flog",
 				loc->narena);
+
+			/* scan the next arenas ahead if not done already */
+			if (batch.next == batch.nscans)
+				arena_scan_batch_start(ppc, loc->arenap,
+					&batch);
+
+			if (arena_scan_consume(ppc, loc, &batch))
+				goto out;
 		}
 
 		/* do all checks */
 		while (CHECK_NOT_COMPLETE(loc, steps)) {
 			if (step_exe(ppc, loc))
-				return;
+				goto out;
 		}
 
 		/* jump to next arena */
@@ -711,4 +953,11 @@ check_btt_map_flog(PMEMpoolcheck *ppc)
 		loc->narena++;
 		loc->step = 0;
 	}
+
+out:
+	/*
+	 * The scans performed ahead are not preserved when the check is
+	 * interrupted, e.g. to ask questions; they are simply repeated.
+	 */
+	arena_scan_batch_fini(&batch);
 }
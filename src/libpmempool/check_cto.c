@@ -37,8 +37,10 @@
 #include <inttypes.h>
 #include <sys/param.h>
 #include <endian.h>
+#include <string.h>
 
 #include "out.h"
+#include "file.h"
 #include "libpmempool.h"
 #include "pmempool.h"
 #include "pool.h"
@@ -77,6 +79,49 @@ cto_read(PMEMpoolcheck *ppc)
 	return 0;
 }
 
+/*
+ * cto_ckpt_valid -- (internal) check if the pool has a usable checkpoint image
+ *
+ * libpmemcto rolls a pool which was not closed back to the image saved by
+ * the last checkpoint, if the image matches the pool.
+ */
+static int
+cto_ckpt_valid(PMEMpoolcheck *ppc)
+{
+	struct pmemcto *cto = &ppc->pool->hdr.cto;
+
+	if (cto->checkpoint == 0)
+		return 0;
+
+	char *ckpt_path = Malloc(strlen(ppc->path) + sizeof(CTO_CKPT_SUFFIX));
+	if (ckpt_path == NULL) {
+		ERR("!Malloc");
+		return 0;
+	}
+
+	strcpy(ckpt_path, ppc->path);
+	strcat(ckpt_path, CTO_CKPT_SUFFIX);
+
+	int valid = 0;
+	struct cto_ckpt_hdr hdr;
+
+	os_off_t off = (os_off_t)(CTO_CKPT_IMAGE(cto->checkpoint) * cto->size);
+
+	if (util_file_get_size(ckpt_path) !=
+			(ssize_t)(CTO_CKPT_IMAGES * cto->size) ||
+	    util_file_pread(ckpt_path, &hdr, sizeof(hdr), off) !=
+			(ssize_t)sizeof(hdr))
+		goto out;
+
+	valid = memcmp(hdr.signature, CTO_CKPT_SIG, POOL_HDR_SIG_LEN) == 0 &&
+		uuidcmp(hdr.poolset_uuid, cto->hdr.poolset_uuid) == 0 &&
+		hdr.addr == cto->addr && hdr.size == cto->size &&
+		hdr.checkpoint == cto->checkpoint;
+out:
+	Free(ckpt_path);
+	return valid;
+}
+
 /*
  * cto_hdr_check -- (internal) check pmemcto header
  */
@@ -92,7 +137,11 @@ cto_hdr_check(PMEMpoolcheck *ppc, location *loc)
 		return -1;
 	}
 
-	if (ppc->pool->hdr.cto.consistent == 0) {
+	if (ppc->pool->hdr.cto.consistent == 0 && cto_ckpt_valid(ppc)) {
+		CHECK_INFO(ppc,
+			"pmemcto.consistent flag is not set, the pool will be rolled back to checkpoint %ju",
+			(uintmax_t)ppc->pool->hdr.cto.checkpoint);
+	} else if (ppc->pool->hdr.cto.consistent == 0) {
 		if (CHECK_ASK(ppc, Q_CTO_CONSISTENT,
 				"pmemcto.consistent flag is not set.|Do you want to set pmemcto.consistent flag?"))
 			goto error;
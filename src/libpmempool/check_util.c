@@ -156,6 +156,18 @@ check_data_free(struct check_data *data)
 	free(data);
 }
 
+/*
+ * check_data_move_infos -- move all info statuses from the source check_data
+ *                          to the end of the info queue of the destination
+ */
+void
+check_data_move_infos(struct check_data *dst, struct check_data *src)
+{
+	LOG(3, NULL);
+
+	TAILQ_CONCAT(&dst->infos, &src->infos, next);
+}
+
 /*
  * check_step_get - return current check step number
  */
@@ -138,6 +138,7 @@ void check_write(PMEMpoolcheck *ppc);
 
 struct check_data *check_data_alloc(void);
 void check_data_free(struct check_data *data);
+void check_data_move_infos(struct check_data *dst, struct check_data *src);
 
 uint32_t check_step_get(struct check_data *data);
 void check_step_inc(struct check_data *data);
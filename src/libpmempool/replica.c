@@ -45,18 +45,22 @@
 #include <string.h>
 #include <unistd.h>
 #include <libgen.h>
+#include <time.h>
 
 #include "obj.h"
 #include "palloc.h"
 #include "file.h"
 #include "os.h"
 #include "out.h"
+#include "sys_util.h"
+#include "util_pmem.h"
 #include "pool_hdr.h"
 #include "set.h"
 #include "util.h"
 #include "uuid.h"
 #include "shutdown_state.h"
 #include "os_dimm.h"
+#include "badblock.h"
 
 /*
  * check_flags_sync -- (internal) check if flags are supported for sync
@@ -64,7 +68,7 @@
 static int
 check_flags_sync(unsigned flags)
 {
-	flags &= ~(unsigned)PMEMPOOL_DRY_RUN;
+	flags &= ~(unsigned)(PMEMPOOL_DRY_RUN | PMEMPOOL_SYNC_INCREMENTAL);
 	return flags > 0;
 }
 
@@ -174,7 +178,13 @@ replica_free_poolset_health_status(struct poolset_health_status *set_hs)
 {
 	LOG(3, "set_hs %p", set_hs);
 	for (unsigned i = 0; i < set_hs->nreplicas; ++i) {
-		Free(set_hs->replica[i]);
+		struct replica_health_status *rep_hs = set_hs->replica[i];
+		if (rep_hs->part_bbs) {
+			for (unsigned p = 0; p < rep_hs->nparts; ++p)
+				badblocks_delete(rep_hs->part_bbs[p]);
+			Free(rep_hs->part_bbs);
+		}
+		Free(rep_hs);
 	}
 	Free(set_hs);
 }
@@ -252,6 +262,29 @@ replica_is_replica_consistent(unsigned repn,
 	return !(REP_HEALTH(set_hs, repn)->flags & IS_INCONSISTENT);
 }
 
+/*
+ * replica_part_has_bad_blocks -- check if an unbroken part is marked as
+ *                                having bad blocks in the helping structure
+ */
+int
+replica_part_has_bad_blocks(unsigned repn, unsigned partn,
+		struct poolset_health_status *set_hs)
+{
+	struct replica_health_status *rhs = REP_HEALTH(set_hs, repn);
+	return !replica_is_part_broken(repn, partn, set_hs) &&
+		(PART_HEALTH(rhs, partn) & HAS_BAD_BLOCKS);
+}
+
+/*
+ * replica_has_bad_blocks -- check if any part in the replica is marked as
+ *                           having bad blocks
+ */
+int
+replica_has_bad_blocks(unsigned repn, struct poolset_health_status *set_hs)
+{
+	return (REP_HEALTH(set_hs, repn)->flags & HAS_BAD_BLOCKS) != 0;
+}
+
 /*
  * replica_is_replica_healthy -- check if replica is unbroken and consistent
  */
@@ -265,15 +298,16 @@ replica_is_replica_healthy(unsigned repn,
 
 /*
  * replica_is_poolset_healthy -- check if all replicas in a poolset are not
- *                               marked as broken nor inconsistent in the
- *                               helping structure
+ *                               marked as broken nor inconsistent nor having
+ *                               bad blocks in the helping structure
  */
 int
 replica_is_poolset_healthy(struct poolset_health_status *set_hs)
 {
 	LOG(3, "set_hs %p", set_hs);
 	for (unsigned r = 0; r < set_hs->nreplicas; ++r) {
-		if (!replica_is_replica_healthy(r, set_hs))
+		if (!replica_is_replica_healthy(r, set_hs) ||
+				replica_has_bad_blocks(r, set_hs))
 			return 0;
 	}
 	return 1;
@@ -314,8 +348,10 @@ replica_find_healthy_replica(struct poolset_health_status *set_hs)
 {
 	LOG(3, "set_hs %p", set_hs);
 
+	/* a replica with bad blocks cannot be a source of data */
 	for (unsigned r = 0; r < set_hs->nreplicas; ++r) {
-		if (replica_is_replica_healthy(r, set_hs))
+		if (replica_is_replica_healthy(r, set_hs) &&
+				!replica_has_bad_blocks(r, set_hs))
 			return r;
 	}
 
@@ -543,8 +579,43 @@ check_checksums_and_signatures(struct pool_set *set,
 	return 0;
 }
 
+/*
+ * badblocks_in_metadata -- (internal) check if any of the bad blocks
+ *                          overlaps the metadata of the part
+ *
+ * The metadata of the first part is the pool descriptor (including the pool
+ * header), which is needed to read the pool size, and of the other parts
+ * the pool header only. Bad blocks in the metadata cannot be repaired by
+ * copying the data, so such a part has to be recreated.
+ */
+static int
+badblocks_in_metadata(struct pool_set *set, unsigned repn, unsigned partn,
+		struct badblocks *bbs)
+{
+	struct pool_set_part *part = PART(REP(set, repn), partn);
+	size_t meta_size;
+	if (partn == 0)
+		meta_size = ALIGN_UP(sizeof(PMEMobjpool), part->alignment);
+	else if (set->options & OPTION_SINGLEHDR)
+		meta_size = 0;
+	else
+		meta_size = part->alignment;
+
+	for (unsigned b = 0; b < bbs->bb_cnt; ++b) {
+		if (bbs->bbv[b].offset < meta_size)
+			return 1;
+	}
+
+	return 0;
+}
+
 /*
  * check_badblocks -- (internal) check if replica contains bad blocks
+ *
+ * A part with bad blocks in its data area is only marked as having bad blocks
+ * and the list of them is stored, so that only the damaged ranges are
+ * restored by the sync; a part with bad blocks in its metadata is marked as
+ * broken.
  */
 static int
 check_badblocks(struct pool_set *set, struct poolset_health_status *set_hs)
@@ -566,19 +637,46 @@ check_badblocks(struct pool_set *set, struct poolset_health_status *set_hs)
 			if (!exists)
 				continue;
 
-			int ret = os_badblocks_check_file(path);
-			if (ret < 0) {
+			struct badblocks *bbs = badblocks_new();
+			if (bbs == NULL)
+				return -1;
+
+			if (os_badblocks_get(path, bbs)) {
 				ERR(
 					"checking replica for bad blocks failed -- '%s'",
 					path);
+				badblocks_delete(bbs);
 				return -1;
 			}
 
-			if (ret > 0) {
-				/* bad blocks were found */
+			if (bbs->bb_cnt == 0) {
+				badblocks_delete(bbs);
+				continue;
+			}
+
+			LOG(1, "pool file '%s' contains %u bad block(s)",
+				path, bbs->bb_cnt);
+
+			if (badblocks_in_metadata(set, r, p, bbs)) {
 				rep_hs->part[p] |= IS_BROKEN;
 				rep_hs->flags |= IS_BROKEN;
+				badblocks_delete(bbs);
+				continue;
+			}
+
+			if (rep_hs->part_bbs == NULL) {
+				rep_hs->part_bbs = Zalloc(rep_hs->nparts *
+						sizeof(struct badblocks *));
+				if (rep_hs->part_bbs == NULL) {
+					ERR("!Zalloc for bad blocks");
+					badblocks_delete(bbs);
+					return -1;
+				}
 			}
+
+			rep_hs->part_bbs[p] = bbs;
+			rep_hs->part[p] |= HAS_BAD_BLOCKS;
+			rep_hs->flags |= HAS_BAD_BLOCKS;
 		}
 	}
 
@@ -1308,15 +1406,315 @@ err:
 }
 
 /*
- * pmempool_syncU -- synchronize replicas within a poolset
+ * replica_copy_init -- initialize the state of copying data between replicas
+ *	from user supplied options, NULL options select defaults
+ */
+int
+replica_copy_init(struct replica_copy *cp,
+		const struct pmempool_copy_opts *opts)
+{
+	LOG(3, "cp %p, opts %p", cp, opts);
+
+	memset(cp, 0, sizeof(*cp));
+
+	if (opts != NULL) {
+		if (opts->nthreads > REPLICA_COPY_MAX_THREADS) {
+			ERR("invalid number of threads %u (max %u)",
+				opts->nthreads, REPLICA_COPY_MAX_THREADS);
+			errno = EINVAL;
+			return -1;
+		}
+
+		cp->nthreads = opts->nthreads;
+		cp->chunk_size = opts->chunk_size;
+		cp->max_bandwidth = opts->max_bandwidth;
+		cp->progress = opts->progress;
+		cp->arg = opts->arg;
+		cp->src_replica = opts->src_replica;
+	}
+
+	if (cp->nthreads == 0) {
+		long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+		cp->nthreads = ncpus < 1 ? 1 :
+			ncpus > REPLICA_COPY_THREADS ?
+			REPLICA_COPY_THREADS : (unsigned)ncpus;
+	}
+
+	if (cp->chunk_size == 0)
+		cp->chunk_size = REPLICA_COPY_CHUNK;
+	/* persisting whole pages avoids flushing the same page twice */
+	cp->chunk_size = ALIGN_UP(cp->chunk_size, Pagesize);
+
+	util_mutex_init(&cp->lock);
+	if ((errno = os_cond_init(&cp->cond)) != 0) {
+		ERR("!os_cond_init");
+		util_mutex_destroy(&cp->lock);
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * replica_copy_fini -- release resources of copying data between replicas
+ */
+void
+replica_copy_fini(struct replica_copy *cp)
+{
+	LOG(3, "cp %p", cp);
+
+	os_cond_destroy(&cp->cond);
+	util_mutex_destroy(&cp->lock);
+}
+
+/*
+ * replica_copy_begin -- start a new copy pass of total bytes
+ */
+void
+replica_copy_begin(struct replica_copy *cp, size_t total)
+{
+	LOG(3, "cp %p, total %zu", cp, total);
+
+	util_mutex_lock(&cp->lock);
+	cp->total = total;
+	cp->copied = 0;
+	cp->written = 0;
+	os_clock_gettime(CLOCK_REALTIME, &cp->start);
+
+	/* let the caller know the size of the pass before it starts */
+	if (!cp->canceled && cp->progress && cp->progress(0, total, cp->arg)) {
+		ERR("operation canceled");
+		cp->canceled = 1;
+	}
+	util_mutex_unlock(&cp->lock);
+}
+
+/*
+ * replica_copy_throttle -- (internal) wait until the average copying speed
+ *	drops below the limit, called with the lock held
+ */
+static void
+replica_copy_throttle(struct replica_copy *cp)
+{
+	double secs = (double)cp->copied / (double)cp->max_bandwidth;
+
+	struct timespec deadline = cp->start;
+	deadline.tv_sec += (time_t)secs;
+	deadline.tv_nsec += (long)((secs - (double)(time_t)secs) * 1e9);
+	if (deadline.tv_nsec >= 1000000000) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000;
+	}
+
+	struct timespec now;
+	for (;;) {
+		os_clock_gettime(CLOCK_REALTIME, &now);
+		if (now.tv_sec > deadline.tv_sec ||
+				(now.tv_sec == deadline.tv_sec &&
+				now.tv_nsec >= deadline.tv_nsec))
+			break;
+
+		/* nobody signals the condition, it serves as a timed sleep */
+		(void) os_cond_timedwait(&cp->cond, &cp->lock, &deadline);
+	}
+}
+
+/*
+ * replica_copy_progress -- account len copied bytes, report the progress and
+ *	apply the bandwidth limit
+ *
+ * The progress callback is never called concurrently. Returns -1 with errno
+ * set to ECANCELED if the operation was canceled by the callback.
+ */
+int
+replica_copy_progress(struct replica_copy *cp, size_t len)
+{
+	int ret = 0;
+
+	util_mutex_lock(&cp->lock);
+
+	if (cp->canceled)
+		goto out;
+
+	cp->copied += len;
+
+	if (cp->max_bandwidth)
+		replica_copy_throttle(cp);
+
+	if (!cp->canceled && cp->progress &&
+			cp->progress(cp->copied, cp->total, cp->arg)) {
+		ERR("operation canceled");
+		cp->canceled = 1;
+	}
+
+out:
+	if (cp->canceled) {
+		errno = ECANCELED;
+		ret = -1;
+	}
+	util_mutex_unlock(&cp->lock);
+
+	return ret;
+}
+
+/*
+ * replica_copy_job -- a single region copied by multiple threads
+ */
+struct replica_copy_job {
+	struct replica_copy *cp;
+	char *dst;
+	const char *src;
+	size_t len;
+	int is_pmem;
+	uint64_t next;		/* offset of the next chunk to be copied */
+};
+
+/*
+ * replica_copy_range -- (internal) copy and persist a range of the region
+ */
+static void
+replica_copy_range(struct replica_copy_job *job, uint64_t off, size_t len)
+{
+	if (job->is_pmem) {
+		/* large copies use non-temporal stores */
+		pmem_memcpy_persist(job->dst + off, job->src + off, len);
+	} else {
+		memcpy(job->dst + off, job->src + off, len);
+		util_persist(0, job->dst + off, len);
+	}
+}
+
+/*
+ * replica_copy_diff -- (internal) copy only those granules of the range
+ *	which differ from the source, returns number of copied bytes
+ */
+static size_t
+replica_copy_diff(struct replica_copy_job *job, uint64_t off, size_t len)
+{
+	size_t written = 0;
+	uint64_t end = off + len;
+
+	while (off < end) {
+		size_t glen = end - off;
+		if (glen > REPLICA_COPY_GRANULE)
+			glen = REPLICA_COPY_GRANULE;
+
+		if (memcmp(job->dst + off, job->src + off, glen) != 0) {
+			replica_copy_range(job, off, glen);
+			written += glen;
+		}
+
+		off += glen;
+	}
+
+	return written;
+}
+
+/*
+ * replica_copy_worker -- (internal) copy and persist chunks of the region
+ *	until there is nothing left or the operation is canceled
+ */
+static void *
+replica_copy_worker(void *arg)
+{
+	struct replica_copy_job *job = arg;
+	struct replica_copy *cp = job->cp;
+	size_t chunk = cp->chunk_size;
+
+	for (;;) {
+		uint64_t off = util_fetch_and_add64(&job->next, chunk);
+		if (off >= job->len)
+			break;
+
+		size_t len = job->len - off;
+		if (len > chunk)
+			len = chunk;
+
+		size_t written = len;
+		if (cp->incremental)
+			written = replica_copy_diff(job, off, len);
+		else
+			replica_copy_range(job, off, len);
+
+		util_fetch_and_add64(&cp->written, written);
+
+		if (replica_copy_progress(cp, len))
+			break;
+	}
+
+	return NULL;
+}
+
+/*
+ * replica_copy_data -- copy len bytes between replicas using multiple
+ *	threads, each chunk is persisted as soon as it is copied
+ *
+ * The source and destination regions must not overlap.
+ */
+int
+replica_copy_data(struct replica_copy *cp, void *dst, const void *src,
+		size_t len, int is_pmem)
+{
+	LOG(3, "cp %p, dst %p, src %p, len %zu, is_pmem %d", cp, dst, src,
+			len, is_pmem);
+
+	struct replica_copy_job job = {
+		.cp = cp,
+		.dst = dst,
+		.src = src,
+		.len = len,
+		.is_pmem = is_pmem,
+		.next = 0,
+	};
+
+	size_t nchunks = (len + cp->chunk_size - 1) / cp->chunk_size;
+	unsigned nthreads = nchunks < cp->nthreads ?
+			(unsigned)nchunks : cp->nthreads;
+
+	os_thread_t threads[REPLICA_COPY_MAX_THREADS];
+	unsigned started = 0;
+
+	/* the calling thread is one of the copying threads */
+	for (; started + 1 < nthreads; ++started) {
+		if (os_thread_create(&threads[started], NULL,
+				replica_copy_worker, &job)) {
+			/* continue with fewer threads */
+			LOG(2, "!os_thread_create");
+			break;
+		}
+	}
+
+	replica_copy_worker(&job);
+
+	for (unsigned t = 0; t < started; ++t)
+		os_thread_join(&threads[t], NULL);
+
+	util_mutex_lock(&cp->lock);
+	int canceled = cp->canceled;
+	util_mutex_unlock(&cp->lock);
+
+	LOG(4, "%zu of %zu bytes differed", cp->written, cp->copied);
+
+	if (canceled) {
+		errno = ECANCELED;
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * pmempool_xsyncU -- synchronize replicas within a poolset using given
+ *	copy options
  */
 #ifndef _WIN32
 static inline
 #endif
 int
-pmempool_syncU(const char *poolset, unsigned flags)
+pmempool_xsyncU(const char *poolset, unsigned flags,
+	const struct pmempool_copy_opts *opts)
 {
-	LOG(3, "poolset %s, flags %u", poolset, flags);
+	LOG(3, "poolset %s, flags %u, opts %p", poolset, flags, opts);
 	ASSERTne(poolset, NULL);
 
 	/* check if poolset has correct signature */
@@ -1358,16 +1756,24 @@ pmempool_syncU(const char *poolset, unsigned flags)
 		goto err_close_file;
 	}
 
+	struct replica_copy cp;
+	if (replica_copy_init(&cp, opts))
+		goto err_close_all;
+
 	/* sync all replicas */
-	if (replica_sync(set, NULL, flags)) {
+	if (replica_sync(set, NULL, flags, &cp)) {
 		LOG(1, "synchronization failed");
-		goto err_close_all;
+		goto err_copy_fini;
 	}
 
+	replica_copy_fini(&cp);
 	util_poolset_close(set, DO_NOT_DELETE_PARTS);
 	os_close(fd);
 	return 0;
 
+err_copy_fini:
+	replica_copy_fini(&cp);
+
 err_close_all:
 	util_poolset_close(set, DO_NOT_DELETE_PARTS);
 
@@ -1381,6 +1787,18 @@ err:
 	return -1;
 }
 
+/*
+ * pmempool_syncU -- synchronize replicas within a poolset
+ */
+#ifndef _WIN32
+static inline
+#endif
+int
+pmempool_syncU(const char *poolset, unsigned flags)
+{
+	return pmempool_xsyncU(poolset, flags, NULL);
+}
+
 #ifndef _WIN32
 /*
  * pmempool_sync -- synchronize replicas within a poolset
@@ -1390,12 +1808,34 @@ pmempool_sync(const char *poolset, unsigned flags)
 {
 	return pmempool_syncU(poolset, flags);
 }
+
+/*
+ * pmempool_xsync -- synchronize replicas within a poolset using given
+ *	copy options
+ */
+int
+pmempool_xsync(const char *poolset, unsigned flags,
+	const struct pmempool_copy_opts *opts)
+{
+	return pmempool_xsyncU(poolset, flags, opts);
+}
 #else
 /*
  * pmempool_syncW -- synchronize replicas within a poolset in widechar
  */
 int
 pmempool_syncW(const wchar_t *poolset, unsigned flags)
+{
+	return pmempool_xsyncW(poolset, flags, NULL);
+}
+
+/*
+ * pmempool_xsyncW -- synchronize replicas within a poolset using given
+ *	copy options in widechar
+ */
+int
+pmempool_xsyncW(const wchar_t *poolset, unsigned flags,
+	const struct pmempool_copy_opts *opts)
 {
 	char *path = util_toUTF8(poolset);
 	if (path == NULL) {
@@ -1403,7 +1843,7 @@ pmempool_syncW(const wchar_t *poolset, unsigned flags)
 		return -1;
 	}
 
-	int ret = pmempool_syncU(path, flags);
+	int ret = pmempool_xsyncU(path, flags, opts);
 
 	util_free_UTF8(path);
 	return ret;
@@ -1411,17 +1851,18 @@ pmempool_syncW(const wchar_t *poolset, unsigned flags)
 #endif
 
 /*
- * pmempool_transformU -- alter poolset structure
+ * pmempool_xtransformU -- alter poolset structure using given copy options
  */
 #ifndef _WIN32
 static inline
 #endif
 int
-pmempool_transformU(const char *poolset_src,
-		const char *poolset_dst, unsigned flags)
+pmempool_xtransformU(const char *poolset_src,
+		const char *poolset_dst, unsigned flags,
+		const struct pmempool_copy_opts *opts)
 {
-	LOG(3, "poolset_src %s, poolset_dst %s, flags %u", poolset_src,
-			poolset_dst, flags);
+	LOG(3, "poolset_src %s, poolset_dst %s, flags %u, opts %p",
+			poolset_src, poolset_dst, flags, opts);
 	ASSERTne(poolset_src, NULL);
 	ASSERTne(poolset_dst, NULL);
 
@@ -1498,16 +1939,24 @@ pmempool_transformU(const char *poolset_src,
 
 	del = is_dry_run(flags) ? DO_NOT_DELETE_PARTS : DELETE_CREATED_PARTS;
 
+	struct replica_copy cp;
+	if (replica_copy_init(&cp, opts))
+		goto err_free_poolout;
+
 	/* transform poolset */
-	if (replica_transform(set_in, set_out, flags)) {
+	if (replica_transform(set_in, set_out, flags, &cp)) {
 		LOG(1, "transformation failed");
-		goto err_free_poolout;
+		goto err_copy_fini;
 	}
 
+	replica_copy_fini(&cp);
 	util_poolset_close(set_in, DO_NOT_DELETE_PARTS);
 	util_poolset_close(set_out, DO_NOT_DELETE_PARTS);
 	return 0;
 
+err_copy_fini:
+	replica_copy_fini(&cp);
+
 err_free_poolout:
 	util_poolset_close(set_out, del);
 
@@ -1521,6 +1970,19 @@ err:
 	return -1;
 }
 
+/*
+ * pmempool_transformU -- alter poolset structure
+ */
+#ifndef _WIN32
+static inline
+#endif
+int
+pmempool_transformU(const char *poolset_src,
+		const char *poolset_dst, unsigned flags)
+{
+	return pmempool_xtransformU(poolset_src, poolset_dst, flags, NULL);
+}
+
 #ifndef _WIN32
 /*
  * pmempool_transform -- alter poolset structure
@@ -1531,6 +1993,17 @@ pmempool_transform(const char *poolset_src,
 {
 	return pmempool_transformU(poolset_src, poolset_dst, flags);
 }
+
+/*
+ * pmempool_xtransform -- alter poolset structure using given copy options
+ */
+int
+pmempool_xtransform(const char *poolset_src,
+	const char *poolset_dst, unsigned flags,
+	const struct pmempool_copy_opts *opts)
+{
+	return pmempool_xtransformU(poolset_src, poolset_dst, flags, opts);
+}
 #else
 /*
  * pmempool_transformW -- alter poolset structure in widechar
@@ -1538,6 +2011,18 @@ pmempool_transform(const char *poolset_src,
 int
 pmempool_transformW(const wchar_t *poolset_src,
 	const wchar_t *poolset_dst, unsigned flags)
+{
+	return pmempool_xtransformW(poolset_src, poolset_dst, flags, NULL);
+}
+
+/*
+ * pmempool_xtransformW -- alter poolset structure using given copy options
+ *	in widechar
+ */
+int
+pmempool_xtransformW(const wchar_t *poolset_src,
+	const wchar_t *poolset_dst, unsigned flags,
+	const struct pmempool_copy_opts *opts)
 {
 	char *path_src = util_toUTF8(poolset_src);
 	if (path_src == NULL) {
@@ -1552,7 +2037,7 @@ pmempool_transformW(const wchar_t *poolset_src,
 		return -1;
 	}
 
-	int ret = pmempool_transformU(path_src, path_dst, flags);
+	int ret = pmempool_xtransformU(path_src, path_dst, flags, opts);
 
 	util_free_UTF8(path_src);
 	util_free_UTF8(path_dst);
@@ -35,6 +35,7 @@
  */
 #include "libpmempool.h"
 #include "pool.h"
+#include "os_thread.h"
 
 #define UNDEF_REPLICA UINT_MAX
 #define UNDEF_PART UINT_MAX
@@ -51,6 +52,13 @@
  */
 #define IS_INCONSISTENT (1 << 1)
 
+/*
+ * A part marked as having bad blocks has healthy metadata, but some ranges
+ * of its data are damaged; only these ranges have to be cleared and restored
+ * from a healthy replica. A replica containing such a part is marked as well.
+ */
+#define HAS_BAD_BLOCKS (1 << 2)
+
 /*
  * A flag which can be passed to sync_replica() to indicate that the function is
  * called by pmempool_transform
@@ -58,9 +66,51 @@
 #define IS_TRANSFORMED (1 << 10)
 
 /*
- * Number of lanes utilized when working with remote replicas
+ * Number of lanes utilized when working with remote replicas -- reading data
+ * from a healthy remote replica is spread across all of them
+ */
+#define REMOTE_NLANES	4
+
+/*
+ * Default size of the chunk of data copied and persisted at once when
+ * rebuilding a replica
  */
-#define REMOTE_NLANES	1
+#define REPLICA_COPY_CHUNK	(16 << 20)
+
+/*
+ * Size of the region compared with the healthy replica in the incremental
+ * sync mode, only differing regions are copied
+ */
+#define REPLICA_COPY_GRANULE	(2 << 20)
+
+/*
+ * Default and maximum number of threads copying data to a rebuilt replica
+ */
+#define REPLICA_COPY_THREADS		8
+#define REPLICA_COPY_MAX_THREADS	64
+
+/*
+ * replica_copy -- state of copying data between replicas shared by all
+ * copying threads, progress is reported per copy pass
+ */
+struct replica_copy {
+	unsigned nthreads;
+	size_t chunk_size;
+	size_t max_bandwidth;
+	pmempool_progress_func *progress;
+	void *arg;
+	int incremental;	/* copy only differing granules */
+	unsigned src_replica;	/* source replica number counted from 1 */
+
+	size_t total;		/* bytes to be copied in the current pass */
+	size_t copied;		/* bytes copied so far in the current pass */
+	size_t written;		/* bytes which actually differed */
+	struct timespec start;	/* start time of the current pass */
+	int canceled;
+
+	os_mutex_t lock;
+	os_cond_t cond;		/* used only for throttling */
+};
 
 /*
  * Helping structures for storing replica and poolset's health status
@@ -72,6 +122,8 @@ struct replica_health_status {
 	unsigned flags;
 	/* effective size of a pool, valid only for healthy replica */
 	size_t pool_size;
+	/* bad blocks for each part, valid only for parts with bad blocks */
+	struct badblocks **part_bbs;
 	/* flags for each part */
 	unsigned part[];
 };
@@ -153,6 +205,10 @@ int replica_is_replica_consistent(unsigned repn,
 		struct poolset_health_status *set_hs);
 int replica_is_replica_healthy(unsigned repn,
 		struct poolset_health_status *set_hs);
+int replica_part_has_bad_blocks(unsigned repn, unsigned partn,
+		struct poolset_health_status *set_hs);
+int replica_has_bad_blocks(unsigned repn,
+		struct poolset_health_status *set_hs);
 unsigned replica_find_healthy_replica(struct poolset_health_status *set_hs);
 int replica_is_poolset_healthy(struct poolset_health_status *set_hs);
 int replica_is_poolset_transformed(unsigned flags);
@@ -166,7 +222,15 @@ int replica_check_local_part_dir(struct pool_set *set, unsigned repn,
 int replica_open_replica_part_files(struct pool_set *set, unsigned repn);
 int replica_open_poolset_part_files(struct pool_set *set);
 
+int replica_copy_init(struct replica_copy *cp,
+		const struct pmempool_copy_opts *opts);
+void replica_copy_fini(struct replica_copy *cp);
+void replica_copy_begin(struct replica_copy *cp, size_t total);
+int replica_copy_progress(struct replica_copy *cp, size_t len);
+int replica_copy_data(struct replica_copy *cp, void *dst, const void *src,
+		size_t len, int is_pmem);
+
 int replica_sync(struct pool_set *set_in, struct poolset_health_status *set_hs,
-		unsigned flags);
+		unsigned flags, struct replica_copy *cp);
 int replica_transform(struct pool_set *set_in, struct pool_set *set_out,
-		unsigned flags);
+		unsigned flags, struct replica_copy *cp);
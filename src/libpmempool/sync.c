@@ -47,6 +47,7 @@
 #include "out.h"
 #include "os.h"
 #include "util_pmem.h"
+#include "os_badblock.h"
 #include "util.h"
 
 #ifdef USE_RPMEM
@@ -128,6 +129,38 @@ recreate_broken_parts(struct pool_set *set,
 	return 0;
 }
 
+/*
+ * clear_bad_blocks -- (internal) clear bad blocks in the parts with damaged
+ *                     data ranges, the ranges are restored later from
+ *                     a healthy replica
+ */
+static int
+clear_bad_blocks(struct pool_set *set, struct poolset_health_status *set_hs)
+{
+	LOG(3, "set %p, set_hs %p", set, set_hs);
+
+	for (unsigned r = 0; r < set_hs->nreplicas; ++r) {
+		if (set->replica[r]->remote ||
+				!replica_has_bad_blocks(r, set_hs))
+			continue;
+
+		struct replica_health_status *rep_hs = REP_HEALTH(set_hs, r);
+
+		for (unsigned p = 0; p < rep_hs->nparts; ++p) {
+			if (!replica_part_has_bad_blocks(r, p, set_hs))
+				continue;
+
+			const char *path = PART(REP(set, r), p)->path;
+			if (os_badblocks_clear(path, rep_hs->part_bbs[p])) {
+				ERR("clearing bad blocks failed -- '%s'", path);
+				return -1;
+			}
+		}
+	}
+
+	return 0;
+}
+
 /*
  * fill_struct_part_uuids -- (internal) set part uuids in pool_set structure
  */
@@ -303,79 +336,286 @@ create_headers_for_broken_parts(struct pool_set *set, unsigned src_replica,
 }
 
 /*
- * copy_data_to_broken_parts -- (internal) copy data to all parts created
- *                              in place of the broken ones
+ * invalidate_broken_parts -- (internal) zero headers of all local parts
+ *                            created in place of the broken ones or with
+ *                            cleared bad blocks, so that parts which were
+ *                            not filled with data are recognized as broken
+ *                            by the next sync
+ */
+static void
+invalidate_broken_parts(struct pool_set *set,
+		struct poolset_health_status *set_hs)
+{
+	LOG(3, "set %p, set_hs %p", set, set_hs);
+	for (unsigned r = 0; r < set_hs->nreplicas; ++r) {
+		/* skip unbroken and remote replicas */
+		if ((!replica_is_replica_broken(r, set_hs) &&
+				!replica_has_bad_blocks(r, set_hs)) ||
+				REP(set, r)->remote)
+			continue;
+
+		for (unsigned p = 0; p < set_hs->replica[r]->nhdrs; p++) {
+			/* skip unbroken parts */
+			if (!replica_is_part_broken(r, p, set_hs) &&
+				!replica_part_has_bad_blocks(r, p, set_hs))
+				continue;
+
+			struct pool_hdr *hdrp = HDR(REP(set, r), p);
+			memset(hdrp, 0, sizeof(*hdrp));
+			util_persist(REP(set, r)->is_pmem, hdrp,
+					sizeof(*hdrp));
+		}
+	}
+}
+
+/*
+ * sync_read_remote -- (internal) read data from a remote replica using all
+ *                     the lanes granted by the remote node
  */
 static int
-copy_data_to_broken_parts(struct pool_set *set, unsigned healthy_replica,
-		unsigned flags, struct poolset_health_status *set_hs)
+sync_read_remote(struct remote_replica *remote, void *buff, size_t off,
+		size_t len)
 {
-	LOG(3, "set %p, healthy_replica %u, flags %u, set_hs %p", set,
-			healthy_replica, flags, set_hs);
+	if (Rpmem_read_bulk == NULL || remote->nlanes <= 1)
+		return Rpmem_read(remote->rpp, buff, off, len, 0);
+
+	return Rpmem_read_bulk(remote->rpp, buff, off, len, 0, remote->nlanes);
+}
 
+/*
+ * part_data_range -- (internal) get the range of data which has to be copied
+ *                    to the part, returns 0 if the part does not need any data
+ *
+ * In the incremental mode data of healthy local replicas is compared with the
+ * source replica as well, as their data may be out of date.
+ */
+static int
+part_data_range(struct pool_set *set, unsigned r, unsigned p,
+		struct poolset_health_status *set_hs, unsigned healthy_replica,
+		unsigned flags, size_t *offp, size_t *lenp)
+{
 	/* get pool size from healthy replica */
 	size_t poolsize = set->poolsize;
 
-	for (unsigned r = 0; r < set_hs->nreplicas; ++r) {
+	if (replica_is_replica_healthy(r, set_hs)) {
 		/* skip unbroken and consistent replicas */
-		if (replica_is_replica_healthy(r, set_hs))
-			continue;
+		if (!(flags & PMEMPOOL_SYNC_INCREMENTAL) ||
+				r == healthy_replica ||
+				REP(set, r)->remote ||
+				REP(set, healthy_replica)->remote)
+			return 0;
+	} else if (!replica_is_part_broken(r, p, set_hs) &&
+		replica_is_replica_consistent(r, set_hs)) {
+		/* skip unbroken parts from consistent replicas */
+		return 0;
+	}
 
-		struct pool_replica *rep = REP(set, r);
-		struct pool_replica *rep_h = REP(set, healthy_replica);
+	size_t off = replica_get_part_data_offset(set, r, p);
+	size_t len = replica_get_part_data_len(set, r, p);
 
-		for (unsigned p = 0; p < rep->nparts; ++p) {
-			/* skip unbroken parts from consistent replicas */
-			if (!replica_is_part_broken(r, p, set_hs) &&
-				replica_is_replica_consistent(r, set_hs))
-				continue;
+	/* do not allow copying too much data */
+	if (off >= poolsize)
+		return 0;
+
+	if (off + len > poolsize || REP(set, r)->remote)
+		len = poolsize - off;
 
-			const struct pool_set_part *part = &rep->part[p];
+	*offp = off;
+	*lenp = len;
+	return 1;
+}
 
-			size_t off = replica_get_part_data_offset(set, r, p);
-			size_t len = replica_get_part_data_len(set, r, p);
+/*
+ * part_bad_block_range -- (internal) get the range of data which has to be
+ *                         restored in place of the (b)th bad block of
+ *                         the part, returns 0 if the bad block does not
+ *                         overlap the data of the pool
+ */
+static int
+part_bad_block_range(struct pool_set *set, unsigned r, unsigned p,
+		struct poolset_health_status *set_hs, unsigned b,
+		size_t *offp, size_t *lenp)
+{
+	struct bad_block *bb = &REP_HEALTH(set_hs, r)->part_bbs[p]->bbv[b];
+	struct pool_set_part *part = PART(REP(set, r), p);
+
+	/* offset of the part's data in the file */
+	size_t data_foff = (p == 0) ? POOL_HDR_SIZE :
+		((set->options & OPTION_SINGLEHDR) ? 0 : part->alignment);
+	size_t data_off = replica_get_part_data_offset(set, r, p);
+	size_t data_len = replica_get_part_data_len(set, r, p);
+
+	size_t beg = (size_t)bb->offset;
+	size_t end = beg + bb->length;
+
+	if (beg < data_foff)
+		beg = data_foff;
+	if (end > data_foff + data_len)
+		end = data_foff + data_len;
+	if (beg >= end)
+		return 0;
+
+	size_t off = data_off + (beg - data_foff);
+	size_t len = end - beg;
+
+	/* do not allow copying too much data */
+	if (off >= set->poolsize)
+		return 0;
+
+	if (off + len > set->poolsize)
+		len = set->poolsize - off;
+
+	*offp = off;
+	*lenp = len;
+	return 1;
+}
+
+/*
+ * sync_persist_remote -- (internal) copy data to a remote replica in chunks
+ *                        so that the progress can be reported
+ */
+static int
+sync_persist_remote(struct remote_replica *remote, size_t off, size_t len,
+		struct replica_copy *cp)
+{
+	while (len > 0) {
+		size_t chunk = len < cp->chunk_size ? len : cp->chunk_size;
+
+		if (Rpmem_persist(remote->rpp, off, chunk, 0, 0))
+			return -1;
+
+		/*
+		 * headers of a remote replica cannot be invalidated if copying
+		 * stops halfway, so cancellation is ignored here
+		 */
+		(void) replica_copy_progress(cp, chunk);
+
+		off += chunk;
+		len -= chunk;
+	}
+
+	return 0;
+}
+
+/*
+ * copy_data_range -- (internal) copy a range of data from the healthy replica
+ *                    to the part of the given replica
+ */
+static int
+copy_data_range(struct pool_set *set, unsigned healthy_replica, unsigned r,
+		unsigned p, size_t off, size_t len, struct replica_copy *cp)
+{
+	struct pool_replica *rep = REP(set, r);
+	struct pool_replica *rep_h = REP(set, healthy_replica);
+	const struct pool_set_part *part = &rep->part[p];
 
-			/* do not allow copying too much data */
-			if (off >= poolsize)
+	/*
+	 * First part of replica is mapped
+	 * with header
+	 */
+	size_t fpoff = (p == 0) ? POOL_HDR_SIZE : 0;
+	void *dst_addr = ADDR_SUM(part->addr,
+			fpoff + off - replica_get_part_data_offset(set, r, p));
+
+	if (rep->remote) {
+		int ret = sync_persist_remote(rep->remote, off, len, cp);
+		if (ret) {
+			LOG(1,
+				"Copying data to remote node failed -- '%s' on '%s'",
+				rep->remote->pool_desc,
+				rep->remote->node_addr);
+			return -1;
+		}
+	} else if (rep_h->remote) {
+		int ret = sync_read_remote(rep_h->remote, dst_addr, off, len);
+		if (ret) {
+			LOG(1,
+				"Reading data from remote node failed -- '%s' on '%s'",
+				rep_h->remote->pool_desc,
+				rep_h->remote->node_addr);
+			return -1;
+		}
+		if (replica_copy_progress(cp, len))
+			return -1;
+	} else {
+		void *src_addr = ADDR_SUM(rep_h->part[0].addr, off);
+
+		/* copy and persist data chunk by chunk */
+		if (replica_copy_data(cp, dst_addr, src_addr, len,
+				rep->is_pmem || part->is_dev_dax))
+			return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * copy_data_to_broken_parts -- (internal) copy data to all parts created
+ *                              in place of the broken ones and to the ranges
+ *                              of cleared bad blocks
+ */
+static int
+copy_data_to_broken_parts(struct pool_set *set, unsigned healthy_replica,
+		unsigned flags, struct poolset_health_status *set_hs,
+		struct replica_copy *cp)
+{
+	LOG(3, "set %p, healthy_replica %u, flags %u, set_hs %p, cp %p", set,
+			healthy_replica, flags, set_hs, cp);
+
+	size_t off;
+	size_t len;
+
+	/* the progress is reported against all data to be copied */
+	size_t total = 0;
+	for (unsigned r = 0; r < set_hs->nreplicas; ++r) {
+		for (unsigned p = 0; p < REP(set, r)->nparts; ++p) {
+			if (part_data_range(set, r, p, set_hs,
+					healthy_replica, flags, &off, &len)) {
+				total += len;
 				continue;
+			}
 
-			if (off + len > poolsize || rep->remote)
-				len = poolsize - off;
-
-			/*
-			 * First part of replica is mapped
-			 * with header
-			 */
-			size_t fpoff = (p == 0) ? POOL_HDR_SIZE : 0;
-			void *dst_addr = ADDR_SUM(part->addr, fpoff);
-
-			if (rep->remote) {
-				int ret = Rpmem_persist(rep->remote->rpp, off,
-						len, 0, 0);
-				if (ret) {
-					LOG(1,
-						"Copying data to remote node failed -- '%s' on '%s'",
-						rep->remote->pool_desc,
-						rep->remote->node_addr);
+			if (!replica_part_has_bad_blocks(r, p, set_hs))
+				continue;
+
+			struct badblocks *bbs =
+				REP_HEALTH(set_hs, r)->part_bbs[p];
+			for (unsigned b = 0; b < bbs->bb_cnt; ++b) {
+				if (part_bad_block_range(set, r, p, set_hs, b,
+						&off, &len))
+					total += len;
+			}
+		}
+	}
+
+	/* only the regions which differ are written in the incremental mode */
+	cp->incremental = (flags & PMEMPOOL_SYNC_INCREMENTAL) != 0;
+	replica_copy_begin(cp, total);
+
+	for (unsigned r = 0; r < set_hs->nreplicas; ++r) {
+		for (unsigned p = 0; p < REP(set, r)->nparts; ++p) {
+			if (part_data_range(set, r, p, set_hs,
+					healthy_replica, flags, &off, &len)) {
+				if (copy_data_range(set, healthy_replica, r, p,
+						off, len, cp))
 					return -1;
-				}
-			} else if (rep_h->remote) {
-				int ret = Rpmem_read(rep_h->remote->rpp,
-						dst_addr, off, len, 0);
-				if (ret) {
-					LOG(1,
-						"Reading data from remote node failed -- '%s' on '%s'",
-						rep_h->remote->pool_desc,
-						rep_h->remote->node_addr);
+				continue;
+			}
+
+			/* restore only the ranges of cleared bad blocks */
+			if (!replica_part_has_bad_blocks(r, p, set_hs))
+				continue;
+
+			struct badblocks *bbs =
+				REP_HEALTH(set_hs, r)->part_bbs[p];
+			for (unsigned b = 0; b < bbs->bb_cnt; ++b) {
+				if (!part_bad_block_range(set, r, p, set_hs, b,
+						&off, &len))
+					continue;
+
+				if (copy_data_range(set, healthy_replica, r, p,
+						off, len, cp))
 					return -1;
-				}
-			} else {
-				void *src_addr =
-					ADDR_SUM(rep_h->part[0].addr, off);
-
-				/* copy all data */
-				memcpy(dst_addr, src_addr, len);
-				util_persist(part->is_dev_dax, dst_addr, len);
 			}
 		}
 	}
@@ -711,14 +951,50 @@ create_remote_replicas(struct pool_set *set,
 }
 
 
+/*
+ * incremental_source -- (internal) get the source replica of the incremental
+ *                       sync given by the user
+ */
+static int
+incremental_source(struct pool_set *set, struct poolset_health_status *set_hs,
+		struct replica_copy *cp, unsigned *repn)
+{
+	if (cp == NULL || cp->src_replica == 0) {
+		ERR("incremental sync requires the source replica");
+		errno = EINVAL;
+		return -1;
+	}
+
+	unsigned r = cp->src_replica - 1;
+	if (r >= set->nreplicas) {
+		ERR("invalid source replica %u", cp->src_replica);
+		errno = EINVAL;
+		return -1;
+	}
+
+	/*
+	 * The bad blocks of the source would be cleared before its data is
+	 * compared with the other replicas, so it must not have any.
+	 */
+	if (!replica_is_replica_healthy(r, set_hs) ||
+			replica_has_bad_blocks(r, set_hs)) {
+		ERR("source replica %u is not healthy", cp->src_replica);
+		errno = EINVAL;
+		return -1;
+	}
+
+	*repn = r;
+	return 0;
+}
+
 /*
  * sync_replica -- synchronize data across replicas within a poolset
  */
 int
 replica_sync(struct pool_set *set, struct poolset_health_status *s_hs,
-		unsigned flags)
+		unsigned flags, struct replica_copy *cp)
 {
-	LOG(3, "set %p, flags %u", set, flags);
+	LOG(3, "set %p, flags %u, cp %p", set, flags, cp);
 	int ret = 0;
 	struct poolset_health_status *set_hs = NULL;
 
@@ -734,8 +1010,12 @@ replica_sync(struct pool_set *set, struct poolset_health_status *s_hs,
 			return -1;
 		}
 
-		/* check if poolset is broken; if not, nothing to do */
-		if (replica_is_poolset_healthy(set_hs)) {
+		/*
+		 * check if poolset is broken; if not, nothing to do unless
+		 * data of the replicas is to be compared
+		 */
+		if (replica_is_poolset_healthy(set_hs) &&
+				!(flags & PMEMPOOL_SYNC_INCREMENTAL)) {
 			LOG(1, "poolset is healthy");
 			goto out;
 		}
@@ -743,13 +1023,25 @@ replica_sync(struct pool_set *set, struct poolset_health_status *s_hs,
 		set_hs = s_hs;
 	}
 
-	/* find one good replica; it will be the source of data */
-	unsigned healthy_replica = replica_find_healthy_replica(set_hs);
-	if (healthy_replica == UNDEF_REPLICA) {
-		ERR("no healthy replica found");
-		errno = EINVAL;
-		ret = -1;
-		goto out;
+	unsigned healthy_replica;
+	if (flags & PMEMPOOL_SYNC_INCREMENTAL) {
+		/*
+		 * healthy metadata says nothing about which replica holds
+		 * the newest data, so the source has to be given explicitly
+		 */
+		if (incremental_source(set, set_hs, cp, &healthy_replica)) {
+			ret = -1;
+			goto out;
+		}
+	} else {
+		/* find one good replica; it will be the source of data */
+		healthy_replica = replica_find_healthy_replica(set_hs);
+		if (healthy_replica == UNDEF_REPLICA) {
+			ERR("no healthy replica found");
+			errno = EINVAL;
+			ret = -1;
+			goto out;
+		}
 	}
 
 	/* in dry-run mode we can stop here */
@@ -765,6 +1057,13 @@ replica_sync(struct pool_set *set, struct poolset_health_status *s_hs,
 		goto out;
 	}
 
+	/* clear bad blocks in parts with damaged data */
+	if (clear_bad_blocks(set, set_hs)) {
+		ERR("clearing bad blocks failed");
+		ret = -1;
+		goto out;
+	}
+
 	/* open all part files */
 	if (replica_open_poolset_part_files(set)) {
 		ERR("opening poolset part files failed");
@@ -812,8 +1111,9 @@ replica_sync(struct pool_set *set, struct poolset_health_status *s_hs,
 
 	/* check and copy data if possible */
 	if (copy_data_to_broken_parts(set, healthy_replica,
-			flags, set_hs)) {
+			flags, set_hs, cp)) {
 		ERR("copying data to broken parts failed");
+		invalidate_broken_parts(set, set_hs);
 		ret = -1;
 		goto out;
 	}
@@ -569,6 +569,23 @@ delete_replicas(struct pool_set *set, struct poolset_compare_status *set_s)
 	return 0;
 }
 
+/*
+ * copy_replica_progress -- (internal) report progress of moving data within
+ *                          a replica once per copy chunk
+ *
+ * Moving data between two mappings of the same replica cannot be split
+ * between threads nor stopped halfway, so cancellation is ignored here.
+ */
+static void
+copy_replica_progress(struct replica_copy *cp, size_t *pending, int last)
+{
+	*pending += POOL_HDR_SIZE;
+	if (*pending >= cp->chunk_size || (last && *pending > 0)) {
+		(void) replica_copy_progress(cp, *pending);
+		*pending = 0;
+	}
+}
+
 /*
  * copy_replica_data_fw -- (internal) copy data between replicas of two
  *                         poolsets, starting from the beginning of the
@@ -576,7 +593,7 @@ delete_replicas(struct pool_set *set, struct poolset_compare_status *set_s)
  */
 static void
 copy_replica_data_fw(struct pool_set *set_dst, struct pool_set *set_src,
-		unsigned repn)
+		unsigned repn, struct replica_copy *cp)
 {
 	LOG(3, "set_in %p, set_out %p, repn %u", set_src, set_dst, repn);
 	ssize_t pool_size = replica_get_pool_size(set_src, repn);
@@ -590,10 +607,13 @@ copy_replica_data_fw(struct pool_set *set_dst, struct pool_set *set_src,
 	void *src = PART(REP(set_src, repn), 1)->addr;
 	void *dst = PART(REP(set_dst, repn), 1)->addr;
 	size_t count = len / POOL_HDR_SIZE;
+	size_t pending = 0;
+	replica_copy_begin(cp, count * POOL_HDR_SIZE);
 	while (count-- > 0) {
 		pmem_memcpy_persist(dst, src, POOL_HDR_SIZE);
 		src = ADDR_SUM(src, POOL_HDR_SIZE);
 		dst = ADDR_SUM(dst, POOL_HDR_SIZE);
+		copy_replica_progress(cp, &pending, count == 0);
 	}
 }
 
@@ -603,7 +623,7 @@ copy_replica_data_fw(struct pool_set *set_dst, struct pool_set *set_src,
  */
 static void
 copy_replica_data_bw(struct pool_set *set_dst, struct pool_set *set_src,
-		unsigned repn)
+		unsigned repn, struct replica_copy *cp)
 {
 	LOG(3, "set_in %p, set_out %p, repn %u", set_src, set_dst, repn);
 	ssize_t pool_size = replica_get_pool_size(set_src, repn);
@@ -617,10 +637,13 @@ copy_replica_data_bw(struct pool_set *set_dst, struct pool_set *set_src,
 	size_t count = len / POOL_HDR_SIZE;
 	void *src = ADDR_SUM(PART(REP(set_src, repn), 1)->addr, len);
 	void *dst = ADDR_SUM(PART(REP(set_dst, repn), 1)->addr, len);
+	size_t pending = 0;
+	replica_copy_begin(cp, count * POOL_HDR_SIZE);
 	while (count-- > 0) {
 		src = ADDR_SUM(src, -(ssize_t)POOL_HDR_SIZE);
 		dst = ADDR_SUM(dst, -(ssize_t)POOL_HDR_SIZE);
 		pmem_memcpy_persist(dst, src, POOL_HDR_SIZE);
+		copy_replica_progress(cp, &pending, count == 0);
 	}
 }
 
@@ -741,7 +764,7 @@ copy_part_fds(struct pool_set *set_dst, struct pool_set *set_src)
  */
 static int
 remove_hdrs_replica(struct pool_set *set_in, struct pool_set *set_out,
-		unsigned repn)
+		unsigned repn, struct replica_copy *cp)
 {
 	LOG(3, "set %p, repn %u", set_in, repn);
 	int ret = 0;
@@ -772,7 +795,7 @@ remove_hdrs_replica(struct pool_set *set_in, struct pool_set *set_out,
 
 	/* move data between the two mappings of the replica */
 	if (REP(set_in, repn)->nparts > 1)
-		copy_replica_data_fw(set_out, set_in, repn);
+		copy_replica_data_fw(set_out, set_in, repn, cp);
 
 	/* make changes to the first part's header */
 	update_replica_header(set_out, repn);
@@ -793,7 +816,7 @@ out:
  */
 static int
 add_hdrs_replica(struct pool_set *set_in, struct pool_set *set_out,
-		unsigned repn)
+		unsigned repn, struct replica_copy *cp)
 {
 	LOG(3, "set %p, repn %u", set_in, repn);
 	int ret = 0;
@@ -832,7 +855,7 @@ add_hdrs_replica(struct pool_set *set_in, struct pool_set *set_out,
 
 	/* copy data between the two mappings of the replica */
 	if (REP(set_in, repn)->nparts > 1)
-		copy_replica_data_bw(set_out, set_in, repn);
+		copy_replica_data_bw(set_out, set_in, repn, cp);
 
 	/* create the missing headers */
 	if (create_missing_headers(set_out, repn)) {
@@ -842,7 +865,7 @@ add_hdrs_replica(struct pool_set *set_in, struct pool_set *set_out,
 		 * state
 		 */
 		if (REP(set_in, repn)->nparts > 1)
-			copy_replica_data_fw(set_in, set_out, repn);
+			copy_replica_data_fw(set_in, set_out, repn, cp);
 		ret = -1;
 		goto out_unmap_out;
 	}
@@ -870,12 +893,13 @@ out:
  */
 static int
 remove_hdrs(struct pool_set *set_in, struct pool_set *set_out,
-		struct poolset_health_status *set_in_hs, unsigned flags)
+		struct poolset_health_status *set_in_hs, unsigned flags,
+		struct replica_copy *cp)
 {
 	LOG(3, "set_in %p, set_out %p, set_in_hs %p, flags %u",
 			set_in, set_out, set_in_hs, flags);
 	for (unsigned r = 0; r < set_in->nreplicas; ++r) {
-		if (remove_hdrs_replica(set_in, set_out, r)) {
+		if (remove_hdrs_replica(set_in, set_out, r, cp)) {
 			LOG(1, "removing headers from replica %u failed", r);
 			/* mark all previous replicas as damaged */
 			while (--r < set_in->nreplicas)
@@ -894,12 +918,12 @@ remove_hdrs(struct pool_set *set_in, struct pool_set *set_out,
 static int
 add_hdrs(struct pool_set *set_in, struct pool_set *set_out,
 		struct poolset_health_status *set_in_hs,
-		unsigned flags)
+		unsigned flags, struct replica_copy *cp)
 {
 	LOG(3, "set_in %p, set_out %p, set_in_hs %p, flags %u",
 			set_in, set_out, set_in_hs, flags);
 	for (unsigned r = 0; r < set_in->nreplicas; ++r) {
-		if (add_hdrs_replica(set_in, set_out, r)) {
+		if (add_hdrs_replica(set_in, set_out, r, cp)) {
 			LOG(1, "adding headers to replica %u failed", r);
 			/* mark all previous replicas as damaged */
 			while (--r < set_in->nreplicas)
@@ -915,9 +939,9 @@ add_hdrs(struct pool_set *set_in, struct pool_set *set_out,
  */
 int
 replica_transform(struct pool_set *set_in, struct pool_set *set_out,
-		unsigned flags)
+		unsigned flags, struct replica_copy *cp)
 {
-	LOG(3, "set_in %p, set_out %p", set_in, set_out);
+	LOG(3, "set_in %p, set_out %p, cp %p", set_in, set_out, cp);
 
 	int ret = 0;
 	/* validate user arguments */
@@ -967,11 +991,13 @@ replica_transform(struct pool_set *set_in, struct pool_set *set_out,
 	if (operation == RM_HDRS) {
 		if (!is_dry_run(flags) &&
 				remove_hdrs(set_in, set_out, set_in_hs,
-						flags)) {
+						flags, cp)) {
 			ERR("removing headers failed; falling back to the "
 					"input poolset");
+			/* falling back has to copy all the data */
+			cp->canceled = 0;
 			if (replica_sync(set_in, set_in_hs,
-					flags | IS_TRANSFORMED)) {
+					flags | IS_TRANSFORMED, cp)) {
 				LOG(1, "falling back to the input poolset "
 						"failed");
 			} else {
@@ -985,11 +1011,14 @@ replica_transform(struct pool_set *set_in, struct pool_set *set_out,
 
 	if (operation == ADD_HDRS) {
 		if (!is_dry_run(flags) &&
-				add_hdrs(set_in, set_out, set_in_hs, flags)) {
+				add_hdrs(set_in, set_out, set_in_hs, flags,
+						cp)) {
 			ERR("adding headers failed; falling back to the "
 					"input poolset");
+			/* falling back has to copy all the data */
+			cp->canceled = 0;
 			if (replica_sync(set_in, set_in_hs,
-					flags | IS_TRANSFORMED)) {
+					flags | IS_TRANSFORMED, cp)) {
 				LOG(1, "falling back to the input poolset "
 						"failed");
 			} else {
@@ -1014,7 +1043,7 @@ replica_transform(struct pool_set *set_in, struct pool_set *set_out,
 	}
 
 	/* signal that sync is called by transform */
-	if (replica_sync(set_out, set_out_hs, flags | IS_TRANSFORMED)) {
+	if (replica_sync(set_out, set_out_hs, flags | IS_TRANSFORMED, cp)) {
 		ret = -1;
 		goto free_cs;
 	}
@@ -660,6 +660,207 @@ rpmem_persist(RPMEMpool *rpp, size_t offset, size_t length,
 	return 0;
 }
 
+/*
+ * rpmem_token -- (internal) compose token of asynchronous persist operation
+ */
+static inline uint64_t
+rpmem_token(unsigned lane, uint32_t seq)
+{
+	return ((uint64_t)seq << 32) | lane;
+}
+
+/*
+ * rpmem_token_lane -- (internal) get lane number from token
+ */
+static inline unsigned
+rpmem_token_lane(uint64_t token)
+{
+	return (unsigned)(token & UINT32_MAX);
+}
+
+/*
+ * rpmem_token_seq -- (internal) get sequence number from token
+ */
+static inline uint32_t
+rpmem_token_seq(uint64_t token)
+{
+	return (uint32_t)(token >> 32);
+}
+
+/*
+ * rpmem_persist_async -- post persist operation on target node without
+ * waiting for its completion
+ *
+ * rpp           -- remote pool handle
+ * offset        -- offset in pool
+ * length        -- length of persist operation
+ * lane          -- lane number
+ * token         -- token identifying the operation
+ */
+int
+rpmem_persist_async(RPMEMpool *rpp, size_t offset, size_t length,
+	unsigned lane, unsigned flags, uint64_t *token)
+{
+	LOG(3, "rpp %p, offset %zu, length %zu, lane %d, flags 0x%x, "
+			"token %p", rpp, offset, length, lane, flags, token);
+
+	if (unlikely(rpp->error)) {
+		errno = rpp->error;
+		return -1;
+	}
+
+	if (flags & RPMEM_FLAGS_MASK) {
+		ERR("invalid flags (0x%x)", flags);
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (token == NULL) {
+		ERR("invalid token");
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (rpp->no_headers == 0 && offset < RPMEM_HDR_SIZE) {
+		ERR("offset (%zu) in pool is less than %d bytes", offset,
+				RPMEM_HDR_SIZE);
+		errno = EINVAL;
+		return -1;
+	}
+
+	unsigned mode = RPMEM_PERSIST_SEND;
+	if (flags & RPMEM_PERSIST_RELAXED)
+		mode = RPMEM_PERSIST_WRITE;
+
+	uint32_t seq;
+	int ret = rpmem_fip_persist_async(rpp->fip, offset, length,
+			lane, mode, &seq);
+	if (unlikely(ret)) {
+		ERR("persist operation failed");
+		rpp->error = ret;
+		errno = rpp->error;
+		return -1;
+	}
+
+	*token = rpmem_token(lane, seq);
+
+	return 0;
+}
+
+/*
+ * rpmem_poll -- check completion of asynchronous persist operation
+ *
+ * Returns 1 if the operation has been completed and 0 if it is still
+ * in progress.
+ */
+int
+rpmem_poll(RPMEMpool *rpp, uint64_t token)
+{
+	LOG(3, "rpp %p, token 0x%" PRIx64, rpp, token);
+
+	if (unlikely(rpp->error)) {
+		errno = rpp->error;
+		return -1;
+	}
+
+	int ret = rpmem_fip_poll(rpp->fip, rpmem_token_lane(token),
+			rpmem_token_seq(token));
+	if (unlikely(ret < 0)) {
+		ERR("persist operation failed");
+		rpp->error = -ret;
+		errno = rpp->error;
+		return -1;
+	}
+
+	return ret;
+}
+
+/*
+ * rpmem_wait -- wait for completion of asynchronous persist operation
+ */
+int
+rpmem_wait(RPMEMpool *rpp, uint64_t token)
+{
+	LOG(3, "rpp %p, token 0x%" PRIx64, rpp, token);
+
+	if (unlikely(rpp->error)) {
+		errno = rpp->error;
+		return -1;
+	}
+
+	int ret = rpmem_fip_wait(rpp->fip, rpmem_token_lane(token),
+			rpmem_token_seq(token));
+	if (unlikely(ret)) {
+		ERR("persist operation failed");
+		rpp->error = ret;
+		errno = rpp->error;
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * rpmem_persistv -- persist operation on a vector of ranges on target node
+ *
+ * rpp           -- remote pool handle
+ * ranges        -- table of ranges to persist
+ * nranges       -- number of ranges
+ * lane          -- lane number
+ */
+int
+rpmem_persistv(RPMEMpool *rpp, const struct rpmem_range *ranges,
+	unsigned nranges, unsigned lane, unsigned flags)
+{
+	LOG(3, "rpp %p, ranges %p, nranges %u, lane %d, flags 0x%x",
+			rpp, ranges, nranges, lane, flags);
+
+	if (unlikely(rpp->error)) {
+		errno = rpp->error;
+		return -1;
+	}
+
+	if (flags & RPMEM_FLAGS_MASK) {
+		ERR("invalid flags (0x%x)", flags);
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (nranges > 0 && ranges == NULL) {
+		ERR("invalid ranges table");
+		errno = EINVAL;
+		return -1;
+	}
+
+	for (unsigned i = 0; i < nranges; i++) {
+		if (rpp->no_headers == 0 && ranges[i].offset < RPMEM_HDR_SIZE) {
+			ERR("offset (%zu) in pool is less than %d bytes",
+					ranges[i].offset, RPMEM_HDR_SIZE);
+			errno = EINVAL;
+			return -1;
+		}
+	}
+
+	/*
+	 * By default use RDMA SEND persist mode which has atomicity
+	 * guarantees. For relaxed persist use RDMA WRITE.
+	 */
+	unsigned mode = RPMEM_PERSIST_SEND;
+	if (flags & RPMEM_PERSIST_RELAXED)
+		mode = RPMEM_PERSIST_WRITE;
+
+	int ret = rpmem_fip_persistv(rpp->fip, ranges, nranges,
+			lane, mode);
+	if (unlikely(ret)) {
+		ERR("persist operation failed");
+		rpp->error = ret;
+		errno = rpp->error;
+		return -1;
+	}
+
+	return 0;
+}
+
 /*
  * rpmem_deep_persist -- deep flush operation on target node
  *
@@ -733,6 +934,78 @@ rpmem_read(RPMEMpool *rpp, void *buff, size_t offset,
 	return 0;
 }
 
+/*
+ * rpmem_read_bulk -- read data from remote pool using multiple lanes:
+ *
+ * rpp           -- remote pool handle
+ * buff          -- output buffer
+ * offset        -- offset in pool
+ * length        -- length of read operation
+ * lane          -- first lane used by the operation
+ * nlanes        -- number of consecutive lanes used by the operation
+ */
+int
+rpmem_read_bulk(RPMEMpool *rpp, void *buff, size_t offset,
+	size_t length, unsigned lane, unsigned nlanes)
+{
+	LOG(3, "rpp %p, buff %p, offset %zu, length %zu, lane %u, nlanes %u",
+			rpp, buff, offset, length, lane, nlanes);
+
+	if (unlikely(rpp->error)) {
+		errno = rpp->error;
+		return -1;
+	}
+
+	if (nlanes == 0) {
+		ERR("invalid number of lanes");
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (rpp->no_headers == 0 && offset < RPMEM_HDR_SIZE)
+		LOG(1, "reading from pool at offset (%zu) less than %d bytes",
+				offset, RPMEM_HDR_SIZE);
+
+	int ret = rpmem_fip_read_bulk(rpp->fip, buff, length, offset,
+			lane, nlanes);
+	if (unlikely(ret)) {
+		errno = ret;
+		ERR("!read operation failed");
+		rpp->error = ret;
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * rpmem_stats_get -- get statistics of remote pool:
+ *
+ * rpp           -- remote pool handle
+ * lane          -- lane number or RPMEM_STATS_ALL_LANES
+ * stats         -- output statistics
+ */
+int
+rpmem_stats_get(RPMEMpool *rpp, unsigned lane, struct rpmem_stats *stats)
+{
+	LOG(3, "rpp %p, lane %u, stats %p", rpp, lane, stats);
+
+	if (stats == NULL) {
+		ERR("invalid stats");
+		errno = EINVAL;
+		return -1;
+	}
+
+	int ret = rpmem_fip_stats_get(rpp->fip, lane, stats);
+	if (ret) {
+		ERR("invalid lane number -- %u", lane);
+		errno = ret;
+		return -1;
+	}
+
+	return 0;
+}
+
 /*
  * rpmem_set_attr -- overwrite pool attributes on the remote node
  *
@@ -84,6 +84,10 @@
 typedef ssize_t (*rpmem_fip_persist_fn)(struct rpmem_fip *fip, size_t offset,
 		size_t len, unsigned lane, unsigned flags);
 
+typedef int (*rpmem_fip_persistv_fn)(struct rpmem_fip *fip,
+		const struct rpmem_range *segs, unsigned nsegs,
+		unsigned lane, unsigned flags);
+
 typedef int (*rpmem_fip_process_fn)(struct rpmem_fip *fip,
 		void *context, uint64_t flags);
 
@@ -103,6 +107,7 @@ cq_read_infinite(struct fid_cq *cq, void *buf, size_t count)
  */
 struct rpmem_fip_ops {
 	rpmem_fip_persist_fn persist;
+	rpmem_fip_persistv_fn persistv;
 	rpmem_fip_process_fn process;
 	rpmem_fip_init_fn lanes_init;
 	rpmem_fip_init_fn lanes_init_mem;
@@ -128,14 +133,32 @@ struct rpmem_fip_plane {
 	struct rpmem_fip_rma read;	/* READ message */
 	struct rpmem_fip_msg send;	/* SEND message */
 	struct rpmem_fip_msg recv;	/* RECV message */
+	uint64_t pending;	/* events completing posted persist */
+	uint32_t async_seq;	/* sequence number of last async persist */
+	uint64_t async_start;	/* start time of pending async persist [ns] */
+	size_t async_len;	/* length of pending async persist */
+	struct rpmem_stats stats; /* lane statistics */
+	void *rd_buff;		/* read buffer, allocated on first use */
+	struct fid_mr *rd_mr;	/* read buffer memory region */
+	void *rd_mr_desc;	/* read buffer memory descriptor */
 } LANE_ALIGN;
 
+/*
+ * rpmem_fip_rslot -- single READ in flight on the read operation's lane
+ */
+struct rpmem_fip_rslot {
+	struct rpmem_fip_rma read;	/* READ message */
+	void *dst;	/* destination of data read to the read buffer */
+	int busy;	/* READ posted and not completed yet */
+};
+
 /*
  * rpmem_fip_rlane -- read operation's lane
  */
 struct rpmem_fip_rlane {
-	struct rpmem_fip_lane base;	/* base lane structure */
-	struct rpmem_fip_rma read;	/* READ message */
+	struct rpmem_fip_plane *lanep;	/* lane the READs are posted on */
+	struct rpmem_fip_rslot slots[RPMEM_FIP_READ_DEPTH];
+	unsigned inflight;		/* number of READs in flight */
 };
 
 struct rpmem_fip {
@@ -214,6 +237,89 @@ rpmem_fip_lane_begin(struct rpmem_fip_lane *lanep, uint64_t event)
 	lanep->event = event;
 }
 
+/*
+ * rpmem_fip_time_ns -- (internal) return monotonic time in nanoseconds
+ */
+static inline uint64_t
+rpmem_fip_time_ns(void)
+{
+	struct timespec ts;
+	os_clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ * rpmem_fip_stat_load -- (internal) read statistics counter
+ */
+static inline uint64_t
+rpmem_fip_stat_load(uint64_t *cnt)
+{
+	uint64_t val;
+	util_atomic_load_explicit64(cnt, &val, memory_order_relaxed);
+	return val;
+}
+
+/*
+ * rpmem_fip_stat_set -- (internal) set statistics counter
+ *
+ * Lane statistics are modified only by the thread which currently uses
+ * the lane, so plain stores are enough. Atomic stores only make reading
+ * them from other threads well defined.
+ */
+static inline void
+rpmem_fip_stat_set(uint64_t *cnt, uint64_t val)
+{
+	util_atomic_store_explicit64(cnt, val, memory_order_relaxed);
+}
+
+/*
+ * rpmem_fip_stat_add -- (internal) increase statistics counter
+ */
+static inline void
+rpmem_fip_stat_add(uint64_t *cnt, uint64_t val)
+{
+	rpmem_fip_stat_set(cnt, rpmem_fip_stat_load(cnt) + val);
+}
+
+/*
+ * rpmem_fip_stat_bucket -- (internal) return latency histogram bucket
+ *
+ * There are four buckets per power of two, so the bucket width is at most
+ * 25% of its lower bound. Latencies above the range are counted in the
+ * last bucket.
+ */
+static inline unsigned
+rpmem_fip_stat_bucket(uint64_t ns)
+{
+	if (ns < 4)
+		return (unsigned)ns;
+
+	unsigned m = util_mssb_index64(ns);
+	unsigned b = 4 * (m - 1) + (unsigned)((ns >> (m - 2)) & 3);
+
+	return b < RPMEM_STATS_HIST_SIZE ? b : RPMEM_STATS_HIST_SIZE - 1;
+}
+
+/*
+ * rpmem_fip_stat_persist -- (internal) account completed persist operation
+ */
+static void
+rpmem_fip_stat_persist(struct rpmem_fip_plane *lanep, size_t len,
+	uint64_t start)
+{
+	struct rpmem_stats *stats = &lanep->stats;
+	uint64_t lat = rpmem_fip_time_ns() - start;
+
+	if (stats->persists == 0 || lat < stats->lat_min)
+		rpmem_fip_stat_set(&stats->lat_min, lat);
+	if (lat > stats->lat_max)
+		rpmem_fip_stat_set(&stats->lat_max, lat);
+	rpmem_fip_stat_add(&stats->lat_sum, lat);
+	rpmem_fip_stat_add(&stats->lat_hist[rpmem_fip_stat_bucket(lat)], 1);
+	rpmem_fip_stat_add(&stats->persist_bytes, len);
+	rpmem_fip_stat_add(&stats->persists, 1);
+}
+
 /*
  * rpmem_fip_lane_init -- (internal) initialize single lane
  */
@@ -316,6 +422,33 @@ rpmem_fip_lane_fini(struct rpmem_fip_lane *lanep)
 	return lret;
 }
 
+/*
+ * rpmem_fip_lane_cq_err -- (internal) report error read from completion queue
+ */
+static int
+rpmem_fip_lane_cq_err(struct rpmem_fip *fip, struct rpmem_fip_lane *lanep,
+	int ret)
+{
+	struct fi_cq_err_entry err;
+	const char *str_err;
+	ssize_t sret;
+
+	sret = fi_cq_readerr(lanep->cq, &err, 0);
+	if (sret < 0) {
+		RPMEM_FI_ERR((int)sret, "error reading from completion queue: "
+			"cannot read error from event queue");
+		goto err;
+	}
+
+	str_err = fi_cq_strerror(lanep->cq, err.prov_errno, NULL, NULL, 0);
+	RPMEM_LOG(ERR, "error reading from completion queue: %s", str_err);
+err:
+	if (unlikely(rpmem_fip_is_closing(fip)))
+		return ECONNRESET; /* it will be passed to errno */
+
+	return ret;
+}
+
 /*
  * rpmem_fip_lane_wait -- (internal) wait for specific event on completion queue
  */
@@ -324,9 +457,6 @@ rpmem_fip_lane_wait(struct rpmem_fip *fip, struct rpmem_fip_lane *lanep,
 	uint64_t e)
 {
 	ssize_t sret = 0;
-	struct fi_cq_err_entry err;
-	const char *str_err;
-	int ret = 0;
 	struct fi_cq_msg_entry cq_entry;
 
 	while (lanep->event & e) {
@@ -338,30 +468,46 @@ rpmem_fip_lane_wait(struct rpmem_fip *fip, struct rpmem_fip_lane *lanep,
 		if (unlikely(sret == -FI_EAGAIN) || sret == 0)
 			continue;
 
-		if (unlikely(sret < 0)) {
-			ret = (int)sret;
-			goto err_cq_read;
-		}
+		if (unlikely(sret < 0))
+			return rpmem_fip_lane_cq_err(fip, lanep, (int)sret);
 
 		lanep->event &= ~cq_entry.flags;
 	}
 
 	return 0;
-err_cq_read:
-	sret = fi_cq_readerr(lanep->cq, &err, 0);
-	if (sret < 0) {
-		RPMEM_FI_ERR((int)sret, "error reading from completion queue: "
-			"cannot read error from event queue");
-		goto err;
-	}
+}
 
-	str_err = fi_cq_strerror(lanep->cq, err.prov_errno, NULL, NULL, 0);
-	RPMEM_LOG(ERR, "error reading from completion queue: %s", str_err);
-err:
-	if (unlikely(rpmem_fip_is_closing(fip)))
-		return ECONNRESET; /* it will be passed to errno */
+/*
+ * rpmem_fip_lane_poll -- (internal) check for specific event on completion
+ * queue without blocking
+ *
+ * Returns 1 if the event has been completed, 0 if it is still in progress
+ * and an error code otherwise.
+ */
+static int
+rpmem_fip_lane_poll(struct rpmem_fip *fip, struct rpmem_fip_lane *lanep,
+	uint64_t e)
+{
+	ssize_t sret = 0;
+	struct fi_cq_msg_entry cq_entry;
 
-	return ret;
+	while (lanep->event & e) {
+		if (unlikely(rpmem_fip_is_closing(fip)))
+			return -ECONNRESET;
+
+		sret = fi_cq_read(lanep->cq, &cq_entry, 1);
+
+		if (sret == -FI_EAGAIN || sret == 0)
+			return 0;
+
+		if (unlikely(sret < 0))
+			return -abs(rpmem_fip_lane_cq_err(fip, lanep,
+					(int)sret));
+
+		lanep->event &= ~cq_entry.flags;
+	}
+
+	return 1;
 }
 
 /*
@@ -543,6 +689,12 @@ rpmem_fip_lanes_fini_common(struct rpmem_fip *fip)
 		ret = rpmem_fip_lane_fini(&fip->lanes[i].base);
 		if (ret)
 			lret = ret;
+
+		if (fip->lanes[i].rd_buff) {
+			RPMEM_FI_CLOSE(fip->lanes[i].rd_mr,
+					"unregistering read buffer");
+			free(fip->lanes[i].rd_buff);
+		}
 	}
 
 	free(fip->lanes);
@@ -947,7 +1099,7 @@ rpmem_fip_fini_lanes_apm(struct rpmem_fip *fip)
 }
 
 /*
- * rpmem_fip_persist_raw -- (internal) perform persist operation using
+ * rpmem_fip_persist_raw -- (internal) post persist operation using
  * READ after WRITE mechanism
  */
 static int
@@ -978,14 +1130,10 @@ rpmem_fip_persist_raw(struct rpmem_fip *fip, size_t offset,
 		return ret;
 	}
 
-	/* wait for READ completion */
-	ret = rpmem_fip_lane_wait(fip, &lanep->base, FI_READ);
-	if (unlikely(ret)) {
-		ERR("waiting for READ completion failed");
-		return ret;
-	}
+	/* READ completion is collected by rpmem_fip_lane_complete */
+	lanep->pending = FI_READ;
 
-	return ret;
+	return 0;
 }
 
 /*
@@ -1005,7 +1153,48 @@ rpmem_fip_post_resp(struct rpmem_fip *fip,
 }
 
 /*
- * rpmem_fip_persist_saw -- (internal) perform persist operation using
+ * rpmem_fip_lane_complete -- (internal) wait for completion of persist
+ * operation posted on the lane
+ */
+static int
+rpmem_fip_lane_complete(struct rpmem_fip *fip, struct rpmem_fip_plane *lanep)
+{
+	uint64_t pending = lanep->pending;
+	if (pending == 0)
+		return 0;
+
+	int ret = rpmem_fip_lane_wait(fip, &lanep->base, pending);
+	if (unlikely(ret)) {
+		ERR("waiting for %s completion failed",
+			(pending & FI_RECV) ? "RECV" : "READ");
+		if (lanep->async_start) {
+			rpmem_fip_stat_set(&lanep->async_start, 0);
+			rpmem_fip_stat_add(&lanep->stats.errors, 1);
+		}
+		return ret;
+	}
+
+	lanep->pending = 0;
+
+	if (lanep->async_start) {
+		rpmem_fip_stat_persist(lanep, lanep->async_len,
+				lanep->async_start);
+		rpmem_fip_stat_set(&lanep->async_start, 0);
+	}
+
+	if (pending & FI_RECV) {
+		ret = rpmem_fip_post_resp(fip, lanep);
+		if (unlikely(ret)) {
+			ERR("posting RECV buffer failed");
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * rpmem_fip_persist_saw -- (internal) post persist operation using
  * SEND after WRITE mechanism
  */
 static int
@@ -1047,24 +1236,14 @@ rpmem_fip_persist_saw(struct rpmem_fip *fip, size_t offset,
 		return ret;
 	}
 
-	/* wait for persist operation completion */
-	ret = rpmem_fip_lane_wait(fip, &lanep->base, FI_RECV);
-	if (unlikely(ret)) {
-		ERR("waiting for RECV completion failed");
-		return ret;
-	}
-
-	ret = rpmem_fip_post_resp(fip, lanep);
-	if (unlikely(ret)) {
-		ERR("posting RECV buffer failed");
-		return ret;
-	}
+	/* persist response is collected by rpmem_fip_lane_complete */
+	lanep->pending = FI_RECV;
 
 	return 0;
 }
 
 /*
- * rpmem_fip_persist_send -- (internal) perform persist operation using
+ * rpmem_fip_persist_send -- (internal) post persist operation using
  * RDMA SEND operation with data inlined in the message buffer.
  */
 static int
@@ -1103,18 +1282,8 @@ rpmem_fip_persist_send(struct rpmem_fip *fip, size_t offset,
 		return ret;
 	}
 
-	/* wait for persist operation completion */
-	ret = rpmem_fip_lane_wait(fip, &lanep->base, FI_RECV);
-	if (unlikely(ret)) {
-		ERR("waiting for RECV completion failed");
-		return ret;
-	}
-
-	ret = rpmem_fip_post_resp(fip, lanep);
-	if (unlikely(ret)) {
-		ERR("posting RECV buffer failed");
-		return ret;
-	}
+	/* persist response is collected by rpmem_fip_lane_complete */
+	lanep->pending = FI_RECV;
 
 	return 0;
 }
@@ -1210,106 +1379,387 @@ rpmem_fip_persist_apm(struct rpmem_fip *fip, size_t offset,
 }
 
 /*
- * rpmem_fip_post_lanes_common -- (internal) post all persist response message
- * buffers
+ * rpmem_fip_persistv_fill -- (internal) fill vectored persist message
+ * header and table of ranges
  */
-static int
-rpmem_fip_post_lanes_common(struct rpmem_fip *fip)
+static inline void
+rpmem_fip_persistv_fill(struct rpmem_fip *fip, struct rpmem_msg_persist *msg,
+	const struct rpmem_range *segs, unsigned nsegs, unsigned lane,
+	unsigned flags)
 {
-	int ret = 0;
-	for (unsigned i = 0; i < fip->nlanes; i++) {
-		ret = rpmem_fip_post_resp(fip, &fip->lanes[i]);
-		if (ret)
-			break;
-	}
+	struct rpmem_msg_persist_range *tab =
+		(struct rpmem_msg_persist_range *)msg->data;
 
-	return ret;
-}
+	msg->flags = flags | RPMEM_PERSIST_VEC;
+	msg->lane = lane;
+	msg->addr = 0;
+	msg->size = nsegs;
 
-/*
- * rpmem_fip_ops -- some operations specific for persistency method used
- */
-static struct rpmem_fip_ops rpmem_fip_ops[MAX_RPMEM_PROV][MAX_RPMEM_PM] = {
-	[RPMEM_PROV_LIBFABRIC_VERBS] = {
-		[RPMEM_PM_GPSPM] = {
-			.persist = rpmem_fip_persist_gpspm,
-			.lanes_init = rpmem_fip_init_lanes_common,
-			.lanes_init_mem = rpmem_fip_init_mem_lanes_gpspm,
-			.lanes_fini = rpmem_fip_fini_lanes_common,
-			.lanes_post = rpmem_fip_post_lanes_common,
-		},
-		[RPMEM_PM_APM] = {
-			.persist = rpmem_fip_persist_apm,
-			.lanes_init = rpmem_fip_init_lanes_apm,
-			.lanes_init_mem = rpmem_fip_init_mem_lanes_apm,
-			.lanes_fini = rpmem_fip_fini_lanes_apm,
-			.lanes_post = rpmem_fip_post_lanes_common,
-		},
-	},
-	[RPMEM_PROV_LIBFABRIC_SOCKETS] = {
-		[RPMEM_PM_GPSPM] = {
-			.persist = rpmem_fip_persist_gpspm_sockets,
-			.lanes_init = rpmem_fip_init_lanes_common,
-			.lanes_init_mem = rpmem_fip_init_mem_lanes_gpspm,
-			.lanes_fini = rpmem_fip_fini_lanes_common,
-			.lanes_post = rpmem_fip_post_lanes_common,
-		},
-		[RPMEM_PM_APM] = {
-			.persist = rpmem_fip_persist_apm_sockets,
-			.lanes_init = rpmem_fip_init_lanes_apm,
-			.lanes_init_mem = rpmem_fip_init_mem_lanes_apm,
-			.lanes_fini = rpmem_fip_fini_lanes_apm,
-			.lanes_post = rpmem_fip_post_lanes_common,
-		},
+	for (unsigned i = 0; i < nsegs; i++) {
+		tab[i].addr = fip->raddr + segs[i].offset;
+		tab[i].size = segs[i].length;
 	}
-};
+}
 
 /*
- * rpmem_fip_set_attr -- (internal) set required attributes
+ * rpmem_fip_persistv_raw -- (internal) post vectored persist operation
+ * using READ after WRITE mechanism
+ *
+ * All WRITEs are posted at once and a single READ flushes all of them.
  */
-static void
-rpmem_fip_set_attr(struct rpmem_fip *fip, struct rpmem_fip_attr *attr)
+static int
+rpmem_fip_persistv_raw(struct rpmem_fip *fip, const struct rpmem_range *segs,
+	unsigned nsegs, unsigned lane)
 {
-	fip->raddr = (uint64_t)attr->raddr;
-	fip->rkey = attr->rkey;
-	fip->laddr = attr->laddr;
-	fip->size = attr->size;
-	fip->buff_size = attr->buff_size;
-	fip->persist_method = attr->persist_method;
+	struct rpmem_fip_plane *lanep = &fip->lanes[lane];
+	int ret;
 
-	rpmem_fip_set_nlanes(fip, attr->nlanes);
+	rpmem_fip_lane_begin(&lanep->base, FI_READ);
 
-	/* one for read operation */
-	fip->cq_size = rpmem_fip_cq_size(fip->persist_method,
-			RPMEM_FIP_NODE_CLIENT);
+	/* WRITE for all requested memory regions */
+	for (unsigned i = 0; i < nsegs; i++) {
+		void *laddr = (void *)((uintptr_t)fip->laddr + segs[i].offset);
+		uint64_t raddr = fip->raddr + segs[i].offset;
 
-	fip->ops = &rpmem_fip_ops[attr->provider][fip->persist_method];
+		ret = rpmem_fip_writemsg(lanep->base.ep,
+				&lanep->write, laddr, segs[i].length, raddr);
+		if (unlikely(ret)) {
+			RPMEM_FI_ERR(ret, "RMA write");
+			return ret;
+		}
+	}
+
+	/* READ to read-after-write buffer */
+	ret = rpmem_fip_readmsg(lanep->base.ep, &lanep->read, fip->raw_buff,
+			RPMEM_RAW_SIZE, fip->raddr);
+	if (unlikely(ret)) {
+		RPMEM_FI_ERR(ret, "RMA read");
+		return ret;
+	}
+
+	/* READ completion is collected by rpmem_fip_lane_complete */
+	lanep->pending = FI_READ;
+
+	return 0;
 }
 
 /*
- * rpmem_fip_init -- initialize fabric provider
+ * rpmem_fip_persistv_saw -- (internal) post vectored persist operation
+ * using SEND after WRITE mechanism
+ *
+ * All WRITEs are posted at once and followed by a single persist message
+ * carrying the table of ranges.
  */
-struct rpmem_fip *
-rpmem_fip_init(const char *node, const char *service,
-	struct rpmem_fip_attr *attr, unsigned *nlanes)
+static int
+rpmem_fip_persistv_saw(struct rpmem_fip *fip, const struct rpmem_range *segs,
+	unsigned nsegs, unsigned lane, unsigned flags)
 {
+	RPMEM_ASSERT(nsegs * sizeof(struct rpmem_msg_persist_range) <=
+			fip->buff_size);
+
+	struct rpmem_fip_plane *lanep = &fip->lanes[lane];
+	struct rpmem_msg_persist *msg;
 	int ret;
 
-	struct rpmem_fip *fip = calloc(1, sizeof(*fip));
-	if (!fip) {
-		RPMEM_LOG(ERR, "!allocating fabric handle");
-		return NULL;
+	ret = rpmem_fip_lane_wait(fip, &lanep->base, FI_SEND);
+	if (unlikely(ret)) {
+		ERR("waiting for SEND completion failed");
+		return ret;
 	}
 
-	ret = rpmem_fip_getinfo(fip, node, service,
-		attr->provider, attr->persist_method);
-	if (ret)
-		goto err_getinfo;
+	rpmem_fip_lane_begin(&lanep->base, FI_RECV | FI_SEND);
 
-	fip->cq_read = attr->provider == RPMEM_PROV_LIBFABRIC_VERBS ?
-		fi_cq_read : cq_read_infinite;
+	/* WRITE for all requested memory regions */
+	for (unsigned i = 0; i < nsegs; i++) {
+		void *laddr = (void *)((uintptr_t)fip->laddr + segs[i].offset);
+		uint64_t raddr = fip->raddr + segs[i].offset;
 
-	rpmem_fip_set_attr(fip, attr);
+		ret = rpmem_fip_writemsg(lanep->base.ep,
+				&lanep->write, laddr, segs[i].length, raddr);
+		if (unlikely(ret)) {
+			RPMEM_FI_ERR(ret, "RMA write");
+			return ret;
+		}
+	}
+
+	/* SEND persist message */
+	msg = rpmem_fip_msg_get_pmsg(&lanep->send);
+	rpmem_fip_persistv_fill(fip, msg, segs, nsegs, lane, flags);
+
+	ret = rpmem_fip_sendmsg(lanep->base.ep, &lanep->send, sizeof(*msg) +
+			nsegs * sizeof(struct rpmem_msg_persist_range));
+	if (unlikely(ret)) {
+		RPMEM_FI_ERR(ret, "MSG send");
+		return ret;
+	}
+
+	/* persist response is collected by rpmem_fip_lane_complete */
+	lanep->pending = FI_RECV;
+
+	return 0;
+}
+
+/*
+ * rpmem_fip_persistv_send -- (internal) post vectored persist operation
+ * using RDMA SEND operation with data inlined in the message buffer
+ *
+ * Packs as many ranges as fit in the message buffer and returns the number
+ * of ranges persisted.
+ */
+static ssize_t
+rpmem_fip_persistv_send(struct rpmem_fip *fip, const struct rpmem_range *segs,
+	unsigned nsegs, unsigned lane, unsigned flags)
+{
+	struct rpmem_fip_plane *lanep = &fip->lanes[lane];
+	struct rpmem_msg_persist *msg;
+	int ret;
+
+	/* count how many ranges fit in the message buffer */
+	size_t len = 0;
+	unsigned n;
+	for (n = 0; n < nsegs; n++) {
+		size_t need = (n + 1) * sizeof(struct rpmem_msg_persist_range) +
+			len + segs[n].length;
+		if (need > fip->buff_size)
+			break;
+		len += segs[n].length;
+	}
+
+	RPMEM_ASSERT(n > 0);
+
+	ret = rpmem_fip_lane_wait(fip, &lanep->base, FI_SEND);
+	if (unlikely(ret)) {
+		ERR("waiting for SEND completion failed");
+		return -abs(ret);
+	}
+
+	rpmem_fip_lane_begin(&lanep->base, FI_RECV | FI_SEND);
+
+	/* SEND persist message */
+	msg = rpmem_fip_msg_get_pmsg(&lanep->send);
+	rpmem_fip_persistv_fill(fip, msg, segs, n, lane, flags);
+
+	uint8_t *data = msg->data + n * sizeof(struct rpmem_msg_persist_range);
+	for (unsigned i = 0; i < n; i++) {
+		memcpy(data, (void *)((uintptr_t)fip->laddr + segs[i].offset),
+				segs[i].length);
+		data += segs[i].length;
+	}
+
+	ret = rpmem_fip_sendmsg(lanep->base.ep, &lanep->send,
+			(size_t)((uintptr_t)data - (uintptr_t)msg));
+	if (unlikely(ret)) {
+		RPMEM_FI_ERR(ret, "MSG send");
+		return -abs(ret);
+	}
+
+	/* persist response is collected by rpmem_fip_lane_complete */
+	lanep->pending = FI_RECV;
+
+	return (ssize_t)n;
+}
+
+/*
+ * rpmem_fip_persistv_send_all -- (internal) perform vectored persist
+ * operation using as many inlined SEND messages as required
+ */
+static int
+rpmem_fip_persistv_send_all(struct rpmem_fip *fip,
+	const struct rpmem_range *segs, unsigned nsegs, unsigned lane,
+	unsigned flags)
+{
+	while (nsegs > 0) {
+		ssize_t r = rpmem_fip_persistv_send(fip, segs, nsegs,
+				lane, flags);
+		if (r < 0)
+			return (int)r;
+
+		segs += r;
+		nsegs -= (unsigned)r;
+
+		/* the last message is completed by the caller */
+		if (nsegs > 0) {
+			int ret = rpmem_fip_lane_complete(fip,
+					&fip->lanes[lane]);
+			if (ret)
+				return ret;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * rpmem_fip_persistv_gpspm_sockets -- (internal) perform vectored persist
+ * operation for GPSPM - sockets provider implementation which doesn't use
+ * the inline persist operation
+ */
+static int
+rpmem_fip_persistv_gpspm_sockets(struct rpmem_fip *fip,
+	const struct rpmem_range *segs, unsigned nsegs, unsigned lane,
+	unsigned flags)
+{
+	unsigned mode = flags & RPMEM_PERSIST_MASK;
+	if (mode == RPMEM_PERSIST_SEND)
+		flags = (flags & ~RPMEM_PERSIST_MASK) | RPMEM_PERSIST_WRITE;
+
+	return rpmem_fip_persistv_saw(fip, segs, nsegs, lane, flags);
+}
+
+/*
+ * rpmem_fip_persistv_apm_sockets -- (internal) perform vectored persist
+ * operation for APM - sockets provider implementation which doesn't use
+ * the inline persist operation
+ */
+static int
+rpmem_fip_persistv_apm_sockets(struct rpmem_fip *fip,
+	const struct rpmem_range *segs, unsigned nsegs, unsigned lane,
+	unsigned flags)
+{
+	return rpmem_fip_persistv_raw(fip, segs, nsegs, lane);
+}
+
+/*
+ * rpmem_fip_persistv_gpspm -- (internal) perform vectored persist operation
+ * for GPSPM
+ */
+static int
+rpmem_fip_persistv_gpspm(struct rpmem_fip *fip, const struct rpmem_range *segs,
+	unsigned nsegs, unsigned lane, unsigned flags)
+{
+	unsigned mode = flags & RPMEM_PERSIST_MASK;
+
+	if (mode == RPMEM_PERSIST_SEND)
+		return rpmem_fip_persistv_send_all(fip, segs, nsegs,
+				lane, flags);
+
+	return rpmem_fip_persistv_saw(fip, segs, nsegs, lane, flags);
+}
+
+/*
+ * rpmem_fip_persistv_apm -- (internal) perform vectored persist operation
+ * for APM
+ */
+static int
+rpmem_fip_persistv_apm(struct rpmem_fip *fip, const struct rpmem_range *segs,
+	unsigned nsegs, unsigned lane, unsigned flags)
+{
+	unsigned mode = flags & RPMEM_PERSIST_MASK;
+
+	if (unlikely(mode == RPMEM_DEEP_PERSIST))
+		return rpmem_fip_persistv_saw(fip, segs, nsegs, lane, flags);
+	else if (mode == RPMEM_PERSIST_SEND)
+		return rpmem_fip_persistv_send_all(fip, segs, nsegs,
+				lane, flags);
+
+	return rpmem_fip_persistv_raw(fip, segs, nsegs, lane);
+}
+
+/*
+ * rpmem_fip_post_lanes_common -- (internal) post all persist response message
+ * buffers
+ */
+static int
+rpmem_fip_post_lanes_common(struct rpmem_fip *fip)
+{
+	int ret = 0;
+	for (unsigned i = 0; i < fip->nlanes; i++) {
+		ret = rpmem_fip_post_resp(fip, &fip->lanes[i]);
+		if (ret)
+			break;
+	}
+
+	return ret;
+}
+
+/*
+ * rpmem_fip_ops -- some operations specific for persistency method used
+ */
+static struct rpmem_fip_ops rpmem_fip_ops[MAX_RPMEM_PROV][MAX_RPMEM_PM] = {
+	[RPMEM_PROV_LIBFABRIC_VERBS] = {
+		[RPMEM_PM_GPSPM] = {
+			.persist = rpmem_fip_persist_gpspm,
+			.persistv = rpmem_fip_persistv_gpspm,
+			.lanes_init = rpmem_fip_init_lanes_common,
+			.lanes_init_mem = rpmem_fip_init_mem_lanes_gpspm,
+			.lanes_fini = rpmem_fip_fini_lanes_common,
+			.lanes_post = rpmem_fip_post_lanes_common,
+		},
+		[RPMEM_PM_APM] = {
+			.persist = rpmem_fip_persist_apm,
+			.persistv = rpmem_fip_persistv_apm,
+			.lanes_init = rpmem_fip_init_lanes_apm,
+			.lanes_init_mem = rpmem_fip_init_mem_lanes_apm,
+			.lanes_fini = rpmem_fip_fini_lanes_apm,
+			.lanes_post = rpmem_fip_post_lanes_common,
+		},
+	},
+	[RPMEM_PROV_LIBFABRIC_SOCKETS] = {
+		[RPMEM_PM_GPSPM] = {
+			.persist = rpmem_fip_persist_gpspm_sockets,
+			.persistv = rpmem_fip_persistv_gpspm_sockets,
+			.lanes_init = rpmem_fip_init_lanes_common,
+			.lanes_init_mem = rpmem_fip_init_mem_lanes_gpspm,
+			.lanes_fini = rpmem_fip_fini_lanes_common,
+			.lanes_post = rpmem_fip_post_lanes_common,
+		},
+		[RPMEM_PM_APM] = {
+			.persist = rpmem_fip_persist_apm_sockets,
+			.persistv = rpmem_fip_persistv_apm_sockets,
+			.lanes_init = rpmem_fip_init_lanes_apm,
+			.lanes_init_mem = rpmem_fip_init_mem_lanes_apm,
+			.lanes_fini = rpmem_fip_fini_lanes_apm,
+			.lanes_post = rpmem_fip_post_lanes_common,
+		},
+	}
+};
+
+/*
+ * rpmem_fip_set_attr -- (internal) set required attributes
+ */
+static void
+rpmem_fip_set_attr(struct rpmem_fip *fip, struct rpmem_fip_attr *attr)
+{
+	fip->raddr = (uint64_t)attr->raddr;
+	fip->rkey = attr->rkey;
+	fip->laddr = attr->laddr;
+	fip->size = attr->size;
+	fip->buff_size = attr->buff_size;
+	fip->persist_method = attr->persist_method;
+
+	rpmem_fip_set_nlanes(fip, attr->nlanes);
+
+	/* one for read operation */
+	fip->cq_size = rpmem_fip_cq_size(fip->persist_method,
+			RPMEM_FIP_NODE_CLIENT);
+
+	fip->ops = &rpmem_fip_ops[attr->provider][fip->persist_method];
+}
+
+/*
+ * rpmem_fip_init -- initialize fabric provider
+ */
+struct rpmem_fip *
+rpmem_fip_init(const char *node, const char *service,
+	struct rpmem_fip_attr *attr, unsigned *nlanes)
+{
+	int ret;
+
+	struct rpmem_fip *fip = calloc(1, sizeof(*fip));
+	if (!fip) {
+		RPMEM_LOG(ERR, "!allocating fabric handle");
+		return NULL;
+	}
+
+	ret = rpmem_fip_getinfo(fip, node, service,
+		attr->provider, attr->persist_method);
+	if (ret)
+		goto err_getinfo;
+
+	fip->cq_read = attr->provider == RPMEM_PROV_LIBFABRIC_VERBS ?
+		fi_cq_read : cq_read_infinite;
+
+	rpmem_fip_set_attr(fip, attr);
 
 	*nlanes = fip->nlanes;
 
@@ -1412,11 +1862,15 @@ close_monitor:
 }
 
 /*
- * rpmem_fip_persist -- perform remote persist operation
+ * rpmem_fip_persist_common -- (internal) post remote persist operation and
+ * wait for its completion unless it is asynchronous
+ *
+ * All but the last chunk of an asynchronous persist are completed
+ * synchronously.
  */
-int
-rpmem_fip_persist(struct rpmem_fip *fip, size_t offset, size_t len,
-	unsigned lane, unsigned flags)
+static int
+rpmem_fip_persist_common(struct rpmem_fip *fip, size_t offset, size_t len,
+	unsigned lane, unsigned flags, int async)
 {
 	RPMEM_ASSERT((flags & RPMEM_PERSIST_MASK) <= RPMEM_PERSIST_MAX);
 
@@ -1430,25 +1884,52 @@ rpmem_fip_persist(struct rpmem_fip *fip, size_t offset, size_t len,
 	if (unlikely(offset > fip->size || offset + len > fip->size))
 		return EINVAL; /* it will be passed to errno */
 
+	struct rpmem_fip_plane *lanep = &fip->lanes[lane];
+
+	/* complete asynchronous persist posted previously on the lane */
+	int ret = rpmem_fip_lane_complete(fip, lanep);
+	if (unlikely(ret))
+		goto err;
+
 	if (unlikely(len == 0)) {
 		return 0;
 	}
 
-	int ret = 0;
+	uint64_t start = rpmem_fip_time_ns();
+	size_t total = len;
+
 	while (len > 0) {
 		size_t tmplen = min(len, fip->fi->ep_attr->max_msg_size);
 
 		ssize_t r = fip->ops->persist(fip, offset, tmplen, lane, flags);
 		if (r < 0) {
 			RPMEM_LOG(ERR, "persist operation failed");
+			rpmem_fip_stat_add(&lanep->stats.errors, 1);
 			ret = (int)r;
 			goto err;
 		}
 		tmplen = (size_t)r;
+		rpmem_fip_stat_add(&lanep->stats.messages, 1);
 
 		offset += tmplen;
 		len -= tmplen;
+
+		if (async && len == 0) {
+			lanep->async_len = total;
+			rpmem_fip_stat_set(&lanep->async_start, start);
+			break;
+		}
+
+		ret = rpmem_fip_lane_complete(fip, lanep);
+		if (unlikely(ret)) {
+			RPMEM_LOG(ERR, "persist operation failed");
+			rpmem_fip_stat_add(&lanep->stats.errors, 1);
+			goto err;
+		}
 	}
+
+	if (!async)
+		rpmem_fip_stat_persist(lanep, total, start);
 err:
 	if (unlikely(rpmem_fip_is_closing(fip)))
 		return ECONNRESET; /* it will be passed to errno */
@@ -1457,13 +1938,122 @@ err:
 }
 
 /*
- * rpmem_fip_read -- perform read operation
+ * rpmem_fip_persist -- perform remote persist operation
  */
 int
-rpmem_fip_read(struct rpmem_fip *fip, void *buff, size_t len,
-	size_t off, unsigned lane)
+rpmem_fip_persist(struct rpmem_fip *fip, size_t offset, size_t len,
+	unsigned lane, unsigned flags)
 {
-	int ret;
+	return rpmem_fip_persist_common(fip, offset, len, lane, flags, 0);
+}
+
+/*
+ * rpmem_fip_persist_async -- post remote persist operation without waiting
+ * for its completion
+ *
+ * The returned sequence number identifies the operation in
+ * rpmem_fip_poll() and rpmem_fip_wait(). Only one asynchronous persist may
+ * be in flight on a lane -- any subsequent operation on the lane completes
+ * it first.
+ */
+int
+rpmem_fip_persist_async(struct rpmem_fip *fip, size_t offset, size_t len,
+	unsigned lane, unsigned flags, uint32_t *seq)
+{
+	int ret = rpmem_fip_persist_common(fip, offset, len, lane, flags, 1);
+	if (ret)
+		return ret;
+
+	*seq = ++fip->lanes[lane].async_seq;
+
+	return 0;
+}
+
+/*
+ * rpmem_fip_poll -- check completion of asynchronous persist operation
+ *
+ * Returns 1 if the operation has been completed, 0 if it is still in
+ * progress and a negative error code otherwise.
+ */
+int
+rpmem_fip_poll(struct rpmem_fip *fip, unsigned lane, uint32_t seq)
+{
+	RPMEM_ASSERT(lane < fip->nlanes);
+	if (unlikely(lane >= fip->nlanes))
+		return -EINVAL;
+
+	struct rpmem_fip_plane *lanep = &fip->lanes[lane];
+
+	if (lanep->pending == 0 || lanep->async_seq != seq)
+		return 1;
+
+	int ret = rpmem_fip_lane_poll(fip, &lanep->base, lanep->pending);
+	if (ret <= 0)
+		return ret;
+
+	/* all events arrived -- it only reposts the response buffer */
+	ret = rpmem_fip_lane_complete(fip, lanep);
+	if (unlikely(ret))
+		return -abs(ret);
+
+	return 1;
+}
+
+/*
+ * rpmem_fip_wait -- wait for completion of asynchronous persist operation
+ */
+int
+rpmem_fip_wait(struct rpmem_fip *fip, unsigned lane, uint32_t seq)
+{
+	RPMEM_ASSERT(lane < fip->nlanes);
+	if (unlikely(lane >= fip->nlanes))
+		return EINVAL; /* it will be passed to errno */
+
+	struct rpmem_fip_plane *lanep = &fip->lanes[lane];
+
+	if (lanep->pending == 0 || lanep->async_seq != seq)
+		return 0;
+
+	int ret = rpmem_fip_lane_complete(fip, lanep);
+
+	if (unlikely(rpmem_fip_is_closing(fip)))
+		return ECONNRESET; /* it will be passed to errno */
+
+	return ret;
+}
+
+/*
+ * rpmem_fip_persistv_flush -- (internal) persist collected segments
+ */
+static int
+rpmem_fip_persistv_flush(struct rpmem_fip *fip, const struct rpmem_range *segs,
+	unsigned nsegs, unsigned lane, unsigned flags)
+{
+	if (nsegs == 0)
+		return 0;
+
+	int ret = fip->ops->persistv(fip, segs, nsegs, lane, flags);
+	if (!ret) {
+		rpmem_fip_stat_add(&fip->lanes[lane].stats.messages, 1);
+		ret = rpmem_fip_lane_complete(fip, &fip->lanes[lane]);
+	}
+	if (ret) {
+		RPMEM_LOG(ERR, "vectored persist operation failed");
+		return -abs(ret);
+	}
+
+	return 0;
+}
+
+/*
+ * rpmem_fip_persistv -- perform remote persist operation on a vector of
+ * ranges using a single persist message per batch of ranges
+ */
+int
+rpmem_fip_persistv(struct rpmem_fip *fip, const struct rpmem_range *ranges,
+	unsigned nranges, unsigned lane, unsigned flags)
+{
+	RPMEM_ASSERT((flags & RPMEM_PERSIST_MASK) <= RPMEM_PERSIST_MAX);
 
 	if (unlikely(rpmem_fip_is_closing(fip)))
 		return ECONNRESET; /* it will be passed to errno */
@@ -1472,21 +2062,173 @@ rpmem_fip_read(struct rpmem_fip *fip, void *buff, size_t len,
 	if (unlikely(lane >= fip->nlanes))
 		return EINVAL; /* it will be passed to errno */
 
-	if (unlikely(len == 0)) {
+	for (unsigned i = 0; i < nranges; i++) {
+		if (unlikely(ranges[i].offset > fip->size ||
+			ranges[i].offset + ranges[i].length > fip->size))
+			return EINVAL; /* it will be passed to errno */
+	}
+
+	/* complete asynchronous persist posted previously on the lane */
+	int ret = rpmem_fip_lane_complete(fip, &fip->lanes[lane]);
+	if (unlikely(ret))
+		return ret;
+
+	unsigned mode = flags & RPMEM_PERSIST_MASK;
+	const size_t entry = sizeof(struct rpmem_msg_persist_range);
+
+	/*
+	 * The table of ranges must fit in the message buffer and in
+	 * RPMEM_PERSIST_SEND mode each segment must fit in it along with
+	 * its table entry. Fall back to the single range persist otherwise.
+	 * The number of WRITEs posted at once is limited by the send queue
+	 * of the lane.
+	 */
+	size_t max_segs = min(fip->buff_size / entry,
+			(size_t)RPMEM_FIP_PERSISTV_DEPTH);
+	size_t max_len = fip->fi->ep_attr->max_msg_size;
+	if (mode == RPMEM_PERSIST_SEND && fip->buff_size > entry)
+		max_len = min(max_len, fip->buff_size - entry);
+
+	if (max_segs == 0 ||
+		(mode == RPMEM_PERSIST_SEND && fip->buff_size <= entry)) {
+		for (unsigned i = 0; i < nranges; i++) {
+			ret = rpmem_fip_persist(fip, ranges[i].offset,
+					ranges[i].length, lane, flags);
+			if (ret)
+				return ret;
+		}
+
 		return 0;
 	}
 
-	size_t rd_buff_len = len < fip->fi->ep_attr->max_msg_size ?
-		len : fip->fi->ep_attr->max_msg_size;
+	struct rpmem_range segs[RPMEM_FIP_PERSISTV_DEPTH];
+	unsigned nsegs = 0;
+	uint64_t start = rpmem_fip_time_ns();
+	size_t total = 0;
 
-	void *rd_buff;		/* buffer for read operation */
-	struct fid_mr *rd_mr;	/* read buffer memory region */
-	void *rd_mr_desc;	/* read buffer memory descriptor */
-	struct rpmem_fip_rlane rd_lane;
+	for (unsigned i = 0; i < nranges; i++) {
+		size_t offset = ranges[i].offset;
+		size_t len = ranges[i].length;
+
+		total += len;
+
+		while (len > 0) {
+			size_t tmplen = min(len, max_len);
+
+			segs[nsegs].offset = offset;
+			segs[nsegs].length = tmplen;
+			nsegs++;
+
+			if (nsegs == max_segs) {
+				ret = rpmem_fip_persistv_flush(fip, segs,
+						nsegs, lane, flags);
+				if (ret)
+					goto err;
+				nsegs = 0;
+			}
+
+			offset += tmplen;
+			len -= tmplen;
+		}
+	}
+
+	ret = rpmem_fip_persistv_flush(fip, segs, nsegs, lane, flags);
+err:
+	if (ret)
+		rpmem_fip_stat_add(&fip->lanes[lane].stats.errors, 1);
+	else
+		rpmem_fip_stat_persist(&fip->lanes[lane], total, start);
+
+	if (unlikely(rpmem_fip_is_closing(fip)))
+		return ECONNRESET; /* it will be passed to errno */
+
+	return ret;
+}
+
+/*
+ * rpmem_fip_stats_add -- (internal) add statistics of the lane to stats
+ */
+static void
+rpmem_fip_stats_add(struct rpmem_stats *stats, struct rpmem_fip_plane *lanep,
+	uint64_t now)
+{
+	struct rpmem_stats *ls = &lanep->stats;
+
+	uint64_t persists = rpmem_fip_stat_load(&ls->persists);
+	if (persists) {
+		uint64_t lat_min = rpmem_fip_stat_load(&ls->lat_min);
+		if (stats->persists == 0 || lat_min < stats->lat_min)
+			stats->lat_min = lat_min;
+		uint64_t lat_max = rpmem_fip_stat_load(&ls->lat_max);
+		if (lat_max > stats->lat_max)
+			stats->lat_max = lat_max;
+	}
+
+	stats->persists += persists;
+	stats->persist_bytes += rpmem_fip_stat_load(&ls->persist_bytes);
+	stats->messages += rpmem_fip_stat_load(&ls->messages);
+	stats->reads += rpmem_fip_stat_load(&ls->reads);
+	stats->read_bytes += rpmem_fip_stat_load(&ls->read_bytes);
+	stats->errors += rpmem_fip_stat_load(&ls->errors);
+	stats->lat_sum += rpmem_fip_stat_load(&ls->lat_sum);
+	for (unsigned b = 0; b < RPMEM_STATS_HIST_SIZE; b++)
+		stats->lat_hist[b] += rpmem_fip_stat_load(&ls->lat_hist[b]);
+
+	uint64_t async_start = rpmem_fip_stat_load(&lanep->async_start);
+	if (async_start) {
+		stats->pending++;
+		if (now > async_start && now - async_start > stats->lag)
+			stats->lag = now - async_start;
+	}
+}
+
+/*
+ * rpmem_fip_stats_get -- get statistics of the lane or of all lanes
+ *
+ * The statistics may be read while other threads use the lanes -- each
+ * counter is read atomically, but the counters are not a consistent
+ * snapshot.
+ */
+int
+rpmem_fip_stats_get(struct rpmem_fip *fip, unsigned lane,
+	struct rpmem_stats *stats)
+{
+	if (unlikely(lane != RPMEM_STATS_ALL_LANES && lane >= fip->nlanes))
+		return EINVAL; /* it will be passed to errno */
+
+	memset(stats, 0, sizeof(*stats));
+
+	uint64_t now = rpmem_fip_time_ns();
+
+	if (lane != RPMEM_STATS_ALL_LANES) {
+		rpmem_fip_stats_add(stats, &fip->lanes[lane], now);
+		return 0;
+	}
+
+	for (unsigned i = 0; i < fip->nlanes; i++)
+		rpmem_fip_stats_add(stats, &fip->lanes[i], now);
+
+	return 0;
+}
+
+/*
+ * rpmem_fip_lane_rd_buff -- (internal) allocate and register the read buffer
+ * of the lane
+ *
+ * The buffer is allocated on the first read to memory outside of the pool
+ * and kept until the lanes are deinitialized.
+ */
+static int
+rpmem_fip_lane_rd_buff(struct rpmem_fip *fip, struct rpmem_fip_plane *lanep)
+{
+	if (lanep->rd_buff)
+		return 0;
+
+	int ret;
 
 	/* allocate buffer for read operation */
-	errno = posix_memalign((void **)&rd_buff, Pagesize,
-			rd_buff_len);
+	errno = posix_memalign(&lanep->rd_buff, Pagesize,
+			RPMEM_FIP_READ_BUFF_SIZE);
 	if (errno) {
 		RPMEM_LOG(ERR, "!allocating read buffer");
 		ret = errno;
@@ -1498,69 +2240,255 @@ rpmem_fip_read(struct rpmem_fip *fip, void *buff, size_t len,
 	 * The read operation utilizes READ operation thus
 	 * the FI_REMOTE_WRITE flag.
 	 */
-	ret = fi_mr_reg(fip->domain, rd_buff,
-			rd_buff_len, FI_REMOTE_WRITE,
-			0, 0, 0, &rd_mr, NULL);
+	ret = fi_mr_reg(fip->domain, lanep->rd_buff,
+			RPMEM_FIP_READ_BUFF_SIZE, FI_REMOTE_WRITE,
+			0, 0, 0, &lanep->rd_mr, NULL);
 	if (ret) {
 		RPMEM_FI_ERR(ret, "registrating read buffer");
+		ret = -ret;
 		goto err_rd_mr;
 	}
 
 	/* get read buffer local memory descriptor */
-	rd_mr_desc = fi_mr_desc(rd_mr);
+	lanep->rd_mr_desc = fi_mr_desc(lanep->rd_mr);
 
-	/*
-	 * Initialize READ message. The completion is required in order
-	 * to signal thread that READ operation has been completed.
-	 */
-	rpmem_fip_rma_init(&rd_lane.read, rd_mr_desc, 0,
-			fip->rkey, &rd_lane, FI_COMPLETION);
+	return 0;
+err_rd_mr:
+	free(lanep->rd_buff);
+	lanep->rd_buff = NULL;
+err_malloc_rd_buff:
+	return ret;
+}
 
-	size_t rd = 0;
-	uint8_t *cbuff = buff;
-	struct rpmem_fip_lane *lanep = &fip->lanes[lane].base;
+/*
+ * rpmem_fip_read_reap -- (internal) wait for completion of a single READ
+ * posted on the lane
+ *
+ * Data read to the read buffer of the lane is copied to its destination.
+ */
+static int
+rpmem_fip_read_reap(struct rpmem_fip *fip, struct rpmem_fip_rlane *rlanep)
+{
+	struct rpmem_fip_lane *lanep = &rlanep->lanep->base;
+	ssize_t sret;
+	struct fi_cq_msg_entry cq_entry;
 
-	while (rd < len) {
-		size_t rd_len = len - rd < rd_buff_len ?
-				len - rd : rd_buff_len;
-		size_t rd_off = off + rd;
-		uint64_t raddr = fip->raddr + rd_off;
+	while (1) {
+		if (unlikely(rpmem_fip_is_closing(fip)))
+			return ECONNRESET;
 
-		rpmem_fip_lane_begin(lanep, FI_READ);
+		sret = fip->cq_read(lanep->cq, &cq_entry, 1);
 
-		ret = rpmem_fip_readmsg(lanep->ep, &rd_lane.read,
-				rd_buff, rd_len, raddr);
-		if (ret) {
-			RPMEM_FI_ERR(ret, "RMA read");
-			goto err_readmsg;
+		if (unlikely(sret == -FI_EAGAIN) || sret == 0)
+			continue;
+
+		if (unlikely(sret < 0)) {
+			/* the failed completion belongs to one of the READs */
+			rlanep->inflight--;
+			return rpmem_fip_lane_cq_err(fip, lanep, (int)sret);
 		}
 
-		VALGRIND_DO_MAKE_MEM_DEFINED(rd_buff, rd_len);
+		if (cq_entry.flags & FI_READ) {
+			struct rpmem_fip_rslot *slot = cq_entry.op_context;
+			struct iovec *iov = &slot->read.msg_iov;
 
-		ret = rpmem_fip_lane_wait(fip, lanep, FI_READ);
-		if (ret) {
-			ERR("error when processing read request");
-			goto err_lane_wait;
+			if (slot->dst) {
+				VALGRIND_DO_MAKE_MEM_DEFINED(iov->iov_base,
+						iov->iov_len);
+				memcpy(slot->dst, iov->iov_base, iov->iov_len);
+			}
+
+			slot->busy = 0;
+			rlanep->inflight--;
+			return 0;
+		}
+
+		/* completion of another operation posted on the lane */
+		lanep->event &= ~cq_entry.flags;
+	}
+}
+
+/*
+ * rpmem_fip_read_lanes -- (internal) read data keeping up to
+ * RPMEM_FIP_READ_DEPTH READs in flight on each of the specified lanes
+ *
+ * If the destination buffer is a part of the registered pool memory it is
+ * used directly as the READ target. Otherwise the data is read to the read
+ * buffers of the lanes and copied to the destination as the READs complete.
+ */
+static int
+rpmem_fip_read_lanes(struct rpmem_fip *fip, void *buff, size_t len,
+	size_t off, unsigned lane, unsigned nlanes)
+{
+	int ret;
+	size_t chunk;
+
+	uintptr_t laddr = (uintptr_t)fip->laddr;
+	uintptr_t baddr = (uintptr_t)buff;
+	int direct = len <= fip->size && baddr >= laddr &&
+			baddr - laddr <= fip->size - len;
+
+	if (direct) {
+		chunk = min(fip->fi->ep_attr->max_msg_size,
+				(size_t)RPMEM_FIP_READ_CHUNK);
+	} else {
+		chunk = min(fip->fi->ep_attr->max_msg_size,
+				(size_t)RPMEM_FIP_READ_BUFF_CHUNK);
+
+		for (unsigned i = 0; i < nlanes; i++) {
+			ret = rpmem_fip_lane_rd_buff(fip,
+					&fip->lanes[lane + i]);
+			if (ret)
+				return ret;
 		}
+	}
+
+	struct rpmem_fip_rlane *rlanes = calloc(nlanes, sizeof(*rlanes));
+	if (!rlanes) {
+		RPMEM_LOG(ERR, "!allocating read lanes");
+		return errno;
+	}
 
-		memcpy(&cbuff[rd], rd_buff, rd_len);
+	for (unsigned i = 0; i < nlanes; i++) {
+		struct rpmem_fip_plane *lanep = &fip->lanes[lane + i];
+		void *desc = direct ? fip->mr_desc : lanep->rd_mr_desc;
 
-		rd += rd_len;
+		rlanes[i].lanep = lanep;
+		for (unsigned j = 0; j < RPMEM_FIP_READ_DEPTH; j++) {
+			rpmem_fip_rma_init(&rlanes[i].slots[j].read, desc, 0,
+					fip->rkey, &rlanes[i].slots[j],
+					FI_COMPLETION);
+		}
 	}
 
+	uint8_t *cbuff = buff;
+	size_t rd = 0;		/* number of bytes posted */
+	size_t inflight = 0;	/* number of READs in flight on all lanes */
+
 	ret = 0;
-err_lane_wait:
-err_readmsg:
-	RPMEM_FI_CLOSE(rd_mr, "unregistering memory");
-err_rd_mr:
-	free(rd_buff);
-err_malloc_rd_buff:
+	unsigned i = 0;
+	do {
+		struct rpmem_fip_rlane *rlanep = &rlanes[i];
+
+		/* reap a completed READ to make room for the next one */
+		if (rlanep->inflight == RPMEM_FIP_READ_DEPTH ||
+				(rd == len && rlanep->inflight)) {
+			ret = rpmem_fip_read_reap(fip, rlanep);
+			inflight--;
+			if (unlikely(ret)) {
+				ERR("error when processing read request");
+				goto err_read;
+			}
+		}
+
+		if (rd < len) {
+			size_t rd_len = min(len - rd, chunk);
+
+			unsigned j = 0;
+			while (rlanep->slots[j].busy)
+				j++;
+
+			struct rpmem_fip_rslot *slot = &rlanep->slots[j];
+			void *target;
+			if (direct) {
+				target = &cbuff[rd];
+				slot->dst = NULL;
+			} else {
+				target = (uint8_t *)rlanep->lanep->rd_buff +
+					j * RPMEM_FIP_READ_BUFF_CHUNK;
+				slot->dst = &cbuff[rd];
+			}
+
+			ret = rpmem_fip_readmsg(rlanep->lanep->base.ep,
+					&slot->read, target, rd_len,
+					fip->raddr + off + rd);
+			if (unlikely(ret)) {
+				RPMEM_FI_ERR(ret, "RMA read");
+				goto err_read;
+			}
+
+			slot->busy = 1;
+			rlanep->inflight++;
+			inflight++;
+			rd += rd_len;
+		}
+
+		i = (i + 1) % nlanes;
+	} while (rd < len || inflight);
+
+	if (direct)
+		VALGRIND_DO_MAKE_MEM_DEFINED(buff, len);
+
+	free(rlanes);
+
+	return 0;
+err_read:
+	/* do not release the slots until all posted READs complete */
+	for (unsigned l = 0; l < nlanes; l++) {
+		while (rlanes[l].inflight) {
+			if (rpmem_fip_read_reap(fip, &rlanes[l]) == ECONNRESET)
+				break;
+		}
+	}
+	free(rlanes);
+	return ret;
+}
+
+/*
+ * rpmem_fip_read_bulk -- perform read operation using multiple lanes
+ *
+ * The lanes from lane to lane + nlanes - 1 are used exclusively for the
+ * duration of the operation.
+ */
+int
+rpmem_fip_read_bulk(struct rpmem_fip *fip, void *buff, size_t len,
+	size_t off, unsigned lane, unsigned nlanes)
+{
+	int ret = 0;
+
+	if (unlikely(rpmem_fip_is_closing(fip)))
+		return ECONNRESET; /* it will be passed to errno */
+
+	RPMEM_ASSERT(lane < fip->nlanes);
+	if (unlikely(lane >= fip->nlanes || nlanes == 0 ||
+			nlanes > fip->nlanes - lane))
+		return EINVAL; /* it will be passed to errno */
+
+	if (unlikely(len == 0)) {
+		return 0;
+	}
+
+	/* complete asynchronous persists posted previously on the lanes */
+	for (unsigned i = 0; i < nlanes; i++) {
+		ret = rpmem_fip_lane_complete(fip, &fip->lanes[lane + i]);
+		if (unlikely(ret))
+			goto err;
+	}
+
+	ret = rpmem_fip_read_lanes(fip, buff, len, off, lane, nlanes);
+	if (ret) {
+		rpmem_fip_stat_add(&fip->lanes[lane].stats.errors, 1);
+	} else {
+		rpmem_fip_stat_add(&fip->lanes[lane].stats.reads, 1);
+		rpmem_fip_stat_add(&fip->lanes[lane].stats.read_bytes, len);
+	}
+err:
 	if (unlikely(rpmem_fip_is_closing(fip)))
 		return ECONNRESET; /* it will be passed to errno */
 
 	return ret;
 }
 
+/*
+ * rpmem_fip_read -- perform read operation
+ */
+int
+rpmem_fip_read(struct rpmem_fip *fip, void *buff, size_t len,
+	size_t off, unsigned lane)
+{
+	return rpmem_fip_read_bulk(fip, buff, len, off, lane, 1);
+}
+
 /*
  * parse_bool -- convert string value to boolean
  */
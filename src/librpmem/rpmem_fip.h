@@ -40,6 +40,8 @@
 #include <sys/socket.h>
 
 struct rpmem_fip;
+struct rpmem_range;
+struct rpmem_stats;
 
 struct rpmem_fip_attr {
 	enum rpmem_provider provider;
@@ -63,7 +65,17 @@ int rpmem_fip_process_stop(struct rpmem_fip *fip);
 
 int rpmem_fip_persist(struct rpmem_fip *fip, size_t offset, size_t len,
 		unsigned lane, unsigned flags);
+int rpmem_fip_persistv(struct rpmem_fip *fip, const struct rpmem_range *ranges,
+		unsigned nranges, unsigned lane, unsigned flags);
+int rpmem_fip_persist_async(struct rpmem_fip *fip, size_t offset, size_t len,
+		unsigned lane, unsigned flags, uint32_t *seq);
+int rpmem_fip_poll(struct rpmem_fip *fip, unsigned lane, uint32_t seq);
+int rpmem_fip_wait(struct rpmem_fip *fip, unsigned lane, uint32_t seq);
 
 int rpmem_fip_read(struct rpmem_fip *fip, void *buff,
 		size_t len, size_t off, unsigned lane);
+int rpmem_fip_read_bulk(struct rpmem_fip *fip, void *buff,
+		size_t len, size_t off, unsigned lane, unsigned nlanes);
+int rpmem_fip_stats_get(struct rpmem_fip *fip, unsigned lane,
+		struct rpmem_stats *stats);
 void rpmem_fip_probe_fork_safety(int *fork_unsafe);
@@ -50,6 +50,7 @@
 #include "pmemcommon.h"
 #include "sys_util.h"
 #include "file.h"
+#include "os_thread.h"
 #include "vmem.h"
 
 #include "valgrind_internal.h"
@@ -153,41 +154,173 @@ vmem_fini(void)
 }
 
 /*
- * vmem_createU -- create a memory pool in a temp file
+ * vmem_populate_range -- (internal) pre-fault a part of the pool
+ */
+static void *
+vmem_populate_range(void *arg)
+{
+	struct vmem_populate *pop = arg;
+
+#ifdef MADV_POPULATE_WRITE
+	/* faults in every page of the range, whatever its size */
+	if (os_madvise(pop->addr, pop->size, MADV_POPULATE_WRITE) == 0)
+		return NULL;
+
+	/* not supported before Linux 5.14 */
+	LOG(4, "madvise MADV_POPULATE_WRITE: %s", strerror(errno));
+#endif
+
+	for (size_t off = 0; off < pop->size; off += pop->step) {
+		volatile char *p = pop->addr + off;
+		if (pop->zeroed)
+			*p = 0;
+		else
+			*p = *p;
+	}
+
+	return NULL;
+}
+
+/*
+ * vmem_populate -- (internal) pre-fault the whole pool
+ *
+ * The range is split between up to one thread per online CPU, so that
+ * the page faults of a large pool are not serialized. If the kernel
+ * cannot populate the range, one byte per page of the given size is
+ * touched, which is enough to fault in the whole page.
+ */
+static void
+vmem_populate(void *addr, size_t size, size_t step, int zeroed)
+{
+	LOG(3, "addr %p size %zu step %zu zeroed %d", addr, size, step,
+			zeroed);
+
+	long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	size_t nthreads = size / VMEM_POPULATE_MIN_SIZE;
+	if (ncpus > 0 && nthreads > (size_t)ncpus)
+		nthreads = (size_t)ncpus;
+	if (nthreads == 0)
+		nthreads = 1;
+
+	struct vmem_populate *pops = NULL;
+	os_thread_t *threads = NULL;
+	if (nthreads > 1) {
+		pops = Malloc(nthreads * sizeof(*pops));
+		threads = Malloc(nthreads * sizeof(*threads));
+	}
+
+	if (pops == NULL || threads == NULL) {
+		struct vmem_populate pop = { addr, size, step, zeroed };
+		vmem_populate_range(&pop);
+		goto out;
+	}
+
+	size_t slice = roundup(size / nthreads, step);
+	size_t off = 0;
+	size_t i;
+	for (i = 0; i < nthreads && off < size; ++i) {
+		pops[i].addr = (char *)addr + off;
+		pops[i].size = MIN(slice, size - off);
+		pops[i].step = step;
+		pops[i].zeroed = zeroed;
+		off += pops[i].size;
+
+		/* not fatal - do the job in the calling thread instead */
+		if (os_thread_create(&threads[i], NULL, vmem_populate_range,
+				&pops[i])) {
+			vmem_populate_range(&pops[i]);
+			pops[i].size = 0;
+		}
+	}
+
+	while (i-- > 0) {
+		if (pops[i].size)
+			os_thread_join(&threads[i], NULL);
+	}
+
+out:
+	Free(pops);
+	Free(threads);
+}
+
+/*
+ * vmem_xcreateU -- create a memory pool in a temp file or in huge pages
  */
 #ifndef _WIN32
 static inline
 #endif
 VMEM *
-vmem_createU(const char *dir, size_t size)
+vmem_xcreateU(const char *dir, size_t size, unsigned flags)
 {
 	vmem_construct();
 
-	LOG(3, "dir \"%s\" size %zu", dir, size);
+	LOG(3, "dir \"%s\" size %zu flags 0x%x", dir, size, flags);
+	if (flags & ~VMEM_CREATE_VALID_FLAGS) {
+		ERR("invalid flags 0x%x", flags);
+		errno = EINVAL;
+		return NULL;
+	}
+
+	if ((flags & VMEM_CREATE_HUGE_2M) && (flags & VMEM_CREATE_HUGE_1G)) {
+		ERR("more than one page size requested");
+		errno = EINVAL;
+		return NULL;
+	}
+
 	if (size < VMEM_MIN_POOL) {
 		ERR("size %zu smaller than %zu", size, VMEM_MIN_POOL);
 		errno = EINVAL;
 		return NULL;
 	}
 
-	int is_dev_dax = util_file_is_device_dax(dir);
+	size_t page_size = 0;
+	if (flags & VMEM_CREATE_HUGE_2M)
+		page_size = 2 * MEGABYTE;
+	else if (flags & VMEM_CREATE_HUGE_1G)
+		page_size = GIGABYTE;
+
+	/* the default alignment is a multiple of 2 MiB */
+	size_t align = MAX(4 * MEGABYTE, page_size);
+
+	int is_dev_dax = 0;
+	int map_sync = 0;
+	if (!(flags & VMEM_CREATE_HUGETLB))
+		is_dev_dax = util_file_is_device_dax(dir);
 
 	util_mutex_lock(&Pool_lock);
 
 	/* silently enforce multiple of mapping alignment */
-	size = roundup(size, Mmap_align);
+	size = roundup(size, MAX(Mmap_align, page_size));
 	void *addr;
-	if (is_dev_dax) {
+	if (flags & VMEM_CREATE_HUGETLB) {
+		if ((addr = util_map_hugetlb(size, page_size)) == NULL) {
+			util_mutex_unlock(&Pool_lock);
+			return NULL;
+		}
+	} else if (is_dev_dax) {
 		if ((addr = util_file_map_whole(dir)) == NULL) {
 			util_mutex_unlock(&Pool_lock);
 			return NULL;
 		}
 	} else {
-		if ((addr = util_map_tmpfile(dir, size,
-					4 * MEGABYTE)) == NULL) {
+		if ((addr = util_map_tmpfile(dir, size, align,
+				&map_sync)) == NULL) {
 			util_mutex_unlock(&Pool_lock);
 			return NULL;
 		}
+
+		if (page_size)
+			util_map_advise_huge(addr, size);
+	}
+
+	/*
+	 * Huge pages of a temporary file are only a hint, so unless they
+	 * come from hugetlbfs every base page has to be touched.
+	 */
+	if (flags & VMEM_CREATE_POPULATE) {
+		size_t step = (flags & VMEM_CREATE_HUGETLB) && page_size ?
+				page_size : Pagesize;
+		vmem_populate(addr, size, step, !is_dev_dax);
 	}
 
 	/* store opaque info at beginning of mapped area */
@@ -197,6 +330,22 @@ vmem_createU(const char *dir, size_t size)
 	vmp->addr = addr;
 	vmp->size = size;
 	vmp->caller_mapped = 0;
+	vmp->node = -1;
+	vmp->node_fixed = 0;
+	vmp->purge = NULL;
+
+	/*
+	 * The pages of a DAX mapping are the persistent memory itself and
+	 * the pages of a regular file live in the page cache, in neither case
+	 * does the memory policy of the mapping decide where they are.
+	 */
+	if (is_dev_dax || map_sync) {
+		vmp->node = util_file_numa_node(dir);
+		vmp->node_fixed = 1;
+	} else if (!(flags & VMEM_CREATE_HUGETLB) &&
+			util_file_is_tmpfs(dir) == 0) {
+		vmp->node_fixed = 1;
+	}
 
 	/* Prepare pool for jemalloc */
 	if (je_vmem_pool_create((void *)((uintptr_t)addr + Header_size),
@@ -224,6 +373,45 @@ vmem_createU(const char *dir, size_t size)
 	return vmp;
 }
 
+#ifndef _WIN32
+/*
+ * vmem_xcreate -- create a memory pool in a temp file or in huge pages
+ */
+VMEM *
+vmem_xcreate(const char *dir, size_t size, unsigned flags)
+{
+	return vmem_xcreateU(dir, size, flags);
+}
+#else
+/*
+ * vmem_xcreateW -- create a memory pool in a temp file or in huge pages
+ */
+VMEM *
+vmem_xcreateW(const wchar_t *dir, size_t size, unsigned flags)
+{
+	char *udir = NULL;
+	if (dir != NULL && (udir = util_toUTF8(dir)) == NULL)
+		return NULL;
+
+	VMEM *ret = vmem_xcreateU(udir, size, flags);
+
+	util_free_UTF8(udir);
+	return ret;
+}
+#endif
+
+/*
+ * vmem_createU -- create a memory pool in a temp file
+ */
+#ifndef _WIN32
+static inline
+#endif
+VMEM *
+vmem_createU(const char *dir, size_t size)
+{
+	return vmem_xcreateU(dir, size, 0);
+}
+
 #ifndef _WIN32
 /*
  * vmem_create -- create a memory pool in a temp file
@@ -286,6 +474,9 @@ vmem_create_in_region(void *addr, size_t size)
 	vmp->addr = addr;
 	vmp->size = size;
 	vmp->caller_mapped = 1;
+	vmp->node = -1;
+	vmp->node_fixed = 0;
+	vmp->purge = NULL;
 
 	util_mutex_lock(&Pool_lock);
 
@@ -314,6 +505,153 @@ vmem_create_in_region(void *addr, size_t size)
 	return vmp;
 }
 
+/*
+ * vmem_purge_all -- (internal) purge dirty pages of all arenas of the pool
+ */
+static void
+vmem_purge_all(pool_t *pool)
+{
+	unsigned narenas;
+	size_t len = sizeof(narenas);
+	char name[32];
+
+	if (je_vmem_pool_ctl(pool, "arenas.narenas", &narenas, &len,
+			NULL, 0) != 0)
+		return;
+
+	/* arena index equal to the number of arenas means all of them */
+	snprintf(name, sizeof(name), "arena.%u.purge", narenas);
+	(void) je_vmem_pool_ctl(pool, name, NULL, NULL, NULL, 0);
+}
+
+/*
+ * vmem_purge_thread -- (internal) purge the pool every decay_ms milliseconds
+ */
+static void *
+vmem_purge_thread(void *arg)
+{
+	VMEM *vmp = arg;
+	struct vmem_purge *vpp = vmp->purge;
+	pool_t *pool = (pool_t *)((uintptr_t)vmp + Header_size);
+
+	util_mutex_lock(&vpp->lock);
+	while (vpp->decay_ms != 0) {
+		struct timespec abstime;
+		os_clock_gettime(CLOCK_REALTIME, &abstime);
+		abstime.tv_sec += vpp->decay_ms / 1000;
+		abstime.tv_nsec += (long)(vpp->decay_ms % 1000) * 1000000;
+		if (abstime.tv_nsec >= 1000000000) {
+			abstime.tv_sec++;
+			abstime.tv_nsec -= 1000000000;
+		}
+
+		/* woken up before the timeout - the interval has changed */
+		if (os_cond_timedwait(&vpp->cond, &vpp->lock, &abstime) !=
+				ETIMEDOUT)
+			continue;
+
+		util_mutex_unlock(&vpp->lock);
+		vmem_purge_all(pool);
+		util_mutex_lock(&vpp->lock);
+	}
+	util_mutex_unlock(&vpp->lock);
+
+	return NULL;
+}
+
+/*
+ * vmem_purge_stop -- (internal) stop background purging of the pool
+ *
+ * If purge is set, the pages left dirty since the last purge are purged,
+ * as the threads freeing memory would not do it anymore.
+ * Must be called with Pool_lock held.
+ */
+static void
+vmem_purge_stop(VMEM *vmp, int purge)
+{
+	struct vmem_purge *vpp = vmp->purge;
+	if (vpp == NULL)
+		return;
+
+	util_mutex_lock(&vpp->lock);
+	vpp->decay_ms = 0;
+	os_cond_signal(&vpp->cond);
+	util_mutex_unlock(&vpp->lock);
+
+	os_thread_join(&vpp->thread, NULL);
+
+	pool_t *pool = (pool_t *)((uintptr_t)vmp + Header_size);
+	if (purge)
+		vmem_purge_all(pool);
+
+	bool deferred = false;
+	(void) je_vmem_pool_ctl(pool, "purge_deferred", NULL, NULL, &deferred,
+			sizeof(deferred));
+
+	os_cond_destroy(&vpp->cond);
+	util_mutex_destroy(&vpp->lock);
+	Free(vpp);
+	vmp->purge = NULL;
+}
+
+/*
+ * vmem_purge_start -- (internal) start background purging of the pool
+ *
+ * Must be called with Pool_lock held.
+ */
+static int
+vmem_purge_start(VMEM *vmp, unsigned decay_ms)
+{
+	pool_t *pool = (pool_t *)((uintptr_t)vmp + Header_size);
+
+	struct vmem_purge *vpp = Malloc(sizeof(*vpp));
+	if (vpp == NULL) {
+		ERR("!Malloc");
+		return -1;
+	}
+
+	util_mutex_init(&vpp->lock);
+	int ret = os_cond_init(&vpp->cond);
+	if (ret) {
+		errno = ret;
+		ERR("!os_cond_init");
+		goto err_cond;
+	}
+	vpp->decay_ms = decay_ms;
+
+	/* leave all purging to the background thread */
+	bool deferred = true;
+	ret = je_vmem_pool_ctl(pool, "purge_deferred", NULL, NULL, &deferred,
+			sizeof(deferred));
+	if (ret) {
+		errno = ret;
+		ERR("!cannot defer purging");
+		goto err_ctl;
+	}
+
+	vmp->purge = vpp;
+	ret = os_thread_create(&vpp->thread, NULL, vmem_purge_thread, vmp);
+	if (ret) {
+		errno = ret;
+		ERR("!os_thread_create");
+		goto err_thread;
+	}
+
+	return 0;
+
+err_thread:
+	vmp->purge = NULL;
+	deferred = false;
+	(void) je_vmem_pool_ctl(pool, "purge_deferred", NULL, NULL, &deferred,
+			sizeof(deferred));
+err_ctl:
+	os_cond_destroy(&vpp->cond);
+err_cond:
+	util_mutex_destroy(&vpp->lock);
+	Free(vpp);
+	return -1;
+}
+
 /*
  * vmem_delete -- delete a memory pool
  */
@@ -324,6 +662,8 @@ vmem_delete(VMEM *vmp)
 
 	util_mutex_lock(&Pool_lock);
 
+	vmem_purge_stop(vmp, 0);
+
 	int ret = je_vmem_pool_delete((pool_t *)((uintptr_t)vmp + Header_size));
 	if (ret != 0) {
 		ERR("invalid pool handle: 0x%" PRIxPTR, (uintptr_t)vmp);
@@ -380,6 +720,182 @@ vmem_stats_print(VMEM *vmp, const char *opts)
 			print_jemalloc_stats, NULL, opts);
 }
 
+/*
+ * vmem_bind_node -- bind the memory of the pool to a NUMA node
+ */
+int
+vmem_bind_node(VMEM *vmp, unsigned node)
+{
+	LOG(3, "vmp %p node %u", vmp, node);
+
+	if (vmp->node_fixed) {
+		if (vmp->node == (int)node)
+			return 0;
+
+		if (vmp->node < 0)
+			ERR("memory of the pool is placed by the file system "
+				"and cannot be bound to a NUMA node");
+		else
+			ERR("memory of the pool is on NUMA node %d and "
+				"cannot be moved", vmp->node);
+		errno = ENOTSUP;
+		return -1;
+	}
+
+	if (util_range_bind_node(vmp->addr, vmp->size, node))
+		return -1;
+
+	/* the header page may be inaccessible, check the first pool page */
+	int actual = util_range_get_node((char *)vmp->addr + Header_size);
+	if (actual < 0)
+		return -1;
+
+	if (actual != (int)node) {
+		ERR("memory of the pool not moved to NUMA node %u "
+			"(found on node %d)", node, actual);
+		errno = EIO;
+		return -1;
+	}
+
+	vmp->node = (int)node;
+
+	return 0;
+}
+
+/*
+ * vmem_thread_bind -- bind the calling thread to the arena of its CPU
+ */
+int
+vmem_thread_bind(VMEM *vmp)
+{
+	LOG(3, "vmp %p", vmp);
+
+	unsigned cpu;
+	unsigned node;
+	if (os_getcpu(&cpu, &node)) {
+		ERR("!getcpu");
+		return -1;
+	}
+
+	pool_t *pool = (pool_t *)((uintptr_t)vmp + Header_size);
+	unsigned narenas;
+	size_t len = sizeof(narenas);
+	int ret = je_vmem_pool_ctl(pool, "arenas.narenas", &narenas, &len,
+			NULL, 0);
+	if (ret == 0) {
+		unsigned arena = cpu % narenas;
+		ret = je_vmem_pool_ctl(pool, "thread.arena", NULL, NULL,
+				&arena, sizeof(arena));
+	}
+
+	if (ret != 0) {
+		errno = ret;
+		ERR("!cannot bind thread to arena");
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * vmem_pool_local -- return the pool local to the calling thread
+ */
+VMEM *
+vmem_pool_local(VMEM *const *pools, unsigned npools)
+{
+	LOG(3, "pools %p npools %u", pools, npools);
+
+	if (npools == 0) {
+		ERR("no pools given");
+		errno = EINVAL;
+		return NULL;
+	}
+
+	unsigned cpu;
+	unsigned node;
+	if (os_getcpu(&cpu, &node)) {
+		ERR("!getcpu");
+		return NULL;
+	}
+
+	for (unsigned i = 0; i < npools; ++i) {
+		if (pools[i]->node == (int)node)
+			return pools[i];
+	}
+
+	/* no pool bound to the node, interleave the pools between nodes */
+	return pools[node % npools];
+}
+
+/*
+ * vmem_background_purge -- purge the pool on a background thread
+ */
+int
+vmem_background_purge(VMEM *vmp, unsigned decay_ms)
+{
+	LOG(3, "vmp %p decay_ms %u", vmp, decay_ms);
+
+	int ret = 0;
+
+	util_mutex_lock(&Pool_lock);
+
+	if (decay_ms == 0) {
+		vmem_purge_stop(vmp, 1);
+	} else if (vmp->purge != NULL) {
+		struct vmem_purge *vpp = vmp->purge;
+		util_mutex_lock(&vpp->lock);
+		vpp->decay_ms = decay_ms;
+		os_cond_signal(&vpp->cond);
+		util_mutex_unlock(&vpp->lock);
+	} else {
+		ret = vmem_purge_start(vmp, decay_ms);
+	}
+
+	util_mutex_unlock(&Pool_lock);
+
+	return ret;
+}
+
+/*
+ * vmem_ctl_get -- read a value of the pool's allocator control entry
+ */
+int
+vmem_ctl_get(VMEM *vmp, const char *name, void *oldp, size_t *oldlenp)
+{
+	LOG(3, "vmp %p name \"%s\" oldp %p oldlenp %p", vmp, name, oldp,
+			oldlenp);
+
+	int ret = je_vmem_pool_ctl((pool_t *)((uintptr_t)vmp + Header_size),
+			name, oldp, oldlenp, NULL, 0);
+	if (ret != 0) {
+		errno = ret;
+		ERR("!cannot read \"%s\"", name);
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * vmem_ctl_set -- modify the pool's allocator control entry
+ */
+int
+vmem_ctl_set(VMEM *vmp, const char *name, void *newp, size_t newlen)
+{
+	LOG(3, "vmp %p name \"%s\" newp %p newlen %zu", vmp, name, newp,
+			newlen);
+
+	int ret = je_vmem_pool_ctl((pool_t *)((uintptr_t)vmp + Header_size),
+			name, NULL, NULL, newp, newlen);
+	if (ret != 0) {
+		errno = ret;
+		ERR("!cannot write \"%s\"", name);
+		return -1;
+	}
+
+	return 0;
+}
+
 /*
  * vmem_malloc -- allocate memory
  */
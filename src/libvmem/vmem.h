@@ -37,6 +37,7 @@
 #include <stddef.h>
 
 #include "pool_hdr.h"
+#include "os_thread.h"
 
 #define VMEM_LOG_PREFIX "libvmem"
 #define VMEM_LOG_LEVEL_VAR "VMEM_LOG_LEVEL"
@@ -52,6 +53,29 @@ struct vmem {
 	void *addr;	/* mapped region */
 	size_t size;	/* size of mapped region */
 	int caller_mapped;
+	int node;	/* NUMA node the pool is bound to, or -1 */
+	int node_fixed;	/* memory placed by the file, cannot be bound */
+	struct vmem_purge *purge; /* background purging state, or NULL */
+};
+
+struct vmem_purge {
+	os_mutex_t lock;
+	os_cond_t cond;
+	os_thread_t thread;
+	unsigned decay_ms;	/* purging interval, 0 stops the thread */
+};
+
+#define VMEM_CREATE_VALID_FLAGS (VMEM_CREATE_HUGE_2M | VMEM_CREATE_HUGE_1G |\
+	VMEM_CREATE_HUGETLB | VMEM_CREATE_POPULATE)
+
+/* minimum part of the pool pre-faulted by a single thread */
+#define VMEM_POPULATE_MIN_SIZE (64 * MEGABYTE)
+
+struct vmem_populate {
+	char *addr;	/* beginning of the range */
+	size_t size;	/* size of the range */
+	size_t step;	/* page size */
+	int zeroed;	/* range known to be zeroed */
 };
 
 void vmem_construct(void);
@@ -56,7 +56,7 @@
  * 4) If the process forks, there is no separate log file open for a new
  *    process, even if the configured log file name is terminated with "-".
  *
- * 5) Fork options 2 and 3 are currently not supported on FreeBSD because
+ * 5) Fork options 2, 3 and 4 are currently not supported on FreeBSD because
  *    locks are dynamically allocated on FreeBSD and hence they would be cloned
  *    as part of the pool. This may be solvable.
  */
@@ -74,8 +74,10 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <pthread.h>
+#include <sys/ioctl.h>
 #ifndef __FreeBSD__
 #include <malloc.h>
+#include <linux/fs.h>
 #endif
 
 #include "libvmem.h"
@@ -103,6 +105,39 @@ static int Fd_clone;
 static int Private;
 static int Forkopt = 1; /* default behavior - remap as private */
 static bool Destructed; /* when set - ignore all calls (do not call jemalloc) */
+static size_t Threshold; /* smaller allocations go to the system heap */
+static uintptr_t Pool_start; /* address range of the pool */
+static uintptr_t Pool_end;
+
+/*
+ * pool -- (internal) return the jemalloc pool of the vmem pool
+ */
+static inline pool_t *
+pool(void)
+{
+	return (pool_t *)((uintptr_t)Vmp + Header_size);
+}
+
+/*
+ * in_pool -- (internal) check if the block was allocated from the pool
+ *
+ * Blocks allocated at initialization phase, or below the threshold,
+ * come from the system heap.
+ */
+static inline int
+in_pool(void *ptr)
+{
+	return (uintptr_t)ptr >= Pool_start && (uintptr_t)ptr < Pool_end;
+}
+
+/*
+ * to_pool -- (internal) check if the allocation should go to the pool
+ */
+static inline int
+to_pool(size_t size)
+{
+	return size >= Threshold;
+}
 
 /*
  * malloc -- allocate a block of size bytes
@@ -120,8 +155,10 @@ malloc(size_t size)
 		return je_vmem_malloc(size);
 	}
 	LOG(4, "size %zu", size);
-	return je_vmem_pool_malloc(
-			(pool_t *)((uintptr_t)Vmp + Header_size), size);
+	if (!to_pool(size))
+		return je_vmem_malloc(size);
+
+	return je_vmem_pool_malloc(pool(), size);
 }
 
 /*
@@ -140,8 +177,10 @@ calloc(size_t nmemb, size_t size)
 		return je_vmem_calloc(nmemb, size);
 	}
 	LOG(4, "nmemb %zu, size %zu", nmemb, size);
-	return je_vmem_pool_calloc((pool_t *)((uintptr_t)Vmp + Header_size),
-			nmemb, size);
+	if (size != 0 && nmemb <= SIZE_MAX / size && !to_pool(nmemb * size))
+		return je_vmem_calloc(nmemb, size);
+
+	return je_vmem_pool_calloc(pool(), nmemb, size);
 }
 
 /*
@@ -159,8 +198,26 @@ realloc(void *ptr, size_t size)
 		return je_vmem_realloc(ptr, size);
 	}
 	LOG(4, "ptr %p, size %zu", ptr, size);
-	return je_vmem_pool_ralloc((pool_t *)((uintptr_t)Vmp + Header_size),
-			ptr, size);
+	if (ptr == NULL)
+		return malloc(size);
+
+	int from_pool = in_pool(ptr);
+	if (size == 0 || from_pool == to_pool(size)) {
+		if (from_pool)
+			return je_vmem_pool_ralloc(pool(), ptr, size);
+		return je_vmem_realloc(ptr, size);
+	}
+
+	/* the block moves between the system heap and the pool */
+	void *new_ptr = malloc(size);
+	if (new_ptr == NULL)
+		return NULL;
+
+	size_t old_size = malloc_usable_size(ptr);
+	memcpy(new_ptr, ptr, MIN(old_size, size));
+	free(ptr);
+
+	return new_ptr;
 }
 
 /*
@@ -177,7 +234,10 @@ free(void *ptr)
 		return;
 	}
 	LOG(4, "ptr %p", ptr);
-	je_vmem_pool_free((pool_t *)((uintptr_t)Vmp + Header_size), ptr);
+	if (in_pool(ptr))
+		je_vmem_pool_free(pool(), ptr);
+	else
+		je_vmem_free(ptr);
 }
 
 /*
@@ -198,7 +258,10 @@ cfree(void *ptr)
 		return;
 	}
 	LOG(4, "ptr %p", ptr);
-	je_vmem_pool_free((pool_t *)((uintptr_t)Vmp + Header_size), ptr);
+	if (in_pool(ptr))
+		je_vmem_pool_free(pool(), ptr);
+	else
+		je_vmem_free(ptr);
 }
 
 /*
@@ -221,9 +284,10 @@ memalign(size_t boundary, size_t size)
 		return je_vmem_aligned_alloc(boundary, size);
 	}
 	LOG(4, "boundary %zu  size %zu", boundary, size);
-	return je_vmem_pool_aligned_alloc(
-			(pool_t *)((uintptr_t)Vmp + Header_size),
-			boundary, size);
+	if (!to_pool(size))
+		return je_vmem_aligned_alloc(boundary, size);
+
+	return je_vmem_pool_aligned_alloc(pool(), boundary, size);
 }
 
 /*
@@ -248,9 +312,10 @@ aligned_alloc(size_t alignment, size_t size)
 		return je_vmem_aligned_alloc(alignment, size);
 	}
 	LOG(4, "alignment %zu  size %zu", alignment, size);
-	return je_vmem_pool_aligned_alloc(
-			(pool_t *)((uintptr_t)Vmp + Header_size),
-			alignment, size);
+	if (!to_pool(size))
+		return je_vmem_aligned_alloc(alignment, size);
+
+	return je_vmem_pool_aligned_alloc(pool(), alignment, size);
 }
 
 /*
@@ -271,9 +336,10 @@ posix_memalign(void **memptr, size_t alignment, size_t size)
 		return je_vmem_posix_memalign(memptr, alignment, size);
 	}
 	LOG(4, "alignment %zu  size %zu", alignment, size);
-	*memptr = je_vmem_pool_aligned_alloc(
-			(pool_t *)((uintptr_t)Vmp + Header_size),
-			alignment, size);
+	if (!to_pool(size))
+		return je_vmem_posix_memalign(memptr, alignment, size);
+
+	*memptr = je_vmem_pool_aligned_alloc(pool(), alignment, size);
 	if (*memptr == NULL)
 		ret = errno;
 	errno = oerrno;
@@ -297,9 +363,10 @@ valloc(size_t size)
 		return je_vmem_aligned_alloc(Pagesize, size);
 	}
 	LOG(4, "size %zu", size);
-	return je_vmem_pool_aligned_alloc(
-			(pool_t *)((uintptr_t)Vmp + Header_size),
-			Pagesize, size);
+	if (!to_pool(size))
+		return je_vmem_aligned_alloc(Pagesize, size);
+
+	return je_vmem_pool_aligned_alloc(pool(), Pagesize, size);
 }
 
 /*
@@ -323,9 +390,11 @@ pvalloc(size_t size)
 		return je_vmem_aligned_alloc(Pagesize, roundup(size, Pagesize));
 	}
 	LOG(4, "size %zu", size);
-	return je_vmem_pool_aligned_alloc(
-			(pool_t *)((uintptr_t)Vmp + Header_size),
-			Pagesize, roundup(size, Pagesize));
+	size = roundup(size, Pagesize);
+	if (!to_pool(size))
+		return je_vmem_aligned_alloc(Pagesize, size);
+
+	return je_vmem_pool_aligned_alloc(pool(), Pagesize, size);
 }
 
 /*
@@ -341,8 +410,10 @@ malloc_usable_size(void *ptr)
 		return je_vmem_malloc_usable_size(ptr);
 	}
 	LOG(4, "ptr %p", ptr);
-	return je_vmem_pool_malloc_usable_size(
-			(pool_t *)((uintptr_t)Vmp + Header_size), ptr);
+	if (!in_pool(ptr))
+		return je_vmem_malloc_usable_size(ptr);
+
+	return je_vmem_pool_malloc_usable_size(pool(), ptr);
 }
 
 #if (defined(__GLIBC__) && !defined(__UCLIBC__))
@@ -445,10 +516,43 @@ libvmmalloc_create(const char *dir, size_t size)
 	 */
 	util_range_none(addr, sizeof(struct pool_hdr));
 
+	Pool_start = (uintptr_t)addr;
+	Pool_end = Pool_start + size;
+
 	LOG(3, "vmp %p", vmp);
 	return vmp;
 }
 
+/*
+ * libvmmalloc_reflink -- (internal) clone the pool file sharing its blocks
+ *
+ * The file system copies the shared blocks lazily, when either file is
+ * modified, so the cost of the clone does not depend on the pool size.
+ * DAX file systems never support it, the caller must be ready to fall back.
+ */
+static int
+libvmmalloc_reflink(void)
+{
+	LOG(3, NULL);
+
+#ifdef FICLONE
+	Fd_clone = util_tmpfile(Dir, "/vmem.XXXXXX", O_EXCL);
+	if (Fd_clone == -1)
+		return -1;
+
+	if (ioctl(Fd_clone, FICLONE, Fd)) {
+		LOG(3, "!ioctl FICLONE");
+		(void) os_close(Fd_clone);
+		return -1;
+	}
+
+	return 0;
+#else
+	LOG(3, "reflink not supported");
+	return -1;
+#endif
+}
+
 /*
  * libvmmalloc_clone - (internal) clone the entire pool
  */
@@ -457,6 +561,10 @@ libvmmalloc_clone(void)
 {
 	LOG(3, NULL);
 	int err;
+
+	if (libvmmalloc_reflink() == 0)
+		return 0;
+
 	Fd_clone = util_tmpfile(Dir, "/vmem.XXXXXX", O_EXCL);
 	if (Fd_clone == -1)
 		return -1;
@@ -572,6 +680,16 @@ libvmmalloc_prefork(void)
 		remap_as_private();
 		break;
 
+	case 4:
+		/* reflink the pool file; if it fails - remap it as private */
+		LOG(3, "reflink or remap");
+
+		if (libvmmalloc_reflink() == 0)
+			break;
+
+		remap_as_private();
+		break;
+
 	case 0:
 		LOG(3, "do nothing");
 		break;
@@ -717,7 +835,7 @@ libvmmalloc_init(void)
 
 	if ((env_str = os_getenv(VMMALLOC_FORK_VAR)) != NULL) {
 		Forkopt = atoi(env_str);
-		if (Forkopt < 0 || Forkopt > 3) {
+		if (Forkopt < 0 || Forkopt > 4) {
 			out_log(NULL, 0, NULL, 0, "Error (libvmmalloc): "
 					"incorrect %s value (%d)",
 					VMMALLOC_FORK_VAR, Forkopt);
@@ -734,6 +852,22 @@ libvmmalloc_init(void)
 		LOG(4, "Fork action %d", Forkopt);
 	}
 
+	if ((env_str = os_getenv(VMMALLOC_THRESHOLD_VAR)) != NULL) {
+		char *endptr;
+		errno = 0;
+		unsigned long long v = strtoull(env_str, &endptr, 10);
+		if (endptr == env_str || *endptr != '\0' || errno ||
+				env_str[strspn(env_str, " \t")] == '-') {
+			out_log(NULL, 0, NULL, 0, "Error (libvmmalloc): "
+					"incorrect %s value (%s)",
+					VMMALLOC_THRESHOLD_VAR, env_str);
+			abort();
+		}
+
+		Threshold = (size_t)v;
+		LOG(4, "Threshold %zu", Threshold);
+	}
+
 	/*
 	 * XXX - vmem_create() could be used here, but then we need to
 	 * link vmem.o, including all the vmem API.
@@ -768,8 +902,7 @@ libvmmalloc_fini(void)
 
 		LOG_NONL(0, "\n=========    vmem pool   ========\n");
 		je_vmem_pool_malloc_stats_print(
-			(pool_t *)((uintptr_t)Vmp + Header_size),
-			print_jemalloc_stats, NULL, "gba");
+			pool(), print_jemalloc_stats, NULL, "gba");
 	}
 
 	common_fini();
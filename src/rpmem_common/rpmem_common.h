@@ -110,6 +110,7 @@ struct rpmem_req_attr {
 	size_t buff_size;
 	enum rpmem_provider provider;
 	const char *pool_desc;
+	unsigned proto_minor;	/* protocol version minor number of client */
 };
 
 /*
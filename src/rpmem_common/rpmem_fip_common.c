@@ -242,15 +242,27 @@ struct rpmem_fip_lane_attr {
 static struct rpmem_fip_lane_attr
 rpmem_fip_lane_attrs[MAX_RPMEM_FIP_NODE][MAX_RPMEM_PM] = {
 	[RPMEM_FIP_NODE_CLIENT][RPMEM_PM_GPSPM] = {
-		.n_per_sq = 2, /* WRITE + SEND */
+		/*
+		 * WRITE + SEND for persist, up to RPMEM_FIP_PERSISTV_DEPTH
+		 * WRITEs + SEND for vectored persist, up to
+		 * RPMEM_FIP_READ_DEPTH READs for bulk read
+		 */
+		.n_per_sq = RPMEM_FIP_PERSISTV_DEPTH + 1,
 		.n_per_rq = 1, /* RECV */
-		.n_per_cq = 3,
+		/* up to RPMEM_FIP_READ_DEPTH READs for bulk read */
+		.n_per_cq = RPMEM_FIP_READ_DEPTH + 2,
 	},
 	[RPMEM_FIP_NODE_CLIENT][RPMEM_PM_APM] = {
-		/* WRITE + READ for persist, WRITE + SEND for deep persist */
-		.n_per_sq = 2, /* WRITE + SEND */
+		/*
+		 * WRITE + READ for persist, WRITE + SEND for deep persist,
+		 * up to RPMEM_FIP_PERSISTV_DEPTH WRITEs + READ or SEND for
+		 * vectored persist, up to RPMEM_FIP_READ_DEPTH READs for
+		 * bulk read
+		 */
+		.n_per_sq = RPMEM_FIP_PERSISTV_DEPTH + 1,
 		.n_per_rq = 1, /* RECV */
-		.n_per_cq = 3,
+		/* up to RPMEM_FIP_READ_DEPTH READs for bulk read */
+		.n_per_cq = RPMEM_FIP_READ_DEPTH + 2,
 	},
 	[RPMEM_FIP_NODE_SERVER][RPMEM_PM_GPSPM] = {
 		.n_per_sq = 1, /* SEND */
@@ -44,6 +44,21 @@
 #define RPMEM_FIVERSION FI_VERSION(1, 4)
 #define RPMEM_FIP_CQ_WAIT_MS	100
 
+/* maximum number of READs kept in flight on a single lane by bulk read */
+#define RPMEM_FIP_READ_DEPTH	16
+/* maximum length of a single READ issued by bulk read */
+#define RPMEM_FIP_READ_CHUNK	(1 << 20)
+/* maximum length of a single READ to the read buffer of the lane */
+#define RPMEM_FIP_READ_BUFF_CHUNK	(1 << 16)
+/* size of the read buffer of the lane */
+#define RPMEM_FIP_READ_BUFF_SIZE \
+	(RPMEM_FIP_READ_DEPTH * RPMEM_FIP_READ_BUFF_CHUNK)
+/*
+ * maximum number of WRITEs posted by a single vectored persist message,
+ * keeps the send queue of the lane at RPMEM_FIP_READ_DEPTH entries
+ */
+#define RPMEM_FIP_PERSISTV_DEPTH	(RPMEM_FIP_READ_DEPTH - 1)
+
 #define min(a, b) ((a) < (b) ? (a) : (b))
 
 /*
@@ -43,7 +43,8 @@
 
 #define RPMEM_PROTO		"tcp"
 #define RPMEM_PROTO_MAJOR	0
-#define RPMEM_PROTO_MINOR	1
+#define RPMEM_PROTO_MINOR	2
+#define RPMEM_PROTO_MINOR_VEC	2	/* first minor with vectored persist */
 #define RPMEM_SIG_SIZE		8
 #define RPMEM_UUID_SIZE		16
 #define RPMEM_PROV_SIZE		32
@@ -223,6 +224,15 @@ struct rpmem_msg_close_resp {
  */
 #define RPMEM_PERSIST_MASK	0x3U
 
+/*
+ * vectored persist -- the message carries a table of
+ * struct rpmem_msg_persist_range entries instead of a single range
+ */
+#define RPMEM_PERSIST_VEC	(1U << 2)
+
+/* maximum number of ranges in a single vectored persist message */
+#define RPMEM_PERSIST_VEC_MAX	64U
+
 /*
  * rpmem_msg_persist -- remote persist message
  */
@@ -234,6 +244,19 @@ struct rpmem_msg_persist {
 	uint8_t data[];
 };
 
+/*
+ * rpmem_msg_persist_range -- single range of vectored persist message
+ *
+ * If the RPMEM_PERSIST_VEC flag is set the size field of persist message
+ * holds the number of ranges and the data field holds a table of ranges.
+ * In RPMEM_PERSIST_SEND mode the data of all ranges follows the table in
+ * the same order.
+ */
+struct rpmem_msg_persist_range {
+	uint64_t addr;	/* remote memory address */
+	uint64_t size;	/* remote memory size */
+};
+
 /*
  * rpmem_msg_persist_resp -- remote persist response message
  */
@@ -0,0 +1,235 @@
+/*
+ * Copyright 2018, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * cto_checkpoint -- unit test for pmemcto_checkpoint
+ *
+ * usage: cto_checkpoint filename op:c|i|n|o|v|x
+ *
+ * c - create the pool, fill it with data and checkpoint it, while other
+ *     threads allocate from the pool; modify the data and the heap and exit
+ *     without closing the pool
+ * i - create the pool, fill it with data and checkpoint it a number of times,
+ *     each time after updating a different buffer; modify the data and
+ *     the heap and exit without closing the pool
+ * n - create the pool and exit without a checkpoint
+ * o - open the pool, verify the data, update it, checkpoint, modify the
+ *     data and the heap again and exit without closing the pool
+ * v - open the pool, verify the data and close the pool
+ * x - open the pool, verify the data, update it and exit without
+ *     a checkpoint
+ */
+
+#include "unittest.h"
+
+#define POOL_SIZE (2 * PMEMCTO_MIN_POOL)
+#define NBUFS 32
+#define BUF_SIZE 4096
+#define NTHREADS 4
+#define NOPS 10000
+#define NCHECKPOINTS 10
+
+struct root {
+	unsigned gen;
+	unsigned bgen[NBUFS];	/* generation of data in each buffer */
+	unsigned char *bufs[NBUFS];
+};
+
+static PMEMctopool *Pcp;
+
+/*
+ * thread_func -- allocate and free objects concurrently with checkpoints
+ */
+static void *
+thread_func(void *arg)
+{
+	for (int i = 0; i < NOPS; ++i) {
+		void *ptr = pmemcto_malloc(Pcp, (size_t)i % 1024 + 1);
+		UT_ASSERTne(ptr, NULL);
+		pmemcto_free(Pcp, ptr);
+	}
+
+	return NULL;
+}
+
+/*
+ * fill_buf -- write the given generation of data to the buffer
+ */
+static void
+fill_buf(struct root *r, int i, unsigned gen)
+{
+	memset(r->bufs[i], (int)(gen + (unsigned)i), BUF_SIZE);
+	r->bgen[i] = gen;
+}
+
+/*
+ * fill -- write the given generation of data to the buffers
+ */
+static void
+fill(struct root *r, unsigned gen)
+{
+	for (int i = 0; i < NBUFS; ++i)
+		fill_buf(r, i, gen);
+	r->gen = gen;
+}
+
+/*
+ * verify -- check the buffers contain the generations saved in root
+ */
+static void
+verify(struct root *r)
+{
+	for (int i = 0; i < NBUFS; ++i) {
+		unsigned char c = (unsigned char)(r->bgen[i] + (unsigned)i);
+		for (int j = 0; j < BUF_SIZE; ++j)
+			UT_ASSERTeq(r->bufs[i][j], c);
+	}
+
+	UT_OUT("gen %u", r->gen);
+}
+
+/*
+ * scribble -- modify the data and the heap after the last checkpoint
+ */
+static void
+scribble(struct root *r)
+{
+	for (int i = 0; i < NBUFS; i += 2) {
+		pmemcto_free(Pcp, r->bufs[i]);
+		r->bufs[i] = pmemcto_malloc(Pcp, 2 * BUF_SIZE);
+		UT_ASSERTne(r->bufs[i], NULL);
+	}
+
+	fill(r, r->gen + 100);
+}
+
+/*
+ * do_check -- print the result of the pool consistency check
+ */
+static void
+do_check(const char *path)
+{
+	int ret = pmemcto_check(path, "test");
+	UT_OUT("check %d", ret);
+	if (ret < 0)
+		UT_OUT("%s", pmemcto_errormsg());
+}
+
+int
+main(int argc, char *argv[])
+{
+	START(argc, argv, "cto_checkpoint");
+
+	if (argc != 3 || strchr("cinovx", argv[2][0]) == NULL ||
+			argv[2][1] != '\0')
+		UT_FATAL("usage: %s filename op:c|i|n|o|v|x", argv[0]);
+
+	const char *path = argv[1];
+	char op = argv[2][0];
+
+	if (op == 'c' || op == 'i' || op == 'n') {
+		Pcp = pmemcto_create(path, "test", POOL_SIZE, 0666);
+		UT_ASSERTne(Pcp, NULL);
+
+		if (op == 'n')
+			goto end;
+
+		struct root *r = pmemcto_malloc(Pcp, sizeof(*r));
+		UT_ASSERTne(r, NULL);
+		for (int i = 0; i < NBUFS; ++i) {
+			r->bufs[i] = pmemcto_malloc(Pcp, BUF_SIZE);
+			UT_ASSERTne(r->bufs[i], NULL);
+		}
+		fill(r, 1);
+		pmemcto_set_root_pointer(Pcp, r);
+
+		if (op == 'i') {
+			/*
+			 * Each image is written with the ranges modified
+			 * since the checkpoint before the previous one.
+			 */
+			for (int i = 0; i < NCHECKPOINTS; ++i) {
+				r->gen++;
+				fill_buf(r, i, r->gen);
+				UT_ASSERTeq(pmemcto_checkpoint(Pcp), 0);
+			}
+
+			scribble(r);
+			goto end;
+		}
+
+		os_thread_t threads[NTHREADS];
+		for (int t = 0; t < NTHREADS; ++t)
+			PTHREAD_CREATE(&threads[t], NULL, thread_func, NULL);
+
+		for (int i = 0; i < NCHECKPOINTS; ++i)
+			UT_ASSERTeq(pmemcto_checkpoint(Pcp), 0);
+
+		for (int t = 0; t < NTHREADS; ++t)
+			PTHREAD_JOIN(&threads[t], NULL);
+
+		UT_ASSERTeq(pmemcto_checkpoint(Pcp), 0);
+		scribble(r);
+		goto end;
+	}
+
+	do_check(path);
+
+	Pcp = pmemcto_open(path, "test");
+	if (Pcp == NULL) {
+		UT_OUT("pmemcto_open: %s", pmemcto_errormsg());
+		goto end;
+	}
+
+	struct root *r = pmemcto_get_root_pointer(Pcp);
+	UT_ASSERTne(r, NULL);
+	verify(r);
+
+	if (op == 'o') {
+		fill(r, r->gen + 1);
+		UT_ASSERTeq(pmemcto_checkpoint(Pcp), 0);
+		scribble(r);
+		goto end;
+	}
+
+	if (op == 'x') {
+		fill(r, r->gen + 1);
+		goto end;
+	}
+
+	pmemcto_close(Pcp);
+
+	do_check(path);
+
+end:
+	DONE(NULL);
+}
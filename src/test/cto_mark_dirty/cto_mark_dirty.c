@@ -0,0 +1,134 @@
+/*
+ * Copyright 2018, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * cto_mark_dirty -- unit test for pmemcto_mark_dirty
+ *
+ * usage: cto_mark_dirty filename
+ */
+
+#include "unittest.h"
+
+#define POOL_SIZE (2 * PMEMCTO_MIN_POOL)
+#define ALLOC_SIZE (64 * 1024)
+#define NALLOCS 16
+#define NMARKS 4096	/* more than the library tracks explicitly */
+#define MARK_SIZE 8
+
+struct root {
+	unsigned char *ptrs[NALLOCS];
+};
+
+/*
+ * do_create -- fill the pool with data, marking it as dirty
+ */
+static void
+do_create(const char *path)
+{
+	PMEMctopool *pcp = pmemcto_create(path, "test", POOL_SIZE, 0666);
+	UT_ASSERTne(pcp, NULL);
+
+	struct root *root = pmemcto_calloc(pcp, 1, sizeof(*root));
+	UT_ASSERTne(root, NULL);
+	pmemcto_set_root_pointer(pcp, root);
+
+	for (int i = 0; i < NALLOCS; ++i) {
+		root->ptrs[i] = pmemcto_malloc(pcp, ALLOC_SIZE);
+		UT_ASSERTne(root->ptrs[i], NULL);
+
+		memset(root->ptrs[i], i, ALLOC_SIZE);
+		pmemcto_mark_dirty(pcp, root->ptrs[i], ALLOC_SIZE);
+	}
+
+	/* adjacent ranges, merged */
+	for (size_t off = 0; off < ALLOC_SIZE; off += MARK_SIZE)
+		pmemcto_mark_dirty(pcp, root->ptrs[0] + off, MARK_SIZE);
+
+	/* distinct ranges, overflowing the tracked ones */
+	for (int m = 0; m < NMARKS; ++m) {
+		unsigned char *ptr = root->ptrs[m % NALLOCS] +
+			(size_t)(m / NALLOCS) * 2 * MARK_SIZE;
+		pmemcto_mark_dirty(pcp, ptr, MARK_SIZE);
+	}
+
+	/* empty range */
+	pmemcto_mark_dirty(pcp, root->ptrs[1], 0);
+
+	/* range out of pool heap */
+	pmemcto_mark_dirty(pcp, pcp, MARK_SIZE);
+	UT_OUT("%s", pmemcto_errormsg());
+
+	pmemcto_mark_dirty(pcp, root->ptrs[0], POOL_SIZE);
+	UT_OUT("%s", pmemcto_errormsg());
+
+	pmemcto_close(pcp);
+}
+
+/*
+ * do_verify -- verify the content of the pool
+ */
+static void
+do_verify(const char *path)
+{
+	UT_ASSERTeq(pmemcto_check(path, "test"), 1);
+
+	PMEMctopool *pcp = pmemcto_open(path, "test");
+	UT_ASSERTne(pcp, NULL);
+
+	struct root *root = pmemcto_get_root_pointer(pcp);
+	UT_ASSERTne(root, NULL);
+
+	for (int i = 0; i < NALLOCS; ++i) {
+		for (size_t off = 0; off < ALLOC_SIZE; ++off)
+			UT_ASSERTeq(root->ptrs[i][off], i);
+		pmemcto_free(pcp, root->ptrs[i]);
+	}
+
+	pmemcto_free(pcp, root);
+	pmemcto_set_root_pointer(pcp, NULL);
+
+	pmemcto_close(pcp);
+}
+
+int
+main(int argc, char *argv[])
+{
+	START(argc, argv, "cto_mark_dirty");
+
+	if (argc != 2)
+		UT_FATAL("usage: %s filename", argv[0]);
+
+	do_create(argv[1]);
+	do_verify(argv[1]);
+
+	DONE(NULL);
+}
@@ -41,19 +41,71 @@
 #include <stdio.h>
 #include "unittest.h"
 
+/*
+ * progress -- state of the progress callback
+ */
+static struct {
+	unsigned ncalls;
+	size_t copied;
+	size_t total;
+	size_t cancel_after;	/* cancel the sync after copying that much */
+} progress;
+
+/*
+ * progress_cb -- check if the progress reported during sync is sane
+ */
+static int
+progress_cb(size_t copied, size_t total, void *arg)
+{
+	UT_ASSERTeq(arg, &progress);
+	UT_ASSERT(copied <= total);
+	UT_ASSERT(copied > progress.copied || copied <= progress.total);
+
+	progress.ncalls++;
+	progress.copied = copied;
+	progress.total = total;
+
+	return progress.cancel_after && copied >= progress.cancel_after;
+}
+
 int
 main(int argc, char *argv[])
 {
 	START(argc, argv, "libpmempool_sync");
-	if (argc != 3)
-		UT_FATAL("usage: %s poolset_file flags", argv[0]);
+	if (argc != 3 && argc != 6 && argc != 7)
+		UT_FATAL("usage: %s poolset_file flags "
+			"[nthreads chunk_size cancel_after [src_replica]]",
+			argv[0]);
+
+	unsigned flags = (unsigned)strtoul(argv[2], NULL, 0);
+
+	int ret;
+	if (argc == 3) {
+		ret = pmempool_sync(argv[1], flags);
+	} else {
+		struct pmempool_copy_opts opts = {
+			.nthreads = (unsigned)strtoul(argv[3], NULL, 0),
+			.chunk_size = strtoul(argv[4], NULL, 0),
+			.max_bandwidth = 0,
+			.progress = progress_cb,
+			.arg = &progress,
+			.src_replica = argc == 7 ?
+				(unsigned)strtoul(argv[6], NULL, 0) : 0,
+		};
+		progress.cancel_after = strtoul(argv[5], NULL, 0);
+
+		ret = pmempool_xsync(argv[1], flags, &opts);
+	}
 
-	int ret = pmempool_sync(argv[1], (unsigned)strtoul(argv[2], NULL, 0));
-	if (ret)
+	if (ret) {
 		UT_OUT("result: %d, errno: %d", ret, errno);
-	else
+		UT_OUT("%s", pmempool_errormsg());
+	} else
 		UT_OUT("result: %d", ret);
 
+	if (argc >= 6 && progress.ncalls > 0)
+		UT_OUT("progress: %s", progress.copied == progress.total ?
+			"complete" : "incomplete");
 
 	DONE(NULL);
 }
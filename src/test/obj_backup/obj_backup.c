@@ -0,0 +1,254 @@
+/*
+ * Copyright 2018, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * obj_backup.c -- unit test for pmemobj_backup
+ *
+ * usage: obj_backup file b|v|e backup
+ *
+ * b - creates the pool and backs it up while other threads modify it
+ *     in transactions
+ * v - opens the backup and verifies its consistency
+ * e - checks error handling
+ */
+
+#include "unittest.h"
+
+#define LAYOUT "obj_backup"
+
+#define NTHREADS 4
+#define NCOUNTERS 64
+#define COUNTER_SIZE (64 * 1024)
+#define NBACKUPS 2
+
+struct root {
+	PMEMmutex lock;		/* protects the sum and the counters */
+	uint64_t sum;		/* sum of the values of all the counters */
+	PMEMoid counters[NCOUNTERS];
+};
+
+struct counter {
+	uint64_t value;
+};
+
+static PMEMobjpool *Pop;
+static int Stop;
+
+/*
+ * increment -- increment the counter and the sum within a transaction
+ */
+static void
+increment(struct root *root, struct counter *c, unsigned *seed)
+{
+	pmemobj_tx_add_range_direct(c, sizeof(*c));
+	pmemobj_tx_add_range_direct(&root->sum, sizeof(root->sum));
+
+	/* churn the heap as well */
+	PMEMoid tmp = pmemobj_tx_alloc(1 + os_rand_r(seed) % 4096, 1);
+	pmemobj_tx_free(tmp);
+
+	c->value++;
+	root->sum++;
+}
+
+/*
+ * worker -- increment random counters and the sum in transactions
+ *
+ * Odd workers lock the mutex before starting a transaction, even ones let the
+ * transaction lock it, so that a thread holding a lane waits for a thread
+ * which does not hold one yet.
+ */
+static void *
+worker(void *arg)
+{
+	unsigned seed = (unsigned)(uintptr_t)arg;
+	int lock_first = seed % 2;
+	struct root *root = pmemobj_direct(pmemobj_root(Pop,
+			sizeof(struct root)));
+
+	while (!util_fetch_and_add32(&Stop, 0)) {
+		unsigned i = (unsigned)os_rand_r(&seed) % NCOUNTERS;
+		struct counter *c = pmemobj_direct(root->counters[i]);
+
+		if (lock_first) {
+			pmemobj_mutex_lock(Pop, &root->lock);
+			TX_BEGIN(Pop) {
+				increment(root, c, &seed);
+			} TX_END
+			pmemobj_mutex_unlock(Pop, &root->lock);
+		} else {
+			TX_BEGIN_PARAM(Pop, TX_PARAM_MUTEX, &root->lock,
+					TX_PARAM_NONE) {
+				increment(root, c, &seed);
+			} TX_END
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * do_backup -- create the pool and back it up while it is modified
+ */
+static void
+do_backup(const char *path, const char *backup)
+{
+	Pop = pmemobj_create(path, LAYOUT, 0, S_IWUSR | S_IRUSR);
+	if (Pop == NULL)
+		UT_FATAL("!pmemobj_create: %s", path);
+
+	PMEMoid root_oid = pmemobj_root(Pop, sizeof(struct root));
+	struct root *root = pmemobj_direct(root_oid);
+
+	for (int i = 0; i < NCOUNTERS; ++i) {
+		if (pmemobj_zalloc(Pop, &root->counters[i], COUNTER_SIZE, 0))
+			UT_FATAL("!pmemobj_zalloc");
+	}
+
+	os_thread_t threads[NTHREADS];
+	for (unsigned t = 0; t < NTHREADS; ++t)
+		PTHREAD_CREATE(&threads[t], NULL, worker,
+			(void *)(uintptr_t)(t + 1));
+
+	for (int b = 0; b < NBACKUPS; ++b) {
+		if (pmemobj_backup(Pop, backup, 0))
+			UT_FATAL("!pmemobj_backup: %s", backup);
+	}
+
+	util_fetch_and_add32(&Stop, 1);
+	for (unsigned t = 0; t < NTHREADS; ++t)
+		PTHREAD_JOIN(&threads[t], NULL);
+
+	UT_OUT("backup done");
+
+	pmemobj_close(Pop);
+}
+
+/*
+ * do_verify -- open the backup and check if the sum matches the counters
+ */
+static void
+do_verify(const char *backup)
+{
+	int ret = pmemobj_check(backup, LAYOUT);
+	UT_ASSERTeq(ret, 1);
+
+	PMEMobjpool *pop = pmemobj_open(backup, LAYOUT);
+	if (pop == NULL)
+		UT_FATAL("!pmemobj_open: %s", backup);
+
+	struct root *root = pmemobj_direct(pmemobj_root(pop,
+			sizeof(struct root)));
+
+	uint64_t sum = 0;
+	for (int i = 0; i < NCOUNTERS; ++i) {
+		UT_ASSERT(!OID_IS_NULL(root->counters[i]));
+		struct counter *c = pmemobj_direct(root->counters[i]);
+		sum += c->value;
+	}
+
+	UT_ASSERTeq(sum, root->sum);
+	UT_OUT("backup consistent");
+
+	pmemobj_close(pop);
+}
+
+/*
+ * do_errors -- check invalid uses of pmemobj_backup
+ */
+static void
+do_errors(const char *path, const char *backup)
+{
+	PMEMobjpool *pop = pmemobj_create(path, LAYOUT, 0, S_IWUSR | S_IRUSR);
+	if (pop == NULL)
+		UT_FATAL("!pmemobj_create: %s", path);
+
+	int ret = pmemobj_backup(pop, backup, 1);
+	UT_ASSERTeq(ret, -1);
+	UT_OUT("invalid flags: %s", strerror(errno));
+
+	TX_BEGIN(pop) {
+		ret = pmemobj_backup(pop, backup, 0);
+		UT_ASSERTeq(ret, -1);
+		UT_OUT("within transaction: %s", strerror(errno));
+	} TX_END
+
+	/* the pool itself is locked */
+	ret = pmemobj_backup(pop, path, 0);
+	UT_ASSERTeq(ret, -1);
+	UT_OUT("backup to the source: %s", strerror(errno));
+
+	/* existing file of a different size */
+	int fd = OPEN(backup, O_RDWR | O_CREAT, S_IWUSR | S_IRUSR);
+	FTRUNCATE(fd, PMEMOBJ_MIN_POOL);
+	CLOSE(fd);
+	ret = pmemobj_backup(pop, backup, 0);
+	UT_ASSERTeq(ret, -1);
+	UT_OUT("size mismatch: %s", strerror(errno));
+
+	/* an aborted transaction must not keep its lane */
+	TX_BEGIN(pop) {
+		pmemobj_tx_abort(EINVAL);
+	} TX_END
+
+	UNLINK(backup);
+	ret = pmemobj_backup(pop, backup, 0);
+	UT_ASSERTeq(ret, 0);
+	UT_OUT("after abort: %d", ret);
+
+	pmemobj_close(pop);
+}
+
+int
+main(int argc, char *argv[])
+{
+	START(argc, argv, "obj_backup");
+
+	if (argc != 4 || strlen(argv[2]) != 1)
+		UT_FATAL("usage: %s file b|v|e backup", argv[0]);
+
+	switch (argv[2][0]) {
+	case 'b':
+		do_backup(argv[1], argv[3]);
+		break;
+	case 'v':
+		do_verify(argv[3]);
+		break;
+	case 'e':
+		do_errors(argv[1], argv[3]);
+		break;
+	default:
+		UT_FATAL("unknown operation %s", argv[2]);
+	}
+
+	DONE(NULL);
+}
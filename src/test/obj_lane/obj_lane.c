@@ -67,6 +67,15 @@ struct mock_pop {
 	struct lane_layout l[MAX_MOCK_LANES];
 };
 
+/*
+ * obj_remote_batch_send -- mock pools have no remote replicas
+ */
+void
+obj_remote_batch_send(PMEMobjpool *pop, unsigned lane)
+{
+	UT_ASSERT(0);
+}
+
 static int construct_fail;
 
 static void *
@@ -38,6 +38,8 @@
 #include <stddef.h>
 
 #include "unittest.h"
+#include "obj.h"
+#include "heap_layout.h"
 
 #define LAYOUT_NAME "obj_zones"
 
@@ -92,13 +94,71 @@ test_open(const char *path)
 	pmemobj_close(pop);
 }
 
+/*
+ * test_break -- corrupt the given zones, each one is given as 'm<zone id>'
+ * to break the zone magic or 't<zone id>' to break the type of the first
+ * chunk of the zone
+ */
+static void
+test_break(const char *path, int nzones, char *zones[])
+{
+	PMEMobjpool *pop;
+	if ((pop = pmemobj_open(path, LAYOUT_NAME)) == NULL)
+		UT_FATAL("!pmemobj_open: %s", path);
+
+	struct heap_layout *layout =
+		(struct heap_layout *)((char *)pop + pop->heap_offset);
+
+	for (int i = 0; i < nzones; ++i) {
+		unsigned zid = (unsigned)strtoul(&zones[i][1], NULL, 10);
+		UT_ASSERT((size_t)zid * ZONE_MAX_SIZE < pop->heap_size);
+
+		struct zone *z = ZID_TO_ZONE(layout, zid);
+		UT_ASSERTeq(z->header.magic, ZONE_HEADER_MAGIC);
+
+		switch (zones[i][0]) {
+		case 'm':
+			z->header.magic = 0xbad;
+			pmemobj_persist(pop, &z->header.magic,
+				sizeof(z->header.magic));
+			break;
+		case 't':
+			z->chunk_headers[0].type = 0;
+			pmemobj_persist(pop, &z->chunk_headers[0].type,
+				sizeof(z->chunk_headers[0].type));
+			break;
+		default:
+			UT_FATAL("invalid zone: %s", zones[i]);
+		}
+	}
+
+	pmemobj_close(pop);
+}
+
+/*
+ * test_check -- check consistency of the pool
+ */
+static void
+test_check(const char *path)
+{
+	int ret = pmemobj_check(path, LAYOUT_NAME);
+	if (ret == 1)
+		UT_OUT("consistent");
+	else if (ret == 0)
+		UT_OUT("not consistent: %s", pmemobj_errormsg());
+	else
+		UT_OUT("error: %s", pmemobj_errormsg());
+}
+
 int
 main(int argc, char *argv[])
 {
 	START(argc, argv, "obj_zones");
 
-	if (argc != 3)
-		UT_FATAL("usage: %s file-name [open|create]", argv[0]);
+	if (argc < 3)
+		UT_FATAL("usage: %s file-name "
+			"[open|create|check|break <m|t><zone id>...]",
+			argv[0]);
 
 	const char *path = argv[1];
 	char op = argv[2][0];
@@ -106,6 +166,10 @@ main(int argc, char *argv[])
 		test_create(path);
 	else if (op == 'o')
 		test_open(path);
+	else if (op == 'k')
+		test_check(path);
+	else if (op == 'b')
+		test_break(path, argc - 3, &argv[3]);
 	else
 		UT_FATAL("invalid operation");
 
@@ -583,6 +583,59 @@ test_read(const struct test_case *tc, int argc, char *argv[])
 	return 2;
 }
 
+/*
+ * test_stats -- test case for statistics of the pool after the data of the
+ * pool has been persisted by npersists operations and read nreads times
+ */
+static int
+test_stats(const struct test_case *tc, int argc, char *argv[])
+{
+	if (argc < 3)
+		UT_FATAL("usage: test_stats <id> <npersists> <nreads>");
+
+	int id = atoi(argv[0]);
+	UT_ASSERT(id >= 0 && id < MAX_IDS);
+	struct pool_entry *pool = &pools[id];
+	uint64_t npersists = (uint64_t)atoi(argv[1]);
+	uint64_t nreads = (uint64_t)atoi(argv[2]);
+	size_t buff_size = pool->size - POOL_HDR_SIZE;
+
+	struct rpmem_stats stats;
+	int ret = rpmem_stats_get(pool->rpp, RPMEM_STATS_ALL_LANES, &stats);
+	UT_ASSERTeq(ret, 0);
+
+	UT_ASSERTeq(stats.persists, npersists);
+	UT_ASSERTeq(stats.persist_bytes, npersists ? buff_size : 0);
+	UT_ASSERT(stats.messages >= stats.persists);
+	UT_ASSERTeq(stats.reads, nreads);
+	UT_ASSERTeq(stats.read_bytes, nreads * buff_size);
+	UT_ASSERTeq(stats.errors, 0);
+	UT_ASSERTeq(stats.pending, 0);
+	UT_ASSERT(stats.lat_min <= stats.lat_max);
+
+	uint64_t nhist = 0;
+	for (unsigned b = 0; b < RPMEM_STATS_HIST_SIZE; b++)
+		nhist += stats.lat_hist[b];
+	UT_ASSERTeq(nhist, stats.persists);
+
+	/* the statistics of lane 0 are a part of the total */
+	struct rpmem_stats lane_stats;
+	ret = rpmem_stats_get(pool->rpp, 0, &lane_stats);
+	UT_ASSERTeq(ret, 0);
+	UT_ASSERT(lane_stats.persists <= stats.persists);
+	UT_ASSERT(lane_stats.reads <= stats.reads);
+
+	ret = rpmem_stats_get(pool->rpp, pool->nlanes, &stats);
+	UT_ASSERTeq(ret, -1);
+	UT_ASSERTeq(errno, EINVAL);
+
+	ret = rpmem_stats_get(pool->rpp, 0, NULL);
+	UT_ASSERTeq(ret, -1);
+	UT_ASSERTeq(errno, EINVAL);
+
+	return 3;
+}
+
 /*
  * test_remove -- test case for remove operation
  */
@@ -895,6 +948,7 @@ static struct test_case test_cases[] = {
 	TEST_CASE(test_persist),
 	TEST_CASE(test_deep_persist),
 	TEST_CASE(test_read),
+	TEST_CASE(test_stats),
 	TEST_CASE(test_remove),
 	TEST_CASE(check_pool),
 	TEST_CASE(fill_pool),
@@ -65,6 +65,10 @@
 uint8_t lpool[POOL_SIZE];
 uint8_t rpool[POOL_SIZE];
 
+#define NCHUNKS		(NLANES * COUNT_PER_LANE)
+
+struct rpmem_range ranges[NCHUNKS];
+
 TEST_CASE_DECLARE(client_init);
 TEST_CASE_DECLARE(server_init);
 TEST_CASE_DECLARE(client_connect);
@@ -72,7 +76,10 @@ TEST_CASE_DECLARE(server_connect);
 TEST_CASE_DECLARE(server_process);
 TEST_CASE_DECLARE(client_persist);
 TEST_CASE_DECLARE(client_persist_mt);
+TEST_CASE_DECLARE(client_persistv);
+TEST_CASE_DECLARE(client_persist_async);
 TEST_CASE_DECLARE(client_read);
+TEST_CASE_DECLARE(client_read_bulk);
 
 /*
  * get_persist_method -- parse persist method
@@ -185,6 +192,41 @@ client_persist_thread(void *arg)
 	return NULL;
 }
 
+/*
+ * check_stats -- verify statistics after client_persist_thread and a single
+ * read of the whole pool on lane 0
+ */
+static void
+check_stats(struct rpmem_fip *fip, unsigned lane)
+{
+	struct rpmem_stats stats;
+	int ret = rpmem_fip_stats_get(fip, lane, &stats);
+	UT_ASSERTeq(ret, 0);
+
+	UT_ASSERTeq(stats.persists, COUNT_PER_LANE);
+	UT_ASSERTeq(stats.persist_bytes, COUNT_PER_LANE * SIZE_PER_LANE);
+	UT_ASSERTeq(stats.messages, COUNT_PER_LANE);
+	UT_ASSERTeq(stats.reads, 1);
+	UT_ASSERTeq(stats.read_bytes, POOL_SIZE);
+	UT_ASSERTeq(stats.errors, 0);
+	UT_ASSERTeq(stats.pending, 0);
+	UT_ASSERT(stats.lat_min <= stats.lat_max);
+	UT_ASSERT(stats.lat_sum >= stats.lat_max);
+
+	uint64_t nhist = 0;
+	for (unsigned b = 0; b < RPMEM_STATS_HIST_SIZE; b++) {
+		if (stats.lat_hist[b] == 0)
+			continue;
+
+		UT_ASSERT(RPMEM_STATS_HIST_LOWER(b) <= stats.lat_max);
+		nhist += stats.lat_hist[b];
+	}
+	UT_ASSERTeq(nhist, stats.persists);
+
+	ret = rpmem_fip_stats_get(fip, UINT_MAX - 1, &stats);
+	UT_ASSERTeq(ret, EINVAL);
+}
+
 /*
  * client_init -- test case for client initialization
  */
@@ -271,6 +313,7 @@ server_init(const struct test_case *tc, int argc, char *argv[])
 		.provider = provider,
 		.persist_method = persist_method,
 		.nthreads = NTHREADS,
+		.proto_minor = RPMEM_PROTO_MINOR,
 	};
 
 	ret = rpmemd_apply_pm_policy(&attr.persist_method, &attr.persist,
@@ -384,6 +427,7 @@ server_connect(const struct test_case *tc, int argc, char *argv[])
 		.provider = provider,
 		.persist_method = persist_method,
 		.nthreads = NTHREADS,
+		.proto_minor = RPMEM_PROTO_MINOR,
 	};
 
 	int ret;
@@ -446,6 +490,8 @@ server_process(const struct test_case *tc, int argc, char *argv[])
 		.provider = provider,
 		.persist_method = persist_method,
 		.nthreads = NTHREADS,
+		.proto_minor = RPMEM_PROTO_MINOR,
+		.buff_size = RPMEM_DEF_BUFF_SIZE,
 	};
 
 	int ret;
@@ -458,6 +504,10 @@ server_process(const struct test_case *tc, int argc, char *argv[])
 			1 /* is pmem */);
 	UT_ASSERTeq(ret, 0);
 
+	rpmemd_apply_batch_policy(attr.persist_method, &attr.flush,
+			&attr.memcpy_nodrain, &attr.drain,
+			1 /* is pmem */);
+
 	fip = rpmemd_fip_init(addr, NULL, &attr, &resp, &err);
 	UT_ASSERTne(fip, NULL);
 
@@ -553,6 +603,228 @@ client_persist(const struct test_case *tc, int argc, char *argv[])
 	ret = rpmem_fip_read(fip, rpool, POOL_SIZE, 0, 0);
 	UT_ASSERTeq(ret, 0);
 
+	check_stats(fip, 0);
+	check_stats(fip, RPMEM_STATS_ALL_LANES);
+
+	client_close_begin(client);
+
+	ret = rpmem_fip_close(fip);
+	UT_ASSERTeq(ret, 0);
+
+	client_close_end(client);
+
+	rpmem_fip_fini(fip);
+
+	ret = memcmp(rpool, lpool, POOL_SIZE);
+	UT_ASSERTeq(ret, 0);
+
+	rpmem_target_free(info);
+
+	return 3;
+}
+
+/*
+ * client_persistv -- test case for vectored persist operation
+ */
+int
+client_persistv(const struct test_case *tc, int argc, char *argv[])
+{
+	if (argc < 3)
+		UT_FATAL("usage: %s <target> <provider> <persist method>",
+				tc->name);
+
+	char *target = argv[0];
+	char *prov_name = argv[1];
+	char *persist_method = argv[2];
+
+	set_rpmem_cmd("server_process %s", persist_method);
+
+	char fip_service[NI_MAXSERV];
+	struct rpmem_target_info *info;
+
+	info = rpmem_target_parse(target);
+	UT_ASSERTne(info, NULL);
+
+	int ret;
+
+	set_pool_data(lpool, 1);
+	set_pool_data(rpool, 1);
+
+	unsigned nlanes = NLANES;
+	enum rpmem_provider provider = get_provider(info->node,
+			prov_name, &nlanes);
+
+	client_t *client;
+	struct rpmem_resp_attr resp;
+	client = client_exchange(info, nlanes, provider, &resp);
+
+	struct rpmem_fip_attr attr = {
+		.provider = provider,
+		.persist_method = resp.persist_method,
+		.laddr = lpool,
+		.size = POOL_SIZE,
+		.buff_size = RPMEM_DEF_BUFF_SIZE,
+		.nlanes = resp.nlanes,
+		.raddr = (void *)resp.raddr,
+		.rkey = resp.rkey,
+	};
+
+	ssize_t sret = snprintf(fip_service, NI_MAXSERV, "%u", resp.port);
+	UT_ASSERT(sret > 0);
+
+	struct rpmem_fip *fip;
+	fip = rpmem_fip_init(info->node, fip_service, &attr, &nlanes);
+	UT_ASSERTne(fip, NULL);
+
+	ret = rpmem_fip_connect(fip);
+	UT_ASSERTeq(ret, 0);
+
+	/* persist with no ranges should always succeed */
+	ret = rpmem_fip_persistv(fip, NULL, 0, 0, RPMEM_PERSIST_WRITE);
+	UT_ASSERTeq(ret, 0);
+
+	/*
+	 * Persist discontiguous ranges -- the even chunks using RDMA WRITE
+	 * and the odd ones inlined in the persist messages.
+	 */
+	unsigned modes[] = {RPMEM_PERSIST_WRITE, RPMEM_PERSIST_SEND};
+	for (unsigned m = 0; m < 2; m++) {
+		unsigned n = 0;
+		for (unsigned c = m; c < NCHUNKS; c += 2) {
+			size_t offset = c * SIZE_PER_LANE;
+			memset(&lpool[offset], (int)c, SIZE_PER_LANE);
+
+			ranges[n].offset = offset;
+			ranges[n].length = SIZE_PER_LANE;
+			n++;
+		}
+
+		ret = rpmem_fip_persistv(fip, ranges, n, 0, modes[m]);
+		UT_ASSERTeq(ret, 0);
+	}
+
+	ret = rpmem_fip_read(fip, rpool, POOL_SIZE, 0, 0);
+	UT_ASSERTeq(ret, 0);
+
+	client_close_begin(client);
+
+	ret = rpmem_fip_close(fip);
+	UT_ASSERTeq(ret, 0);
+
+	client_close_end(client);
+
+	rpmem_fip_fini(fip);
+
+	ret = memcmp(rpool, lpool, POOL_SIZE);
+	UT_ASSERTeq(ret, 0);
+
+	rpmem_target_free(info);
+
+	return 3;
+}
+
+/*
+ * client_persist_async -- test case for asynchronous persist operation
+ */
+int
+client_persist_async(const struct test_case *tc, int argc, char *argv[])
+{
+	if (argc < 3)
+		UT_FATAL("usage: %s <target> <provider> <persist method>",
+				tc->name);
+
+	char *target = argv[0];
+	char *prov_name = argv[1];
+	char *persist_method = argv[2];
+
+	set_rpmem_cmd("server_process %s", persist_method);
+
+	char fip_service[NI_MAXSERV];
+	struct rpmem_target_info *info;
+
+	info = rpmem_target_parse(target);
+	UT_ASSERTne(info, NULL);
+
+	int ret;
+
+	set_pool_data(lpool, 1);
+	set_pool_data(rpool, 1);
+
+	unsigned nlanes = NLANES;
+	enum rpmem_provider provider = get_provider(info->node,
+			prov_name, &nlanes);
+
+	client_t *client;
+	struct rpmem_resp_attr resp;
+	client = client_exchange(info, nlanes, provider, &resp);
+
+	struct rpmem_fip_attr attr = {
+		.provider = provider,
+		.persist_method = resp.persist_method,
+		.laddr = lpool,
+		.size = POOL_SIZE,
+		.nlanes = resp.nlanes,
+		.raddr = (void *)resp.raddr,
+		.rkey = resp.rkey,
+	};
+
+	ssize_t sret = snprintf(fip_service, NI_MAXSERV, "%u", resp.port);
+	UT_ASSERT(sret > 0);
+
+	struct rpmem_fip *fip;
+	fip = rpmem_fip_init(info->node, fip_service, &attr, &nlanes);
+	UT_ASSERTne(fip, NULL);
+
+	ret = rpmem_fip_connect(fip);
+	UT_ASSERTeq(ret, 0);
+
+	uint32_t *seqs = MALLOC(nlanes * sizeof(*seqs));
+
+	/*
+	 * Post a persist on each lane and collect the completions afterwards
+	 * -- polling on even lanes and waiting on odd ones.
+	 */
+	for (unsigned i = 0; i < COUNT_PER_LANE; i++) {
+		for (unsigned l = 0; l < nlanes; l++) {
+			size_t offset = l * TOTAL_PER_LANE + i * SIZE_PER_LANE;
+			memset(&lpool[offset], (int)(l + i), SIZE_PER_LANE);
+
+			ret = rpmem_fip_persist_async(fip, offset,
+					SIZE_PER_LANE, l, RPMEM_PERSIST_WRITE,
+					&seqs[l]);
+			UT_ASSERTeq(ret, 0);
+		}
+
+		for (unsigned l = 0; l < nlanes; l++) {
+			if (l % 2) {
+				ret = rpmem_fip_wait(fip, l, seqs[l]);
+				UT_ASSERTeq(ret, 0);
+				continue;
+			}
+
+			while ((ret = rpmem_fip_poll(fip, l, seqs[l])) == 0)
+				;
+			UT_ASSERTeq(ret, 1);
+
+			/* completed operation stays completed */
+			ret = rpmem_fip_poll(fip, l, seqs[l]);
+			UT_ASSERTeq(ret, 1);
+		}
+	}
+
+	/* any subsequent operation on the lane completes the pending one */
+	ret = rpmem_fip_persist_async(fip, 0, SIZE_PER_LANE, 0,
+			RPMEM_PERSIST_WRITE, &seqs[0]);
+	UT_ASSERTeq(ret, 0);
+
+	ret = rpmem_fip_read(fip, rpool, POOL_SIZE, 0, 0);
+	UT_ASSERTeq(ret, 0);
+
+	ret = rpmem_fip_poll(fip, 0, seqs[0]);
+	UT_ASSERTeq(ret, 1);
+
+	FREE(seqs);
+
 	client_close_begin(client);
 
 	ret = rpmem_fip_close(fip);
@@ -739,6 +1011,108 @@ client_read(const struct test_case *tc, int argc, char *argv[])
 	return 3;
 }
 
+/*
+ * client_read_bulk -- test case for read operation using multiple lanes
+ */
+int
+client_read_bulk(const struct test_case *tc, int argc, char *argv[])
+{
+	if (argc < 3)
+		UT_FATAL("usage: %s <target> <provider> <persist method>",
+				tc->name);
+
+	char *target = argv[0];
+	char *prov_name = argv[1];
+	char *persist_method = argv[2];
+
+	set_rpmem_cmd("server_process %s", persist_method);
+
+	char fip_service[NI_MAXSERV];
+	struct rpmem_target_info *info;
+	int ret;
+
+	info = rpmem_target_parse(target);
+	UT_ASSERTne(info, NULL);
+
+	set_pool_data(lpool, 0);
+	set_pool_data(rpool, 1);
+
+	unsigned nlanes = NLANES;
+	enum rpmem_provider provider = get_provider(info->node,
+			prov_name, &nlanes);
+
+	client_t *client;
+	struct rpmem_resp_attr resp;
+	client = client_exchange(info, nlanes, provider, &resp);
+
+	struct rpmem_fip_attr attr = {
+		.provider = provider,
+		.persist_method = resp.persist_method,
+		.laddr = lpool,
+		.size = POOL_SIZE,
+		.nlanes = resp.nlanes,
+		.raddr = (void *)resp.raddr,
+		.rkey = resp.rkey,
+	};
+
+	ssize_t sret = snprintf(fip_service, NI_MAXSERV, "%u", resp.port);
+	UT_ASSERT(sret > 0);
+
+	struct rpmem_fip *fip;
+	fip = rpmem_fip_init(info->node, fip_service, &attr, &nlanes);
+	UT_ASSERTne(fip, NULL);
+
+	ret = rpmem_fip_connect(fip);
+	UT_ASSERTeq(ret, 0);
+
+	/* invalid range of lanes */
+	ret = rpmem_fip_read_bulk(fip, lpool, POOL_SIZE, 0, 0, 0);
+	UT_ASSERTeq(ret, EINVAL);
+	ret = rpmem_fip_read_bulk(fip, lpool, POOL_SIZE, 0, 0, nlanes + 1);
+	UT_ASSERTeq(ret, EINVAL);
+
+	/* read to memory which is not registered */
+	uint8_t *buff = MALLOC(POOL_SIZE);
+	memset(buff, 0, POOL_SIZE);
+
+	ret = rpmem_fip_read_bulk(fip, buff, POOL_SIZE, 0, 0, nlanes);
+	UT_ASSERTeq(ret, 0);
+
+	/* read it again in pieces through the already allocated read buffers */
+	memset(buff, 0, POOL_SIZE);
+
+	ret = rpmem_fip_read_bulk(fip, buff, 1, 0, 0, 1);
+	UT_ASSERTeq(ret, 0);
+	ret = rpmem_fip_read_bulk(fip, buff + 1, POOL_SIZE - 1, 1, 0, nlanes);
+	UT_ASSERTeq(ret, 0);
+
+	/* read to the registered pool memory using the upper half of lanes */
+	unsigned half = nlanes / 2;
+	ret = rpmem_fip_read_bulk(fip, lpool, POOL_SIZE, 0,
+			half, nlanes - half);
+	UT_ASSERTeq(ret, 0);
+
+	client_close_begin(client);
+
+	ret = rpmem_fip_close(fip);
+	UT_ASSERTeq(ret, 0);
+
+	client_close_end(client);
+
+	rpmem_fip_fini(fip);
+
+	ret = memcmp(rpool, buff, POOL_SIZE);
+	UT_ASSERTeq(ret, 0);
+
+	ret = memcmp(rpool, lpool, POOL_SIZE);
+	UT_ASSERTeq(ret, 0);
+
+	FREE(buff);
+	rpmem_target_free(info);
+
+	return 3;
+}
+
 /*
  * test_cases -- available test cases
  */
@@ -749,8 +1123,11 @@ static struct test_case test_cases[] = {
 	TEST_CASE(server_connect),
 	TEST_CASE(client_persist),
 	TEST_CASE(client_persist_mt),
+	TEST_CASE(client_persistv),
+	TEST_CASE(client_persist_async),
 	TEST_CASE(server_process),
 	TEST_CASE(client_read),
+	TEST_CASE(client_read_bulk),
 };
 
 #define NTESTS	(sizeof(test_cases) / sizeof(test_cases[0]))
@@ -97,7 +97,7 @@ req_cb_check_req(const struct rpmem_req_attr *req)
 	UT_ASSERTeq(req->pool_size, POOL_SIZE);
 	UT_ASSERTeq(req->provider, PROVIDER);
 	UT_ASSERTeq(strcmp(req->pool_desc, POOL_DESC), 0);
-
+	UT_ASSERT(req->proto_minor <= RPMEM_PROTO_MINOR);
 }
 
 /*
@@ -139,12 +139,12 @@ client_msg_create_noresp(const char *ctarget)
 }
 
 /*
- * client_msg_create_resp -- send create request message and expect a response
- * with specified status. If status is 0, validate create request response
- * message
+ * client_msg_create_resp -- send create request message of specified protocol
+ * minor version and expect a response with specified status. If status is 0,
+ * validate create request response message
  */
 static void
-client_msg_create_resp(const char *ctarget, int status)
+client_msg_create_resp(const char *ctarget, int status, unsigned minor)
 {
 	char *target = STRDUP(ctarget);
 	size_t msg_size = sizeof(CREATE_MSG) + POOL_DESC_SIZE;
@@ -155,6 +155,7 @@ client_msg_create_resp(const char *ctarget, int status)
 
 	*msg = CREATE_MSG;
 	msg->hdr.size = msg_size;
+	msg->c.minor = (uint16_t)minor;
 	memcpy(msg->pool_desc.desc, POOL_DESC, POOL_DESC_SIZE);
 
 	rpmem_hton_msg_create(msg);
@@ -200,10 +201,14 @@ client_create(const struct test_case *tc, int argc, char *argv[])
 	client_msg_create_noresp(target);
 
 	set_rpmem_cmd("server_msg_resp %d %d", RPMEM_MSG_TYPE_CREATE, 0);
-	client_msg_create_resp(target, 0);
+	client_msg_create_resp(target, 0, RPMEM_PROTO_MINOR);
 
 	set_rpmem_cmd("server_msg_resp %d %d", RPMEM_MSG_TYPE_CREATE, 1);
-	client_msg_create_resp(target, 1);
+	client_msg_create_resp(target, 1, RPMEM_PROTO_MINOR);
+
+	/* older minor version of the protocol is accepted */
+	set_rpmem_cmd("server_msg_resp %d %d", RPMEM_MSG_TYPE_CREATE, 0);
+	client_msg_create_resp(target, 0, RPMEM_PROTO_MINOR - 1);
 
 	return 1;
 }
@@ -140,12 +140,12 @@ client_msg_open_noresp(const char *ctarget)
 }
 
 /*
- * client_msg_open_resp -- send open request message and expect a response
- * with specified status. If status is 0, validate open request response
- * message
+ * client_msg_open_resp -- send open request message of specified protocol
+ * minor version and expect a response with specified status. If status is 0,
+ * validate open request response message
  */
 static void
-client_msg_open_resp(const char *ctarget, int status)
+client_msg_open_resp(const char *ctarget, int status, unsigned minor)
 {
 	char *target = STRDUP(ctarget);
 	size_t msg_size = sizeof(OPEN_MSG) + POOL_DESC_SIZE;
@@ -156,6 +156,7 @@ client_msg_open_resp(const char *ctarget, int status)
 
 	*msg = OPEN_MSG;
 	msg->hdr.size = msg_size;
+	msg->c.minor = (uint16_t)minor;
 	memcpy(msg->pool_desc.desc, POOL_DESC, POOL_DESC_SIZE);
 
 	rpmem_hton_msg_open(msg);
@@ -201,10 +202,14 @@ client_open(const struct test_case *tc, int argc, char *argv[])
 	client_msg_open_noresp(target);
 
 	set_rpmem_cmd("server_msg_resp %d %d", RPMEM_MSG_TYPE_OPEN, 0);
-	client_msg_open_resp(target, 0);
+	client_msg_open_resp(target, 0, RPMEM_PROTO_MINOR);
 
 	set_rpmem_cmd("server_msg_resp %d %d", RPMEM_MSG_TYPE_OPEN, 1);
-	client_msg_open_resp(target, 1);
+	client_msg_open_resp(target, 1, RPMEM_PROTO_MINOR);
+
+	/* older minor version of the protocol is accepted */
+	set_rpmem_cmd("server_msg_resp %d %d", RPMEM_MSG_TYPE_OPEN, 0);
+	client_msg_open_resp(target, 0, RPMEM_PROTO_MINOR - 1);
 
 	return 1;
 }
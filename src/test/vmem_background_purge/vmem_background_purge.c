@@ -0,0 +1,191 @@
+/*
+ * Copyright 2018, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * vmem_background_purge.c -- unit test for vmem_background_purge
+ *
+ * usage: vmem_background_purge directory
+ */
+
+#include <stdbool.h>
+
+#include "unittest.h"
+
+#define POOL_SIZE (64 << 20)
+#define ALLOC_SIZE (1 << 20)
+#define NALLOCS 16
+#define HUGE_SIZE (8 << 20)	/* larger than a chunk */
+#define NHUGE 2
+#define DECAY_LONG_MS 60000
+#define DECAY_SHORT_MS 10
+#define WAIT_MAX_MS 10000
+
+#ifdef __FreeBSD__
+typedef char vec_t;
+#else
+typedef unsigned char vec_t;
+#endif
+
+/*
+ * count_resident -- return the number of resident pages of the range
+ */
+static size_t
+count_resident(void *addr, size_t len)
+{
+	size_t npages = (len + Ut_pagesize - 1) / Ut_pagesize;
+	vec_t *vec = MALLOC(sizeof(*vec) * npages);
+
+	UT_ASSERTeq(mincore(addr, len, vec), 0);
+
+	size_t resident = 0;
+	for (size_t i = 0; i < npages; ++i)
+		resident += vec[i] & 0x1;
+
+	FREE(vec);
+
+	return resident;
+}
+
+/*
+ * count_all_resident -- return the number of resident pages of the objects
+ */
+static size_t
+count_all_resident(void *ptrs[], void *huge[])
+{
+	size_t resident = 0;
+	for (int i = 0; i < NALLOCS; ++i)
+		resident += count_resident(ptrs[i], ALLOC_SIZE);
+	for (int i = 0; i < NHUGE; ++i)
+		resident += count_resident(huge[i], HUGE_SIZE);
+
+	return resident;
+}
+
+/*
+ * is_deferred -- check whether inline purging of the pool is disabled
+ */
+static bool
+is_deferred(VMEM *vmp)
+{
+	bool deferred;
+	size_t len = sizeof(deferred);
+
+	UT_ASSERTeq(vmem_ctl_get(vmp, "purge_deferred", &deferred, &len), 0);
+
+	return deferred;
+}
+
+int
+main(int argc, char *argv[])
+{
+	START(argc, argv, "vmem_background_purge");
+
+	if (argc != 2)
+		UT_FATAL("usage: %s directory", argv[0]);
+
+	VMEM *vmp = vmem_create(argv[1], POOL_SIZE);
+	if (vmp == NULL)
+		UT_FATAL("!vmem_create");
+
+	UT_ASSERT(!is_deferred(vmp));
+
+	/* stopping purging which is not running is a no-op */
+	UT_ASSERTeq(vmem_background_purge(vmp, 0), 0);
+
+	UT_ASSERTeq(vmem_background_purge(vmp, DECAY_LONG_MS), 0);
+	UT_ASSERT(is_deferred(vmp));
+
+	void *ptrs[NALLOCS];
+	for (int i = 0; i < NALLOCS; ++i) {
+		ptrs[i] = vmem_malloc(vmp, ALLOC_SIZE);
+		UT_ASSERTne(ptrs[i], NULL);
+		memset(ptrs[i], 0xc5, ALLOC_SIZE);
+	}
+
+	void *huge[NHUGE];
+	for (int i = 0; i < NHUGE; ++i) {
+		huge[i] = vmem_malloc(vmp, HUGE_SIZE);
+		UT_ASSERTne(huge[i], NULL);
+		memset(huge[i], 0xc5, HUGE_SIZE);
+	}
+
+	for (int i = 0; i < NALLOCS; ++i)
+		vmem_free(vmp, ptrs[i]);
+	for (int i = 0; i < NHUGE; ++i)
+		vmem_free(vmp, huge[i]);
+
+	/* nothing purged inline, the pages are still there */
+	size_t resident = 0;
+	for (int i = 0; i < NALLOCS; ++i)
+		resident += count_resident(ptrs[i], ALLOC_SIZE);
+	UT_ASSERTne(resident, 0);
+
+	/* not even of the chunks returned by huge objects */
+	for (int i = 0; i < NHUGE; ++i)
+		UT_ASSERTeq(count_resident(huge[i], HUGE_SIZE),
+				HUGE_SIZE / Ut_pagesize);
+	resident = count_all_resident(ptrs, huge);
+
+	/* shorten the interval of the running thread */
+	UT_ASSERTeq(vmem_background_purge(vmp, DECAY_SHORT_MS), 0);
+
+	for (int ms = 0; resident != 0 && ms < WAIT_MAX_MS;
+			ms += DECAY_SHORT_MS) {
+		usleep(DECAY_SHORT_MS * 1000);
+		resident = count_all_resident(ptrs, huge);
+	}
+
+	/* the file blocks have been released, not only the mappings */
+	UT_ASSERTeq(resident, 0);
+
+	/* reclaimed memory is known to be zeroed */
+	for (int i = 0; i < NALLOCS; ++i) {
+		char *ptr = vmem_calloc(vmp, 1, ALLOC_SIZE);
+		UT_ASSERTne(ptr, NULL);
+		for (size_t j = 0; j < ALLOC_SIZE; ++j)
+			UT_ASSERTeq(ptr[j], 0);
+		ptrs[i] = ptr;
+	}
+
+	for (int i = 0; i < NALLOCS; ++i)
+		vmem_free(vmp, ptrs[i]);
+
+	UT_ASSERTeq(vmem_background_purge(vmp, 0), 0);
+	UT_ASSERT(!is_deferred(vmp));
+
+	/* the thread is stopped when the pool is deleted */
+	UT_ASSERTeq(vmem_background_purge(vmp, DECAY_SHORT_MS), 0);
+
+	vmem_delete(vmp);
+
+	DONE(NULL);
+}
@@ -0,0 +1,181 @@
+/*
+ * Copyright 2018, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * vmem_ctl.c -- unit test for vmem_ctl_get and vmem_ctl_set
+ *
+ * usage: vmem_ctl
+ */
+
+#include <stdbool.h>
+
+#include "unittest.h"
+
+#define ALLOC_SIZE (1 << 20)
+
+/*
+ * get_unsigned -- read an unsigned control entry
+ */
+static unsigned
+get_unsigned(VMEM *vmp, const char *name)
+{
+	unsigned val;
+	size_t len = sizeof(val);
+
+	UT_ASSERTeq(vmem_ctl_get(vmp, name, &val, &len), 0);
+	UT_ASSERTeq(len, sizeof(val));
+
+	return val;
+}
+
+/*
+ * get_allocated -- refresh the statistics and read the allocated bytes
+ */
+static size_t
+get_allocated(VMEM *vmp)
+{
+	uint64_t epoch = 1;
+	UT_ASSERTeq(vmem_ctl_set(vmp, "epoch", &epoch, sizeof(epoch)), 0);
+
+	size_t allocated;
+	size_t len = sizeof(allocated);
+	UT_ASSERTeq(vmem_ctl_get(vmp, "stats.allocated", &allocated, &len), 0);
+
+	return allocated;
+}
+
+int
+main(int argc, char *argv[])
+{
+	START(argc, argv, "vmem_ctl");
+
+	if (argc != 1)
+		UT_FATAL("usage: %s", argv[0]);
+
+	void *mem_pool1 = MMAP_ANON_ALIGNED(VMEM_MIN_POOL, 4 << 20);
+	void *mem_pool2 = MMAP_ANON_ALIGNED(VMEM_MIN_POOL, 4 << 20);
+
+	VMEM *vmp1 = vmem_create_in_region(mem_pool1, VMEM_MIN_POOL);
+	if (vmp1 == NULL)
+		UT_FATAL("!vmem_create_in_region");
+
+	VMEM *vmp2 = vmem_create_in_region(mem_pool2, VMEM_MIN_POOL);
+	if (vmp2 == NULL)
+		UT_FATAL("!vmem_create_in_region");
+
+	/* global entries */
+	const char *version;
+	size_t len = sizeof(version);
+	UT_ASSERTeq(vmem_ctl_get(vmp1, "version", &version, &len), 0);
+	UT_ASSERTne(version, NULL);
+
+	/* statistics are kept per pool */
+	void *ptr = vmem_malloc(vmp2, ALLOC_SIZE);
+	UT_ASSERTne(ptr, NULL);
+
+	UT_ASSERTeq(get_allocated(vmp1), 0);
+	UT_ASSERT(get_allocated(vmp2) >= ALLOC_SIZE);
+
+	vmem_free(vmp2, ptr);
+	UT_ASSERTeq(get_allocated(vmp2), 0);
+
+	/* purging dirty pages */
+	UT_ASSERTeq(vmem_ctl_set(vmp2, "arena.0.purge", NULL, 0), 0);
+
+	/* adding an arena and binding the thread to it */
+	unsigned narenas = get_unsigned(vmp1, "arenas.narenas");
+	UT_ASSERT(narenas > 0);
+
+	unsigned arena = get_unsigned(vmp1, "arenas.extend");
+	UT_ASSERTeq(arena, narenas);
+	UT_ASSERTeq(get_unsigned(vmp1, "arenas.narenas"), narenas + 1);
+	UT_ASSERTeq(get_unsigned(vmp2, "arenas.narenas"), narenas);
+
+	UT_ASSERTeq(vmem_ctl_set(vmp1, "thread.arena", &arena, sizeof(arena)),
+			0);
+	UT_ASSERTeq(get_unsigned(vmp1, "thread.arena"), arena);
+
+	ptr = vmem_malloc(vmp1, ALLOC_SIZE);
+	UT_ASSERTne(ptr, NULL);
+	vmem_free(vmp1, ptr);
+
+	/* tuning is kept per pool */
+	ssize_t lg_dirty_mult;
+	ssize_t opt_lg_dirty_mult;
+	len = sizeof(opt_lg_dirty_mult);
+	UT_ASSERTeq(vmem_ctl_get(vmp1, "opt.lg_dirty_mult", &opt_lg_dirty_mult,
+			&len), 0);
+
+	lg_dirty_mult = -1;
+	UT_ASSERTeq(vmem_ctl_set(vmp1, "lg_dirty_mult", &lg_dirty_mult,
+			sizeof(lg_dirty_mult)), 0);
+	UT_ASSERTeq(vmem_ctl_get(vmp1, "lg_dirty_mult", &lg_dirty_mult,
+			&len), 0);
+	UT_ASSERTeq(lg_dirty_mult, -1);
+	UT_ASSERTeq(vmem_ctl_get(vmp2, "lg_dirty_mult", &lg_dirty_mult,
+			&len), 0);
+	UT_ASSERTeq(lg_dirty_mult, opt_lg_dirty_mult);
+
+	/* freed objects are not held in the thread cache */
+	bool tcache = false;
+	UT_ASSERTeq(vmem_ctl_set(vmp1, "tcache", &tcache, sizeof(tcache)), 0);
+	ptr = vmem_malloc(vmp1, sizeof(int));
+	UT_ASSERTne(ptr, NULL);
+	vmem_free(vmp1, ptr);
+	UT_ASSERTeq(get_allocated(vmp1), 0);
+
+	/* errors */
+	UT_ASSERTeq(vmem_ctl_get(vmp1, "stats.nonexistent", &arena, &len), -1);
+	UT_ASSERTeq(errno, ENOENT);
+	UT_OUT("%s", vmem_errormsg());
+
+	len = sizeof(uint64_t);
+	UT_ASSERTeq(vmem_ctl_get(vmp1, "arenas.narenas", &arena, &len), -1);
+	UT_ASSERTeq(errno, EINVAL);
+	UT_OUT("%s", vmem_errormsg());
+
+	UT_ASSERTeq(vmem_ctl_set(vmp1, "arenas.narenas", &arena,
+			sizeof(arena)), -1);
+	UT_ASSERTeq(errno, EPERM);
+	UT_OUT("%s", vmem_errormsg());
+
+	lg_dirty_mult = -2;
+	UT_ASSERTeq(vmem_ctl_set(vmp1, "lg_dirty_mult", &lg_dirty_mult,
+			sizeof(lg_dirty_mult)), -1);
+	UT_ASSERTeq(errno, EINVAL);
+	UT_OUT("%s", vmem_errormsg());
+
+	vmem_delete(vmp1);
+	vmem_delete(vmp2);
+
+	DONE(NULL);
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2018, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * vmem_numa.c -- unit test for vmem_bind_node, vmem_thread_bind and
+ * vmem_pool_local
+ *
+ * usage: vmem_numa
+ */
+
+#include "unittest.h"
+
+#define NPOOLS 2
+
+int
+main(int argc, char *argv[])
+{
+	START(argc, argv, "vmem_numa");
+
+	if (argc != 1)
+		UT_FATAL("usage: %s", argv[0]);
+
+	VMEM *pools[NPOOLS];
+	for (unsigned i = 0; i < NPOOLS; ++i) {
+		void *mem = MMAP_ANON_ALIGNED(VMEM_MIN_POOL, 4 << 20);
+		pools[i] = vmem_create_in_region(mem, VMEM_MIN_POOL);
+		if (pools[i] == NULL)
+			UT_FATAL("!vmem_create_in_region");
+	}
+
+	/* with no pool bound to a node, the pools are interleaved */
+	VMEM *local = vmem_pool_local(pools, NPOOLS);
+	UT_ASSERT(local == pools[0] || local == pools[1]);
+
+	UT_ASSERTeq(vmem_pool_local(pools, 0), NULL);
+	UT_ASSERTeq(errno, EINVAL);
+	UT_OUT("%s", vmem_errormsg());
+
+	/* the memory of the second pool is on node 0, present on any system */
+	UT_ASSERTeq(vmem_bind_node(pools[1], 0), 0);
+
+	UT_ASSERTeq(vmem_bind_node(pools[0], 1U << 20), -1);
+	UT_ASSERTeq(errno, EINVAL);
+	UT_OUT("%s", vmem_errormsg());
+
+	/* single node systems always run on node 0 */
+	unsigned cpu;
+	unsigned node;
+	UT_ASSERTeq(os_getcpu(&cpu, &node), 0);
+	if (node == 0)
+		UT_ASSERTeq(vmem_pool_local(pools, NPOOLS), pools[1]);
+
+	/* the thread uses the arena of its CPU */
+	UT_ASSERTeq(vmem_thread_bind(pools[1]), 0);
+
+	unsigned narenas;
+	size_t len = sizeof(narenas);
+	UT_ASSERTeq(vmem_ctl_get(pools[1], "arenas.narenas", &narenas, &len),
+			0);
+
+	unsigned arena;
+	len = sizeof(arena);
+	UT_ASSERTeq(vmem_ctl_get(pools[1], "thread.arena", &arena, &len), 0);
+	UT_ASSERT(arena < narenas);
+
+	void *ptr = vmem_malloc(pools[1], 1024);
+	UT_ASSERTne(ptr, NULL);
+	vmem_free(pools[1], ptr);
+
+	for (unsigned i = 0; i < NPOOLS; ++i)
+		vmem_delete(pools[i]);
+
+	DONE(NULL);
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright 2018, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * vmem_xcreate.c -- unit test for vmem_xcreate
+ *
+ * usage: vmem_xcreate directory op
+ *
+ * op can be:
+ *	e - invalid arguments
+ *	p - 2 MiB aligned and pre-populated pool in a temp file
+ *	h - pool in anonymous 2 MiB huge pages
+ */
+
+#include "unittest.h"
+
+#define POOL_SIZE (128 << 20)
+#define HUGE_2M (2 << 20)
+#define ALLOC_SIZE (1 << 20)
+
+#ifdef __FreeBSD__
+typedef char vec_t;
+#else
+typedef unsigned char vec_t;
+#endif
+
+/*
+ * check_pool -- verify the pool is aligned and usable
+ */
+static void
+check_pool(VMEM *vmp)
+{
+	UT_ASSERTeq((uintptr_t)vmp % HUGE_2M, 0);
+
+	void *ptr = vmem_malloc(vmp, ALLOC_SIZE);
+	UT_ASSERTne(ptr, NULL);
+	memset(ptr, 0xc5, ALLOC_SIZE);
+	vmem_free(vmp, ptr);
+}
+
+/*
+ * check_resident -- verify all pages of the range are resident
+ */
+static void
+check_resident(void *addr, size_t len)
+{
+	size_t npages = (len + Ut_pagesize - 1) / Ut_pagesize;
+	vec_t *vec = MALLOC(sizeof(*vec) * npages);
+
+	UT_ASSERTeq(mincore(addr, len, vec), 0);
+
+	size_t resident = 0;
+	for (size_t i = 0; i < npages; ++i)
+		resident += vec[i] & 0x1;
+
+	UT_ASSERTeq(resident, npages);
+
+	FREE(vec);
+}
+
+/*
+ * test_errors -- invalid arguments are rejected
+ */
+static void
+test_errors(const char *dir)
+{
+	VMEM *vmp = vmem_xcreate(dir, VMEM_MIN_POOL, 1U << 31);
+	UT_ASSERTeq(vmp, NULL);
+	UT_ASSERTeq(errno, EINVAL);
+	UT_OUT("%s", vmem_errormsg());
+
+	vmp = vmem_xcreate(dir, VMEM_MIN_POOL,
+			VMEM_CREATE_HUGE_2M | VMEM_CREATE_HUGE_1G);
+	UT_ASSERTeq(vmp, NULL);
+	UT_ASSERTeq(errno, EINVAL);
+	UT_OUT("%s", vmem_errormsg());
+
+	vmp = vmem_xcreate(dir, VMEM_MIN_POOL - 1, VMEM_CREATE_HUGE_2M);
+	UT_ASSERTeq(vmp, NULL);
+	UT_ASSERTeq(errno, EINVAL);
+}
+
+/*
+ * test_populate -- pool in a temp file, pre-faulted at creation
+ */
+static void
+test_populate(const char *dir)
+{
+	VMEM *vmp = vmem_xcreate(dir, POOL_SIZE,
+			VMEM_CREATE_HUGE_2M | VMEM_CREATE_POPULATE);
+	if (vmp == NULL)
+		UT_FATAL("!vmem_xcreate");
+
+	check_resident(vmp, POOL_SIZE);
+	check_pool(vmp);
+
+	vmem_delete(vmp);
+}
+
+/*
+ * test_hugetlb -- pool in anonymous huge pages
+ */
+static void
+test_hugetlb(void)
+{
+	VMEM *vmp = vmem_xcreate(NULL, VMEM_MIN_POOL, VMEM_CREATE_HUGETLB |
+			VMEM_CREATE_HUGE_2M | VMEM_CREATE_POPULATE);
+	if (vmp == NULL)
+		UT_FATAL("!vmem_xcreate");
+
+	check_pool(vmp);
+
+	vmem_delete(vmp);
+}
+
+int
+main(int argc, char *argv[])
+{
+	START(argc, argv, "vmem_xcreate");
+
+	if (argc != 3)
+		UT_FATAL("usage: %s directory op", argv[0]);
+
+	switch (argv[2][0]) {
+	case 'e':
+		test_errors(argv[1]);
+		break;
+	case 'p':
+		test_populate(argv[1]);
+		break;
+	case 'h':
+		test_hugetlb();
+		break;
+	default:
+		UT_FATAL("unknown operation %s", argv[2]);
+	}
+
+	DONE(NULL);
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright 2018, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * vmmalloc_threshold.c -- unit test for libvmmalloc VMMALLOC_THRESHOLD
+ *
+ * usage: vmmalloc_threshold
+ */
+
+#include <inttypes.h>
+#include <malloc.h>
+#include "unittest.h"
+
+#define THRESHOLD (64 * 1024)
+#define SMALL_SIZE 100
+#define LARGE_SIZE (1 << 20)
+
+/*
+ * in_pool -- check if the block belongs to the pool
+ *
+ * The pool is the only file-backed mapping the allocator uses, while the
+ * system heap consists of anonymous mappings.
+ */
+static int
+in_pool(void *ptr)
+{
+	FILE *fp = os_fopen("/proc/self/maps", "r");
+	UT_ASSERTne(fp, NULL);
+
+	int ret = -1;
+	char line[4096];
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		uintptr_t start;
+		uintptr_t end;
+		unsigned long inode;
+
+		UT_ASSERTeq(sscanf(line, "%" SCNxPTR "-%" SCNxPTR
+				" %*s %*s %*s %lu", &start, &end, &inode), 3);
+
+		if ((uintptr_t)ptr >= start && (uintptr_t)ptr < end) {
+			ret = inode != 0;
+			break;
+		}
+	}
+
+	fclose(fp);
+
+	UT_ASSERTne(ret, -1);
+	return ret;
+}
+
+int
+main(int argc, char *argv[])
+{
+	START(argc, argv, "vmmalloc_threshold");
+
+	if (argc != 1)
+		UT_FATAL("usage: %s", argv[0]);
+
+	char *small = malloc(SMALL_SIZE);
+	UT_ASSERTne(small, NULL);
+	UT_ASSERT(!in_pool(small));
+	memset(small, 0x5a, SMALL_SIZE);
+
+	char *large = malloc(LARGE_SIZE);
+	UT_ASSERTne(large, NULL);
+	UT_ASSERT(in_pool(large));
+	UT_ASSERT(malloc_usable_size(large) >= LARGE_SIZE);
+	memset(large, 0xa5, LARGE_SIZE);
+
+	int *zeroed = calloc(THRESHOLD / sizeof(int), sizeof(int));
+	UT_ASSERTne(zeroed, NULL);
+	UT_ASSERT(in_pool(zeroed));
+	for (size_t i = 0; i < THRESHOLD / sizeof(int); ++i)
+		UT_ASSERTeq(zeroed[i], 0);
+	free(zeroed);
+
+	void *aligned;
+	UT_ASSERTeq(posix_memalign(&aligned, 4096, SMALL_SIZE), 0);
+	UT_ASSERT(!in_pool(aligned));
+	UT_ASSERTeq((uintptr_t)aligned % 4096, 0);
+	free(aligned);
+
+	/* growing past the threshold moves the block to the pool */
+	small = realloc(small, LARGE_SIZE);
+	UT_ASSERTne(small, NULL);
+	UT_ASSERT(in_pool(small));
+	for (size_t i = 0; i < SMALL_SIZE; ++i)
+		UT_ASSERTeq(small[i], 0x5a);
+
+	/* shrinking below the threshold moves the block out of the pool */
+	large = realloc(large, SMALL_SIZE);
+	UT_ASSERTne(large, NULL);
+	UT_ASSERT(!in_pool(large));
+	for (size_t i = 0; i < SMALL_SIZE; ++i)
+		UT_ASSERTeq((unsigned char)large[i], 0xa5);
+
+	free(small);
+	free(large);
+
+	DONE(NULL);
+}
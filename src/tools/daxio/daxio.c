@@ -35,6 +35,8 @@
  *            Device DAX device using mmap instead of file I/O API
  */
 
+#define _GNU_SOURCE
+#include <assert.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <getopt.h>
@@ -47,6 +49,7 @@
 #include <sys/sysmacros.h>
 #include <limits.h>
 #include <string.h>
+#include <time.h>
 
 #include <ndctl/libndctl.h>
 #include <ndctl/libdaxctl.h>
@@ -54,6 +57,7 @@
 
 #include "util.h"
 #include "os_dimm.h"
+#include "os_thread.h"
 
 #define ALIGN_UP(size, align) (((size) + (align) - 1) & ~((align) - 1))
 #define ALIGN_DOWN(size, align) ((size) & ~((align) - 1))
@@ -69,11 +73,33 @@ do {\
 		__func__, __LINE__, func, strerror(errno));\
 } while (0)
 
+/* maximum number of threads performing the I/O */
+#define DAXIO_MAX_THREADS 8
+
+/* size of a piece of data processed by a thread at once */
+#define DAXIO_CHUNK_SIZE ((size_t)1 << 22) /* 4 MiB */
+
+/* granularity of skipping zeroed regions of mapped input */
+#define DAXIO_ZERO_BLOCK_SIZE ((size_t)1 << 16) /* 64 KiB */
+
+#ifdef DEBUG
+/*
+ * In debug builds a list of regular files treated as Device DAX, separated
+ * by colons, can be specified. It allows testing the memory-mapped I/O
+ * without Device DAX hardware.
+ */
+#define DAXIO_EMULATE_DEVDAX_VAR "DAXIO_EMULATE_DEVDAX"
+#endif
+
 struct daxio_device {
 	char *path;
 	int fd;
 	size_t size;		/* actual file/device size */
 	int is_devdax;
+	int is_emulated;	/* regular file treated as Device DAX */
+	int is_stream;		/* stdin/stdout, pipe or other non-seekable */
+	int is_reg;		/* regular file */
+	int is_zeroed;		/* output range is known to be zeroed */
 
 	/* Device DAX only */
 	size_t align;		/* internal device alignment */
@@ -93,6 +119,9 @@ struct daxio_device {
 struct daxio_context {
 	size_t len;	/* total length of I/O */
 	int zero;
+	unsigned nthreads;	/* number of I/O threads, 0 means automatic */
+	int progress;	/* print progress and throughput */
+	int sparse;	/* do not write zeroed regions of the input */
 	struct daxio_device src;
 	struct daxio_device dst;
 };
@@ -103,8 +132,27 @@ struct daxio_context {
 static struct daxio_context Ctx = {
 	SIZE_MAX,	/* len */
 	0,		/* zero */
-	{ NULL, -1, SIZE_MAX, 0, 0, NULL, 0, 0, 0, 0, NULL, NULL },
-	{ NULL, -1, SIZE_MAX, 0, 0, NULL, 0, 0, 0, 0, NULL, NULL },
+	0,		/* nthreads */
+	0,		/* progress */
+	0,		/* sparse */
+	{ NULL, -1, SIZE_MAX, 0, 0, 0, 0, 0, 0, NULL, 0, 0, 0, 0, NULL, NULL },
+	{ NULL, -1, SIZE_MAX, 0, 0, 0, 0, 0, 0, NULL, 0, 0, 0, 0, NULL, NULL },
+};
+
+/*
+ * daxio_io -- state shared by the threads performing the I/O
+ */
+struct daxio_io {
+	struct daxio_context *ctx;
+	size_t len;		/* total length of the I/O */
+	size_t next;		/* offset of the next chunk to be processed */
+	size_t done;		/* number of processed bytes */
+	size_t skipped;		/* number of bytes not written as zeroed */
+	int sparse;		/* do not write zeroed regions */
+	int32_t error;		/* set by any thread, accessed atomically */
+	unsigned reported;	/* last reported percentage of progress */
+	struct timespec start;
+	os_mutex_t lock;	/* serializes printing of progress */
 };
 
 /*
@@ -130,6 +178,11 @@ print_usage(void)
 	printf("-s, --seek=BYTES  - seek offset for output (default 0)\n");
 	printf("-l, --len=BYTES   - total length to perform the I/O\n");
 	printf("-z, --zero        - zeroing the device\n");
+	printf("-t, --threads=NUM - number of threads performing the I/O\n");
+	printf("-S, --sparse      - do not write zeroed regions of the "
+		"input,\n");
+	printf("                    the output must be zeroed already\n");
+	printf("-p, --progress    - print progress and throughput\n");
 	printf("-h. --help        - print this help\n");
 	printf("-V, --version     - display version of daxio\n");
 }
@@ -144,6 +197,9 @@ static const struct option long_options[] = {
 	{"seek",	required_argument,	NULL,	's'},
 	{"len",		required_argument,	NULL,	'l'},
 	{"zero",	no_argument,		NULL,	'z'},
+	{"threads",	required_argument,	NULL,	't'},
+	{"sparse",	no_argument,		NULL,	'S'},
+	{"progress",	no_argument,		NULL,	'p'},
 	{"help",	no_argument,		NULL,	'h'},
 	{"version",	no_argument,		NULL,	'V'},
 	{NULL,		0,			NULL,	 0 },
@@ -158,8 +214,10 @@ parse_args(struct daxio_context *ctx, int argc, char * const argv[])
 	int opt;
 	size_t offset;
 	size_t len;
+	char *end;
+	unsigned long nthreads;
 
-	while ((opt = getopt_long(argc, argv, "i:o:k:s:l:zhV",
+	while ((opt = getopt_long(argc, argv, "i:o:k:s:l:zt:SphV",
 			long_options, NULL)) != -1) {
 		switch (opt) {
 		case 'i':
@@ -192,6 +250,23 @@ parse_args(struct daxio_context *ctx, int argc, char * const argv[])
 		case 'z':
 			ctx->zero = 1;
 			break;
+		case 't':
+			errno = 0;
+			nthreads = strtoul(optarg, &end, 10);
+			if (errno || *end != '\0' || nthreads == 0 ||
+					nthreads > UINT_MAX) {
+				ERR("'%s' -- invalid number of threads\n",
+						optarg);
+				return -1;
+			}
+			ctx->nthreads = (unsigned)nthreads;
+			break;
+		case 'S':
+			ctx->sparse = 1;
+			break;
+		case 'p':
+			ctx->progress = 1;
+			break;
 		case 'h':
 			print_usage();
 			exit(EXIT_SUCCESS);
@@ -232,6 +307,7 @@ validate_args(struct daxio_context *ctx)
 		}
 		ctx->src.fd = STDIN_FILENO;
 		ctx->src.path = "STDIN";
+		ctx->src.is_stream = 1;
 	}
 
 	/* if no output file provided, use stdout */
@@ -243,6 +319,7 @@ validate_args(struct daxio_context *ctx)
 		}
 		ctx->dst.fd = STDOUT_FILENO;
 		ctx->dst.path = "STDOUT";
+		ctx->dst.is_stream = 1;
 	}
 
 	return 0;
@@ -315,6 +392,35 @@ end:
 	return ret;
 }
 
+#ifdef DEBUG
+/*
+ * is_emulated_devdax -- (internal) check if the file is on the list of files
+ *	treated as Device DAX
+ */
+static int
+is_emulated_devdax(const char *path)
+{
+	const char *list = getenv(DAXIO_EMULATE_DEVDAX_VAR);
+	if (list == NULL)
+		return 0;
+
+	size_t len = strlen(path);
+	while (*list != '\0') {
+		const char *end = strchr(list, ':');
+		size_t elen = end ? (size_t)(end - list) : strlen(list);
+
+		if (elen == len && strncmp(list, path, len) == 0)
+			return 1;
+
+		if (end == NULL)
+			break;
+		list = end + 1;
+	}
+
+	return 0;
+}
+#endif
+
 /*
  * setup_device -- (internal) open/mmap file/device
  */
@@ -343,6 +449,8 @@ setup_device(struct ndctl_ctx *ndctl_ctx, struct daxio_device *dev, int is_dst)
 				FAIL("open");
 				return -1;
 			}
+			dev->is_reg = 1;
+			dev->is_zeroed = 1;
 			return 0;
 		} else {
 			return -1;
@@ -359,8 +467,8 @@ setup_device(struct ndctl_ctx *ndctl_ctx, struct daxio_device *dev, int is_dst)
 
 	/* check if this is regular file or device */
 	if (S_ISREG(stbuf.st_mode)) {
+		dev->is_reg = 1;
 		if (is_dst) {
-			flags = O_RDWR|O_TRUNC;
 			dev->size = SIZE_MAX;
 		} else {
 			dev->size = (size_t)stbuf.st_size;
@@ -376,13 +484,29 @@ setup_device(struct ndctl_ctx *ndctl_ctx, struct daxio_device *dev, int is_dst)
 	}
 
 	/* check if this is Device DAX */
-	if (S_ISCHR(stbuf.st_mode))
+	if (S_ISCHR(stbuf.st_mode)) {
 		find_dev_dax(ndctl_ctx, dev);
+		dev->is_stream = !dev->is_devdax;
+#ifdef DEBUG
+	} else if (S_ISREG(stbuf.st_mode) && is_emulated_devdax(dev->path)) {
+		dev->is_devdax = 1;
+		dev->is_emulated = 1;
+		dev->is_reg = 0;
+		dev->size = (size_t)stbuf.st_size;
+		dev->align = (size_t)sysconf(_SC_PAGESIZE);
+		if (dev->size == 0 || dev->size % dev->align) {
+			ERR("size of emulated Device DAX \"%s\" must be"
+				" a non-zero multiple of page size\n",
+				dev->path);
+			return -1;
+		}
+#endif
+	}
 
 	if (!dev->is_devdax)
 		return 0;
 
-	if (is_dst) {
+	if (is_dst && !dev->is_emulated) {
 		/* XXX - clear only badblocks in range bound by offset/len */
 		if (os_dimm_devdax_clear_badblocks_all(dev->path)) {
 			ERR("failed to clear badblocks on \"%s\"\n",
@@ -480,6 +604,352 @@ cleanup_devices(struct daxio_context *ctx)
 		cleanup_device(&ctx->src);
 }
 
+/*
+ * io_device_write -- (internal) copy data to mapped output and persist them
+ */
+static int
+io_device_write(struct daxio_device *dev, char *addr, const char *buf,
+	size_t len)
+{
+	if (dev->is_emulated) {
+		if (buf)
+			memcpy(addr, buf, len);
+		else
+			memset(addr, 0, len);
+
+		if (pmem_msync(addr, len)) {
+			FAIL("pmem_msync");
+			return -1;
+		}
+		return 0;
+	}
+
+	if (buf)
+		pmem_memcpy_persist(addr, buf, len);
+	else
+		pmem_memset_persist(addr, 0, len);
+
+	return 0;
+}
+
+/*
+ * io_write -- (internal) write data or zeros (if buf is NULL) to the output
+ *	at the specified offset of the I/O
+ */
+static int
+io_write(struct daxio_io *io, size_t off, const char *buf, size_t len)
+{
+	struct daxio_device *dst = &io->ctx->dst;
+
+	if (dst->is_devdax)
+		return io_device_write(dst, dst->addr + dst->offset + off,
+				buf, len);
+
+	assert(buf != NULL);
+
+	size_t cnt = 0;
+	while (cnt < len) {
+		ssize_t wcnt = pwrite(dst->fd, buf + cnt, len - cnt,
+				(off_t)(dst->offset + off + cnt));
+		if (wcnt == -1) {
+			FAIL("pwrite");
+			return -1;
+		}
+		cnt += (size_t)wcnt;
+	}
+
+	return 0;
+}
+
+/*
+ * io_from_device -- (internal) copy a chunk from mapped input, zeroed blocks
+ *	are not written in the sparse mode
+ */
+static int
+io_from_device(struct daxio_io *io, size_t off, size_t len)
+{
+	struct daxio_device *src = &io->ctx->src;
+	const char *addr = src->addr + src->offset + off;
+
+	if (!io->sparse)
+		return io_write(io, off, addr, len);
+
+	size_t start = 0; /* beginning of not yet written data */
+	size_t pos;
+	for (pos = 0; pos < len; pos += DAXIO_ZERO_BLOCK_SIZE) {
+		size_t blen = len - pos < DAXIO_ZERO_BLOCK_SIZE ?
+			len - pos : DAXIO_ZERO_BLOCK_SIZE;
+
+		if (!util_is_zeroed(addr + pos, blen))
+			continue;
+
+		if (pos > start &&
+		    io_write(io, off + start, addr + start, pos - start))
+			return -1;
+
+		util_fetch_and_add64(&io->skipped, blen);
+		start = pos + blen;
+	}
+
+	if (len > start &&
+	    io_write(io, off + start, addr + start, len - start))
+		return -1;
+
+	return 0;
+}
+
+/*
+ * io_from_file -- (internal) read a chunk from the input file directly to
+ *	mapped output
+ *
+ * Holes in a regular input file are not read, they are zeroed in the output
+ * or skipped in the sparse mode.
+ */
+static int
+io_from_file(struct daxio_io *io, size_t off, size_t len)
+{
+	struct daxio_device *src = &io->ctx->src;
+	struct daxio_device *dst = &io->ctx->dst;
+	char *addr = dst->addr + dst->offset + off;
+	size_t start = src->offset + off;
+	size_t end = start + len;
+	size_t pos = start;
+
+	while (pos < end) {
+		size_t data = pos;
+		size_t data_end = end;
+
+		if (src->is_reg) {
+			off_t d = lseek(src->fd, (off_t)pos, SEEK_DATA);
+			if (d >= 0 || errno == ENXIO) {
+				/* ENXIO means there is no data till the end */
+				data = d < 0 || (size_t)d > end ?
+					end : (size_t)d;
+
+				off_t h = data < end ? lseek(src->fd,
+						(off_t)data, SEEK_HOLE) : -1;
+				if (h > (off_t)data && (size_t)h < end)
+					data_end = (size_t)h;
+			}
+		}
+
+		if (data > pos) {
+			if (io->sparse)
+				util_fetch_and_add64(&io->skipped, data - pos);
+			else if (io_device_write(dst, addr + (pos - start),
+					NULL, data - pos))
+				return -1;
+
+			pos = data;
+			continue;
+		}
+
+		size_t cnt = pos;
+		while (cnt < data_end) {
+			ssize_t rcnt = pread(src->fd, addr + (cnt - start),
+					data_end - cnt, (off_t)cnt);
+			if (rcnt == -1) {
+				FAIL("pread");
+				return -1;
+			}
+			if (rcnt == 0) {
+				ERR("unexpected end of input \"%s\"\n",
+						src->path);
+				return -1;
+			}
+			cnt += (size_t)rcnt;
+		}
+
+		if (dst->is_emulated) {
+			if (pmem_msync(addr + (pos - start), data_end - pos)) {
+				FAIL("pmem_msync");
+				return -1;
+			}
+		} else {
+			pmem_persist(addr + (pos - start), data_end - pos);
+		}
+
+		pos = data_end;
+	}
+
+	return 0;
+}
+
+/*
+ * io_progress -- (internal) account processed data and print progress
+ */
+static void
+io_progress(struct daxio_io *io, size_t len)
+{
+	size_t done = util_fetch_and_add64(&io->done, len) + len;
+
+	if (!io->ctx->progress || io->len == 0)
+		return;
+
+	unsigned pct = (unsigned)(done * 100 / io->len);
+
+	os_mutex_lock(&io->lock);
+	if (pct > io->reported || done == io->len) {
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		double secs = (double)(now.tv_sec - io->start.tv_sec) +
+			(double)(now.tv_nsec - io->start.tv_nsec) / 1e9;
+		double mibps = secs > 0 ? (double)done / secs / (1 << 20) : 0;
+
+		io->reported = pct;
+		fprintf(stderr, "\rdaxio: copied %zu of %zu bytes (%u%%), "
+			"%.1f MiB/s", done, io->len, pct, mibps);
+		if (done == io->len)
+			fprintf(stderr, "\n");
+	}
+	os_mutex_unlock(&io->lock);
+}
+
+/*
+ * io_worker -- (internal) process chunks of the I/O until all of them are
+ *	processed or an error occurs
+ */
+static void *
+io_worker(void *arg)
+{
+	struct daxio_io *io = arg;
+	struct daxio_context *ctx = io->ctx;
+
+	while (1) {
+		int32_t error;
+		util_atomic_load_explicit32(&io->error, &error,
+			memory_order_acquire);
+		if (error)
+			break;
+
+		size_t off = util_fetch_and_add64(&io->next, DAXIO_CHUNK_SIZE);
+		if (off >= io->len)
+			break;
+
+		size_t len = io->len - off < DAXIO_CHUNK_SIZE ?
+			io->len - off : DAXIO_CHUNK_SIZE;
+
+		int ret;
+		if (ctx->zero)
+			ret = io_write(io, off, NULL, len);
+		else if (ctx->src.is_devdax)
+			ret = io_from_device(io, off, len);
+		else
+			ret = io_from_file(io, off, len);
+
+		if (ret) {
+			util_atomic_store_explicit32(&io->error, 1,
+				memory_order_release);
+			break;
+		}
+
+		io_progress(io, len);
+	}
+
+	return NULL;
+}
+
+/*
+ * do_parallel_io -- (internal) perform I/O between mapped device and
+ *	a seekable file/device using multiple threads
+ */
+static int
+do_parallel_io(struct daxio_context *ctx)
+{
+	struct daxio_io io;
+	memset(&io, 0, sizeof(io));
+	io.ctx = ctx;
+	io.len = ctx->len;
+
+	/*
+	 * Like dd(1), truncate an existing regular output file at the seek
+	 * offset, so the whole output range reads as zeros.
+	 */
+	if (ctx->dst.is_reg && !ctx->dst.is_zeroed) {
+		if (ftruncate(ctx->dst.fd, (off_t)ctx->dst.offset)) {
+			FAIL("ftruncate");
+			return -1;
+		}
+		ctx->dst.is_zeroed = 1;
+	}
+
+	io.sparse = ctx->sparse || ctx->dst.is_zeroed;
+
+	/* do not read beyond the end of a regular input file */
+	if (!ctx->zero && ctx->src.is_reg) {
+		size_t avail = ctx->src.size > ctx->src.offset ?
+			ctx->src.size - ctx->src.offset : 0;
+		if (io.len > avail)
+			io.len = avail;
+	}
+
+	unsigned nthreads = ctx->nthreads;
+	if (nthreads == 0) {
+		long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+		nthreads = ncpus > DAXIO_MAX_THREADS ?
+			DAXIO_MAX_THREADS : (ncpus > 0 ? (unsigned)ncpus : 1);
+	}
+
+	size_t nchunks = (io.len + DAXIO_CHUNK_SIZE - 1) / DAXIO_CHUNK_SIZE;
+	if (nthreads > nchunks)
+		nthreads = nchunks ? (unsigned)nchunks : 1;
+
+	os_thread_t *threads = NULL;
+	if (nthreads > 1) {
+		threads = malloc((nthreads - 1) * sizeof(*threads));
+		if (threads == NULL) {
+			FAIL("malloc");
+			return -1;
+		}
+	}
+
+	os_mutex_init(&io.lock);
+	clock_gettime(CLOCK_MONOTONIC, &io.start);
+
+	/* the calling thread is one of the workers */
+	unsigned started = 0;
+	for (; started < nthreads - 1; ++started) {
+		if (os_thread_create(&threads[started], NULL, io_worker, &io))
+			break; /* the running workers process the rest */
+	}
+
+	io_worker(&io);
+
+	for (unsigned i = 0; i < started; ++i)
+		os_thread_join(&threads[i], NULL);
+
+	free(threads);
+	os_mutex_destroy(&io.lock);
+
+	/* zeroed blocks at the end of the output file were not written */
+	if (!io.error && io.sparse && ctx->dst.is_reg) {
+		struct stat stbuf;
+		if (fstat(ctx->dst.fd, &stbuf)) {
+			FAIL("fstat");
+			io.error = 1;
+		} else if ((size_t)stbuf.st_size < ctx->dst.offset + io.len &&
+			ftruncate(ctx->dst.fd,
+				(off_t)(ctx->dst.offset + io.len))) {
+			FAIL("ftruncate");
+			io.error = 1;
+		}
+	}
+
+	if (io.error) {
+		ERR("failed to perform I/O\n");
+		return -1;
+	}
+
+	if (io.len != ctx->len)
+		ERR("requested size %zu larger than source\n", ctx->len);
+
+	if (ctx->progress && io.skipped)
+		ERR("skipped %zu zeroed bytes\n", io.skipped);
+
+	ERR("copied %zu bytes to device \"%s\"\n", io.len, ctx->dst.path);
+	return 0;
+}
+
 /*
  * do_io -- (internal) write data to device/file
  */
@@ -497,16 +967,23 @@ do_io(struct ndctl_ctx *ndctl_ctx, struct daxio_context *ctx)
 			ERR("output offset beyond device size");
 			return -1;
 		}
+	}
 
-		char *dst_addr = ctx->dst.addr + ctx->dst.offset;
-		pmem_memset_persist(dst_addr, 0, ctx->len);
-		cnt = (ssize_t)ctx->len;
-	} else if (ctx->src.is_devdax && ctx->dst.is_devdax) {
-		/* memcpy between src and dst */
-		char *src_addr = ctx->src.addr + ctx->src.offset;
-		char *dst_addr = ctx->dst.addr + ctx->dst.offset;
-		pmem_memcpy_persist(dst_addr, src_addr, ctx->len);
-		cnt = (ssize_t)ctx->len;
+	/*
+	 * Only I/O involving stdin/stdout or other non-seekable files has
+	 * to be performed sequentially.
+	 */
+	if (ctx->zero) {
+		if (ctx->dst.is_devdax)
+			return do_parallel_io(ctx);
+	} else if (!ctx->src.is_stream && !ctx->dst.is_stream &&
+	    (ctx->src.is_devdax || ctx->dst.is_devdax)) {
+		return do_parallel_io(ctx);
+	}
+
+	if (ctx->zero) {
+		ERR("output is not device dax\n");
+		return -1;
 	} else if (ctx->src.is_devdax) {
 		/* write to file directly from mmap'ed src */
 		char *src_addr = ctx->src.addr + ctx->src.offset;
@@ -1443,3 +1443,37 @@ util_pool_clear_badblocks(const char *path, int create)
 
 	return 0;
 }
+
+/*
+ * util_print_copy_progress -- print percentage of copied data and average
+ *	throughput, used as a progress callback of sync and transform
+ */
+int
+util_print_copy_progress(size_t copied, size_t total, void *arg)
+{
+	struct copy_progress *pr = arg;
+	struct timespec now;
+
+	/* nothing to be copied in this pass */
+	if (total == 0)
+		return 0;
+
+	os_clock_gettime(CLOCK_MONOTONIC, &now);
+
+	/* a new copy pass is reported with nothing copied */
+	if (copied == 0)
+		pr->start = now;
+
+	double secs = (double)(now.tv_sec - pr->start.tv_sec) +
+		(double)(now.tv_nsec - pr->start.tv_nsec) / 1e9;
+	double mibps = secs > 0 ? (double)copied / secs / (1 << 20) : 0;
+	double pct = total ? (double)copied * 100 / (double)total : 100;
+
+	printf("\rcopied %zu of %zu bytes (%.1f%%), %.1f MiB/s",
+		copied, total, pct, mibps);
+	if (copied >= total)
+		printf("\n");
+	fflush(stdout);
+
+	return 0;
+}
@@ -38,6 +38,7 @@
 #include <stddef.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <time.h>
 
 #include "queue.h"
 #include "log.h"
@@ -237,6 +238,15 @@ int util_heap_get_bitmap_params(uint64_t block_size, uint64_t *nallocsp,
 
 int util_pool_clear_badblocks(const char *path, int create);
 
+/*
+ * copy_progress -- state of printing progress of sync and transform
+ */
+struct copy_progress {
+	struct timespec start;	/* start time of the current copy pass */
+};
+
+int util_print_copy_progress(size_t copied, size_t total, void *arg);
+
 static const struct range ENTIRE_UINT64 = {
 	{ NULL, NULL },	/* range */
 	0,		/* first */
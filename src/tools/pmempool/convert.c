@@ -45,24 +45,51 @@
 #include <sys/mman.h>
 #include <endian.h>
 #include "common.h"
+#include "output.h"
 #include "set.h"
 #include "libpmem.h"
 #include "convert.h"
 #include "util_pmem.h"
+#include "os.h"
+
+/*
+ * pmempool_convert_context -- state of the conversion
+ */
+struct pmempool_convert_context {
+	int progress;		/* print progress and throughput */
+	size_t written;		/* bytes persisted by the current step */
+	unsigned reported;	/* last reported percentage of progress */
+	struct timespec start;	/* start time of the current step */
+};
+
+static struct pmempool_convert_context Convert_ctx;
 
 static const char * const help_str =
 "Upgrade pool files layout version.\n"
 "\n"
+"Common options:\n"
+"  -p, --progress       print progress and throughput of the conversion\n"
+"  -h, --help           display this help and exit\n"
+"\n"
 "For complete documentation see %s-convert(1) manual page.\n"
 ;
 
+/*
+ * long_options -- command line options
+ */
+static const struct option long_options[] = {
+	{"help",	no_argument,		NULL,	'h'},
+	{"progress",	no_argument,		NULL,	'p'},
+	{NULL,		0,			NULL,	 0 },
+};
+
 /*
  * print_usage -- print application usage short description
  */
 static void
 print_usage(char *appname)
 {
-	printf("Usage: %s convert <file>\n", appname);
+	printf("Usage: %s convert [<options>] <file>\n", appname);
 }
 
 /*
@@ -131,6 +158,80 @@ void
 pmempool_convert_persist(void *poolset, const void *addr, size_t len)
 {
 	pool_set_file_persist(poolset, addr, len);
+	Convert_ctx.written += len;
+}
+
+/*
+ * convert_elapsed -- (internal) return seconds elapsed since the current
+ *	conversion step has started
+ */
+static double
+convert_elapsed(void)
+{
+	struct timespec now;
+	os_clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (double)(now.tv_sec - Convert_ctx.start.tv_sec) +
+		(double)(now.tv_nsec - Convert_ctx.start.tv_nsec) / 1e9;
+}
+
+/*
+ * pmempool_convert_progress -- report progress of the current conversion
+ *	step, 'done' and 'total' are sizes of the processed metadata
+ */
+void
+pmempool_convert_progress(size_t done, size_t total)
+{
+	if (!Convert_ctx.progress || total == 0)
+		return;
+
+	/* report only whole percents */
+	unsigned pct = (unsigned)(done * 100 / total);
+	if (pct == Convert_ctx.reported && done < total)
+		return;
+	Convert_ctx.reported = pct;
+
+	double secs = convert_elapsed();
+	double mibps = secs > 0 ? (double)done / secs / (1 << 20) : 0;
+
+	printf("\rprocessed %zu of %zu bytes (%.1f%%), %.1f MiB/s",
+		done, total, (double)pct, mibps);
+	if (done >= total)
+		printf("\n");
+	fflush(stdout);
+}
+
+/*
+ * pmempool_convert_parse_args -- (internal) parse command line arguments
+ */
+static int
+pmempool_convert_parse_args(char *appname, int argc, char *argv[],
+	const char **file)
+{
+	int opt;
+	while ((opt = getopt_long(argc, argv, "hp",
+			long_options, NULL)) != -1) {
+		switch (opt) {
+		case 'h':
+			pmempool_convert_help(appname);
+			exit(EXIT_SUCCESS);
+		case 'p':
+			Convert_ctx.progress = 1;
+			break;
+		default:
+			print_usage(appname);
+			return -1;
+		}
+	}
+
+	if (optind + 1 != argc) {
+		print_usage(appname);
+		return -1;
+	}
+
+	*file = argv[optind];
+
+	return 0;
 }
 
 /*
@@ -139,14 +240,11 @@ pmempool_convert_persist(void *poolset, const void *addr, size_t len)
 int
 pmempool_convert_func(char *appname, int argc, char *argv[])
 {
-	if (argc != 2) {
-		print_usage(appname);
-
+	const char *f;
+	if (pmempool_convert_parse_args(appname, argc, argv, &f))
 		return -1;
-	}
 
 	int ret = 0;
-	const char *f = argv[1];
 
 	struct pmem_pool_params params;
 	if (pmem_pool_parse_params(f, &params, 1)) {
@@ -227,8 +325,16 @@ pmempool_convert_func(char *appname, int argc, char *argv[])
 		}
 	}
 
+	/*
+	 * The major version in the pool headers is updated after each step,
+	 * so an interrupted conversion resumes from the last unfinished step.
+	 */
 	uint32_t i;
 	for (i = m; i < COUNT_OF(version_convert); ++i) {
+		Convert_ctx.written = 0;
+		Convert_ctx.reported = 0;
+		os_clock_gettime(CLOCK_MONOTONIC, &Convert_ctx.start);
+
 		if (version_convert[i](psf, pop) != 0) {
 			fprintf(stderr, "Failed to convert the pool\n");
 			break;
@@ -251,16 +357,27 @@ pmempool_convert_func(char *appname, int argc, char *argv[])
 						sizeof(struct pool_hdr));
 				}
 			}
+
+			if (Convert_ctx.progress) {
+				double secs = convert_elapsed();
+				printf("converted from version %" PRIu32
+					" to %" PRIu32 " in %.3f s, "
+					"%zu bytes written (%.1f MiB/s)\n",
+					i, target_m, secs, Convert_ctx.written,
+					secs > 0 ? (double)Convert_ctx.written /
+					secs / (1 << 20) : 0);
+			}
 		}
 	}
 
+	/*
+	 * Each conversion step persists all of its modifications, so there
+	 * is no need to flush the whole pool here.
+	 */
 	if (i != m) /* at least one step has been performed */
 		printf("The pool has been converted to version %" PRIu32 "\n",
 		    i);
 
-	util_persist_auto(psf->poolset->replica[0]->part[0].is_dev_dax, pop,
-			psf->size);
-
 out:
 	for (unsigned r = 0; r < psf->poolset->nreplicas; ++r) {
 		struct pool_replica *rep = psf->poolset->replica[r];
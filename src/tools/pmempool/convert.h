@@ -40,6 +40,7 @@ int pmempool_convert_func(char *appname, int argc, char *argv[]);
 void pmempool_convert_help(char *appname);
 
 void pmempool_convert_persist(void *poolset, const void *addr, size_t len);
+void pmempool_convert_progress(size_t done, size_t total);
 
 int convert_v1_v2(void *poolset, void *addr);
 int convert_v3_v4(void *poolset, void *addr);
@@ -35,6 +35,7 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <inttypes.h>
 #include <string.h>
 #include <assert.h>
@@ -333,12 +334,14 @@ redo_recover(struct redo_log *redo, size_t nentries)
 	pmempool_convert_persist(poolset, val, sizeof(uint64_t));
 }
 
-static int
-pfree(uint64_t *off)
+/*
+ * pfree_offset -- (internal) free the object at the specified offset
+ */
+static void
+pfree_offset(uint64_t offset)
 {
-	uint64_t offset = *off;
 	if (offset == 0)
-		return 0;
+		return;
 
 	PMEMoid oid;
 	oid.off = offset;
@@ -351,9 +354,10 @@ pfree(uint64_t *off)
 		chdr->type = CHUNK_TYPE_FREE;
 		pmempool_convert_persist(poolset, &chdr->type,
 			sizeof(chdr->type));
-		*off = 0;
-		pmempool_convert_persist(poolset, off, sizeof(*off));
-		return 0;
+		return;
+	} else if (chdr->type == CHUNK_TYPE_FREE) {
+		/* freed by an interrupted run of the conversion */
+		return;
 	} else if (chdr->type != CHUNK_TYPE_RUN) {
 		assert(0);
 	}
@@ -372,6 +376,19 @@ pfree(uint64_t *off)
 	run->bitmap[bpos] &= ~bmask;
 	pmempool_convert_persist(poolset, &run->bitmap[bpos],
 		sizeof(run->bitmap[bpos]));
+}
+
+/*
+ * pfree -- (internal) free the object and clear the persistent offset
+ */
+static int
+pfree(uint64_t *off)
+{
+	if (*off == 0)
+		return 0;
+
+	pfree_offset(*off);
+
 	*off = 0;
 	pmempool_convert_persist(poolset, off, sizeof(*off));
 
@@ -395,33 +412,68 @@ lane_list_recover(struct lane_list_section *list)
 	return 0;
 }
 
-static void
+/*
+ * foreach_clear_undo_list -- (internal) process and clear the undo list
+ *
+ * The list entries of objects which are not freed are cleared only after
+ * the whole list has been walked, in reverse order. If the conversion is
+ * interrupted, the entries which are still set form a prefix of the list,
+ * so the next run can walk it again.
+ */
+static int
 foreach_clear_undo_list(struct list_head *head,
-	void (*cb)(PMEMoid oid), int free)
+	void (*cb)(PMEMoid oid), int free_obj)
 {
-	PMEMoid iter = head->pe_first;
-	PMEMoid next = {0, 0};
+	uint64_t *offs = NULL;
+	size_t noffs = 0;
+	size_t maxoffs = 0;
 
-	/*
-	 * Ff the list is empty the condition will be true because next is
-	 * initialized with zeroes - same as the first element of an empty list
-	 */
-	while (next.off != head->pe_first.off) {
-		next = D_RW_OBJ(iter)->oobh.oob.pe_next;
+	/* a zeroed entry has been cleared by an interrupted run */
+	PMEMoid iter = head->pe_first;
+	while (iter.off != 0) {
+		PMEMoid next = D_RW_OBJ(iter)->oobh.oob.pe_next;
 
 		if (cb)
 			cb(iter);
 
-		if (free)
-			pfree(&iter.off);
-		else
-			memset(&D_RW_OBJ(iter)->oobh.oob, 0,
-				sizeof(struct list_entry));
+		/* iter is a local copy, so only the object is modified */
+		if (free_obj) {
+			pfree_offset(iter.off);
+		} else {
+			if (noffs == maxoffs) {
+				maxoffs = maxoffs ? 2 * maxoffs : 64;
+				uint64_t *n = realloc(offs,
+					maxoffs * sizeof(*offs));
+				if (n == NULL) {
+					perror("realloc");
+					free(offs);
+					return -1;
+				}
+				offs = n;
+			}
+			offs[noffs++] = iter.off;
+		}
+
+		if (next.off == head->pe_first.off)
+			break;
 
 		iter = next;
-	};
+	}
+
+	while (noffs > 0) {
+		PMEMoid oid;
+		oid.off = offs[--noffs];
+
+		struct list_entry *oob = &D_RW_OBJ(oid)->oobh.oob;
+		memset(oob, 0, sizeof(*oob));
+		pmempool_convert_persist(poolset, oob, sizeof(*oob));
+	}
+
+	free(offs);
 
 	memset(head, 0, sizeof(*head));
+
+	return 0;
 }
 
 static void
@@ -455,41 +507,71 @@ restore_set_cache_range(PMEMoid cache)
 static int
 lane_tx_abort(struct lane_tx_layout *tx)
 {
-	foreach_clear_undo_list(&tx->undo_alloc,
-		NULL, 1);
-	foreach_clear_undo_list(&tx->undo_free,
-		NULL, 0);
-	foreach_clear_undo_list(&tx->undo_set,
-		restore_set_range, 1);
-	foreach_clear_undo_list(&tx->undo_set_cache,
-		restore_set_cache_range, 1);
+	if (foreach_clear_undo_list(&tx->undo_alloc,
+			NULL, 1))
+		return -1;
+	if (foreach_clear_undo_list(&tx->undo_free,
+			NULL, 0))
+		return -1;
+	if (foreach_clear_undo_list(&tx->undo_set,
+			restore_set_range, 1))
+		return -1;
 
-	return 0;
+	return foreach_clear_undo_list(&tx->undo_set_cache,
+		restore_set_cache_range, 1);
 }
 
 static int
 lane_tx_commit(struct lane_tx_layout *tx)
 {
-	foreach_clear_undo_list(&tx->undo_alloc, NULL, 0);
-	foreach_clear_undo_list(&tx->undo_free, NULL, 1);
-	foreach_clear_undo_list(&tx->undo_set, NULL, 1);
-	foreach_clear_undo_list(&tx->undo_set_cache, NULL, 1);
+	if (foreach_clear_undo_list(&tx->undo_alloc, NULL, 0))
+		return -1;
+	if (foreach_clear_undo_list(&tx->undo_free, NULL, 1))
+		return -1;
+	if (foreach_clear_undo_list(&tx->undo_set, NULL, 1))
+		return -1;
 
-	return 0;
+	return foreach_clear_undo_list(&tx->undo_set_cache, NULL, 1);
 }
 
+/*
+ * lane_tx_recover -- (internal) recover the transaction lane section
+ *
+ * The state is not reset here, it is cleared together with the whole lane.
+ * An interrupted conversion has to commit the transaction again.
+ */
 static int
 lane_tx_recover(struct lane_tx_layout *tx)
 {
-	if (tx->state == TX_STATE_NONE) { /* abort */
+	if (tx->state == TX_STATE_NONE) /* abort */
 		return lane_tx_abort(tx);
-	} else if (tx->state == TX_STATE_COMMITTED) {
-		tx->state = TX_STATE_NONE;
-
+	else if (tx->state == TX_STATE_COMMITTED)
 		return lane_tx_commit(tx);
-	} else {
+	else
 		return -1;
+}
+
+/*
+ * Number of lanes recovered before they are cleared. Clearing the lanes
+ * checkpoints the conversion, an interrupted conversion recovers again only
+ * lanes from the last unfinished batch.
+ */
+#define LANES_BATCH 64
+
+/*
+ * lane_is_zeroed -- (internal) check whether the lane has been already
+ *	recovered and cleared
+ */
+static int
+lane_is_zeroed(struct lane_layout *lane)
+{
+	const uint64_t *data = (const uint64_t *)lane;
+	for (size_t i = 0; i < sizeof(*lane) / sizeof(*data); ++i) {
+		if (data[i])
+			return 0;
 	}
+
+	return 1;
 }
 
 int
@@ -502,17 +584,41 @@ convert_v1_v2(void *psf, void *addr)
 
 	struct lane_layout *lanes =
 		(struct lane_layout *)((char *)addr + pop->lanes_offset);
-	for (uint64_t i = 0; i < pop->nlanes; ++i) {
-		lane_alloc_recover((struct allocator_lane_section *)
-			&lanes[i].sections[LANE_SECTION_ALLOCATOR]);
-		lane_list_recover((struct lane_list_section *)
-			&lanes[i].sections[LANE_SECTION_LIST]);
-		lane_tx_recover((struct lane_tx_layout *)
-			&lanes[i].sections[LANE_SECTION_TRANSACTION]);
+	for (uint64_t b = 0; b < pop->nlanes; b += LANES_BATCH) {
+		uint64_t n = pop->nlanes - b;
+		if (n > LANES_BATCH)
+			n = LANES_BATCH;
+
+		int recovered = 0;
+		for (uint64_t i = b; i < b + n; ++i) {
+			struct lane_layout *lane = &lanes[i];
+
+			/*
+			 * A cleared lane does not need recovery, it has been
+			 * converted by an interrupted run of the tool already.
+			 */
+			if (lane_is_zeroed(lane))
+				continue;
+
+			lane_alloc_recover((struct allocator_lane_section *)
+				&lane->sections[LANE_SECTION_ALLOCATOR]);
+			lane_list_recover((struct lane_list_section *)
+				&lane->sections[LANE_SECTION_LIST]);
+			if (lane_tx_recover((struct lane_tx_layout *)
+				&lane->sections[LANE_SECTION_TRANSACTION]))
+				return -1;
+			recovered = 1;
+		}
+
+		if (recovered) {
+			memset(&lanes[b], 0, n * sizeof(struct lane_layout));
+			pmempool_convert_persist(poolset, &lanes[b],
+				n * sizeof(struct lane_layout));
+		}
+
+		pmempool_convert_progress((b + n) * sizeof(struct lane_layout),
+			pop->nlanes * sizeof(struct lane_layout));
 	}
-	memset(lanes, 0, pop->nlanes * sizeof(struct lane_layout));
-	pmempool_convert_persist(poolset, lanes,
-		pop->nlanes * sizeof(struct lane_layout));
 
 	return 0;
 }
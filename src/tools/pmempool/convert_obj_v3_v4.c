@@ -45,6 +45,7 @@
 #define PMEMOBJ_MAX_LAYOUT ((size_t)1024)
 #define OBJ_DSC_P_SIZE		2048
 #define OBJ_DSC_P_UNUSED	(OBJ_DSC_P_SIZE - PMEMOBJ_MAX_LAYOUT - 40)
+#define OBJ_PMEM_RESERVED_SIZE	512
 
 struct pool_hdr {
 	char data[4096];
@@ -112,7 +113,7 @@ struct pmemobjpool {
 
 	uint64_t conversion_flags;
 
-	char pmem_reserved[512]; /* must be zeroed */
+	char pmem_reserved[OBJ_PMEM_RESERVED_SIZE]; /* must be zeroed */
 
 	/* some run-time state, allocated out of memory pool... */
 	void *addr;		/* mapped region */
@@ -190,23 +191,36 @@ obj_root_restore_size(void *psf, struct pmemobjpool *pop)
 
 #define CONVERSION_FLAG_OLD_SET_CACHE ((1ULL) << 0)
 
+/*
+ * CONVERT_V3_V4_METASIZE -- size of the metadata processed by the conversion
+ */
+#define CONVERT_V3_V4_METASIZE\
+	(sizeof(uint64_t) + OBJ_PMEM_RESERVED_SIZE + sizeof(uint64_t))
+
 int
 convert_v3_v4(void *psf, void *addr)
 {
 	struct pmemobjpool *pop = addr;
+	size_t done = 0;
 
 	assert(sizeof(struct pmemobjpool) == 8192);
 
 	pop->conversion_flags = CONVERSION_FLAG_OLD_SET_CACHE;
 	pmempool_convert_persist(psf, &pop->conversion_flags,
 		sizeof(pop->conversion_flags));
+	done += sizeof(pop->conversion_flags);
+	pmempool_convert_progress(done, CONVERT_V3_V4_METASIZE);
 
 	/* zero out the pmem reserved part of the header */
 	memset(pop->pmem_reserved, 0, sizeof(pop->pmem_reserved));
 	pmempool_convert_persist(psf, pop->pmem_reserved,
 		sizeof(pop->pmem_reserved));
+	done += sizeof(pop->pmem_reserved);
+	pmempool_convert_progress(done, CONVERT_V3_V4_METASIZE);
 
 	obj_root_restore_size(psf, pop);
+	done += sizeof(pop->root_size);
+	pmempool_convert_progress(done, CONVERT_V3_V4_METASIZE);
 
 	return 0;
 }
@@ -97,6 +97,7 @@ struct pmempool_info_args {
 		uint64_t lane_sections;
 		bool lanes_recovery;
 		bool ignore_empty_obj;
+		bool json;		/* print statistics in JSON format */
 		uint64_t chunk_types;
 		size_t replica;
 		struct ranges lane_ranges;
@@ -116,9 +117,21 @@ struct pmem_blk_stats {
 	uint32_t noflag;	/* number of blocks not marked with any flag */
 };
 
+/*
+ * Runs are grouped by fill ratio in 10% steps, the last bucket
+ * holds completely filled runs.
+ */
+#define RUN_FILL_BUCKETS 11
+
+/*
+ * Free chunks are grouped by the most significant bit of their size idx.
+ */
+#define FREE_CHUNK_BUCKETS 32
+
 struct pmem_obj_class_stats {
 	uint64_t n_units;
 	uint64_t n_used;
+	uint64_t n_runs_fill[RUN_FILL_BUCKETS];
 };
 
 struct pmem_obj_zone_stats {
@@ -126,6 +139,8 @@ struct pmem_obj_zone_stats {
 	uint64_t n_chunks_type[MAX_CHUNK_TYPE];
 	uint64_t size_chunks;
 	uint64_t size_chunks_type[MAX_CHUNK_TYPE];
+	uint64_t n_free_chunks[FREE_CHUNK_BUCKETS];
+	uint64_t max_free_chunk;
 	struct pmem_obj_class_stats class_stats[MAX_ALLOCATION_CLASSES];
 };
 
@@ -136,6 +151,12 @@ struct pmem_obj_type_stats {
 	uint64_t n_bytes;
 };
 
+struct pmem_obj_size_stats {
+	uint64_t user_size;	/* usable size of an object */
+	uint64_t real_size;	/* size of the memory block with header */
+	uint64_t n_objects;
+};
+
 struct pmem_obj_stats {
 	uint64_t n_total_objects;
 	uint64_t n_total_bytes;
@@ -143,6 +164,9 @@ struct pmem_obj_stats {
 	uint64_t n_zones_used;
 	struct pmem_obj_zone_stats *zone_stats;
 	TAILQ_HEAD(obj_type_stats_head, pmem_obj_type_stats) type_stats;
+	struct pmem_obj_size_stats *size_stats; /* sorted by sizes */
+	size_t n_size_stats;
+	size_t max_size_stats;
 };
 
 /*
@@ -166,7 +190,6 @@ struct pmem_info {
 		size_t size;
 		struct pmem_obj_stats stats;
 		uint64_t uuid_lo;
-		uint64_t objid;
 	} obj;
 	struct {
 		struct pmemcto *pcp;
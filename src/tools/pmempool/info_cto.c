@@ -74,6 +74,7 @@ info_cto_descriptor(struct pmem_info *pip)
 	outv_field(v, "Base address", "%p", (void *)pcp->addr);
 	outv_field(v, "Size", "0x%zx", (size_t)pcp->size);
 	outv_field(v, "Consistent", "%d", pcp->consistent);
+	outv_field(v, "Checkpoint", "%ju", (uintmax_t)pcp->checkpoint);
 	outv_field(v, "Root pointer", "%p", (void *)pcp->root);
 }
 
@@ -41,6 +41,7 @@
 #include <sys/mman.h>
 #include <assert.h>
 #include <inttypes.h>
+#include <unistd.h>
 
 #include "alloc_class.h"
 
@@ -49,9 +50,19 @@
 #include "output.h"
 #include "info.h"
 #include "util.h"
+#include "os_thread.h"
 
 #define BITMAP_BUFF_SIZE 1024
 
+/* maximum number of threads used for collecting statistics */
+#define INFO_OBJ_MAX_THREADS 16
+
+/* maximum number of recommended allocation classes */
+#define INFO_OBJ_MAX_RECOMMENDED 8
+
+/* share of objects covered by the recommended allocation classes */
+#define INFO_OBJ_RECOMMENDED_COVERAGE 0.9
+
 #define OFF_TO_PTR(pop, off) ((void *)((uintptr_t)(pop) + (off)))
 
 #define PTR_TO_OFF(pop, ptr) ((uintptr_t)(ptr) - (uintptr_t)(pop))
@@ -228,6 +239,151 @@ pmem_obj_stats_get_type(struct pmem_obj_stats *stats, uint64_t type_num)
 	return type;
 }
 
+/*
+ * pmem_obj_stats_add_size -- add objects of specified sizes to stats
+ */
+static void
+pmem_obj_stats_add_size(struct pmem_obj_stats *stats, uint64_t user_size,
+	uint64_t real_size, uint64_t n_objects)
+{
+	/* binary search for the sizes, entries are sorted by sizes */
+	size_t l = 0;
+	size_t r = stats->n_size_stats;
+	while (l < r) {
+		size_t m = l + (r - l) / 2;
+		struct pmem_obj_size_stats *size = &stats->size_stats[m];
+		if (size->user_size < user_size ||
+			(size->user_size == user_size &&
+			size->real_size < real_size)) {
+			l = m + 1;
+		} else {
+			r = m;
+		}
+	}
+
+	if (l < stats->n_size_stats &&
+		stats->size_stats[l].user_size == user_size &&
+		stats->size_stats[l].real_size == real_size) {
+		stats->size_stats[l].n_objects += n_objects;
+		return;
+	}
+
+	if (stats->n_size_stats == stats->max_size_stats) {
+		size_t max = stats->max_size_stats ?
+			2 * stats->max_size_stats : 64;
+		struct pmem_obj_size_stats *sizes = realloc(stats->size_stats,
+				max * sizeof(*sizes));
+		if (!sizes) {
+			outv_err("cannot allocate memory for size stats\n");
+			exit(EXIT_FAILURE);
+		}
+
+		stats->size_stats = sizes;
+		stats->max_size_stats = max;
+	}
+
+	memmove(&stats->size_stats[l + 1], &stats->size_stats[l],
+		(stats->n_size_stats - l) * sizeof(stats->size_stats[0]));
+	stats->n_size_stats++;
+
+	stats->size_stats[l].user_size = user_size;
+	stats->size_stats[l].real_size = real_size;
+	stats->size_stats[l].n_objects = n_objects;
+}
+
+/*
+ * pmem_obj_stats_add_object -- add object to stats, returns non-zero value
+ *	if the object is filtered out by the type numbers range
+ */
+static int
+pmem_obj_stats_add_object(struct pmem_info *pip, struct pmem_obj_stats *stats,
+	const struct memory_block *m)
+{
+	uint64_t type_num = m->m_ops->get_extra(m);
+
+	if (!util_ranges_contain(&pip->args.obj.type_ranges, type_num))
+		return 1;
+
+	uint64_t real_size = m->m_ops->get_real_size(m);
+	stats->n_total_objects++;
+	stats->n_total_bytes += real_size;
+
+	struct pmem_obj_type_stats *type_stats =
+		pmem_obj_stats_get_type(stats, type_num);
+
+	type_stats->n_objects++;
+	type_stats->n_bytes += real_size;
+
+	/* sizes of objects are printed only in JSON format */
+	if (pip->args.obj.json)
+		pmem_obj_stats_add_size(stats, m->m_ops->get_user_size(m),
+				real_size, 1);
+
+	return 0;
+}
+
+/*
+ * pmem_obj_stats_add_run_fill -- add run's fill ratio to stats
+ */
+static void
+pmem_obj_stats_add_run_fill(struct pmem_obj_zone_stats *stats,
+	uint8_t class_id, uint32_t used, uint32_t units)
+{
+	if (units)
+		stats->class_stats[class_id].n_runs_fill[(uint64_t)used *
+			(RUN_FILL_BUCKETS - 1) / units]++;
+}
+
+/*
+ * pmem_obj_stats_add_free_chunk -- add free chunk to stats
+ */
+static void
+pmem_obj_stats_add_free_chunk(struct pmem_obj_zone_stats *stats,
+	uint32_t size_idx)
+{
+	if (!size_idx)
+		return;
+
+	stats->n_free_chunks[util_mssb_index(size_idx)]++;
+	if (size_idx > stats->max_free_chunk)
+		stats->max_free_chunk = size_idx;
+}
+
+/*
+ * pmem_obj_stats_merge -- merge objects' stats collected by a single thread
+ */
+static void
+pmem_obj_stats_merge(struct pmem_obj_stats *dest, struct pmem_obj_stats *src)
+{
+	dest->n_total_objects += src->n_total_objects;
+	dest->n_total_bytes += src->n_total_bytes;
+	dest->n_zones_used += src->n_zones_used;
+
+	while (!TAILQ_EMPTY(&src->type_stats)) {
+		struct pmem_obj_type_stats *type =
+			TAILQ_FIRST(&src->type_stats);
+		TAILQ_REMOVE(&src->type_stats, type, next);
+
+		struct pmem_obj_type_stats *dest_type =
+			pmem_obj_stats_get_type(dest, type->type_num);
+		dest_type->n_objects += type->n_objects;
+		dest_type->n_bytes += type->n_bytes;
+
+		free(type);
+	}
+
+	for (size_t i = 0; i < src->n_size_stats; i++) {
+		struct pmem_obj_size_stats *size = &src->size_stats[i];
+		pmem_obj_stats_add_size(dest, size->user_size,
+				size->real_size, size->n_objects);
+	}
+
+	free(src->size_stats);
+	src->size_stats = NULL;
+	src->n_size_stats = 0;
+	src->max_size_stats = 0;
+}
+
 /*
  * info_obj_redo -- print redo log entries
  */
@@ -531,34 +687,39 @@ info_obj_zone_hdr(struct pmem_info *pip, int v, struct zone_header *zone)
 	outv_field(v, "Size idx", "%u", zone->size_idx);
 }
 
+/*
+ * info_obj_walk -- state of a walk over the zones of the heap
+ *
+ * The zones may be walked by many threads at once, each one with its own
+ * walk and objects' statistics, see info_obj_zones_stats.
+ */
+struct info_obj_walk {
+	struct pmem_info *pip;
+	struct pmem_obj_stats *stats;	/* objects' statistics */
+	uint64_t objid;			/* id of the next object */
+};
+
 /*
  * info_obj_object -- print information about object
  */
 static void
-info_obj_object(struct pmem_info *pip, const struct memory_block *m,
+info_obj_object(struct info_obj_walk *walk, const struct memory_block *m,
 	uint64_t objid)
 {
+	struct pmem_info *pip = walk->pip;
+
 	if (!util_ranges_contain(&pip->args.ranges, objid))
 		return;
 
-	uint64_t type_num = m->m_ops->get_extra(m);
-
-	if (!util_ranges_contain(&pip->args.obj.type_ranges, type_num))
+	if (pmem_obj_stats_add_object(pip, walk->stats, m))
 		return;
 
-	uint64_t real_size = m->m_ops->get_real_size(m);
-	pip->obj.stats.n_total_objects++;
-	pip->obj.stats.n_total_bytes += real_size;
-
-	struct pmem_obj_type_stats *type_stats =
-		pmem_obj_stats_get_type(&pip->obj.stats, type_num);
-
-	type_stats->n_objects++;
-	type_stats->n_bytes += real_size;
-
 	int vid = pip->args.obj.vobjects;
 	int v = pip->args.obj.vobjects;
 
+	if (!outv_check(v))
+		return;
+
 	outv_indent(v, 1);
 	info_obj_object_hdr(pip, v, vid, m, objid);
 	outv_indent(v, -1);
@@ -570,7 +731,11 @@ info_obj_object(struct pmem_info *pip, const struct memory_block *m,
 static void
 info_obj_run_bitmap(int v, struct chunk_run *run, uint32_t bsize)
 {
-	if (outv_check(v) && outv_check(VERBOSE_MAX)) {
+	/* get_bitmap_str uses a static buffer */
+	if (!outv_check(v))
+		return;
+
+	if (outv_check(VERBOSE_MAX)) {
 		/* print all values from bitmap for higher verbosity */
 		for (int i = 0; i < MAX_BITMAP_VALUES; i++) {
 			outv(VERBOSE_MAX, "%s\n",
@@ -612,12 +777,12 @@ info_obj_memblock_is_root(struct pmem_info *pip, const struct memory_block *m)
 static int
 info_obj_run_cb(const struct memory_block *m, void *arg)
 {
-	struct pmem_info *pip = arg;
+	struct info_obj_walk *walk = arg;
 
-	if (info_obj_memblock_is_root(pip, m))
+	if (info_obj_memblock_is_root(walk->pip, m))
 		return 0;
 
-	info_obj_object(pip, m, pip->obj.objid++);
+	info_obj_object(walk, m, walk->objid++);
 
 	return 0;
 }
@@ -626,10 +791,11 @@ info_obj_run_cb(const struct memory_block *m, void *arg)
  * info_obj_chunk -- print chunk info
  */
 static void
-info_obj_chunk(struct pmem_info *pip, uint64_t c, uint64_t z,
+info_obj_chunk(struct info_obj_walk *walk, uint64_t c, uint64_t z,
 	struct chunk_header *chunk_hdr, struct chunk *chunk,
 	struct pmem_obj_zone_stats *stats)
 {
+	struct pmem_info *pip = walk->pip;
 	int v = pip->args.obj.vchunkhdr;
 	outv(v, "\n");
 	outv_field(v, "Chunk", "%lu", c);
@@ -661,8 +827,11 @@ info_obj_chunk(struct pmem_info *pip, uint64_t c, uint64_t z,
 
 			/* skip root object */
 			if (!info_obj_memblock_is_root(pip, &m)) {
-				info_obj_object(pip, &m, pip->obj.objid++);
+				info_obj_object(walk, &m, walk->objid++);
 			}
+		} else if (pip->args.obj.json) {
+			pmem_obj_stats_add_free_chunk(stats,
+				chunk_hdr->size_idx);
 		}
 	} else if (chunk_hdr->type == CHUNK_TYPE_RUN) {
 		struct chunk_run *run = (struct chunk_run *)chunk;
@@ -674,8 +843,15 @@ info_obj_chunk(struct pmem_info *pip, uint64_t c, uint64_t z,
 		struct alloc_class *aclass = alloc_class_by_run(
 			pip->obj.alloc_classes,
 			run->block_size, (uint16_t)m.header_type, m.size_idx);
+		/*
+		 * out_get_size_str uses a static buffer, so it must not be
+		 * called when zones are walked by many threads
+		 */
+		int vsize = outv_check(v);
+
 		if (aclass) {
-			outv_field(v, "Block size", "%s",
+			if (vsize)
+				outv_field(v, "Block size", "%s",
 					out_get_size_str(run->block_size,
 						pip->args.human));
 
@@ -686,6 +862,9 @@ info_obj_chunk(struct pmem_info *pip, uint64_t c, uint64_t z,
 			} else {
 				stats->class_stats[aclass->id].n_units += units;
 				stats->class_stats[aclass->id].n_used += used;
+				if (pip->args.obj.json)
+					pmem_obj_stats_add_run_fill(stats,
+						aclass->id, used, units);
 
 				outv_field(v, "Bitmap", "%u / %u", used, units);
 			}
@@ -694,8 +873,8 @@ info_obj_chunk(struct pmem_info *pip, uint64_t c, uint64_t z,
 				run, units);
 
 			heap_run_foreach_object(pip->obj.heap, info_obj_run_cb,
-				pip, &m);
-		} else {
+				walk, &m);
+		} else if (vsize) {
 			outv_field(v, "Block size", "%s [invalid!]",
 					out_get_size_str(run->block_size,
 						pip->args.human));
@@ -707,9 +886,10 @@ info_obj_chunk(struct pmem_info *pip, uint64_t c, uint64_t z,
  * info_obj_zone_chunks -- print chunk headers from specified zone
  */
 static void
-info_obj_zone_chunks(struct pmem_info *pip, struct zone *zone, uint64_t z,
-	struct pmem_obj_zone_stats *stats)
+info_obj_zone_chunks(struct info_obj_walk *walk, struct zone *zone,
+	uint64_t z, struct pmem_obj_zone_stats *stats)
 {
+	struct pmem_info *pip = walk->pip;
 	uint64_t c = 0;
 	while (c < zone->header.size_idx) {
 		enum chunk_type type = zone->chunk_headers[c].type;
@@ -722,7 +902,7 @@ info_obj_zone_chunks(struct pmem_info *pip, struct zone *zone, uint64_t z,
 				stats->size_chunks += size_idx;
 				stats->size_chunks_type[type] += size_idx;
 
-				info_obj_chunk(pip, c, z,
+				info_obj_chunk(walk, c, z,
 					&zone->chunk_headers[c],
 					&zone->chunks[c], stats);
 
@@ -732,7 +912,7 @@ info_obj_zone_chunks(struct pmem_info *pip, struct zone *zone, uint64_t z,
 				pip->args.obj.chunk_types &
 				(1 << CHUNK_TYPE_FOOTER)) {
 				size_t f = c + size_idx - 1;
-				info_obj_chunk(pip, f, z,
+				info_obj_chunk(walk, f, z,
 					&zone->chunk_headers[f],
 					&zone->chunks[f], stats);
 			}
@@ -742,6 +922,116 @@ info_obj_zone_chunks(struct pmem_info *pip, struct zone *zone, uint64_t z,
 	}
 }
 
+/*
+ * info_obj_zones_ctx -- shared state of threads collecting zones' statistics
+ */
+struct info_obj_zones_ctx {
+	struct pmem_info *pip;
+	struct heap_layout *layout;
+	uint64_t nzones;
+	uint64_t next_zone;
+};
+
+/*
+ * info_obj_zones_worker -- thread collecting zones' statistics
+ */
+struct info_obj_zones_worker {
+	os_thread_t thread;
+	struct info_obj_zones_ctx *ctx;
+	struct info_obj_walk walk;
+	struct pmem_obj_stats stats;	/* objects' stats of the thread */
+};
+
+/*
+ * info_obj_zones_stats_worker -- (internal) collect statistics of zones
+ *	until all of them are processed
+ */
+static void *
+info_obj_zones_stats_worker(void *arg)
+{
+	struct info_obj_zones_worker *w = arg;
+	struct info_obj_zones_ctx *ctx = w->ctx;
+	struct pmem_info *pip = ctx->pip;
+
+	while (1) {
+		uint64_t z = util_fetch_and_add64(&ctx->next_zone, 1);
+		if (z >= ctx->nzones)
+			break;
+
+		if (!util_ranges_contain(&pip->args.obj.zone_ranges, z))
+			continue;
+
+		struct zone *zone = ZID_TO_ZONE(ctx->layout, z);
+		if (zone->header.magic == ZONE_HEADER_MAGIC)
+			w->stats.n_zones_used++;
+
+		info_obj_zone_chunks(&w->walk, zone, z,
+				&pip->obj.stats.zone_stats[z]);
+	}
+
+	return NULL;
+}
+
+/*
+ * info_obj_zones_stats -- (internal) collect zones' statistics using
+ *	multiple threads
+ *
+ * Zones are handed out to the threads one by one. Each thread walks them
+ * with its own objects' statistics which are merged when all zones are
+ * processed, so the result does not depend on the number of threads.
+ * Statistics of each zone are collected by a single thread.
+ */
+static void
+info_obj_zones_stats(struct pmem_info *pip, struct heap_layout *layout,
+	uint64_t nzones)
+{
+	struct info_obj_zones_ctx ctx;
+	ctx.pip = pip;
+	ctx.layout = layout;
+	ctx.nzones = nzones;
+	ctx.next_zone = 0;
+
+	long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	uint64_t nthreads = ncpus > 0 ? (uint64_t)ncpus : 1;
+	if (nthreads > INFO_OBJ_MAX_THREADS)
+		nthreads = INFO_OBJ_MAX_THREADS;
+	if (nthreads > nzones)
+		nthreads = nzones;
+	if (nthreads == 0)
+		nthreads = 1;
+
+	struct info_obj_zones_worker *workers = calloc(nthreads,
+			sizeof(*workers));
+	if (!workers)
+		err(1, "Cannot allocate memory for zone stats workers");
+
+	for (uint64_t i = 0; i < nthreads; i++) {
+		workers[i].ctx = &ctx;
+		workers[i].walk.pip = pip;
+		workers[i].walk.stats = &workers[i].stats;
+		TAILQ_INIT(&workers[i].stats.type_stats);
+	}
+
+	/* the calling thread is one of the workers */
+	uint64_t started = 1;
+	for (; started < nthreads; started++) {
+		if (os_thread_create(&workers[started].thread, NULL,
+				info_obj_zones_stats_worker,
+				&workers[started]))
+			break; /* the running workers process the rest */
+	}
+
+	info_obj_zones_stats_worker(&workers[0]);
+
+	for (uint64_t i = 1; i < started; i++)
+		os_thread_join(&workers[i].thread, NULL);
+
+	for (uint64_t i = 0; i < started; i++)
+		pmem_obj_stats_merge(&pip->obj.stats, &workers[i].stats);
+
+	free(workers);
+}
+
 /*
  * info_obj_root_obj -- print root object
  */
@@ -777,7 +1067,8 @@ info_obj_zones_chunks(struct pmem_info *pip)
 {
 	if (!outv_check(pip->args.obj.vheap) &&
 		!outv_check(pip->args.vstats) &&
-		!outv_check(pip->args.obj.vobjects))
+		!outv_check(pip->args.obj.vobjects) &&
+		!pip->args.obj.json)
 		return;
 
 	struct pmemobjpool *pop = pip->obj.pop;
@@ -789,6 +1080,24 @@ info_obj_zones_chunks(struct pmem_info *pip)
 	if (!pip->obj.stats.zone_stats)
 		err(1, "Cannot allocate memory for zone stats");
 
+	/*
+	 * When neither the heap nor objects are printed and objects are not
+	 * selected by their ids, only statistics are needed and zones may be
+	 * processed in any order.
+	 */
+	if (!outv_check(pip->args.obj.vheap) &&
+		!outv_check(pip->args.obj.vchunkhdr) &&
+		!outv_check(pip->args.obj.vobjects) &&
+		!pip->args.use_range) {
+		info_obj_zones_stats(pip, layout, maxzone);
+		return;
+	}
+
+	struct info_obj_walk walk;
+	walk.pip = pip;
+	walk.stats = &pip->obj.stats;
+	walk.objid = 0;
+
 	for (size_t i = 0; i < maxzone; i++) {
 		struct zone *zone = ZID_TO_ZONE(layout, i);
 
@@ -807,7 +1116,7 @@ info_obj_zones_chunks(struct pmem_info *pip)
 					&zone->header);
 
 			outv_indent(vvv, 1);
-			info_obj_zone_chunks(pip, zone, i,
+			info_obj_zone_chunks(&walk, zone, i,
 					&pip->obj.stats.zone_stats[i]);
 			outv_indent(vvv, -1);
 		}
@@ -1017,11 +1326,18 @@ info_obj_add_zone_stats(struct pmem_obj_zone_stats *total,
 			stats->size_chunks_type[type];
 	}
 
+	for (int b = 0; b < FREE_CHUNK_BUCKETS; b++)
+		total->n_free_chunks[b] += stats->n_free_chunks[b];
+
 	for (int class = 0; class < MAX_ALLOCATION_CLASSES; class++) {
 		total->class_stats[class].n_units +=
 			stats->class_stats[class].n_units;
 		total->class_stats[class].n_used +=
 			stats->class_stats[class].n_used;
+
+		for (int b = 0; b < RUN_FILL_BUCKETS; b++)
+			total->class_stats[class].n_runs_fill[b] +=
+				stats->class_stats[class].n_runs_fill[b];
 	}
 }
 
@@ -1055,6 +1371,310 @@ info_obj_stats_zones(struct pmem_info *pip, int v, struct pmem_obj_stats *stats,
 	outv_indent(v, -1);
 }
 
+/*
+ * info_obj_recommended -- allocation class recommended for objects of
+ *	a single usable size
+ */
+struct info_obj_recommended {
+	uint64_t user_size;
+	uint64_t n_objects;
+	uint64_t real_bytes;	/* bytes occupied by the objects now */
+};
+
+/*
+ * info_obj_recommended_cmp -- (internal) sort recommendations by number
+ *	of objects, descending
+ */
+static int
+info_obj_recommended_cmp(const void *lhs, const void *rhs)
+{
+	const struct info_obj_recommended *l = lhs;
+	const struct info_obj_recommended *r = rhs;
+
+	if (l->n_objects != r->n_objects)
+		return l->n_objects > r->n_objects ? -1 : 1;
+
+	if (l->user_size != r->user_size)
+		return l->user_size < r->user_size ? -1 : 1;
+
+	return 0;
+}
+
+/*
+ * info_obj_json_ratio -- (internal) return ratio or zero if denominator is 0
+ */
+static double
+info_obj_json_ratio(uint64_t num, uint64_t den)
+{
+	return den ? (double)num / (double)den : 0.0;
+}
+
+static const char *header_type_str[MAX_HEADER_TYPES] = {
+	[HEADER_LEGACY] = "legacy",
+	[HEADER_COMPACT] = "compact",
+	[HEADER_NONE] = "none",
+};
+
+/*
+ * info_obj_stats_json_objects -- (internal) print objects' statistics
+ *	in JSON format
+ */
+static void
+info_obj_stats_json_objects(struct pmem_obj_stats *stats)
+{
+	outj_object_begin("objects", 0);
+	outj_uint("count", stats->n_total_objects);
+	outj_uint("bytes", stats->n_total_bytes);
+
+	outj_array_begin("types", 0);
+	struct pmem_obj_type_stats *type;
+	TAILQ_FOREACH(type, &stats->type_stats, next) {
+		if (!type->n_objects)
+			continue;
+
+		outj_object_begin(NULL, 1);
+		outj_uint("type_num", type->type_num);
+		outj_uint("count", type->n_objects);
+		outj_uint("bytes", type->n_bytes);
+		outj_object_end();
+	}
+	outj_array_end();
+
+	outj_array_begin("sizes", 0);
+	for (size_t i = 0; i < stats->n_size_stats; i++) {
+		struct pmem_obj_size_stats *size = &stats->size_stats[i];
+
+		outj_object_begin(NULL, 1);
+		outj_uint("size", size->user_size);
+		outj_uint("real_size", size->real_size);
+		outj_uint("count", size->n_objects);
+		outj_object_end();
+	}
+	outj_array_end();
+
+	outj_object_end();
+}
+
+/*
+ * info_obj_stats_json_chunks -- (internal) print chunks' statistics
+ *	in JSON format
+ */
+static void
+info_obj_stats_json_chunks(struct pmem_obj_zone_stats *total)
+{
+	outj_object_begin("chunks", 0);
+	outj_uint("count", total->n_chunks);
+	outj_uint("size_chunks", total->size_chunks);
+	outj_array_begin("types", 0);
+	for (unsigned type = 0; type < MAX_CHUNK_TYPE; type++) {
+		if (!total->n_chunks_type[type])
+			continue;
+
+		outj_object_begin(NULL, 1);
+		outj_str("type", out_get_chunk_type_str(type));
+		outj_uint("count", total->n_chunks_type[type]);
+		outj_uint("size_chunks", total->size_chunks_type[type]);
+		outj_object_end();
+	}
+	outj_array_end();
+	outj_object_end();
+
+	uint64_t n_free = 0;
+	for (unsigned b = 0; b < FREE_CHUNK_BUCKETS; b++)
+		n_free += total->n_free_chunks[b];
+
+	outj_object_begin("free_chunks", 0);
+	outj_uint("count", n_free);
+	outj_uint("size_chunks", total->size_chunks_type[CHUNK_TYPE_FREE]);
+	outj_uint("largest_chunks", total->max_free_chunk);
+	outj_array_begin("histogram", 0);
+	for (unsigned b = 0; b < FREE_CHUNK_BUCKETS; b++) {
+		if (!total->n_free_chunks[b])
+			continue;
+
+		outj_object_begin(NULL, 1);
+		outj_uint("min_chunks", (uint64_t)1 << b);
+		outj_uint("max_chunks", ((uint64_t)2 << b) - 1);
+		outj_uint("count", total->n_free_chunks[b]);
+		outj_object_end();
+	}
+	outj_array_end();
+	outj_object_end();
+}
+
+/*
+ * info_obj_stats_json_alloc_classes -- (internal) print allocation classes'
+ *	statistics and fragmentation ratios in JSON format
+ */
+static void
+info_obj_stats_json_alloc_classes(struct pmem_info *pip,
+	struct pmem_obj_zone_stats *total)
+{
+	uint64_t run_bytes = 0;
+	uint64_t run_used = 0;
+
+	outj_array_begin("alloc_classes", 0);
+	for (unsigned class = 0; class < MAX_ALLOCATION_CLASSES; class++) {
+		struct alloc_class *c = alloc_class_by_id(
+				pip->obj.alloc_classes, (uint8_t)class);
+		if (c == NULL)
+			continue;
+
+		struct pmem_obj_class_stats *cstats =
+			&total->class_stats[class];
+		if (!cstats->n_units)
+			continue;
+
+		uint64_t bytes = c->unit_size * cstats->n_units;
+		uint64_t used = c->unit_size * cstats->n_used;
+
+		outj_object_begin(NULL, 0);
+		outj_uint("id", class);
+		outj_str("type", c->type == CLASS_RUN ? "run" : "huge");
+		outj_str("header", header_type_str[c->header_type]);
+		outj_uint("unit_size", c->unit_size);
+		outj_uint("units", cstats->n_units);
+		outj_uint("used_units", cstats->n_used);
+		outj_uint("bytes", bytes);
+		outj_uint("used_bytes", used);
+		outj_double("occupancy", info_obj_json_ratio(
+			cstats->n_used, cstats->n_units));
+
+		if (c->type == CLASS_RUN) {
+			run_bytes += bytes;
+			run_used += used;
+
+			uint64_t n_runs = 0;
+			for (unsigned b = 0; b < RUN_FILL_BUCKETS; b++)
+				n_runs += cstats->n_runs_fill[b];
+
+			outj_uint("runs", n_runs);
+			outj_array_begin("run_fill_histogram", 1);
+			for (unsigned b = 0; b < RUN_FILL_BUCKETS; b++)
+				outj_uint(NULL, cstats->n_runs_fill[b]);
+			outj_array_end();
+		}
+		outj_object_end();
+	}
+	outj_array_end();
+
+	uint64_t free_chunks = total->size_chunks_type[CHUNK_TYPE_FREE];
+	double ext_frag = free_chunks ? 1.0 - info_obj_json_ratio(
+		total->max_free_chunk, free_chunks) : 0.0;
+
+	outj_object_begin("fragmentation", 0);
+	outj_double("free_chunks", ext_frag);
+	outj_double("runs", info_obj_json_ratio(run_bytes - run_used,
+		run_bytes));
+	outj_object_end();
+}
+
+/*
+ * info_obj_stats_json_recommended -- (internal) print allocation classes
+ *	recommended for the observed sizes of objects in JSON format
+ *
+ * The most common usable sizes of objects which fit into a single chunk
+ * run are recommended until they cover most of such objects. Each
+ * recommended class uses the compact header and has a unit size equal
+ * to the usable size plus the header, so no space is wasted on rounding.
+ */
+static void
+info_obj_stats_json_recommended(struct pmem_obj_stats *stats)
+{
+	struct info_obj_recommended *rec = NULL;
+	size_t nrec = 0;
+	uint64_t n_objects = 0;
+
+	if (stats->n_size_stats) {
+		rec = calloc(stats->n_size_stats, sizeof(*rec));
+		if (!rec)
+			err(1, "Cannot allocate memory for recommendations");
+	}
+
+	/* entries with the same usable size are adjacent */
+	for (size_t i = 0; i < stats->n_size_stats; i++) {
+		struct pmem_obj_size_stats *size = &stats->size_stats[i];
+		if (size->user_size + ALLOC_HDR_COMPACT_SIZE > RUNSIZE)
+			continue;
+
+		if (!nrec || rec[nrec - 1].user_size != size->user_size)
+			rec[nrec++].user_size = size->user_size;
+
+		rec[nrec - 1].n_objects += size->n_objects;
+		rec[nrec - 1].real_bytes += size->n_objects * size->real_size;
+		n_objects += size->n_objects;
+	}
+
+	if (nrec)
+		qsort(rec, nrec, sizeof(*rec), info_obj_recommended_cmp);
+
+	outj_array_begin("recommended_alloc_classes", 0);
+	uint64_t covered = 0;
+	for (size_t i = 0; i < nrec && i < INFO_OBJ_MAX_RECOMMENDED; i++) {
+		if ((double)covered >=
+			INFO_OBJ_RECOMMENDED_COVERAGE * (double)n_objects)
+			break;
+
+		uint64_t unit_size = rec[i].user_size + ALLOC_HDR_COMPACT_SIZE;
+		uint64_t units = RUNSIZE / unit_size;
+		if (units > RUN_BITMAP_SIZE)
+			units = RUN_BITMAP_SIZE;
+
+		uint64_t bytes = unit_size * rec[i].n_objects;
+		uint64_t saved = rec[i].real_bytes > bytes ?
+			rec[i].real_bytes - bytes : 0;
+
+		covered += rec[i].n_objects;
+
+		outj_object_begin(NULL, 1);
+		outj_uint("unit_size", unit_size);
+		outj_uint("units_per_block", units);
+		outj_str("header", header_type_str[HEADER_COMPACT]);
+		outj_uint("count", rec[i].n_objects);
+		outj_double("share", info_obj_json_ratio(rec[i].n_objects,
+			n_objects));
+		outj_uint("bytes_saved", saved);
+		outj_object_end();
+	}
+	outj_array_end();
+
+	free(rec);
+}
+
+/*
+ * info_obj_stats_json -- print statistics in JSON format
+ */
+static void
+info_obj_stats_json(struct pmem_info *pip)
+{
+	struct pmem_obj_stats *stats = &pip->obj.stats;
+	struct pmem_obj_zone_stats *total = calloc(1, sizeof(*total));
+	if (!total)
+		err(1, "Cannot allocate memory for zone stats");
+
+	for (uint64_t i = 0; i < stats->n_zones; i++) {
+		struct pmem_obj_zone_stats *zstats = &stats->zone_stats[i];
+		info_obj_add_zone_stats(total, zstats);
+		if (zstats->max_free_chunk > total->max_free_chunk)
+			total->max_free_chunk = zstats->max_free_chunk;
+	}
+
+	outj_object_begin(NULL, 0);
+	info_obj_stats_json_objects(stats);
+
+	outj_object_begin("zones", 0);
+	outj_uint("count", stats->n_zones);
+	outj_uint("used", stats->n_zones_used);
+	outj_object_end();
+
+	info_obj_stats_json_chunks(total);
+	info_obj_stats_json_alloc_classes(pip, total);
+	info_obj_stats_json_recommended(stats);
+	outj_object_end();
+
+	free(total);
+}
+
 /*
  * info_obj_stats -- print statistics
  */
@@ -1063,6 +1683,11 @@ info_obj_stats(struct pmem_info *pip)
 {
 	int v = pip->args.vstats;
 
+	if (pip->args.obj.json) {
+		info_obj_stats_json(pip);
+		return;
+	}
+
 	if (!outv_check(v))
 		return;
 
@@ -72,6 +72,7 @@ static FILE *out_fh;
 static const char *out_prefix;
 
 #define STR_MAX 256
+#define OUTJ_MAX_DEPTH 16
 
 /*
  * outv_check -- verify verbosity level
@@ -903,3 +904,170 @@ out_get_incompat_features_str(uint32_t incompat)
 	}
 	return str_buff;
 }
+
+/*
+ * Nesting state of the JSON output, a container printed in a single line
+ * forces all the containers nested in it to be printed in the same line.
+ */
+static struct {
+	int first;	/* no value printed in the container yet */
+	int oneline;	/* container printed in a single line */
+} outj_stack[OUTJ_MAX_DEPTH];
+static int outj_depth;
+
+/*
+ * outj_str_escaped -- (internal) print string as a JSON string literal
+ */
+static void
+outj_str_escaped(const char *str)
+{
+	fputc('"', out_fh);
+	for (const unsigned char *c = (const unsigned char *)str; *c; c++) {
+		if (*c == '"' || *c == '\\')
+			fprintf(out_fh, "\\%c", *c);
+		else if (*c < 0x20)
+			fprintf(out_fh, "\\u%04x", *c);
+		else
+			fputc(*c, out_fh);
+	}
+	fputc('"', out_fh);
+}
+
+/*
+ * outj_value_begin -- (internal) print separator, indentation and key of
+ *	a value which is about to be printed
+ */
+static void
+outj_value_begin(const char *key)
+{
+	if (outj_depth > 0) {
+		int oneline = outj_stack[outj_depth - 1].oneline;
+		int first = outj_stack[outj_depth - 1].first;
+
+		if (!first)
+			fputc(',', out_fh);
+
+		if (oneline) {
+			fputc(' ', out_fh);
+		} else {
+			fputc('\n', out_fh);
+			for (int i = 0; i < outj_depth; i++)
+				fputc('\t', out_fh);
+		}
+
+		outj_stack[outj_depth - 1].first = 0;
+	}
+
+	if (key) {
+		outj_str_escaped(key);
+		fprintf(out_fh, ": ");
+	}
+}
+
+/*
+ * outj_container_begin -- (internal) open JSON object or array
+ */
+static void
+outj_container_begin(const char *key, char c, int oneline)
+{
+	assert(outj_depth < OUTJ_MAX_DEPTH);
+
+	outj_value_begin(key);
+	fputc(c, out_fh);
+
+	if (outj_depth > 0 && outj_stack[outj_depth - 1].oneline)
+		oneline = 1;
+
+	outj_stack[outj_depth].first = 1;
+	outj_stack[outj_depth].oneline = oneline;
+	outj_depth++;
+}
+
+/*
+ * outj_container_end -- (internal) close JSON object or array
+ */
+static void
+outj_container_end(char c)
+{
+	assert(outj_depth > 0);
+
+	outj_depth--;
+	if (outj_stack[outj_depth].oneline) {
+		fputc(' ', out_fh);
+	} else {
+		fputc('\n', out_fh);
+		for (int i = 0; i < outj_depth; i++)
+			fputc('\t', out_fh);
+	}
+	fputc(c, out_fh);
+
+	if (outj_depth == 0)
+		fputc('\n', out_fh);
+}
+
+/*
+ * outj_object_begin -- open JSON object, the key is NULL for values of
+ *	arrays and for the top-level value
+ */
+void
+outj_object_begin(const char *key, int oneline)
+{
+	outj_container_begin(key, '{', oneline);
+}
+
+/*
+ * outj_object_end -- close JSON object
+ */
+void
+outj_object_end(void)
+{
+	outj_container_end('}');
+}
+
+/*
+ * outj_array_begin -- open JSON array
+ */
+void
+outj_array_begin(const char *key, int oneline)
+{
+	outj_container_begin(key, '[', oneline);
+}
+
+/*
+ * outj_array_end -- close JSON array
+ */
+void
+outj_array_end(void)
+{
+	outj_container_end(']');
+}
+
+/*
+ * outj_uint -- print unsigned integer JSON value
+ */
+void
+outj_uint(const char *key, uint64_t value)
+{
+	outj_value_begin(key);
+	fprintf(out_fh, "%" PRIu64, value);
+}
+
+/*
+ * outj_double -- print floating-point JSON value
+ */
+void
+outj_double(const char *key, double value)
+{
+	outj_value_begin(key);
+	fprintf(out_fh, "%.4f", value);
+}
+
+/*
+ * outj_str -- print string JSON value
+ */
+void
+outj_str(const char *key, const char *value)
+{
+	outj_value_begin(key);
+	outj_str_escaped(value);
+}
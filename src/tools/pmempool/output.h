@@ -76,3 +76,11 @@ const char *out_get_arch_machine_str(uint16_t machine);
 const char *out_get_last_shutdown_str(uint8_t dirty);
 const char *out_get_alignment_desc_str(uint64_t ad, uint64_t cur_ad);
 const char *out_get_incompat_features_str(uint32_t incompat);
+
+void outj_object_begin(const char *key, int oneline);
+void outj_object_end(void);
+void outj_array_begin(const char *key, int oneline);
+void outj_array_end(void);
+void outj_uint(const char *key, uint64_t value);
+void outj_double(const char *key, double value);
+void outj_str(const char *key, const char *value);
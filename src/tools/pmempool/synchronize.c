@@ -37,6 +37,7 @@
 #include "synchronize.h"
 
 #include <stdio.h>
+#include <limits.h>
 #include <libgen.h>
 #include <string.h>
 #include <unistd.h>
@@ -54,6 +55,8 @@
  */
 struct pmempool_sync_context {
 	unsigned flags;		/* flags which modify the command execution */
+	struct pmempool_copy_opts opts;	/* options of copying data */
+	int progress;		/* print progress of copying data */
 	char *poolset_file;	/* a path to a poolset file */
 };
 
@@ -62,6 +65,8 @@ struct pmempool_sync_context {
  */
 static const struct pmempool_sync_context pmempool_sync_default = {
 	.flags		= 0,
+	.opts		= { 0 },
+	.progress	= 0,
 	.poolset_file	= NULL,
 };
 
@@ -74,6 +79,12 @@ static const char * const help_str =
 "Common options:\n"
 "  -d, --dry-run        do not apply changes, only check for viability of"
 " synchronization\n"
+"  -i, --incremental <replica>\n"
+"                       copy only regions which differ from the given replica\n"
+"  -j, --threads <num>  number of threads copying data\n"
+"  -b, --bandwidth <size>\n"
+"                       limit copying speed to <size> bytes per second\n"
+"  -p, --progress       print progress and throughput of copying data\n"
 "  -v, --verbose        increase verbosity level\n"
 "  -h, --help           display this help and exit\n"
 "\n"
@@ -86,6 +97,10 @@ static const char * const help_str =
 static const struct option long_options[] = {
 	{"dry-run",	no_argument,		NULL,	'd'},
 	{"help",	no_argument,		NULL,	'h'},
+	{"incremental",	required_argument,	NULL,	'i'},
+	{"threads",	required_argument,	NULL,	'j'},
+	{"bandwidth",	required_argument,	NULL,	'b'},
+	{"progress",	no_argument,		NULL,	'p'},
 	{"verbose",	no_argument,		NULL,	'v'},
 	{NULL,		0,			NULL,	 0 },
 };
@@ -127,11 +142,25 @@ pmempool_sync_parse_args(struct pmempool_sync_context *ctx, char *appname,
 		int argc, char *argv[])
 {
 	int opt;
-	while ((opt = getopt_long(argc, argv, "dhv",
+	char *end;
+	unsigned long repn;
+	while ((opt = getopt_long(argc, argv, "dhvi:j:b:p",
 			long_options, NULL)) != -1) {
 		switch (opt) {
 		case 'd':
-			ctx->flags = PMEMPOOL_DRY_RUN;
+			ctx->flags |= PMEMPOOL_DRY_RUN;
+			break;
+		case 'i':
+			errno = 0;
+			repn = strtoul(optarg, &end, 10);
+			if (errno || *end != '\0' || optarg[0] == '-' ||
+					repn >= UINT_MAX) {
+				outv_err("invalid replica '%s'\n", optarg);
+				exit(EXIT_FAILURE);
+			}
+			/* the library counts replicas from 1 */
+			ctx->opts.src_replica = (unsigned)repn + 1;
+			ctx->flags |= PMEMPOOL_SYNC_INCREMENTAL;
 			break;
 		case 'h':
 			pmempool_sync_help(appname);
@@ -139,6 +168,26 @@ pmempool_sync_parse_args(struct pmempool_sync_context *ctx, char *appname,
 		case 'v':
 			out_set_vlevel(1);
 			break;
+		case 'j':
+			errno = 0;
+			ctx->opts.nthreads = (unsigned)strtoul(optarg,
+					&end, 10);
+			if (errno || *end != '\0' || ctx->opts.nthreads == 0) {
+				outv_err("invalid number of threads '%s'\n",
+						optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'b':
+			if (util_parse_size(optarg,
+					&ctx->opts.max_bandwidth)) {
+				outv_err("invalid bandwidth '%s'\n", optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'p':
+			ctx->progress = 1;
+			break;
 		default:
 			print_usage(appname);
 			exit(EXIT_FAILURE);
@@ -168,7 +217,13 @@ pmempool_sync_func(char *appname, int argc, char *argv[])
 	if ((ret = pmempool_sync_parse_args(&ctx, appname, argc, argv)))
 		return ret;
 
-	ret = pmempool_sync(ctx.poolset_file, ctx.flags);
+	struct copy_progress progress = { { 0, 0 } };
+	if (ctx.progress) {
+		ctx.opts.progress = util_print_copy_progress;
+		ctx.opts.arg = &progress;
+	}
+
+	ret = pmempool_xsync(ctx.poolset_file, ctx.flags, &ctx.opts);
 
 	if (ret) {
 		outv_err("failed to synchronize: %s\n", pmempool_errormsg());
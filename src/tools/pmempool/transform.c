@@ -53,6 +53,8 @@
  */
 struct pmempool_transform_context {
 	unsigned flags;		/* flags which modify the command execution */
+	struct pmempool_copy_opts opts;	/* options of copying data */
+	int progress;		/* print progress of copying data */
 	char *poolset_file_src;	/* a path to a source poolset file */
 	char *poolset_file_dst;	/* a path to a target poolset file */
 };
@@ -62,6 +64,8 @@ struct pmempool_transform_context {
  */
 static const struct pmempool_transform_context pmempool_transform_default = {
 	.flags			= 0,
+	.opts			= { 0 },
+	.progress		= 0,
 	.poolset_file_src	= NULL,
 	.poolset_file_dst	= NULL,
 };
@@ -75,6 +79,10 @@ static const char * const help_str =
 "Common options:\n"
 "  -d, --dry-run        do not apply changes, only check for viability of"
 " transformation\n"
+"  -j, --threads <num>  number of threads copying data\n"
+"  -b, --bandwidth <size>\n"
+"                       limit copying speed to <size> bytes per second\n"
+"  -p, --progress       print progress and throughput of copying data\n"
 "  -v, --verbose        increase verbosity level\n"
 "  -h, --help           display this help and exit\n"
 "\n"
@@ -87,6 +95,9 @@ static const char * const help_str =
 static const struct option long_options[] = {
 	{"dry-run",	no_argument,		NULL,	'd'},
 	{"help",	no_argument,		NULL,	'h'},
+	{"threads",	required_argument,	NULL,	'j'},
+	{"bandwidth",	required_argument,	NULL,	'b'},
+	{"progress",	no_argument,		NULL,	'p'},
 	{"verbose",	no_argument,		NULL,	'v'},
 	{NULL,		0,			NULL,	 0 },
 };
@@ -129,7 +140,8 @@ pmempool_transform_parse_args(struct pmempool_transform_context *ctx,
 		char *appname, int argc, char *argv[])
 {
 	int opt;
-	while ((opt = getopt_long(argc, argv, "dhv",
+	char *end;
+	while ((opt = getopt_long(argc, argv, "dhvj:b:p",
 			long_options, NULL)) != -1) {
 		switch (opt) {
 		case 'd':
@@ -141,6 +153,26 @@ pmempool_transform_parse_args(struct pmempool_transform_context *ctx,
 		case 'v':
 			out_set_vlevel(1);
 			break;
+		case 'j':
+			errno = 0;
+			ctx->opts.nthreads = (unsigned)strtoul(optarg,
+					&end, 10);
+			if (errno || *end != '\0' || ctx->opts.nthreads == 0) {
+				outv_err("invalid number of threads '%s'\n",
+						optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'b':
+			if (util_parse_size(optarg,
+					&ctx->opts.max_bandwidth)) {
+				outv_err("invalid bandwidth '%s'\n", optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'p':
+			ctx->progress = 1;
+			break;
 		default:
 			print_usage(appname);
 			exit(EXIT_FAILURE);
@@ -171,8 +203,14 @@ pmempool_transform_func(char *appname, int argc, char *argv[])
 	if ((ret = pmempool_transform_parse_args(&ctx, appname, argc, argv)))
 		return ret;
 
-	ret = pmempool_transform(ctx.poolset_file_src, ctx.poolset_file_dst,
-			ctx.flags);
+	struct copy_progress progress = { { 0, 0 } };
+	if (ctx.progress) {
+		ctx.opts.progress = util_print_copy_progress;
+		ctx.opts.arg = &progress;
+	}
+
+	ret = pmempool_xtransform(ctx.poolset_file_src, ctx.poolset_file_dst,
+			ctx.flags, &ctx.opts);
 
 	if (ret) {
 		if (errno)
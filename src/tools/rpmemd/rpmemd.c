@@ -202,6 +202,7 @@ rpmemd_common_fip_init(struct rpmemd *rpmemd, const struct rpmem_req_attr *req,
 		.deep_persist	= rpmemd_deep_persist,
 		.ctx		= rpmemd,
 		.buff_size	= req->buff_size,
+		.proto_minor	= req->proto_minor,
 	};
 
 	const int is_pmem = rpmemd_db_pool_is_pmem(rpmemd->pool);
@@ -213,6 +214,12 @@ rpmemd_common_fip_init(struct rpmemd *rpmemd, const struct rpmem_req_attr *req,
 		goto err_fip_init;
 	}
 
+	rpmemd_apply_batch_policy(fip_attr.persist_method,
+			&fip_attr.flush,
+			&fip_attr.memcpy_nodrain,
+			&fip_attr.drain,
+			is_pmem);
+
 	const char *node = rpmem_get_ssh_conn_addr();
 	enum rpmem_err err;
 
@@ -371,6 +378,8 @@ rpmemd_fip_stop(struct rpmemd *rpmemd)
 		if (ret) {
 			RPMEMD_LOG(ERR, "!stopping fip process failed");
 		}
+
+		rpmemd_fip_stats_log(rpmemd->fip);
 	}
 
 	rpmemd->fip_running = 0;
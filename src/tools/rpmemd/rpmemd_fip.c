@@ -63,6 +63,13 @@
 #define RPMEMD_FI_ERR(e, fmt, args...)\
 	RPMEMD_LOG(ERR, fmt ": %s", ## args, fi_strerror((e)))
 
+/* maximum number of completions processed at once */
+#define RPMEMD_FIP_CQ_BATCH	16
+
+/* bounds of number of polls of completion queues before blocking on one */
+#define RPMEMD_FIP_SPIN_MIN	16
+#define RPMEMD_FIP_SPIN_MAX	4096
+
 #define RPMEMD_FI_CLOSE(f, fmt, args...) (\
 {\
 	int ret = fi_close(&(f)->fid);\
@@ -89,6 +96,9 @@ struct rpmemd_fip_lane {
 	struct rpmem_msg_persist_resp resp; /* persist response msg buffer */
 	int send_posted;		/* send buffer has been posted */
 	int recv_posted;		/* recv buffer has been posted */
+	uint64_t nmsgs;			/* number of persist messages */
+	uint64_t nbytes;		/* number of bytes made persistent */
+	uint64_t nerrors;		/* number of invalid persist messages */
 };
 
 /*
@@ -100,6 +110,10 @@ struct rpmemd_fip_thread {
 	struct fid_cq *cq;		/* per-thread completion queue */
 	struct rpmemd_fip_lane **lanes; /* lanes processed by this thread */
 	size_t nlanes;	/* number of lanes processed by this thread */
+	unsigned spin;	/* number of polls before blocking */
+	uint64_t nbatches;	/* number of processed batches */
+	uint64_t ncompl;	/* number of processed completions */
+	uint64_t nblocks;	/* number of blocking waits */
 };
 
 /*
@@ -117,6 +131,10 @@ struct rpmemd_fip {
 	void *(*memcpy_persist)(void *pmemdest, const void *src, size_t len);
 	int (*deep_persist)(const void *addr, size_t len, void *ctx);
 	void *ctx;
+	/* functions for batching flushes, NULL if not supported */
+	int (*flush)(const void *addr, size_t len);
+	void *(*memcpy_nodrain)(void *pmemdest, const void *src, size_t len);
+	void (*drain)(void);
 	void *addr;			/* pool's address */
 	size_t size;			/* size of the pool */
 	enum rpmem_persist_method persist_method;
@@ -127,6 +145,7 @@ struct rpmemd_fip {
 	size_t cq_size;	/* size of completion queue */
 	size_t lanes_per_thread; /* numer of lanes per thread */
 	size_t buff_size;	/* size of buffer for inlined data */
+	unsigned proto_minor;	/* protocol version minor number of client */
 
 	struct rpmemd_fip_lane *lanes;
 	struct rpmem_fip_lane rd_lane; /* lane for read operation */
@@ -598,6 +617,25 @@ rpmemd_fip_fini_common(struct rpmemd_fip *fip)
 	return lret;
 }
 
+/*
+ * rpmemd_fip_check_range -- verify range of persist operation
+ */
+static inline int
+rpmemd_fip_check_range(struct rpmemd_fip *fip, uint64_t addr, uint64_t size)
+{
+	uintptr_t raddr = addr;
+	uintptr_t laddr = (uintptr_t)fip->addr;
+
+	if (raddr < laddr || raddr + size > laddr + fip->size) {
+		RPMEMD_LOG(ERR, "invalid address or size requested "
+			"for persist operation (0x%lx, %lu)",
+			raddr, size);
+		return -1;
+	}
+
+	return 0;
+}
+
 /*
  * rpmemd_fip_check_pmsg -- verify persist message
  */
@@ -609,16 +647,97 @@ rpmemd_fip_check_pmsg(struct rpmemd_fip *fip, struct rpmem_msg_persist *pmsg)
 		return -1;
 	}
 
-	uintptr_t raddr = pmsg->addr;
-	uintptr_t laddr = (uintptr_t)fip->addr;
+	if (pmsg->flags & RPMEM_PERSIST_VEC) {
+		if (fip->proto_minor < RPMEM_PROTO_MINOR_VEC) {
+			RPMEMD_LOG(ERR, "vectored persist not supported by "
+				"protocol version %u.%u", RPMEM_PROTO_MAJOR,
+				fip->proto_minor);
+			return -1;
+		}
 
-	if (raddr < laddr || raddr + pmsg->size > laddr + fip->size) {
-		RPMEMD_LOG(ERR, "invalid address or size requested "
-			"for persist operation (0x%lx, %lu)",
-			raddr, pmsg->size);
+		return 0;
+	}
+
+	return rpmemd_fip_check_range(fip, pmsg->addr, pmsg->size);
+}
+
+/*
+ * rpmemd_fip_persist_range -- make range persistent, if flushes are batched
+ * the drain is left to the caller
+ */
+static inline void
+rpmemd_fip_persist_range(struct rpmemd_fip *fip, void *addr, size_t len)
+{
+	if (fip->drain)
+		fip->flush(addr, len);
+	else
+		fip->persist(addr, len);
+}
+
+/*
+ * rpmemd_fip_memcpy_range -- copy inlined data and make it persistent, if
+ * flushes are batched the drain is left to the caller
+ */
+static inline void
+rpmemd_fip_memcpy_range(struct rpmemd_fip *fip, void *addr, const void *src,
+	size_t len)
+{
+	if (fip->drain)
+		fip->memcpy_nodrain(addr, src, len);
+	else
+		fip->memcpy_persist(addr, src, len);
+}
+
+/*
+ * rpmemd_fip_persist_vec -- verify and persist all ranges of vectored
+ * persist message
+ */
+static int
+rpmemd_fip_persist_vec(struct rpmemd_fip *fip, struct rpmem_msg_persist *pmsg,
+	unsigned mode)
+{
+	struct rpmem_msg_persist_range *tab =
+		(struct rpmem_msg_persist_range *)pmsg->data;
+	const size_t entry = sizeof(*tab);
+
+	if (pmsg->size == 0 || pmsg->size > RPMEM_PERSIST_VEC_MAX ||
+		pmsg->size * entry > fip->buff_size) {
+		RPMEMD_LOG(ERR, "invalid number of ranges requested "
+			"for persist operation -- %lu", pmsg->size);
 		return -1;
 	}
 
+	VALGRIND_DO_MAKE_MEM_DEFINED(tab, pmsg->size * entry);
+
+	size_t total = pmsg->size * entry;
+	for (uint64_t i = 0; i < pmsg->size; i++) {
+		if (rpmemd_fip_check_range(fip, tab[i].addr, tab[i].size))
+			return -1;
+
+		if (mode == RPMEM_PERSIST_SEND) {
+			if (tab[i].size > fip->buff_size - total) {
+				RPMEMD_LOG(ERR, "inlined data exceeds "
+					"message buffer size");
+				return -1;
+			}
+			total += tab[i].size;
+		}
+	}
+
+	uint8_t *data = pmsg->data + pmsg->size * entry;
+	for (uint64_t i = 0; i < pmsg->size; i++) {
+		void *addr = (void *)tab[i].addr;
+
+		if (mode == RPMEM_DEEP_PERSIST) {
+			fip->deep_persist(addr, tab[i].size, fip->ctx);
+		} else if (mode == RPMEM_PERSIST_SEND) {
+			rpmemd_fip_memcpy_range(fip, addr, data, tab[i].size);
+			data += tab[i].size;
+		} else {
+			rpmemd_fip_persist_range(fip, addr, tab[i].size);
+		}
+	}
+
 	return 0;
 }
 
@@ -653,6 +772,9 @@ err:
 
 /*
  * rpmemd_fip_process_recv -- process FI_RECV completion
+ *
+ * If flushes are batched the persisted data is not drained, the caller must
+ * drain it before calling rpmemd_fip_process_resp.
  */
 static int
 rpmemd_fip_process_recv(struct rpmemd_fip *fip, struct rpmemd_fip_lane *lanep)
@@ -662,9 +784,7 @@ rpmemd_fip_process_recv(struct rpmemd_fip *fip, struct rpmemd_fip_lane *lanep)
 	lanep->recv_posted = 0;
 
 	/*
-	 * Get persist message and persist message response from appropriate
-	 * buffers. The persist message is in lane's RECV buffer and the
-	 * persist response message in lane's SEND buffer.
+	 * Get persist message from lane's RECV buffer.
 	 */
 	struct rpmem_msg_persist *pmsg = rpmem_fip_msg_get_pmsg(&lanep->recv);
 	VALGRIND_DO_MAKE_MEM_DEFINED(pmsg, sizeof(*pmsg));
@@ -675,14 +795,52 @@ rpmemd_fip_process_recv(struct rpmemd_fip *fip, struct rpmemd_fip_lane *lanep)
 		goto err;
 	unsigned mode = pmsg->flags & RPMEM_PERSIST_MASK;
 
+	lanep->nmsgs++;
+
+	if (pmsg->flags & RPMEM_PERSIST_VEC) {
+		ret = rpmemd_fip_persist_vec(fip, pmsg, mode);
+		if (unlikely(ret))
+			goto err;
+
+		struct rpmem_msg_persist_range *tab =
+			(struct rpmem_msg_persist_range *)pmsg->data;
+		for (uint64_t i = 0; i < pmsg->size; i++)
+			lanep->nbytes += tab[i].size;
+
+		return 0;
+	}
+
+	lanep->nbytes += pmsg->size;
+
 	if (mode == RPMEM_DEEP_PERSIST) {
 		fip->deep_persist((void *)pmsg->addr, pmsg->size, fip->ctx);
 	} else if (mode == RPMEM_PERSIST_SEND) {
-		fip->memcpy_persist((void *)pmsg->addr, pmsg->data, pmsg->size);
+		rpmemd_fip_memcpy_range(fip, (void *)pmsg->addr, pmsg->data,
+				pmsg->size);
 	} else {
-		fip->persist((void *)pmsg->addr, pmsg->size);
+		rpmemd_fip_persist_range(fip, (void *)pmsg->addr, pmsg->size);
 	}
 
+	return 0;
+err:
+	lanep->nerrors++;
+	return ret;
+}
+
+/*
+ * rpmemd_fip_process_resp -- respond to persist message processed by
+ * rpmemd_fip_process_recv
+ */
+static int
+rpmemd_fip_process_resp(struct rpmemd_fip *fip, struct rpmemd_fip_lane *lanep)
+{
+	int ret = 0;
+
+	/*
+	 * The persist message is in lane's RECV buffer and the persist
+	 * response message in lane's SEND buffer.
+	 */
+	struct rpmem_msg_persist *pmsg = rpmem_fip_msg_get_pmsg(&lanep->recv);
 	struct rpmem_msg_persist_resp *pres = lanep->send_posted ?
 		&lanep->resp : rpmem_fip_msg_get_pres(&lanep->send);
 
@@ -704,96 +862,168 @@ err:
 }
 
 /*
- * rpmemd_fip_cq_read -- wait for specific events on completion queue
+ * rpmemd_fip_cq_err -- report error read from completion queue
  */
 static int
-rpmemd_fip_cq_read(struct rpmemd_fip *fip, struct fid_cq *cq,
-	struct rpmemd_fip_lane **lanep, uint64_t *event, uint64_t event_mask)
+rpmemd_fip_cq_err(struct fid_cq *cq, int ret)
 {
 	struct fi_cq_err_entry err;
-	struct fi_cq_msg_entry cq_entry;
 	const char *str_err;
 	ssize_t sret;
-	int ret;
 
-	while (!fip->closing) {
-		sret = fi_cq_sread(cq, &cq_entry, 1, NULL,
-				RPMEM_FIP_CQ_WAIT_MS);
+	sret = fi_cq_readerr(cq, &err, 0);
+	if (sret < 0) {
+		RPMEMD_FI_ERR((int)sret, "error reading from completion queue: "
+			"cannot read error from completion queue");
+		return ret;
+	}
 
-		if (unlikely(fip->closing))
-			break;
+	str_err = fi_cq_strerror(cq, err.prov_errno, NULL, NULL, 0);
+	RPMEMD_LOG(ERR, "error reading from completion queue: %s", str_err);
 
-		if (unlikely(sret == -FI_EAGAIN || sret == 0))
-			continue;
+	return ret;
+}
 
-		if (unlikely(sret < 0)) {
-			ret = (int)sret;
-			goto err_cq_read;
-		}
+/*
+ * rpmemd_fip_process_batch -- process completions read at once
+ *
+ * The data of all persist messages is made persistent first, so that with
+ * batched flushes a single drain covers all of them, and then responses
+ * are sent in the order the completions were read.
+ */
+static int
+rpmemd_fip_process_batch(struct rpmemd_fip *fip,
+	struct fi_cq_msg_entry *entries, size_t n)
+{
+	int ret;
 
-		if (!(cq_entry.flags & event_mask)) {
+	for (size_t i = 0; i < n; i++) {
+		if (!(entries[i].flags & (FI_SEND|FI_RECV))) {
 			RPMEMD_LOG(ERR, "unexpected event received %lx",
-					cq_entry.flags);
-			ret = -1;
-			goto err;
+					entries[i].flags);
+			return -1;
 		}
 
-		if (!cq_entry.op_context) {
+		if (!entries[i].op_context) {
 			RPMEMD_LOG(ERR, "null context received");
-			ret = -1;
-			goto err;
+			return -1;
 		}
+	}
 
-		*event = cq_entry.flags & event_mask;
-		*lanep = cq_entry.op_context;
+	int persisted = 0;
+	for (size_t i = 0; i < n; i++) {
+		if (!(entries[i].flags & FI_RECV))
+			continue;
 
-		return 0;
+		ret = rpmemd_fip_process_recv(fip, entries[i].op_context);
+		if (unlikely(ret))
+			return ret;
+
+		persisted = 1;
+	}
+
+	if (persisted && fip->drain)
+		fip->drain();
+
+	for (size_t i = 0; i < n; i++) {
+		struct rpmemd_fip_lane *lanep = entries[i].op_context;
+
+		if (entries[i].flags & FI_RECV)
+			ret = rpmemd_fip_process_resp(fip, lanep);
+		else
+			ret = rpmemd_fip_process_send(fip, lanep);
+		if (unlikely(ret))
+			return ret;
 	}
 
 	return 0;
-err_cq_read:
-	sret = fi_cq_readerr(cq, &err, 0);
-	if (sret < 0) {
-		RPMEMD_FI_ERR((int)sret, "error reading from completion queue: "
-			"cannot read error from completion queue");
-		goto err;
+}
+
+/*
+ * rpmemd_fip_cq_process -- read and process completions from completion
+ * queue of the thread
+ *
+ * If block is set the function waits up to RPMEM_FIP_CQ_WAIT_MS for
+ * a completion.
+ *
+ * Returns number of processed completions or negative value on error.
+ */
+static int
+rpmemd_fip_cq_process(struct rpmemd_fip *fip, struct rpmemd_fip_thread *thread,
+	int block)
+{
+	struct fi_cq_msg_entry entries[RPMEMD_FIP_CQ_BATCH];
+	ssize_t sret;
+	int ret;
+
+	if (block)
+		sret = fi_cq_sread(thread->cq, entries, RPMEMD_FIP_CQ_BATCH,
+				NULL, RPMEM_FIP_CQ_WAIT_MS);
+	else
+		sret = fi_cq_read(thread->cq, entries, RPMEMD_FIP_CQ_BATCH);
+
+	if (unlikely(fip->closing) || sret == -FI_EAGAIN || sret == 0)
+		return 0;
+
+	if (unlikely(sret < 0)) {
+		ret = rpmemd_fip_cq_err(thread->cq, (int)sret);
+		return ret < 0 ? ret : -1;
 	}
 
-	str_err = fi_cq_strerror(cq, err.prov_errno, NULL, NULL, 0);
-	RPMEMD_LOG(ERR, "error reading from completion queue: %s", str_err);
-err:
+	ret = rpmemd_fip_process_batch(fip, entries, (size_t)sret);
+	if (unlikely(ret))
+		ret = ret < 0 ? ret : -ret;
+	else
+		ret = (int)sret;
+
+	thread->nbatches++;
+	thread->ncompl += (uint64_t)sret;
+
 	return ret;
 }
 
 /*
  * rpmemd_fip_thread -- thread callback which processes persist
  * operation
+ *
+ * The thread polls its completion queue and if there is no work for a number
+ * of polls it blocks on it. The number of polls is adjusted -- it grows when
+ * work shows up while polling and shrinks when the thread has to block
+ * anyway.
  */
 static void *
 rpmemd_fip_thread(void *arg)
 {
 	struct rpmemd_fip_thread *thread = arg;
 	struct rpmemd_fip *fip = thread->fip;
-	struct rpmemd_fip_lane *lanep = NULL;
-	uint64_t event = 0;
+	unsigned polls = 0;
 	int ret = 0;
 
+	thread->spin = RPMEMD_FIP_SPIN_MIN;
+
 	while (!fip->closing) {
-		ret = rpmemd_fip_cq_read(fip, thread->cq, &lanep, &event,
-			FI_SEND|FI_RECV);
-		if (ret)
+		ret = rpmemd_fip_cq_process(fip, thread, 0);
+		if (ret < 0)
 			goto err;
 
-		if (unlikely(fip->closing))
-			break;
+		if (ret > 0) {
+			if (polls && thread->spin < RPMEMD_FIP_SPIN_MAX)
+				thread->spin *= 2;
+			polls = 0;
+			continue;
+		}
 
-		RPMEMD_ASSERT(lanep != NULL);
-		if (event & FI_RECV)
-			ret = rpmemd_fip_process_recv(fip, lanep);
-		else if (event & FI_SEND)
-			ret = rpmemd_fip_process_send(fip, lanep);
-		if (ret)
+		if (++polls < thread->spin)
+			continue;
+
+		polls = 0;
+		thread->nblocks++;
+		ret = rpmemd_fip_cq_process(fip, thread, 1);
+		if (ret < 0)
 			goto err;
+
+		if (ret == 0 && thread->spin > RPMEMD_FIP_SPIN_MIN)
+			thread->spin /= 2;
 	}
 
 	return 0;
@@ -832,7 +1062,13 @@ rpmemd_fip_set_attr(struct rpmemd_fip *fip, struct rpmemd_fip_attr *attr)
 	fip->memcpy_persist = attr->memcpy_persist;
 	fip->deep_persist = attr->deep_persist;
 	fip->ctx = attr->ctx;
+	if (attr->flush && attr->memcpy_nodrain && attr->drain) {
+		fip->flush = attr->flush;
+		fip->memcpy_nodrain = attr->memcpy_nodrain;
+		fip->drain = attr->drain;
+	}
 	fip->buff_size = attr->buff_size;
+	fip->proto_minor = attr->proto_minor;
 	fip->pmsg_size = roundup(sizeof(struct rpmem_msg_persist) +
 			fip->buff_size, (size_t)64);
 
@@ -1243,3 +1479,44 @@ rpmemd_fip_process_stop(struct rpmemd_fip *fip)
 
 	return lret;
 }
+
+/*
+ * rpmemd_fip_stats_log -- log statistics of processed persist messages
+ *
+ * Must not be called while processing is in progress.
+ */
+void
+rpmemd_fip_stats_log(struct rpmemd_fip *fip)
+{
+	uint64_t nmsgs = 0;
+	uint64_t nbytes = 0;
+	uint64_t nerrors = 0;
+
+	RPMEMD_LOG(INFO, "lanes statistics:");
+	for (unsigned i = 0; i < fip->nlanes; i++) {
+		struct rpmemd_fip_lane *lanep = &fip->lanes[i];
+		if (lanep->nmsgs == 0 && lanep->nerrors == 0)
+			continue;
+
+		RPMEMD_LOG(INFO, RPMEMD_LOG_INDENT "lane %u: messages %lu, "
+			"bytes %lu, errors %lu", i, lanep->nmsgs,
+			lanep->nbytes, lanep->nerrors);
+
+		nmsgs += lanep->nmsgs;
+		nbytes += lanep->nbytes;
+		nerrors += lanep->nerrors;
+	}
+
+	RPMEMD_LOG(INFO, "threads statistics:");
+	for (size_t i = 0; i < fip->nthreads; i++) {
+		struct rpmemd_fip_thread *thread = &fip->threads[i];
+		RPMEMD_LOG(INFO, RPMEMD_LOG_INDENT "thread %zu: completions "
+			"%lu, batches %lu, blocking waits %lu", i,
+			thread->ncompl, thread->nbatches, thread->nblocks);
+	}
+
+	RPMEMD_LOG(NOTICE, "persist statistics:");
+	RPMEMD_LOG(NOTICE, RPMEMD_LOG_INDENT "messages: %lu", nmsgs);
+	RPMEMD_LOG(NOTICE, RPMEMD_LOG_INDENT "bytes: %lu", nbytes);
+	RPMEMD_LOG(NOTICE, RPMEMD_LOG_INDENT "errors: %lu", nerrors);
+}
@@ -44,12 +44,18 @@ struct rpmemd_fip_attr {
 	unsigned nlanes;
 	size_t nthreads;
 	size_t buff_size;
+	unsigned proto_minor;
 	enum rpmem_provider provider;
 	enum rpmem_persist_method persist_method;
 	int (*persist)(const void *addr, size_t len);
 	void *(*memcpy_persist)(void *pmemdest, const void *src, size_t len);
 	int (*deep_persist)(const void *addr, size_t len, void *ctx);
 	void *ctx;
+
+	/* optional -- used for batching flushes of concurrent requests */
+	int (*flush)(const void *addr, size_t len);
+	void *(*memcpy_nodrain)(void *pmemdest, const void *src, size_t len);
+	void (*drain)(void);
 };
 
 struct rpmemd_fip *rpmemd_fip_init(const char *node,
@@ -64,3 +70,4 @@ int rpmemd_fip_process_start(struct rpmemd_fip *fip);
 int rpmemd_fip_process_stop(struct rpmemd_fip *fip);
 int rpmemd_fip_wait_close(struct rpmemd_fip *fip, int timeout);
 int rpmemd_fip_close(struct rpmemd_fip *fip);
+void rpmemd_fip_stats_log(struct rpmemd_fip *fip);
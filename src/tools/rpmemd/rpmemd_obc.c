@@ -58,17 +58,24 @@ struct rpmemd_obc {
 
 /*
  * rpmemd_obc_check_proto_ver -- check protocol version
+ *
+ * Clients using an older minor version are accepted, the features added
+ * in later minor versions are not used on their connections.
  */
 static int
 rpmemd_obc_check_proto_ver(unsigned major, unsigned minor)
 {
 	if (major != RPMEM_PROTO_MAJOR ||
-	    minor != RPMEM_PROTO_MINOR) {
+	    minor > RPMEM_PROTO_MINOR) {
 		RPMEMD_LOG(ERR, "unsupported protocol version -- %u.%u",
 				major, minor);
 		return -1;
 	}
 
+	if (minor < RPMEM_PROTO_MINOR)
+		RPMEMD_LOG(NOTICE, "using protocol version %u.%u", major,
+				minor);
+
 	return 0;
 }
 
@@ -254,6 +261,7 @@ rpmemd_obc_process_create(struct rpmemd_obc *obc,
 		.pool_desc = (char *)msg->pool_desc.desc,
 		.provider = (enum rpmem_provider)msg->c.provider,
 		.buff_size = msg->c.buff_size,
+		.proto_minor = msg->c.minor,
 	};
 
 	struct rpmem_pool_attr *rattr = NULL;
@@ -280,6 +288,7 @@ rpmemd_obc_process_open(struct rpmemd_obc *obc,
 		.pool_desc = (const char *)msg->pool_desc.desc,
 		.provider = (enum rpmem_provider)msg->c.provider,
 		.buff_size = msg->c.buff_size,
+		.proto_minor = msg->c.minor,
 	};
 
 	return req_cb->open(obc, arg, &req);
@@ -53,6 +53,17 @@ rpmemd_pmem_persist(const void *addr, size_t len)
 	return 0;
 }
 
+/*
+ * rpmemd_pmem_flush -- pmem_flush wrapper required to unify function
+ * pointer type with pmem_msync
+ */
+static int
+rpmemd_pmem_flush(const void *addr, size_t len)
+{
+	pmem_flush(addr, len);
+	return 0;
+}
+
 /*
  * rpmemd_flush_fatal -- APM specific flush function which should never be
  * called because APM does not require flushes
@@ -146,3 +157,31 @@ rpmemd_apply_pm_policy(enum rpmem_persist_method *persist_method,
 
 	return 0;
 }
+
+/*
+ * rpmemd_apply_batch_policy -- choose the functions used for persisting
+ * requests which are processed together -- the data of each request is
+ * flushed separately and all of them are drained at once
+ *
+ * Batching is possible only for pools on persistent memory, so for other
+ * pools all the functions are set to NULL.
+ */
+void
+rpmemd_apply_batch_policy(enum rpmem_persist_method persist_method,
+	int (**flush)(const void *addr, size_t len),
+	void *(**memcpy_nodrain)(void *pmemdest, const void *src, size_t len),
+	void (**drain)(void),
+	const int is_pmem)
+{
+	if (!is_pmem) {
+		*flush = NULL;
+		*memcpy_nodrain = NULL;
+		*drain = NULL;
+		return;
+	}
+
+	*flush = persist_method == RPMEM_PM_APM ?
+		rpmemd_flush_fatal : rpmemd_pmem_flush;
+	*memcpy_nodrain = pmem_memcpy_nodrain;
+	*drain = pmem_drain;
+}
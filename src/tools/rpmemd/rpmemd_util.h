@@ -40,3 +40,8 @@ int rpmemd_apply_pm_policy(enum rpmem_persist_method *persist_method,
 	int (**persist)(const void *addr, size_t len),
 	void *(**memcpy_persist)(void *pmemdest, const void *src, size_t len),
 	const int is_pmem);
+void rpmemd_apply_batch_policy(enum rpmem_persist_method persist_method,
+	int (**flush)(const void *addr, size_t len),
+	void *(**memcpy_nodrain)(void *pmemdest, const void *src, size_t len),
+	void (**drain)(void),
+	const int is_pmem);
@@ -304,6 +304,7 @@
 #define	opt_zero JEMALLOC_N(opt_zero)
 #define	p2rz JEMALLOC_N(p2rz)
 #define	pages_purge JEMALLOC_N(pages_purge)
+#define	pages_purge_reclaim JEMALLOC_N(pages_purge_reclaim)
 #define	pools_shared_data_initialized JEMALLOC_N(pools_shared_data_initialized)
 #define	pow2_ceil JEMALLOC_N(pow2_ceil)
 #define	prof_backtrace JEMALLOC_N(prof_backtrace)
@@ -454,6 +455,7 @@
 #define	pool_prefork JEMALLOC_N(pool_prefork)
 #define	pool_postfork_parent JEMALLOC_N(pool_postfork_parent)
 #define	pool_postfork_child JEMALLOC_N(pool_postfork_child)
+#define	pool_purge_deferred JEMALLOC_N(pool_purge_deferred)
 #define	pool_alloc JEMALLOC_N(pool_alloc)
 #define	vec_get JEMALLOC_N(vec_get)
 #define	vec_set JEMALLOC_N(vec_set)
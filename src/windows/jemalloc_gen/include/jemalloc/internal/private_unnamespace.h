@@ -304,6 +304,7 @@
 #undef opt_zero
 #undef p2rz
 #undef pages_purge
+#undef pages_purge_reclaim
 #undef pools_shared_data_initialized
 #undef pow2_ceil
 #undef prof_backtrace
@@ -454,6 +455,7 @@
 #undef pool_prefork
 #undef pool_postfork_parent
 #undef pool_postfork_child
+#undef pool_purge_deferred
 #undef pool_alloc
 #undef vec_get
 #undef vec_set
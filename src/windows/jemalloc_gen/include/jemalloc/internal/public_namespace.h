@@ -10,6 +10,9 @@
 #define	je_pool_extend JEMALLOC_N(pool_extend)
 #define	je_pool_set_alloc_funcs JEMALLOC_N(pool_set_alloc_funcs)
 #define	je_pool_check JEMALLOC_N(pool_check)
+#define	je_pool_ctl JEMALLOC_N(pool_ctl)
+#define	je_pool_quiesce JEMALLOC_N(pool_quiesce)
+#define	je_pool_resume JEMALLOC_N(pool_resume)
 #define	je_malloc_conf JEMALLOC_N(malloc_conf)
 #define	je_malloc_message JEMALLOC_N(malloc_message)
 #define	je_malloc JEMALLOC_N(malloc)
@@ -10,6 +10,9 @@
 #undef je_pool_extend
 #undef je_pool_set_alloc_funcs
 #undef je_pool_check
+#undef je_pool_ctl
+#undef je_pool_quiesce
+#undef je_pool_resume
 #undef je_malloc_conf
 #undef je_malloc_message
 #undef je_malloc
@@ -68,6 +68,9 @@ extern "C" {
 #  define je_pool_extend je_vmem_pool_extend
 #  define je_pool_set_alloc_funcs je_vmem_pool_set_alloc_funcs
 #  define je_pool_check je_vmem_pool_check
+#  define je_pool_ctl je_vmem_pool_ctl
+#  define je_pool_quiesce je_vmem_pool_quiesce
+#  define je_pool_resume je_vmem_pool_resume
 #  define je_malloc_conf je_vmem_malloc_conf
 #  define je_malloc_message je_vmem_malloc_message
 #  define je_malloc je_vmem_malloc
@@ -166,6 +169,10 @@ JEMALLOC_EXPORT void	je_pool_malloc_stats_print(pool_t *pool,
 JEMALLOC_EXPORT void	je_pool_set_alloc_funcs(void *(*malloc_func)(size_t),
 							void (*free_func)(void *));
 JEMALLOC_EXPORT int	je_pool_check(pool_t *pool);
+JEMALLOC_EXPORT int	je_pool_ctl(pool_t *pool, const char *name,
+    void *oldp, size_t *oldlenp, void *newp, size_t newlen);
+JEMALLOC_EXPORT void	je_pool_quiesce(pool_t *pool);
+JEMALLOC_EXPORT void	je_pool_resume(pool_t *pool);
 
 JEMALLOC_EXPORT void	*je_malloc(size_t size) JEMALLOC_ATTR(malloc);
 JEMALLOC_EXPORT void	*je_calloc(size_t num, size_t size)
@@ -234,6 +241,9 @@ typedef bool (chunk_dalloc_t)(void *, size_t, unsigned, pool_t *);
 #  define pool_extend je_pool_extend
 #  define pool_set_alloc_funcs je_pool_set_alloc_funcs
 #  define pool_check je_pool_check
+#  define pool_ctl je_pool_ctl
+#  define pool_quiesce je_pool_quiesce
+#  define pool_resume je_pool_resume
 #  define malloc_conf je_malloc_conf
 #  define malloc_message je_malloc_message
 #  define malloc je_malloc
@@ -276,6 +286,9 @@ typedef bool (chunk_dalloc_t)(void *, size_t, unsigned, pool_t *);
 #  undef je_pool_extend
 #  undef je_pool_set_alloc_funcs
 #  undef je_pool_check
+#  undef je_pool_ctl
+#  undef je_pool_quiesce
+#  undef je_pool_resume
 #  undef je_malloc_conf
 #  undef je_malloc_message
 #  undef je_malloc
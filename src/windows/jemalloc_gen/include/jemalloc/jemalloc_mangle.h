@@ -21,6 +21,9 @@
 #  define pool_extend je_pool_extend
 #  define pool_set_alloc_funcs je_pool_set_alloc_funcs
 #  define pool_check je_pool_check
+#  define pool_ctl je_pool_ctl
+#  define pool_quiesce je_pool_quiesce
+#  define pool_resume je_pool_resume
 #  define malloc_conf je_malloc_conf
 #  define malloc_message je_malloc_message
 #  define malloc je_malloc
@@ -63,6 +66,9 @@
 #  undef je_pool_extend
 #  undef je_pool_set_alloc_funcs
 #  undef je_pool_check
+#  undef je_pool_ctl
+#  undef je_pool_quiesce
+#  undef je_pool_resume
 #  undef je_malloc_conf
 #  undef je_malloc_message
 #  undef je_malloc
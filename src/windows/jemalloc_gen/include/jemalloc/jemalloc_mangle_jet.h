@@ -21,6 +21,9 @@
 #  define pool_extend jet_pool_extend
 #  define pool_set_alloc_funcs jet_pool_set_alloc_funcs
 #  define pool_check jet_pool_check
+#  define pool_ctl jet_pool_ctl
+#  define pool_quiesce jet_pool_quiesce
+#  define pool_resume jet_pool_resume
 #  define malloc_conf jet_malloc_conf
 #  define malloc_message jet_malloc_message
 #  define malloc jet_malloc
@@ -63,6 +66,9 @@
 #  undef jet_pool_extend
 #  undef jet_pool_set_alloc_funcs
 #  undef jet_pool_check
+#  undef jet_pool_ctl
+#  undef jet_pool_quiesce
+#  undef jet_pool_resume
 #  undef jet_malloc_conf
 #  undef jet_malloc_message
 #  undef jet_malloc
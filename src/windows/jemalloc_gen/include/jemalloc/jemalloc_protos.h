@@ -25,6 +25,10 @@ JEMALLOC_EXPORT void	je_pool_malloc_stats_print(pool_t *pool,
 JEMALLOC_EXPORT void	je_pool_set_alloc_funcs(void *(*malloc_func)(size_t),
 							void (*free_func)(void *));
 JEMALLOC_EXPORT int	je_pool_check(pool_t *pool);
+JEMALLOC_EXPORT int	je_pool_ctl(pool_t *pool, const char *name,
+    void *oldp, size_t *oldlenp, void *newp, size_t newlen);
+JEMALLOC_EXPORT void	je_pool_quiesce(pool_t *pool);
+JEMALLOC_EXPORT void	je_pool_resume(pool_t *pool);
 
 JEMALLOC_EXPORT void	*je_malloc(size_t size) JEMALLOC_ATTR(malloc);
 JEMALLOC_EXPORT void	*je_calloc(size_t num, size_t size)
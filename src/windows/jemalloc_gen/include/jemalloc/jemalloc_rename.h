@@ -16,6 +16,9 @@
 #  define je_pool_extend je_vmem_pool_extend
 #  define je_pool_set_alloc_funcs je_vmem_pool_set_alloc_funcs
 #  define je_pool_check je_vmem_pool_check
+#  define je_pool_ctl je_vmem_pool_ctl
+#  define je_pool_quiesce je_vmem_pool_quiesce
+#  define je_pool_resume je_vmem_pool_resume
 #  define je_malloc_conf je_vmem_malloc_conf
 #  define je_malloc_message je_vmem_malloc_message
 #  define je_malloc je_vmem_malloc